@@ -304,6 +304,10 @@ SOURCE=.\src\gui\ContextMenuMetadataItemVisitor.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\gui\CopyDataDialog.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\gui\controls\ControlUtils.cpp
 # End Source File
 # Begin Source File
@@ -312,6 +316,10 @@ SOURCE=.\src\metadata\CreateDDLVisitor.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\metadata\DDLScriptWriter.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\gui\CreateIndexDialog.cpp
 # End Source File
 # Begin Source File
@@ -368,6 +376,10 @@ SOURCE=.\src\gui\ExecuteSqlFrame.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\gui\ImportDataDialog.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\core\FRError.cpp
 # End Source File
 # Begin Source File
@@ -404,6 +416,10 @@ SOURCE=.\src\sql\IncompleteStatement.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\sql\ExecutionPlan.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\metadata\Index.cpp
 # End Source File
 # Begin Source File
@@ -416,6 +432,10 @@ SOURCE=.\src\gui\controls\LogTextControl.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\gui\controls\RelationIOListCtrl.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\gui\MainFrame.cpp
 # End Source File
 # Begin Source File
@@ -444,10 +464,50 @@ SOURCE=.\src\metadata\MetadataItemVisitor.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\metadata\MetadataCache.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\engine\MetadataLoader.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\engine\MetadataSearchIndex.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\SharedAttachment.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\DataGenerator.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\BatchInsert.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\BackupRestoreProgress.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\DataCopier.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\DataImporter.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\MetadataChangeDetector.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\StatementBenchmark.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\metadata\MetadataTemplateCmdHandler.cpp
 # End Source File
 # Begin Source File
@@ -488,6 +548,10 @@ SOURCE=.\src\gui\ProgressDialog.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\gui\PropertyPageBenchmark.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\core\ProgressIndicator.cpp
 # End Source File
 # Begin Source File
@@ -548,6 +612,10 @@ SOURCE=.\src\core\TemplateProcessor.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\core\TemplateCache.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\gui\controls\TextControl.cpp
 # End Source File
 # Begin Source File
@@ -588,6 +656,10 @@ SOURCE=.\src\metadata\database.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\metadata\DependencyGraph.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\databasehandler.cpp
 # End Source File
 # Begin Source File
@@ -662,6 +734,10 @@ SOURCE=.\src\metadata\root.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\metadata\SchemaComparer.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\metadata\server.cpp
 # End Source File
 # Begin Source File
@@ -742,6 +818,10 @@ SOURCE=.\src\gui\ContextMenuMetadataItemVisitor.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\gui\CopyDataDialog.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\gui\controls\ControlUtils.h
 # End Source File
 # Begin Source File
@@ -750,6 +830,10 @@ SOURCE=.\src\metadata\CreateDDLVisitor.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\metadata\DDLScriptWriter.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\gui\CreateIndexDialog.h
 # End Source File
 # Begin Source File
@@ -806,6 +890,10 @@ SOURCE=.\src\gui\ExecuteSqlFrame.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\gui\ImportDataDialog.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\core\FRError.h
 # End Source File
 # Begin Source File
@@ -842,6 +930,10 @@ SOURCE=.\src\sql\IncompleteStatement.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\sql\ExecutionPlan.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\metadata\Index.h
 # End Source File
 # Begin Source File
@@ -858,6 +950,10 @@ SOURCE=.\src\gui\controls\LogTextControl.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\gui\controls\RelationIOListCtrl.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\gui\MainFrame.h
 # End Source File
 # Begin Source File
@@ -890,10 +986,50 @@ SOURCE=.\src\metadata\MetadataItemVisitor.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\metadata\MetadataCache.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\engine\MetadataLoader.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\engine\MetadataSearchIndex.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\SharedAttachment.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\DataGenerator.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\BatchInsert.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\BackupRestoreProgress.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\DataCopier.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\DataImporter.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\MetadataChangeDetector.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\src\engine\StatementBenchmark.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\metadata\MetadataTemplateManager.h
 # End Source File
 # Begin Source File
@@ -934,6 +1070,10 @@ SOURCE=.\src\gui\ProgressDialog.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\gui\PropertyPageBenchmark.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\core\ProgressIndicator.h
 # End Source File
 # Begin Source File
@@ -990,6 +1130,10 @@ SOURCE=.\src\core\TemplateProcessor.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\core\TemplateCache.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\gui\controls\TextControl.h
 # End Source File
 # Begin Source File
@@ -1030,6 +1174,10 @@ SOURCE=.\src\metadata\database.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\metadata\DependencyGraph.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\metadata\domain.h
 # End Source File
 # Begin Source File
@@ -1090,6 +1238,10 @@ SOURCE=.\src\metadata\root.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\src\metadata\SchemaComparer.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\src\metadata\server.h
 # End Source File
 # Begin Source File
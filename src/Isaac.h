@@ -131,6 +131,26 @@ public:
         isaac(&ctxM);
     }
 
+    // seeds the generator for use as stream of random numbers, see
+    // getRandom(), at most 256 seed values are used
+    Isaac(const unsigned long* seed, int count)
+    {
+        for (int i=0; i<256; ++i)
+            ctxM.randrsl[i] = (i < count) ? (ub4)(seed[i] & 0xffffffff) : 0;
+        randinit(&ctxM);
+    }
+
+    // returns the next random number, between 0 and 2^32-1
+    unsigned long getRandom()
+    {
+        if (!ctxM.randcnt--)
+        {
+            isaac(&ctxM);
+            ctxM.randcnt = 255;
+        }
+        return ctxM.randrsl[ctxM.randcnt];
+    }
+
     wxString getCipher(const wxString& pwd)
     {
         wxString result;
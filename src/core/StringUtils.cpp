@@ -277,3 +277,12 @@ wxString wrapText(const wxString& text, size_t maxWidth, size_t indent)
     return wrappedText;
 }
 
+wxString formatDuration(boost::int64_t seconds)
+{
+    if (seconds >= 3600)
+    {
+        return wxString::Format("%d:%02d:%02d", int(seconds / 3600),
+            int(seconds / 60 % 60), int(seconds % 60));
+    }
+    return wxString::Format("%d:%02d", int(seconds / 60), int(seconds % 60));
+}
@@ -29,6 +29,7 @@
 
 #include <string>
 
+#include <boost/cstdint.hpp>
 
 std::string wx2std(const wxString& input, wxMBConv* conv = wxConvCurrent);
 
@@ -60,4 +61,7 @@ wxString loadEntireFile(const wxFileName& filename);
 //  Code adapted from wxWidgets' wxTextWrapper function.
 wxString wrapText(const wxString& text, size_t maxWidth, size_t indent);
 
+//! formats a number of seconds as "m:ss", or as "h:mm:ss" from one hour on
+wxString formatDuration(boost::int64_t seconds);
+
 #endif // FR_STRINGUTILS_H
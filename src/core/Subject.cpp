@@ -32,12 +32,21 @@
 
 #include <algorithm>
 #include <list>
+#include <vector>
+
+#include <boost/unordered_set.hpp>
 
 #include "core/Observer.h"
 #include "core/Subject.h"
 
 typedef std::list<Observer*> ObserverList;
 
+// subjects waiting for the outermost NotificationBatch to end, the vector
+// keeps the order of the first request, the set is used for the lookups
+static std::vector<Subject*> pendingSubjects;
+static boost::unordered_set<Subject*> pendingSubjectSet;
+static NotificationStatistics notificationStatistics;
+
 Subject::Subject()
 {
     locksCountM = 0;
@@ -46,13 +55,14 @@ Subject::Subject()
 
 Subject::~Subject()
 {
+    // the entry in pendingSubjects is skipped when its set entry is missing
+    pendingSubjectSet.erase(this);
     detachAllObservers();
 }
 
 void Subject::attachObserver(Observer* observer, bool callUpdate)
 {
-    if (observer && observersM.end() == std::find(observersM.begin(),
-        observersM.end(), observer))
+    if (observer && observerSetM.insert(observer).second)
     {
         observer->addSubject(this);
         observersM.push_back(observer);
@@ -67,10 +77,13 @@ void Subject::detachObserver(Observer* observer)
         return;
 
     observer->removeSubject(this);
-    ObserverList::iterator it = find(observersM.begin(), observersM.end(),
-        observer);
-    if (it != observersM.end())
-        observersM.erase(it);
+    if (observerSetM.erase(observer))
+    {
+        ObserverList::iterator it = find(observersM.begin(),
+            observersM.end(), observer);
+        if (it != observersM.end())
+            observersM.erase(it);
+    }
 }
 
 void Subject::detachAllObservers()
@@ -85,30 +98,49 @@ void Subject::detachAllObservers()
             (*it)->removeSubject(this);
     }
     observersM.clear();
+    observerSetM.clear();
 }
 
 bool Subject::isObservedBy(Observer* observer) const
 {
-    return observersM.end() != std::find(observersM.begin(),
-        observersM.end(), observer);
+    return observerSetM.find(observer) != observerSetM.end();
 }
 
 void Subject::notifyObservers()
 {
+    ++notificationStatistics.requested;
     if (isLocked())
         needsNotifyObjectsM = true;
+    else if (NotificationBatch::isActive())
+    {
+        needsNotifyObjectsM = false;
+        if (pendingSubjectSet.insert(this).second)
+            pendingSubjects.push_back(this);
+        else
+            ++notificationStatistics.coalesced;
+    }
     else
+        deliverNotification();
+}
+
+void Subject::deliverNotification()
+{
+    needsNotifyObjectsM = false;
+    if (observersM.empty())
+        return;
+    ++notificationStatistics.delivered;
+
+    ObserverList orig(observersM);
+    // make sure there are no reentrancy problems
+    // loop over the items in the original list, but ignore all observers
+    // which have already been removed from the original list
+    for (ObserverList::iterator it = orig.begin(); it != orig.end(); ++it)
     {
-        ObserverList orig(observersM);
-        // make sure there are no reentrancy problems
-        // loop over the items in the original list, but ignore all observers
-        // which have already been removed from the original list
-        for (ObserverList::iterator it = orig.begin(); it != orig.end(); ++it)
+        if (isObservedBy(*it))
         {
-            if (isObservedBy(*it))
-                (*it)->doUpdate();
+            ++notificationStatistics.observerUpdates;
+            (*it)->doUpdate();
         }
-        needsNotifyObjectsM = false;
     }
 }
 
@@ -175,3 +207,66 @@ void SubjectLocker::setSubject(Subject* subject)
     }
 }
 
+
+NotificationStatistics::NotificationStatistics()
+    : requested(0), coalesced(0), delivered(0), observerUpdates(0)
+{
+}
+
+unsigned int NotificationBatch::depthM = 0;
+
+NotificationBatch::NotificationBatch(const char* name)
+    : nameM(name), startStatisticsM(notificationStatistics)
+{
+    ++depthM;
+}
+
+NotificationBatch::~NotificationBatch()
+{
+    if (--depthM == 0)
+        flush();
+
+    if (nameM)
+    {
+        const NotificationStatistics& now(notificationStatistics);
+        wxLogDebug("%s: %lu notifications requested, %lu coalesced, "
+            "%lu delivered, %lu observer updates", nameM,
+            now.requested - startStatisticsM.requested,
+            now.coalesced - startStatisticsM.coalesced,
+            now.delivered - startStatisticsM.delivered,
+            now.observerUpdates - startStatisticsM.observerUpdates);
+    }
+}
+
+void NotificationBatch::flush()
+{
+    // observers may request new notifications (or start a new batch) in
+    // their update() methods, so keep going until nothing is pending
+    while (!pendingSubjects.empty())
+    {
+        std::vector<Subject*> subjects;
+        subjects.swap(pendingSubjects);
+        for (std::vector<Subject*>::iterator it = subjects.begin();
+            it != subjects.end(); ++it)
+        {
+            // subjects destroyed in the meantime have removed their entry
+            if (!pendingSubjectSet.erase(*it))
+                continue;
+            // a subject locked in the meantime notifies when unlocked
+            if ((*it)->isLocked())
+                (*it)->needsNotifyObjectsM = true;
+            else
+                (*it)->deliverNotification();
+        }
+    }
+}
+
+bool NotificationBatch::isActive()
+{
+    return depthM > 0;
+}
+
+const NotificationStatistics& NotificationBatch::getStatistics()
+{
+    return notificationStatistics;
+}
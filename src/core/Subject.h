@@ -27,19 +27,26 @@
 #include <list>
 #include <vector>
 
+#include <boost/unordered_set.hpp>
+
 class Observer;
 
 class Subject
 {
 private:
     friend class SubjectLocker;
+    friend class NotificationBatch;
 
     unsigned int locksCountM;
+    // observersM keeps the order of attachment, observerSetM allows for
+    // membership checks in constant time
     std::list<Observer*> observersM;
+    boost::unordered_set<Observer*> observerSetM;
     bool needsNotifyObjectsM;
 
     void detachAllObservers();
     bool isObservedBy(Observer* observer) const;
+    void deliverNotification();
 protected:
     // make these protected, as instances of this class are bogus...
     Subject();
@@ -69,4 +76,40 @@ public:
     ~SubjectLocker();
 };
 
+// counters of the observer notifications since program start
+struct NotificationStatistics
+{
+    // calls of Subject::notifyObservers()
+    unsigned long requested;
+    // requests dropped because the subject was already waiting in a batch
+    unsigned long coalesced;
+    // notifications actually sent to the observers of a subject
+    unsigned long delivered;
+    // resulting calls of Observer::update()
+    unsigned long observerUpdates;
+
+    NotificationStatistics();
+};
+
+// Collects the notifications of all subjects while at least one instance
+// exists, and delivers them once per subject when the outermost instance
+// is destroyed. Unlike SubjectLocker it doesn't need to lock the children
+// of a subject recursively, so it is cheap to use around bulk operations
+// like connecting, refreshing or parsing executed DDL statements.
+class NotificationBatch
+{
+private:
+    const char* nameM;
+    NotificationStatistics startStatisticsM;
+
+    static unsigned int depthM;
+    static void flush();
+public:
+    NotificationBatch(const char* name = 0);
+    ~NotificationBatch();
+
+    static bool isActive();
+    static const NotificationStatistics& getStatistics();
+};
+
 #endif
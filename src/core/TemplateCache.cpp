@@ -0,0 +1,191 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include "core/StringUtils.h"
+#include "core/TemplateCache.h"
+
+// large enough for all property pages and code templates and the texts of
+// their nested commands
+static const size_t maxCachedTemplates = 1024;
+
+TemplateCache& getTemplateCache()
+{
+    static TemplateCache cache;
+    return cache;
+}
+
+TemplateCache::TemplateCache()
+    : maxEntriesM(maxCachedTemplates)
+{
+}
+
+// commands are in format: {%cmdName:cmdParams%}
+void TemplateCache::parse(const wxString& inputText,
+    CompiledTemplate& compiled)
+{
+    wxString::size_type pos = 0, oldpos = 0, endpos = 0;
+    while (true)
+    {
+        pos = inputText.find("{%", pos);
+        if (pos == wxString::npos)
+        {
+            TemplateItem item;
+            item.text = inputText.substr(oldpos);
+            compiled.push_back(item);
+            break;
+        }
+
+        wxString::size_type check, startpos = pos;
+        int cnt = 1;
+        while (cnt > 0)
+        {
+            endpos = inputText.find("%}", startpos+1);
+            if (endpos == wxString::npos)
+                break;
+
+            check = inputText.find("{%", startpos+1);
+            if (check == wxString::npos)
+                startpos = endpos;
+            else
+            {
+                startpos = (check < endpos ? check : endpos);
+                if (startpos == check)
+                    cnt++;
+            }
+            if (startpos == endpos)
+                cnt--;
+            startpos++;
+        }
+
+        if (cnt > 0)    // no matching closing %}
+            break;
+
+        compiled.push_back(TemplateItem());
+        TemplateItem& item = compiled.back();
+        item.text = inputText.substr(oldpos, pos - oldpos);
+        wxString cmd = inputText.substr(pos + 2, endpos - pos - 2); // 2 = start_marker_len = end_marker_len
+
+        // parse command name and params.
+        enum TemplateCmdState
+        {
+            inText,
+            inString1,
+            inString2
+        };
+        TemplateCmdState state = inText;
+        wxString buffer;
+        unsigned int nestLevel = 0;
+        for (wxString::size_type i = 0; i < cmd.Length(); i++)
+        {
+            wxChar c = cmd[i];
+
+            if (c == ':')
+            {
+                if ((nestLevel == 0) && (state == inText))
+                {
+                    item.cmdParams.Add(buffer);
+                    buffer.Clear();
+                    continue;
+                }
+            }
+            buffer += c;
+
+            if ((c == '{') && (i < cmd.Length() - 1) && (cmd[i + 1] == '%'))
+                nestLevel++;
+            else if ((c == '}') && (i > 0) && (cmd[i - 1] == '%'))
+                nestLevel--;
+            else if (c == '\'')
+                state == inString1 ? state = inText : state = inString1;
+            else if (c == '"')
+                state == inString2 ? state = inText : state = inString2;
+        }
+        if (buffer.Length() > 0)
+            item.cmdParams.Add(buffer);
+
+        if (item.cmdParams.Count() > 0)
+        {
+            item.cmdName = item.cmdParams[0];
+            item.cmdParams.RemoveAt(0);
+        }
+        oldpos = pos = endpos + 2;
+    }
+}
+
+CompiledTemplatePtr TemplateCache::compile(const wxString& text)
+{
+    EntryMap::iterator it = indexM.find(text);
+    if (it != indexM.end())
+    {
+        // move to the front of the list, iterators stay valid
+        entriesM.splice(entriesM.begin(), entriesM, (*it).second);
+        return entriesM.front().second;
+    }
+
+    boost::shared_ptr<CompiledTemplate> compiled(new CompiledTemplate());
+    parse(text, *compiled);
+    entriesM.push_front(Entry(text, compiled));
+    indexM[text] = entriesM.begin();
+    // the template may still be rendered when it is evicted, so the parsed
+    // form is shared with the callers
+    while (entriesM.size() > maxEntriesM)
+    {
+        indexM.erase(entriesM.back().first);
+        entriesM.pop_back();
+    }
+    return compiled;
+}
+
+wxString TemplateCache::loadFile(const wxFileName& fileName)
+{
+    wxString path(fileName.GetFullPath());
+    std::map<wxString, File>::iterator it = filesM.find(path);
+    if (it != filesM.end() && fileName.FileExists()
+        && (*it).second.modified == fileName.GetModificationTime()
+        && (*it).second.size == fileName.GetSize())
+    {
+        return (*it).second.text;
+    }
+
+    File& file = filesM[path];
+    // throws if the file doesn't exist
+    file.text = loadEntireFile(fileName);
+    file.modified = fileName.GetModificationTime();
+    file.size = fileName.GetSize();
+    return file.text;
+}
+
+void TemplateCache::clear()
+{
+    entriesM.clear();
+    indexM.clear();
+    filesM.clear();
+}
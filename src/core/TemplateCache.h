@@ -0,0 +1,96 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_TEMPLATECACHE_H
+#define FR_TEMPLATECACHE_H
+
+#include <wx/datetime.h>
+#include <wx/filename.h>
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "core/TemplateProcessor.h"
+
+// A command of a template, together with the literal text before it.
+// Command parameters are kept as text, as they are expanded by the command
+// handlers (which get the parsed form of them from the cache as well).
+struct TemplateItem
+{
+    wxString text;
+    // empty for the literal text at the end of the template
+    wxString cmdName;
+    TemplateCmdParams cmdParams;
+};
+
+typedef std::vector<TemplateItem> CompiledTemplate;
+typedef boost::shared_ptr<const CompiledTemplate> CompiledTemplatePtr;
+
+// Caches template files and the parsed form of template texts, so that
+// property pages and code templates are parsed only once and not every
+// time they are rendered.
+class TemplateCache
+{
+private:
+    typedef std::pair<wxString, CompiledTemplatePtr> Entry;
+    typedef std::list<Entry> EntryList;
+    typedef boost::unordered_map<wxString, EntryList::iterator,
+        wxStringHash, wxStringEqual> EntryMap;
+    // entriesM keeps the least recently used order, indexM allows for
+    // lookups by text
+    EntryList entriesM;
+    EntryMap indexM;
+    size_t maxEntriesM;
+
+    struct File
+    {
+        wxDateTime modified;
+        wxULongLong size;
+        wxString text;
+    };
+    std::map<wxString, File> filesM;
+
+    static void parse(const wxString& text, CompiledTemplate& compiled);
+
+    // only getTemplateCache() may instantiate an object of this class.
+    friend TemplateCache& getTemplateCache();
+    TemplateCache();
+    TemplateCache(const TemplateCache&);
+    TemplateCache& operator=(const TemplateCache&);
+public:
+    // returns the parsed form of the template text
+    CompiledTemplatePtr compile(const wxString& text);
+    // returns the contents of the file, which is read again only if its
+    // modification time or size has changed
+    wxString loadFile(const wxFileName& fileName);
+    void clear();
+};
+
+//!singleton instance of the template cache.
+TemplateCache& getTemplateCache();
+
+#endif // FR_TEMPLATECACHE_H
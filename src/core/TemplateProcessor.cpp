@@ -38,11 +38,14 @@
 #include "core/FRError.h"
 #include "core/ProcessableObject.h"
 #include "core/ProgressIndicator.h"
+#include "core/TemplateCache.h"
 #include "TemplateProcessor.h"
 
 
 TemplateProcessor::TemplateProcessor(ProcessableObject* object, wxWindow* window)
-    : objectM(object), windowM(window)
+    : objectM(object), windowM(window), stepPositionM(0), stepObjectM(0),
+        stepDepthM(0), stepCommandM(false), stepIterationM(0),
+        stepFirstItemM(true)
 {
 }
 
@@ -398,99 +401,39 @@ void TemplateProcessor::internalProcessTemplateText(wxString& processedText,
     if (object == 0)
         object = objectM;
 
-    // parse commands
-    wxString::size_type pos = 0, oldpos = 0, endpos = 0;
-    while (true)
+    // texts without commands don't need to be parsed (or cached)
+    if (inputText.find("{%") == wxString::npos)
     {
-        pos = inputText.find("{%", pos);
-        if (pos == wxString::npos)
-        {
-            processedText += inputText.substr(oldpos);
-            break;
-        }
-
-        wxString::size_type check, startpos = pos;
-        int cnt = 1;
-        while (cnt > 0)
-        {
-            endpos = inputText.find("%}", startpos+1);
-            if (endpos == wxString::npos)
-                break;
-
-            check = inputText.find("{%", startpos+1);
-            if (check == wxString::npos)
-                startpos = endpos;
-            else
-            {
-                startpos = (check < endpos ? check : endpos);
-                if (startpos == check)
-                    cnt++;
-            }
-            if (startpos == endpos)
-                cnt--;
-            startpos++;
-        }
-
-        if (cnt > 0)    // no matching closing %}
-            break;
-
-        processedText += inputText.substr(oldpos, pos - oldpos);
-        wxString cmd = inputText.substr(pos + 2, endpos - pos - 2); // 2 = start_marker_len = end_marker_len
-
-        // parse command name and params.
-        wxString cmdName;
-        TemplateCmdParams cmdParams;
+        processedText += inputText;
+        return;
+    }
 
-        enum TemplateCmdState
-        {
-            inText,
-            inString1,
-            inString2
-        };
-        TemplateCmdState state = inText;
-        wxString buffer;
-        unsigned int nestLevel = 0;
-        for (wxString::size_type i = 0; i < cmd.Length(); i++)
+    // the parsed template is shared, as it may be evicted from the cache
+    // by the nested commands while it is processed
+    CompiledTemplatePtr compiled(getTemplateCache().compile(inputText));
+    ++stepDepthM;
+    try
+    {
+        for (CompiledTemplate::const_iterator it = compiled->begin();
+            it != compiled->end(); ++it)
         {
-            wxChar c = cmd[i];
-
-            if (c == ':')
+            processedText += (*it).text;
+            if (!(*it).cmdName.IsEmpty())
             {
-                if ((nestLevel == 0) && (state == inText))
-                {
-                    cmdParams.Add(buffer);
-                    buffer.Clear();
-                    continue;
-                }
+                processCommand((*it).cmdName, (*it).cmdParams, object,
+                    processedText);
             }
-            buffer += c;
-
-            if ((c == '{') && (i < cmd.Length() - 1) && (cmd[i + 1] == '%'))
-                nestLevel++;
-            else if ((c == '}') && (i > 0) && (cmd[i - 1] == '%'))
-                nestLevel--;
-            else if (c == '\'')
-                state == inString1 ? state = inText : state = inString1;
-            else if (c == '"')
-                state == inString2 ? state = inText : state = inString2;
         }
-        if (buffer.Length() > 0)
-            cmdParams.Add(buffer);
-
-        if (cmdParams.Count() > 0)
-        {
-            cmdName = cmdParams[0];
-            cmdParams.RemoveAt(0);
-            if (!cmdName.IsEmpty())
-                processCommand(cmdName, cmdParams, object, processedText);
-        }
-        oldpos = pos = endpos + 2;
     }
+    catch (...)
+    {
+        --stepDepthM;
+        throw;
+    }
+    --stepDepthM;
 }
 
-void TemplateProcessor::processTemplateFile(wxString& processedText,
-    const wxFileName&  inputFileName, ProcessableObject* object,
-    ProgressIndicator* progressIndicator)
+void TemplateProcessor::setTemplateFile(const wxFileName& inputFileName)
 {
     fileNameM = inputFileName;
 
@@ -504,9 +447,91 @@ void TemplateProcessor::processTemplateFile(wxString& processedText,
     wxFileName confFileName(confFileNameStr);
     confFileName.SetExt("conf");
     configM.setConfigFileName(confFileName);
+}
+
+void TemplateProcessor::processTemplateFile(wxString& processedText,
+    const wxFileName&  inputFileName, ProcessableObject* object,
+    ProgressIndicator* progressIndicator)
+{
+    setTemplateFile(inputFileName);
+    progressIndicatorM = progressIndicator;
+    internalProcessTemplateText(processedText,
+        getTemplateCache().loadFile(fileNameM), object);
+}
+
+void TemplateProcessor::startProcessingFile(const wxFileName& inputFileName,
+    ProcessableObject* object)
+{
+    setTemplateFile(inputFileName);
+    stepTemplateM = getTemplateCache().compile(
+        getTemplateCache().loadFile(fileNameM));
+    stepPositionM = 0;
+    stepObjectM = (object) ? object : objectM;
+    stepIterationsM.clear();
+    stepIterationM = 0;
+}
+
+bool TemplateProcessor::processNextCommand(wxString& processedText,
+    ProgressIndicator* progressIndicator)
+{
     progressIndicatorM = progressIndicator;
-    internalProcessTemplateText(processedText, loadEntireFile(fileNameM),
-        object);
+    if (stepIterationM < stepIterationsM.size())
+    {
+        // same as the iterations of the loops that aren't deferred
+        wxString newText;
+        internalProcessTemplateText(newText, stepTextM,
+            stepIterationsM[stepIterationM++].get());
+        if (!newText.IsEmpty())
+        {
+            if (!stepFirstItemM)
+                processedText += escapeChars(stepSeparatorM);
+            stepFirstItemM = false;
+            processedText += newText;
+        }
+        if (stepIterationM == stepIterationsM.size())
+        {
+            stepIterationsM.clear();
+            stepIterationM = 0;
+        }
+    }
+    else if (stepTemplateM && stepPositionM < stepTemplateM->size())
+    {
+        const TemplateItem& item((*stepTemplateM)[stepPositionM++]);
+        processedText += item.text;
+        if (!item.cmdName.IsEmpty())
+        {
+            stepCommandM = true;
+            try
+            {
+                processCommand(item.cmdName, item.cmdParams, stepObjectM,
+                    processedText);
+            }
+            catch (...)
+            {
+                stepCommandM = false;
+                throw;
+            }
+            stepCommandM = false;
+        }
+    }
+    return !stepIterationsM.empty()
+        || (stepTemplateM && stepPositionM < stepTemplateM->size());
+}
+
+bool TemplateProcessor::deferIterations(
+    const std::vector<ProcessableObjectPtr>& objects,
+    const wxString& separator, const wxString& text)
+{
+    // the output of a nested command is used by its enclosing command, so
+    // only the loops of the top-level commands can be deferred
+    if (!stepCommandM || stepDepthM > 0 || objects.empty())
+        return false;
+    stepIterationsM = objects;
+    stepIterationM = 0;
+    stepSeparatorM = separator;
+    stepTextM = text;
+    stepFirstItemM = true;
+    return true;
 }
 
 void TemplateProcessor::processTemplateText(wxString& processedText,
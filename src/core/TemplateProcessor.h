@@ -30,6 +30,9 @@
 
 #include <list>
 #include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
 
 #include "config/Config.h"
 #include "core/ProcessableObject.h"
@@ -46,8 +49,10 @@ public:
 };
 
 typedef std::map<wxString, wxString> wxStringMap;
+typedef boost::shared_ptr<ProcessableObject> ProcessableObjectPtr;
 
 class TemplateCmdHandler;
+struct TemplateItem;
 
 class TemplateProcessor
 {
@@ -60,6 +65,22 @@ private:
     Config configM;
     Config infoM;
     wxWindow* windowM;
+    // state of processing a file in steps
+    boost::shared_ptr<const std::vector<TemplateItem> > stepTemplateM;
+    size_t stepPositionM;
+    ProcessableObject* stepObjectM;
+    // nesting level of the commands processed by internalProcessTemplateText()
+    unsigned stepDepthM;
+    bool stepCommandM;
+    // iterations of a top-level {%foreach%} command left to
+    // processNextCommand(), the objects are kept alive until processed
+    std::vector<ProcessableObjectPtr> stepIterationsM;
+    size_t stepIterationM;
+    wxString stepSeparatorM;
+    wxString stepTextM;
+    bool stepFirstItemM;
+
+    void setTemplateFile(const wxFileName& inputFileName);
 protected:
     TemplateProcessor(ProcessableObject* object, wxWindow* window);
     // Processes a command found in template text
@@ -82,6 +103,21 @@ public:
     void processTemplateFile(wxString& processedText,
         const wxFileName& inputFileName, ProcessableObject* object,
         ProgressIndicator* progressIndicator = 0);
+    // Loads the specified file like processTemplateFile(), but leaves the
+    // processing to processNextCommand(), so callers can show partial
+    // results and stop processing between the top-level commands.
+    void startProcessingFile(const wxFileName& inputFileName,
+        ProcessableObject* object);
+    // Processes the next top-level command of the file loaded by
+    // startProcessingFile(), or the next iteration of a top-level foreach
+    // loop, returns false when there is nothing more to process.
+    bool processNextCommand(wxString& processedText,
+        ProgressIndicator* progressIndicator = 0);
+    // Called by the handlers of {%foreach%} commands, returns true if the
+    // iterations will be processed by the next calls of processNextCommand(),
+    // false if the command is nested or not processed in steps.
+    bool deferIterations(const std::vector<ProcessableObjectPtr>& objects,
+        const wxString& separator, const wxString& text);
     // Sets a variable value. If the variable already exists it is overwritten.
     // To clear a variable, set it to an empty string.
     void setVar(const wxString& varName, const wxString& varValue);
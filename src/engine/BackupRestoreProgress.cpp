@@ -0,0 +1,491 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/filename.h>
+#include <wx/tokenzr.h>
+
+#include <algorithm>
+
+#include "config/Config.h"
+#include "config/DatabaseConfig.h"
+#include "core/StringUtils.h"
+#include "engine/BackupRestoreProgress.h"
+#include "engine/MetadataLoader.h"
+#include "metadata/database.h"
+
+// number of runs kept in the history of a database
+static const size_t maxHistoryRuns = 20;
+
+static wxString unquoteName(const wxString& name)
+{
+    wxString s(name);
+    s.Trim(true).Trim(false);
+    if (s.length() >= 2 && s[0] == '"' && s.Last() == '"')
+    {
+        s = s.Mid(1, s.length() - 2);
+        s.Replace("\"\"", "\"");
+    }
+    return s;
+}
+
+static bool startsWithAny(const wxString& line, const char* prefixes[],
+    wxString& rest)
+{
+    for (const char** p = prefixes; *p; ++p)
+    {
+        if (line.StartsWith(*p, &rest))
+            return true;
+    }
+    return false;
+}
+
+static bool toInt64(const wxString& value, int64_t& result)
+{
+    wxLongLong_t ll;
+    if (!value.ToLongLong(&ll))
+        return false;
+    result = ll;
+    return true;
+}
+
+BackupRestoreEvent::BackupRestoreEvent()
+    : kind(other), count(0)
+{
+}
+
+/*static*/
+BackupRestoreEvent BackupRestoreEvent::parse(const wxString& line)
+{
+    static const char* tablePrefixes[] = {
+        "writing data for table ", "writing data for relation ",
+        "restoring data for table ", "restoring data for relation ", 0 };
+    static const char* indexPrefixes[] = {
+        "writing index ", "restoring index ",
+        "activating and creating deferred index ", 0 };
+
+    BackupRestoreEvent event;
+    wxString s(line);
+    s.Trim(true).Trim(false);
+    // gbak prefixes its messages, the services API usually doesn't
+    if (s.StartsWith("gbak:", &s))
+        s.Trim(false);
+
+    wxString rest;
+    if (s.StartsWith("ERROR:"))
+        event.kind = error;
+    else if (startsWithAny(s, tablePrefixes, rest))
+    {
+        event.kind = tableData;
+        event.name = unquoteName(rest);
+    }
+    else if (startsWithAny(s, indexPrefixes, rest))
+    {
+        event.kind = index;
+        event.name = unquoteName(rest);
+    }
+    else if (s.EndsWith(" records written", &rest)
+        || s.EndsWith(" records restored", &rest))
+    {
+        if (toInt64(rest.Trim(false), event.count))
+            event.kind = records;
+    }
+    else
+    {
+        // "closing file, committing, and finishing. 1234 bytes written"
+        int pos = s.Find(" bytes written");
+        if (pos != wxNOT_FOUND)
+        {
+            rest = s.Left(pos).AfterLast(' ');
+            if (toInt64(rest, event.count))
+                event.kind = bytes;
+        }
+    }
+    return event;
+}
+
+BackupRestoreRun::BackupRestoreRun()
+    : seconds(0), records(0), bytes(-1)
+{
+}
+
+double BackupRestoreRun::getRecordsPerSecond() const
+{
+    return (seconds > 0) ? double(records) / seconds : double(records);
+}
+
+wxString BackupRestoreRun::toString() const
+{
+    return started.Format("%Y%m%d%H%M%S") + ";"
+        + wxLongLong(seconds).ToString() + ";"
+        + wxLongLong(records).ToString() + ";"
+        + wxLongLong(bytes).ToString();
+}
+
+bool BackupRestoreRun::fromString(const wxString& value)
+{
+    wxStringTokenizer tkz(value, ";");
+    if (tkz.CountTokens() != 4)
+        return false;
+    if (!started.ParseFormat(tkz.GetNextToken(), "%Y%m%d%H%M%S"))
+        return false;
+    return toInt64(tkz.GetNextToken(), seconds)
+        && toInt64(tkz.GetNextToken(), records)
+        && toInt64(tkz.GetNextToken(), bytes);
+}
+
+BackupRestoreHistory::BackupRestoreHistory(Database* database,
+        BackupRestoreOperation operation)
+    : databaseM(database), operationM(operation)
+{
+    wxArrayString values;
+    DatabaseConfig(databaseM, config()).getValue(getConfigKey(), values);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        BackupRestoreRun run;
+        if (run.fromString(values[i]))
+            runsM.push_back(run);
+    }
+}
+
+wxString BackupRestoreHistory::getConfigKey() const
+{
+    if (operationM == operationBackup)
+        return "BackupHistory";
+    return "RestoreHistory";
+}
+
+const std::vector<BackupRestoreRun>& BackupRestoreHistory::getRuns() const
+{
+    return runsM;
+}
+
+void BackupRestoreHistory::addRun(const BackupRestoreRun& run)
+{
+    runsM.push_back(run);
+    if (runsM.size() > maxHistoryRuns)
+        runsM.erase(runsM.begin(), runsM.end() - maxHistoryRuns);
+
+    wxArrayString values;
+    for (size_t i = 0; i < runsM.size(); ++i)
+        values.push_back(runsM[i].toString());
+    DatabaseConfig(databaseM, config()).setValue(getConfigKey(), values);
+}
+
+bool BackupRestoreHistory::getAverage(size_t count,
+    BackupRestoreRun& average) const
+{
+    count = std::min(count, runsM.size());
+    if (count == 0)
+        return false;
+
+    average = BackupRestoreRun();
+    average.started = runsM[runsM.size() - count].started;
+    average.bytes = 0;
+    for (size_t i = runsM.size() - count; i < runsM.size(); ++i)
+    {
+        average.seconds += runsM[i].seconds;
+        average.records += runsM[i].records;
+        if (average.bytes >= 0 && runsM[i].bytes >= 0)
+            average.bytes += runsM[i].bytes;
+        else
+            average.bytes = -1;
+    }
+    average.seconds /= int64_t(count);
+    average.records /= int64_t(count);
+    if (average.bytes > 0)
+        average.bytes /= int64_t(count);
+    return true;
+}
+
+wxString BackupRestoreProgress::Status::getStatistics() const
+{
+    wxString s(formatDuration(seconds) + _(" elapsed"));
+    s += wxString::Format(_(", %s records"),
+        wxLongLong(records).ToString().c_str());
+    if (seconds > 0)
+    {
+        s += wxString::Format(_(" (%s per second)"),
+            wxLongLong(records / seconds).ToString().c_str());
+    }
+    if (bytes >= 0)
+    {
+        double mb = bytes / 1048576.0;
+        s += wxString::Format(_(", %.1f MB"), mb);
+        if (seconds > 0)
+            s += wxString::Format(_(" (%.1f MB/s)"), mb / seconds);
+    }
+    if (remainingSeconds >= 0)
+        s += ", " + formatDuration(remainingSeconds) + _(" remaining");
+    return s;
+}
+
+BackupRestoreProgress::BackupRestoreProgress(
+        BackupRestoreOperation operation, const wxString& file)
+    : operationM(operation), fileM(file), expectedRecordsM(0),
+        expectedBytesM(0), startMillisM(0), stopMillisM(0), tableRecordsM(0),
+        finishedRecordsM(0), indicesM(0), bytesWrittenM(-1),
+        completedM(false), errorsM(false)
+{
+}
+
+void BackupRestoreProgress::setExpectedWork(int64_t records, int64_t bytes,
+    const std::map<wxString, int64_t>& tableEstimates)
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    tableEstimatesM = tableEstimates;
+    expectedRecordsM = records;
+    expectedBytesM = bytes;
+    if (expectedRecordsM <= 0)
+    {
+        expectedRecordsM = 0;
+        for (std::map<wxString, int64_t>::const_iterator it =
+            tableEstimatesM.begin(); it != tableEstimatesM.end(); ++it)
+        {
+            expectedRecordsM += it->second;
+        }
+    }
+}
+
+void BackupRestoreProgress::start()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    startedM = wxDateTime::Now();
+    startMillisM = ::wxGetLocalTimeMillis();
+    stopMillisM = 0;
+    tableM.clear();
+    tableRecordsM = 0;
+    finishedRecordsM = 0;
+    indexM.clear();
+    indicesM = 0;
+    bytesWrittenM = -1;
+    completedM = false;
+    errorsM = false;
+}
+
+void BackupRestoreProgress::processLine(const wxString& line)
+{
+    BackupRestoreEvent event(BackupRestoreEvent::parse(line));
+    if (event.kind == BackupRestoreEvent::other)
+        return;
+
+    boost::lock_guard<boost::mutex> guard(lockM);
+    switch (event.kind)
+    {
+        case BackupRestoreEvent::tableData:
+            finishedRecordsM += tableRecordsM;
+            tableRecordsM = 0;
+            tableM = event.name;
+            indexM.clear();
+            break;
+        case BackupRestoreEvent::records:
+            // the count is for the whole table so far
+            tableRecordsM = event.count;
+            break;
+        case BackupRestoreEvent::index:
+            // a backup only writes the index definitions
+            if (operationM == operationRestore)
+            {
+                indexM = event.name;
+                ++indicesM;
+            }
+            break;
+        case BackupRestoreEvent::bytes:
+            bytesWrittenM = event.count;
+            break;
+        case BackupRestoreEvent::error:
+            errorsM = true;
+            break;
+        default:
+            break;
+    }
+}
+
+void BackupRestoreProgress::setCompleted()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    completedM = true;
+    stopMillisM = ::wxGetLocalTimeMillis();
+}
+
+void BackupRestoreProgress::stop()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    if (stopMillisM == 0)
+        stopMillisM = ::wxGetLocalTimeMillis();
+}
+
+int64_t BackupRestoreProgress::getFileSize() const
+{
+    if (fileM.empty() || !wxFileName::FileExists(fileM))
+        return -1;
+    wxULongLong size = wxFileName::GetSize(fileM);
+    if (size == wxInvalidSize)
+        return -1;
+    return int64_t(size.GetValue());
+}
+
+int64_t BackupRestoreProgress::getSeconds() const
+{
+    if (startMillisM == 0)
+        return 0;
+    wxLongLong stop(stopMillisM);
+    if (stop == 0)
+        stop = ::wxGetLocalTimeMillis();
+    return ((stop - startMillisM) / 1000).GetValue();
+}
+
+BackupRestoreProgress::Status BackupRestoreProgress::getStatus() const
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    Status status;
+    status.seconds = getSeconds();
+    status.records = finishedRecordsM + tableRecordsM;
+    status.bytes = getFileSize();
+    if (status.bytes < 0)
+        status.bytes = bytesWrittenM;
+    status.percent = -1;
+    status.remainingSeconds = -1;
+
+    // the work done so far, and the work expected in total
+    int64_t done = 0, expected = 0;
+    if (expectedRecordsM > 0)
+    {
+        done = status.records;
+        expected = expectedRecordsM;
+    }
+    else if (expectedBytesM > 0 && status.bytes >= 0)
+    {
+        done = status.bytes;
+        expected = expectedBytesM;
+    }
+
+    if (completedM)
+        status.percent = 100;
+    else if (expected > 0)
+    {
+        // metadata and indices are not accounted for, and the expected work
+        // is just an estimate, so never show the job as done before it is
+        status.percent = int(std::min(int64_t(99), done * 100 / expected));
+        if (done > 0 && done < expected && status.seconds > 0)
+        {
+            status.remainingSeconds =
+                (expected - done) * status.seconds / done;
+        }
+    }
+
+    bool backup = (operationM == operationBackup);
+    if (completedM)
+    {
+        status.phase = backup ? _("Backup completed.")
+            : _("Restore completed.");
+    }
+    else if (!indexM.empty())
+    {
+        status.phase = wxString::Format(_("Creating index %s (%u so far)"),
+            indexM.c_str(), indicesM);
+    }
+    else if (!tableM.empty())
+    {
+        status.phase = wxString::Format(backup
+                ? _("Writing data of table %s: %s records")
+                : _("Restoring data of table %s: %s records"),
+            tableM.c_str(), wxLongLong(tableRecordsM).ToString().c_str());
+        std::map<wxString, int64_t>::const_iterator it =
+            tableEstimatesM.find(tableM);
+        if (it != tableEstimatesM.end() && it->second > 0)
+        {
+            status.phase += wxString::Format(_(" of about %s"),
+                wxLongLong(it->second).ToString().c_str());
+        }
+    }
+    else
+        status.phase = backup ? _("Writing metadata") : _("Restoring metadata");
+    return status;
+}
+
+bool BackupRestoreProgress::isCompleted() const
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    return completedM;
+}
+
+bool BackupRestoreProgress::hasErrors() const
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    return errorsM;
+}
+
+BackupRestoreRun BackupRestoreProgress::getRun() const
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    BackupRestoreRun run;
+    run.started = startedM;
+    run.seconds = getSeconds();
+    run.records = finishedRecordsM + tableRecordsM;
+    run.bytes = getFileSize();
+    if (run.bytes < 0)
+        run.bytes = bytesWrittenM;
+    return run;
+}
+
+/*static*/
+void BackupRestoreProgress::estimateTableRecords(Database* database,
+    std::map<wxString, int64_t>& estimates)
+{
+    estimates.clear();
+    if (!database || !database->isConnected())
+        return;
+
+    wxMBConv* conv = database->getCharsetConverter();
+    MetadataLoader* loader = database->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+
+    // the selectivity of a unique index is 1 / number of records
+    IBPP::Statement& st1 = loader->getStatement(
+        "select i.rdb$relation_name, i.rdb$statistics from rdb$indices i"
+        " join rdb$relations r on r.rdb$relation_name = i.rdb$relation_name"
+        " where i.rdb$unique_flag = 1 and i.rdb$statistics > 0"
+        " and coalesce(r.rdb$system_flag, 0) = 0"
+        " and r.rdb$view_blr is null"
+    );
+    st1->Execute();
+    while (st1->Fetch())
+    {
+        std::string s;
+        st1->Get(1, s);
+        double selectivity;
+        st1->Get(2, selectivity);
+
+        int64_t& estimate = estimates[std2wxIdentifier(s, conv)];
+        estimate = std::max(estimate, int64_t(1.0 / selectivity + 0.5));
+    }
+}
@@ -0,0 +1,171 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_BACKUPRESTOREPROGRESS_H
+#define FR_BACKUPRESTOREPROGRESS_H
+
+#include <wx/datetime.h>
+#include <wx/string.h>
+
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <ibpp.h>
+
+class Database;
+
+// A line of the verbose output of a backup or restore through the services
+// API (the messages gbak shows with -v), reduced to the things that tell how
+// far the job has come.  Only the english messages are recognized, all other
+// lines are of kind other.
+struct BackupRestoreEvent
+{
+    enum Kind {
+        other,
+        tableData,  // data of table name is written / restored next
+        records,    // count records of the current table done so far
+        index,      // index name is written / created
+        bytes,      // count bytes have been written to the backup file
+        error       // the job reported an error
+    };
+
+    Kind kind;
+    wxString name;
+    int64_t count;
+
+    BackupRestoreEvent();
+    static BackupRestoreEvent parse(const wxString& line);
+};
+
+// A completed backup or restore, as kept in the history of a database.
+struct BackupRestoreRun
+{
+    wxDateTime started;
+    int64_t seconds;
+    int64_t records;
+    int64_t bytes;   // -1 if unknown
+
+    BackupRestoreRun();
+    double getRecordsPerSecond() const;
+    wxString toString() const;
+    bool fromString(const wxString& value);
+};
+
+enum BackupRestoreOperation { operationBackup, operationRestore };
+
+// The last runs of either operation for a database, stored in its settings.
+class BackupRestoreHistory
+{
+private:
+    Database* databaseM;
+    BackupRestoreOperation operationM;
+    std::vector<BackupRestoreRun> runsM;
+    wxString getConfigKey() const;
+public:
+    BackupRestoreHistory(Database* database,
+        BackupRestoreOperation operation);
+
+    // oldest run first
+    const std::vector<BackupRestoreRun>& getRuns() const;
+    void addRun(const BackupRestoreRun& run);
+    // averages the last count runs, returns false if there are none
+    bool getAverage(size_t count, BackupRestoreRun& average) const;
+};
+
+// Keeps track of a running backup or restore.  The worker thread feeds the
+// verbose output to processLine(), the frame asks for getStatus() whenever
+// it updates its display.  The percentage done and the remaining time are
+// based on the number of records expected (from an earlier run or the index
+// statistics of the tables) or else on the expected size of the file being
+// written.
+class BackupRestoreProgress
+{
+public:
+    struct Status
+    {
+        wxString phase;
+        int percent;    // -1 if unknown
+        int64_t seconds;
+        int64_t records;
+        int64_t bytes;  // -1 if unknown
+        int64_t remainingSeconds;   // -1 if unknown
+
+        wxString getStatistics() const;
+    };
+private:
+    mutable boost::mutex lockM;
+    BackupRestoreOperation operationM;
+    wxString fileM;
+    std::map<wxString, int64_t> tableEstimatesM;
+    int64_t expectedRecordsM;
+    int64_t expectedBytesM;
+    wxDateTime startedM;
+    wxLongLong startMillisM;
+    wxLongLong stopMillisM;
+
+    wxString tableM;
+    int64_t tableRecordsM;
+    int64_t finishedRecordsM;
+    wxString indexM;
+    unsigned indicesM;
+    int64_t bytesWrittenM;
+    bool completedM;
+    bool errorsM;
+
+    int64_t getFileSize() const;
+    int64_t getSeconds() const;
+public:
+    // file is the name of the file written by the job, if it can be
+    // accessed locally, its size is used as the number of bytes written
+    BackupRestoreProgress(BackupRestoreOperation operation,
+        const wxString& file);
+
+    // records and bytes are taken from an earlier run (0 if unknown), the
+    // sum of the table estimates is used if no record count is given
+    void setExpectedWork(int64_t records, int64_t bytes,
+        const std::map<wxString, int64_t>& tableEstimates);
+    void start();
+    // these are called by the worker thread
+    void processLine(const wxString& line);
+    void setCompleted();
+    void stop();
+
+    Status getStatus() const;
+    bool isCompleted() const;
+    // true if an ERROR: line was reported, even when the job finished
+    bool hasErrors() const;
+    BackupRestoreRun getRun() const;
+
+    // estimates the number of records of the user tables from the
+    // selectivity of their unique indices, so tables without unique index
+    // and indices with outdated statistics lead to wrong estimates
+    static void estimateTableRecords(Database* database,
+        std::map<wxString, int64_t>& estimates);
+};
+
+typedef boost::shared_ptr<BackupRestoreProgress> BackupRestoreProgressPtr;
+
+#endif // FR_BACKUPRESTOREPROGRESS_H
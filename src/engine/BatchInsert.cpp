@@ -0,0 +1,374 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+
+#include "core/FRError.h"
+#include "core/StringUtils.h"
+#include "engine/BatchInsert.h"
+#include "metadata/column.h"
+#include "metadata/database.h"
+#include "metadata/domain.h"
+
+// limits for the EXECUTE BLOCK statements inserting several rows, both the
+// statement text and the parameter message are kept below 64 kB
+static const int maxBlockRows = 256;
+static const int maxBlockSize = 48000;
+// maximum size of blob segments written
+static const int maxSegmentSize = 32768;
+
+ParameterValue::ParameterValue()
+    : type(pvNull), integer(0), number(0), date(0), time(0)
+{
+}
+
+ParameterValue::Type getParameterValueType(IBPP::SDT type)
+{
+    switch (type)
+    {
+        case IBPP::sdString:    return ParameterValue::pvString;
+        case IBPP::sdSmallint:  return ParameterValue::pvSmallint;
+        case IBPP::sdInteger:   return ParameterValue::pvInteger;
+        case IBPP::sdLargeint:  return ParameterValue::pvLargeint;
+        case IBPP::sdFloat:     return ParameterValue::pvFloat;
+        case IBPP::sdDouble:    return ParameterValue::pvDouble;
+        case IBPP::sdDate:      return ParameterValue::pvDate;
+        case IBPP::sdTime:      return ParameterValue::pvTime;
+        case IBPP::sdTimestamp: return ParameterValue::pvTimestamp;
+        case IBPP::sdBlob:      return ParameterValue::pvBlob;
+        case IBPP::sdArray:
+            throw FRError(_("Array datatype not supported"));
+        default:
+            return ParameterValue::pvNull;
+    }
+}
+
+void setParameter(IBPP::Statement& statement, int param,
+    const ParameterValue& value)
+{
+    switch (value.type)
+    {
+        case ParameterValue::pvString:
+            statement->Set(param, value.text);                  break;
+        case ParameterValue::pvSmallint:
+            statement->Set(param, int16_t(value.integer));      break;
+        case ParameterValue::pvInteger:
+            statement->Set(param, int32_t(value.integer));      break;
+        case ParameterValue::pvLargeint:
+            statement->Set(param, int64_t(value.integer));      break;
+        case ParameterValue::pvFloat:
+            statement->Set(param, float(value.number));         break;
+        case ParameterValue::pvDouble:
+            statement->Set(param, value.number);                break;
+        case ParameterValue::pvDate:
+            statement->Set(param, IBPP::Date(value.date));      break;
+        case ParameterValue::pvTime:
+            statement->Set(param, IBPP::Time(value.time));      break;
+        case ParameterValue::pvTimestamp:
+        {
+            IBPP::Timestamp ts;
+            ts.SetDate(value.date);
+            ts.SetTime(value.time);
+            statement->Set(param, ts);
+            break;
+        }
+        case ParameterValue::pvBlob:
+        {
+            IBPP::Blob blob = IBPP::BlobFactory(statement->DatabasePtr(),
+                statement->TransactionPtr());
+            blob->Create();
+            for (size_t pos = 0; pos < value.text.size();
+                pos += maxSegmentSize)
+            {
+                int size = int(std::min(value.text.size() - pos,
+                    size_t(maxSegmentSize)));
+                blob->Write(value.text.data() + pos, size);
+            }
+            blob->Close();
+            statement->Set(param, blob);
+            break;
+        }
+        default:
+            statement->SetNull(param);
+    }
+}
+
+void getColumnValue(IBPP::Statement& statement, int col,
+    ParameterValue::Type type, ParameterValue& value)
+{
+    value.type = statement->IsNull(col) ? ParameterValue::pvNull : type;
+    switch (value.type)
+    {
+        case ParameterValue::pvString:
+        case ParameterValue::pvBlob:
+            // blobs are loaded completely
+            statement->Get(col, value.text);
+            break;
+        case ParameterValue::pvSmallint:
+        {
+            int16_t i;
+            statement->Get(col, i);
+            value.integer = i;
+            break;
+        }
+        case ParameterValue::pvInteger:
+        {
+            int32_t i;
+            statement->Get(col, i);
+            value.integer = i;
+            break;
+        }
+        case ParameterValue::pvLargeint:
+        {
+            int64_t i;
+            statement->Get(col, i);
+            value.integer = i;
+            break;
+        }
+        case ParameterValue::pvFloat:
+        {
+            float f;
+            statement->Get(col, f);
+            value.number = f;
+            break;
+        }
+        case ParameterValue::pvDouble:
+            statement->Get(col, value.number);
+            break;
+        case ParameterValue::pvDate:
+        {
+            IBPP::Date d;
+            statement->Get(col, d);
+            value.date = d.GetDate();
+            break;
+        }
+        case ParameterValue::pvTime:
+        {
+            IBPP::Time t;
+            statement->Get(col, t);
+            value.time = t.GetTime();
+            break;
+        }
+        case ParameterValue::pvTimestamp:
+        {
+            IBPP::Timestamp ts;
+            statement->Get(col, ts);
+            value.date = ts.GetDate();
+            value.time = ts.GetTime();
+            break;
+        }
+        default:
+            value.type = ParameterValue::pvNull;
+    }
+}
+
+// returns the declaration of an EXECUTE BLOCK parameter for the column,
+// or an empty string if it can't be declared
+static wxString getParameterDeclaration(Column* column)
+{
+    DomainPtr d = column->getDomain();
+    if (!d)
+        return wxEmptyString;
+    if (!d->isSystem())
+        return d->getQuotedName();
+    wxString declaration(d->getDatatypeAsString());
+    wxString charset(d->getCharset());
+    if (!charset.IsEmpty())
+        declaration += " CHARACTER SET " + charset;
+    return declaration;
+}
+
+void createBatchInsertSql(Database* database, IBPP::Transaction& transaction,
+    const wxString& tableName, const std::vector<Column*>& columns,
+    int maxRows, BatchInsertSql& sql)
+{
+    IBPP::Database db(database->getIBPPDatabase());
+    wxMBConv* converter = database->getCharsetConverter();
+
+    wxString columnList, params;
+    std::vector<wxString> declarations;
+    bool declared = true;
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        if (i)
+        {
+            columnList += ", ";
+            params += ",";
+        }
+        columnList += columns[i]->getQuotedName();
+        params += "?";
+        declarations.push_back(getParameterDeclaration(columns[i]));
+        if (declarations.back().IsEmpty())
+            declared = false;
+    }
+    wxString insert = "INSERT INTO " + tableName + " (" + columnList
+        + ") VALUES (";
+    sql.insertSql = wx2std(insert + params + ")", converter);
+    sql.blockSql.clear();
+    sql.blockRows = 1;
+
+    IBPP::Statement st = IBPP::StatementFactory(db, transaction);
+    st->Prepare(sql.insertSql);
+    sql.types.clear();
+    sql.scales.clear();
+    int rowSize = 0;
+    for (int p = 1; p <= st->Parameters(); ++p)
+    {
+        sql.types.push_back(getParameterValueType(st->ParameterType(p)));
+        sql.scales.push_back(st->ParameterScale(p));
+        // data plus null indicator, aligned
+        rowSize += st->ParameterSize(p) + 8;
+    }
+    if (!declared)
+        return;
+
+    int rowSqlSize = insert.Length();
+    for (size_t i = 0; i < declarations.size(); ++i)
+        rowSqlSize += declarations[i].Length() + 30;
+    int rows = std::min(std::min(maxBlockRows, maxRows),
+        maxBlockSize / std::max(1, std::max(rowSize, rowSqlSize)));
+    if (rows < 2)
+        return;
+
+    wxString decls, body;
+    for (int r = 1; r <= rows; ++r)
+    {
+        wxString values;
+        for (size_t i = 0; i < declarations.size(); ++i)
+        {
+            wxString name(wxString::Format("P%d_%d", r, int(i + 1)));
+            if (!decls.IsEmpty())
+                decls += ", ";
+            decls += name + " " + declarations[i] + " = ?";
+            if (i)
+                values += ", ";
+            values += ":" + name;
+        }
+        body += "  " + insert + values + ");\n";
+    }
+    std::string blockSql(wx2std("EXECUTE BLOCK (" + decls + ")\nAS\nBEGIN\n"
+        + body + "END", converter));
+    try
+    {
+        IBPP::Statement block = IBPP::StatementFactory(db, transaction);
+        block->Prepare(blockSql);
+    }
+    catch (IBPP::Exception&)
+    {
+        return;
+    }
+    sql.blockSql = blockSql;
+    sql.blockRows = rows;
+}
+
+BatchInserter::BatchInserter(IBPP::Database& database,
+        IBPP::Transaction& transaction, const BatchInsertSql& sql)
+    : blockRowsM(sql.blockRows), columnsM(sql.types.size())
+{
+    insertM = IBPP::StatementFactory(database, transaction);
+    insertM->Prepare(sql.insertSql);
+    if (blockRowsM > 1)
+    {
+        blockM = IBPP::StatementFactory(database, transaction);
+        blockM->Prepare(sql.blockSql);
+    }
+}
+
+int BatchInserter::getBlockRows() const
+{
+    return blockRowsM;
+}
+
+void BatchInserter::insert(const ParameterValue* values, int rows)
+{
+    while (blockRowsM > 1 && rows >= blockRowsM)
+    {
+        for (int i = 0; i < blockRowsM * columnsM; ++i)
+            setParameter(blockM, i + 1, values[i]);
+        blockM->Execute();
+        values += blockRowsM * columnsM;
+        rows -= blockRowsM;
+    }
+    for (; rows > 0; --rows, values += columnsM)
+        insertRow(values);
+}
+
+void BatchInserter::insertRow(const ParameterValue* values)
+{
+    for (int i = 0; i < columnsM; ++i)
+        setParameter(insertM, i + 1, values[i]);
+    insertM->Execute();
+}
+
+RowBatchQueue::RowBatchQueue(size_t maxBatches)
+    : maxBatchesM(maxBatches), closedM(false), canceledM(false)
+{
+}
+
+bool RowBatchQueue::push(RowBatchPtr batch)
+{
+    boost::unique_lock<boost::mutex> lock(lockM);
+    while (!canceledM && batchesM.size() >= maxBatchesM)
+        changedM.wait(lock);
+    if (canceledM)
+        return false;
+    batchesM.push_back(batch);
+    changedM.notify_all();
+    return true;
+}
+
+bool RowBatchQueue::pop(RowBatchPtr& batch)
+{
+    boost::unique_lock<boost::mutex> lock(lockM);
+    while (!canceledM && !closedM && batchesM.empty())
+        changedM.wait(lock);
+    if (canceledM || batchesM.empty())
+        return false;
+    batch = batchesM.front();
+    batchesM.pop_front();
+    changedM.notify_all();
+    return true;
+}
+
+void RowBatchQueue::close()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    closedM = true;
+    changedM.notify_all();
+}
+
+void RowBatchQueue::cancel()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    canceledM = true;
+    changedM.notify_all();
+}
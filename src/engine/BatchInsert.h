@@ -0,0 +1,140 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_BATCHINSERT_H
+#define FR_BATCHINSERT_H
+
+#include <wx/string.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <ibpp.h>
+
+class Column;
+class Database;
+
+// A parameter value, the type determines the IBPP::Statement::Set() method
+// used for it.  Dates and times are stored as IBPP date and time values,
+// blob values are stored as text and written to a new blob on insert.
+struct ParameterValue
+{
+    enum Type { pvNull, pvString, pvSmallint, pvInteger, pvLargeint,
+        pvFloat, pvDouble, pvDate, pvTime, pvTimestamp, pvBlob };
+    Type type;
+    std::string text;
+    int64_t integer;
+    double number;
+    int date;
+    int time;
+
+    ParameterValue();
+};
+
+// returns the value type for parameters of the given type, throws for
+// array parameters
+ParameterValue::Type getParameterValueType(IBPP::SDT type);
+void setParameter(IBPP::Statement& statement, int param,
+    const ParameterValue& value);
+// reads a column of the current row as value of the given type, numbers are
+// read unscaled so the column scale has to match the parameter scale
+void getColumnValue(IBPP::Statement& statement, int col,
+    ParameterValue::Type type, ParameterValue& value);
+
+// Statements to insert rows into some columns of a table.  They are created
+// in the main thread and executed by a BatchInserter in a worker thread.
+// Several rows are inserted at once with an EXECUTE BLOCK statement, if the
+// server (or a parameter type) doesn't support that blockRows is 1.
+struct BatchInsertSql
+{
+    std::string insertSql;
+    std::string blockSql;
+    int blockRows;
+    // parameter types and scales of the columns
+    std::vector<ParameterValue::Type> types;
+    std::vector<int> scales;
+};
+
+// the statements are prepared on the transaction to check them, blocks
+// have at most maxRows rows
+void createBatchInsertSql(Database* database, IBPP::Transaction& transaction,
+    const wxString& tableName, const std::vector<Column*>& columns,
+    int maxRows, BatchInsertSql& sql);
+
+class BatchInserter
+{
+private:
+    IBPP::Statement insertM;
+    IBPP::Statement blockM;
+    int blockRowsM;
+    int columnsM;
+public:
+    // prepares the statements on the attachment and transaction of the
+    // calling thread
+    BatchInserter(IBPP::Database& database, IBPP::Transaction& transaction,
+        const BatchInsertSql& sql);
+
+    int getBlockRows() const;
+    // the values of a row are consecutive, rows are inserted blockwise
+    // as long as possible
+    void insert(const ParameterValue* values, int rows);
+    void insertRow(const ParameterValue* values);
+};
+
+// Rows of parameter values, the values of a row are consecutive.
+struct RowBatch
+{
+    int rows;
+    std::vector<ParameterValue> values;
+};
+
+typedef boost::shared_ptr<RowBatch> RowBatchPtr;
+
+// Bounded queue between a thread producing rows and the thread inserting
+// them.
+class RowBatchQueue
+{
+private:
+    boost::mutex lockM;
+    boost::condition_variable changedM;
+    std::deque<RowBatchPtr> batchesM;
+    size_t maxBatchesM;
+    bool closedM;
+    bool canceledM;
+public:
+    RowBatchQueue(size_t maxBatches);
+
+    // waits while the queue is full, returns false if it has been canceled
+    bool push(RowBatchPtr batch);
+    // waits for the next batch, returns false if there are no more batches
+    bool pop(RowBatchPtr& batch);
+    // called by the producing thread after the last batch
+    void close();
+    void cancel();
+};
+
+#endif // FR_BATCHINSERT_H
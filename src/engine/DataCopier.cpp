@@ -0,0 +1,600 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+#include <limits>
+
+#include <boost/bind.hpp>
+
+#include "core/FRError.h"
+#include "core/ProgressIndicator.h"
+#include "core/StringUtils.h"
+#include "engine/BatchInsert.h"
+#include "engine/DataCopier.h"
+#include "engine/SharedAttachment.h"
+#include "metadata/column.h"
+#include "metadata/constraints.h"
+#include "metadata/database.h"
+#include "metadata/domain.h"
+#include "metadata/table.h"
+
+// number of tables that are copied at the same time
+static const size_t maxConcurrentTables = 4;
+// number of rows read at once when rows are inserted one at a time
+static const int minBatchRows = 64;
+// number of batches read in advance
+static const size_t maxQueuedBatches = 8;
+
+struct DataCopier::TableJob
+{
+    wxString name;
+    Table* target;
+    std::vector<Column*> sourceColumns;
+    std::vector<Column*> targetColumns;
+
+    // set up in the main thread when the level is started
+    std::string countSql;
+    std::string selectSql;
+    BatchInsertSql sql;
+    // text is converted between the connection character sets for these
+    // columns, every job has its own converters
+    std::vector<bool> transcode;
+    boost::shared_ptr<wxMBConv> sourceConverter;
+    boost::shared_ptr<wxMBConv> targetConverter;
+
+    // protected by the mutex of the DataCopier
+    int64_t records;    // -1 until the rows have been counted
+    int64_t copied;
+    size_t slot;
+    bool running;
+    bool done;
+
+    // main thread only
+    wxLongLong started;
+};
+
+// returns the type of the column for use in a CAST
+static wxString getColumnType(Column* column)
+{
+    DomainPtr d = column->getDomain();
+    if (!d)
+        return wxEmptyString;
+    wxString type(d->getDatatypeAsString());
+    wxString charset(d->getCharset());
+    if (!charset.IsEmpty() && (d->isString() || type.EndsWith(" 1")))
+        type += " CHARACTER SET " + charset;
+    return type;
+}
+
+// text columns and text blobs
+static bool isTextColumn(Column* column)
+{
+    DomainPtr d = column->getDomain();
+    return d && (d->isString() || !d->getCharset().IsEmpty());
+}
+
+DataCopier::DataCopier(Database* source, Database* target,
+        unsigned commitInterval)
+    : sourceM(source), targetM(target), commitIntervalM(commitInterval),
+        nextJobM(0), runningM(0), copiedM(0), committedM(0), cancelM(false)
+{
+}
+
+DataCopier::~DataCopier()
+{
+    for (size_t i = 0; i < sourceAttachmentsM.size(); ++i)
+        disconnectAttachment(sourceAttachmentsM[i]);
+    for (size_t i = 0; i < targetAttachmentsM.size(); ++i)
+        disconnectAttachment(targetAttachmentsM[i]);
+}
+
+bool DataCopier::addTable(Table* source, Table* target)
+{
+    TableJobPtr job(new TableJob);
+    source->ensureChildrenLoaded();
+    target->ensureChildrenLoaded();
+    for (ColumnPtrs::const_iterator it = target->begin();
+        it != target->end(); ++it)
+    {
+        if (!(*it)->getComputedSource().IsEmpty())
+            continue;
+        ColumnPtr column(source->findColumn((*it)->getName_()));
+        if (!column)
+            continue;
+        job->sourceColumns.push_back(column.get());
+        job->targetColumns.push_back((*it).get());
+    }
+    if (job->targetColumns.empty())
+        return false;
+
+    job->name = target->getName_();
+    job->target = target;
+    job->sql.blockRows = 1;
+    job->records = -1;
+    job->copied = 0;
+    job->slot = 0;
+    job->running = false;
+    job->done = false;
+
+    wxMBConv* converter = sourceM->getCharsetConverter();
+    job->countSql = wx2std("SELECT COUNT(*) FROM "
+        + source->getQuotedName(), converter);
+    wxString select;
+    for (size_t i = 0; i < job->sourceColumns.size(); ++i)
+    {
+        Column* s = job->sourceColumns[i];
+        wxString type(getColumnType(job->targetColumns[i]));
+        if (!select.IsEmpty())
+            select += ", ";
+        if (type.IsEmpty() || type == getColumnType(s))
+            select += s->getQuotedName();
+        else
+            select += "CAST(" + s->getQuotedName() + " AS " + type + ")";
+    }
+    job->selectSql = wx2std("SELECT " + select + " FROM "
+        + source->getQuotedName(), converter);
+    jobsM.push_back(job);
+    return true;
+}
+
+// the tables are sorted into levels, the tables of a level only depend on
+// tables of the previous levels (or on tables that aren't copied)
+void DataCopier::sortJobs(std::vector<std::vector<TableJobPtr> >& levels)
+{
+    std::vector<Table*> tables;
+    for (std::vector<TableJobPtr>::iterator it = jobsM.begin();
+        it != jobsM.end(); ++it)
+    {
+        tables.push_back((*it)->target);
+    }
+    Table::loadConstraintsOf(targetM->getDatabase(), tables);
+
+    std::vector<TableJobPtr> remaining(jobsM);
+    std::vector<std::vector<wxString> > dependsOn;
+    for (std::vector<TableJobPtr>::iterator it = remaining.begin();
+        it != remaining.end(); ++it)
+    {
+        std::vector<wxString> names;
+        std::vector<ForeignKey>* fks = (*it)->target->getForeignKeys();
+        for (std::vector<ForeignKey>::iterator fk = fks->begin();
+            fk != fks->end(); ++fk)
+        {
+            wxString name(Identifier((*fk).getReferencedTable()).getQuoted());
+            if (name == (*it)->target->getQuotedName())  // self reference
+                continue;
+            for (std::vector<Table*>::iterator t = tables.begin();
+                t != tables.end(); ++t)
+            {
+                if ((*t)->getQuotedName() == name)
+                    names.push_back(name);
+            }
+        }
+        dependsOn.push_back(names);
+    }
+
+    while (!remaining.empty())
+    {
+        std::vector<TableJobPtr> level;
+        for (size_t i = 0; i < remaining.size(); )
+        {
+            if (!dependsOn[i].empty())
+            {
+                ++i;
+                continue;
+            }
+            level.push_back(remaining[i]);
+            remaining.erase(remaining.begin() + i);
+            dependsOn.erase(dependsOn.begin() + i);
+        }
+        if (level.empty())
+        {
+            throw FRError(_("A circular dependency was detected among the tables, the order for copying them can't be determined."));
+        }
+        for (std::vector<TableJobPtr>::iterator it = level.begin();
+            it != level.end(); ++it)
+        {
+            wxString name((*it)->target->getQuotedName());
+            for (size_t i = 0; i < dependsOn.size(); ++i)
+            {
+                dependsOn[i].erase(std::remove(dependsOn[i].begin(),
+                    dependsOn[i].end(), name), dependsOn[i].end());
+            }
+        }
+        levels.push_back(level);
+    }
+}
+
+// sets up the statements of the table and checks them, called in the main
+// thread
+void DataCopier::prepareJob(TableJob& job,
+    IBPP::Transaction& sourceTransaction,
+    IBPP::Transaction& targetTransaction)
+{
+    createBatchInsertSql(targetM, targetTransaction,
+        job.target->getQuotedName(), job.targetColumns,
+        std::numeric_limits<int>::max(), job.sql);
+    IBPP::Statement st = IBPP::StatementFactory(sourceM->getIBPPDatabase(),
+        sourceTransaction);
+    st->Prepare(job.selectSql);
+    if (st->Columns() != int(job.sql.types.size()))
+        throw FRError(_("Columns don't match in table ") + job.name);
+
+    bool differentCharsets = sourceM->getConnectionCharset().Upper()
+        != targetM->getConnectionCharset().Upper();
+    job.transcode.clear();
+    for (size_t i = 0; i < job.targetColumns.size(); ++i)
+    {
+        job.transcode.push_back(differentCharsets
+            && isTextColumn(job.targetColumns[i]));
+    }
+    // wxMBConv objects must not be shared between threads
+    job.sourceConverter.reset(sourceM->getCharsetConverter()->Clone());
+    job.targetConverter.reset(targetM->getCharsetConverter()->Clone());
+}
+
+bool DataCopier::run(ProgressIndicator* progressIndicator)
+{
+    std::vector<std::vector<TableJobPtr> > levels;
+    sortJobs(levels);
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        IBPP::Transaction sourceTr =
+            IBPP::TransactionFactory(sourceM->getIBPPDatabase(), IBPP::amRead);
+        IBPP::Transaction targetTr =
+            IBPP::TransactionFactory(targetM->getIBPPDatabase());
+        sourceTr->Start();
+        targetTr->Start();
+        for (std::vector<TableJobPtr>::iterator it = levels[i].begin();
+            it != levels[i].end(); ++it)
+        {
+            if (progressIndicator)
+            {
+                progressIndicator->setProgressMessage(
+                    _("Preparing ") + (*it)->name);
+                if (progressIndicator->isCanceled())
+                    return false;
+            }
+            prepareJob(*(*it), sourceTr, targetTr);
+        }
+        sourceTr->Commit();
+        targetTr->Commit();
+
+        if (!copyLevel(levels[i], progressIndicator))
+            return false;
+    }
+    return true;
+}
+
+bool DataCopier::copyLevel(const std::vector<TableJobPtr>& level,
+    ProgressIndicator* progressIndicator)
+{
+    size_t count = std::min(level.size(), maxConcurrentTables);
+    while (sourceAttachmentsM.size() < count)
+    {
+        IBPP::Database source(sourceM->createSecondaryAttachment());
+        source->Connect();
+        sourceAttachmentsM.push_back(source);
+        IBPP::Database target(targetM->createSecondaryAttachment());
+        target->Connect();
+        targetAttachmentsM.push_back(target);
+    }
+
+    {
+        boost::lock_guard<boost::mutex> guard(lockM);
+        pendingM = level;
+        nextJobM = 0;
+        runningM = count;
+    }
+    boost::thread_group threads;
+    for (size_t i = 0; i < count; ++i)
+    {
+        threads.create_thread(boost::bind(&DataCopier::copyTables, this, i,
+            sourceAttachmentsM[i], targetAttachmentsM[i]));
+    }
+
+    while (true)
+    {
+        size_t running;
+        {
+            boost::lock_guard<boost::mutex> guard(lockM);
+            running = runningM;
+        }
+        if (progressIndicator)
+        {
+            updateProgress(level, progressIndicator);
+            if (progressIndicator->isCanceled())
+            {
+                boost::lock_guard<boost::mutex> guard(lockM);
+                cancelM = true;
+            }
+        }
+        if (!running)
+            break;
+        wxMilliSleep(50);
+    }
+    threads.join_all();
+
+    boost::lock_guard<boost::mutex> guard(lockM);
+    if (!errorM.empty())
+        throw FRError(errorM);
+    return !cancelM;
+}
+
+// shows the overall progress on the first level and the rate and estimated
+// remaining time of the running tables on the others
+void DataCopier::updateProgress(const std::vector<TableJobPtr>& level,
+    ProgressIndicator* progressIndicator)
+{
+    wxLongLong now(wxGetLocalTimeMillis());
+    std::vector<wxString> messages(maxConcurrentTables);
+    std::vector<int> positions(maxConcurrentTables, -1);
+    size_t done = 0;
+    int64_t copied;
+    {
+        boost::lock_guard<boost::mutex> guard(lockM);
+        copied = copiedM;
+        for (std::vector<TableJobPtr>::const_iterator it = level.begin();
+            it != level.end(); ++it)
+        {
+            TableJob& job(*(*it));
+            if (job.done)
+                ++done;
+            if (!job.running)
+                continue;
+            if (job.started == 0)
+                job.started = now;
+            double seconds = (now - job.started).ToDouble() / 1000.0;
+            int64_t rate = (seconds > 0) ? int64_t(job.copied / seconds) : 0;
+            wxString message(job.name + ": "
+                + wxLongLong(job.copied).ToString());
+            if (job.records >= 0)
+            {
+                message += " / " + wxLongLong(job.records).ToString();
+                positions[job.slot] = job.records
+                    ? int(job.copied * 1000 / job.records) : 1000;
+            }
+            message += wxString::Format(_(" records, %s per second"),
+                wxLongLong(rate).ToString().c_str());
+            if (job.records >= 0 && rate > 0)
+            {
+                message += ", " + formatDuration((job.records - job.copied)
+                    / rate) + _(" remaining");
+            }
+            messages[job.slot] = message;
+        }
+    }
+
+    progressIndicator->initProgress(wxString::Format(
+        _("Copied %d of %d tables, %s records."), int(done),
+        int(level.size()), wxLongLong(copied).ToString().c_str()),
+        level.size(), done);
+    for (size_t i = 0; i < maxConcurrentTables; ++i)
+    {
+        if (!messages[i].IsEmpty() && positions[i] < 0)
+            progressIndicator->initProgressIndeterminate(messages[i], i + 2);
+        else
+        {
+            progressIndicator->initProgress(messages[i], 1000,
+                std::max(0, positions[i]), i + 2);
+        }
+    }
+}
+
+int64_t DataCopier::getCopiedRecords()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    return copiedM;
+}
+
+int64_t DataCopier::getCommittedRecords()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    return committedM;
+}
+
+size_t DataCopier::getProgressLevelCount()
+{
+    return 1 + maxConcurrentTables;
+}
+
+DataCopier::TableJobPtr DataCopier::getNextJob(size_t slot)
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    if (cancelM || nextJobM >= pendingM.size())
+        return TableJobPtr();
+    TableJobPtr job(pendingM[nextJobM++]);
+    job->slot = slot;
+    job->running = true;
+    return job;
+}
+
+bool DataCopier::isCanceled()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    return cancelM;
+}
+
+// the first error cancels all other threads
+void DataCopier::setError(const std::string& error)
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    if (errorM.empty())
+        errorM = error;
+    cancelM = true;
+}
+
+// worker thread, copies tables of the current level until there are none
+// left, inserting all of them in one transaction
+void DataCopier::copyTables(size_t slot, IBPP::Database source,
+    IBPP::Database target)
+{
+    try
+    {
+        IBPP::Transaction tr = IBPP::TransactionFactory(target);
+        tr->Start();
+        unsigned uncommitted = 0;
+        TableJobPtr job;
+        while ((job = getNextJob(slot)))
+            copyTable(job, source, target, tr, uncommitted);
+        if (isCanceled())
+            tr->Rollback();
+        else
+            commit(tr, uncommitted);
+    }
+    catch (std::exception& e)
+    {
+        setError(e.what());
+    }
+    catch (...)
+    {
+        setError("Unknown error while copying data");
+    }
+
+    boost::lock_guard<boost::mutex> guard(lockM);
+    --runningM;
+}
+
+void DataCopier::copyTable(TableJobPtr job, IBPP::Database& source,
+    IBPP::Database& target, IBPP::Transaction& transaction,
+    unsigned& uncommitted)
+{
+    BatchInserter inserter(target, transaction, job->sql);
+    int columns = job->sql.types.size();
+
+    RowBatchQueue queue(maxQueuedBatches);
+    boost::thread reader(boost::bind(&DataCopier::readRows, this, job,
+        source, &queue));
+    try
+    {
+        RowBatchPtr batch;
+        while (!isCanceled() && queue.pop(batch))
+        {
+            for (int row = 0; row < batch->rows; )
+            {
+                int rows = std::min(batch->rows - row,
+                    inserter.getBlockRows());
+                inserter.insert(&batch->values[row * columns], rows);
+                row += rows;
+
+                uncommitted += rows;
+                if (commitIntervalM && uncommitted >= commitIntervalM)
+                {
+                    commit(transaction, uncommitted);
+                    transaction->Start();
+                }
+            }
+            boost::lock_guard<boost::mutex> guard(lockM);
+            job->copied += batch->rows;
+            copiedM += batch->rows;
+        }
+    }
+    catch (...)
+    {
+        queue.cancel();
+        reader.join();
+        throw;
+    }
+    queue.cancel();
+    reader.join();
+
+    boost::lock_guard<boost::mutex> guard(lockM);
+    job->running = false;
+    job->done = true;
+}
+
+// commits the transaction of a worker thread and counts its records as
+// committed
+void DataCopier::commit(IBPP::Transaction& transaction, unsigned& uncommitted)
+{
+    transaction->Commit();
+    boost::lock_guard<boost::mutex> guard(lockM);
+    committedM += uncommitted;
+    uncommitted = 0;
+}
+
+// reader thread of a table, stops early if the queue is canceled
+void DataCopier::readRows(TableJobPtr job, IBPP::Database source,
+    RowBatchQueue* queue)
+{
+    try
+    {
+        IBPP::Transaction tr = IBPP::TransactionFactory(source,
+            IBPP::amRead);
+        tr->Start();
+        IBPP::Statement st = IBPP::StatementFactory(source, tr);
+        st->Execute(job->countSql);
+        int64_t records = 0;
+        if (st->Fetch())
+            st->Get(1, records);
+        {
+            boost::lock_guard<boost::mutex> guard(lockM);
+            job->records = records;
+        }
+
+        st->Execute(job->selectSql);
+        int columns = job->sql.types.size();
+        int batchRows = std::max(job->sql.blockRows, minBatchRows);
+        bool more = true;
+        while (more)
+        {
+            RowBatchPtr batch(new RowBatch);
+            batch->rows = 0;
+            batch->values.resize(batchRows * columns);
+            ParameterValue* value = &batch->values[0];
+            while (batch->rows < batchRows && (more = st->Fetch()))
+            {
+                for (int c = 0; c < columns; ++c, ++value)
+                {
+                    getColumnValue(st, c + 1, job->sql.types[c], *value);
+                    if (job->transcode[c]
+                        && value->type != ParameterValue::pvNull)
+                    {
+                        wxString s(value->text.data(),
+                            *job->sourceConverter, value->text.size());
+                        value->text = wx2std(s, job->targetConverter.get());
+                    }
+                }
+                ++batch->rows;
+            }
+            if (batch->rows && !queue->push(batch))
+                return;
+        }
+        tr->Commit();
+    }
+    catch (std::exception& e)
+    {
+        setError(e.what());
+        queue->cancel();
+        return;
+    }
+    queue->close();
+}
@@ -0,0 +1,116 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_DATACOPIER_H
+#define FR_DATACOPIER_H
+
+#include <wx/string.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <ibpp.h>
+
+class Database;
+class ProgressIndicator;
+class RowBatchQueue;
+class Table;
+
+// Copies the data of tables into tables of another database.  Columns are
+// matched by name, values are converted by the source server (with a CAST
+// to the type of the target column where the types differ).  The tables
+// are copied in the order of their foreign keys in the target database,
+// tables that don't depend on each other at the same time.  For every
+// table one thread reads batches of rows on a secondary attachment to the
+// source database, another one inserts them on a secondary attachment to
+// the target database, with a bounded queue in between.
+class DataCopier
+{
+private:
+    struct TableJob;
+    typedef boost::shared_ptr<TableJob> TableJobPtr;
+
+    Database* sourceM;
+    Database* targetM;
+    unsigned commitIntervalM;
+    std::vector<TableJobPtr> jobsM;
+    std::vector<IBPP::Database> sourceAttachmentsM;
+    std::vector<IBPP::Database> targetAttachmentsM;
+
+    // state shared with the worker threads
+    boost::mutex lockM;
+    std::vector<TableJobPtr> pendingM;
+    size_t nextJobM;
+    size_t runningM;
+    int64_t copiedM;
+    int64_t committedM;
+    bool cancelM;
+    std::string errorM;
+
+    void sortJobs(std::vector<std::vector<TableJobPtr> >& levels);
+    void prepareJob(TableJob& job, IBPP::Transaction& sourceTransaction,
+        IBPP::Transaction& targetTransaction);
+    bool copyLevel(const std::vector<TableJobPtr>& level,
+        ProgressIndicator* progressIndicator);
+    void updateProgress(const std::vector<TableJobPtr>& level,
+        ProgressIndicator* progressIndicator);
+
+    // run in worker threads
+    void copyTables(size_t slot, IBPP::Database source,
+        IBPP::Database target);
+    void copyTable(TableJobPtr job, IBPP::Database& source,
+        IBPP::Database& target, IBPP::Transaction& transaction,
+        unsigned& uncommitted);
+    void commit(IBPP::Transaction& transaction, unsigned& uncommitted);
+    void readRows(TableJobPtr job, IBPP::Database source,
+        RowBatchQueue* queue);
+    TableJobPtr getNextJob(size_t slot);
+    bool isCanceled();
+    void setError(const std::string& error);
+public:
+    // commitInterval is the number of records after which the transactions
+    // are committed, with 0 they are committed after all tables that don't
+    // depend on each other have been copied
+    DataCopier(Database* source, Database* target,
+        unsigned commitInterval = 0);
+    ~DataCopier();
+
+    // copies the columns of the target table that have the same name as a
+    // column of the source table, returns false if there are none
+    bool addTable(Table* source, Table* target);
+
+    // the progress indicator should have getProgressLevelCount() levels,
+    // one for the whole copy and one for every table copied at the same
+    // time, returns false if canceled
+    bool run(ProgressIndicator* progressIndicator = 0);
+    int64_t getCopiedRecords();
+    // records committed so far, they stay in the target database when the
+    // copy is canceled or fails
+    int64_t getCommittedRecords();
+    static size_t getProgressLevelCount();
+};
+
+#endif // FR_DATACOPIER_H
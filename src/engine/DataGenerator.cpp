@@ -0,0 +1,997 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/txtstrm.h>
+#include <wx/wfstream.h>
+
+#include <algorithm>
+#include <ctime>
+
+#include <boost/bind.hpp>
+
+#include "core/FRError.h"
+#include "core/ProgressIndicator.h"
+#include "core/StringUtils.h"
+#include "engine/BatchInsert.h"
+#include "engine/DataGenerator.h"
+#include "engine/SharedAttachment.h"
+#include "metadata/column.h"
+#include "metadata/database.h"
+#include "metadata/table.h"
+#include "Isaac.h"
+
+// number of tables of a level that are filled at the same time
+static const size_t maxConcurrentTables = 4;
+// number of rows generated at once when rows are inserted one at a time
+static const int minBatchRows = 64;
+// number of batches generated in advance
+static const size_t maxQueuedBatches = 4;
+
+// every generator thread has its own stream of random numbers
+class RandomStream
+{
+private:
+    Isaac isaacM;
+public:
+    RandomStream(const unsigned long* seed, int count)
+        : isaacM(seed, count)
+    {
+    }
+
+    // returns a value between 0 and (maxval-1)
+    int next(double maxval)
+    {
+        return (int)(maxval * isaacM.getRandom() / 4294967296.0);
+    }
+};
+
+// dd.mm.yyyy
+static void str2date(const wxString& str, int& date)
+{
+    long d,m,y;
+    if (!str.Mid(0,2).ToLong(&d) || !str.Mid(3,2).ToLong(&m) ||
+        !str.Mid(6,4).ToLong(&y) || !IBPP::itod(&date, y,m,d))
+    {
+        throw FRError(_("Invalid date: ") + str);
+    }
+}
+
+// HH:MM:SS
+static void str2time(const wxString& str, int& mytime)
+{
+    long h = 0, m = 0, s = 0;
+    if (!str.Mid(0, 2).ToLong(&h) || !str.Mid(3, 2).ToLong(&m)
+        || !str.Mid(6, 2).ToLong(&s))
+    {
+        throw FRError(_("Invalid time: ") + str);
+    }
+    IBPP::itot(&mytime, h, m, s, 0);
+}
+
+// returns the comma separated parts of the range
+static std::vector<wxString> splitRange(const wxString& range)
+{
+    std::vector<wxString> parts;
+    size_t start = 0;
+    while (start < range.Length())
+    {
+        size_t p = range.find(",", start);
+        if (p == wxString::npos)
+            p = range.Length();
+        parts.push_back(range.Mid(start, p - start));
+        start = p + 1;
+    }
+    return parts;
+}
+
+// All value sources are set up completely before the rows are generated,
+// getValue() is called from the generator threads and must not modify the
+// source.
+class ValueSource
+{
+public:
+    virtual ~ValueSource() {}
+    virtual void getValue(int recNo, RandomStream& random,
+        ParameterValue& value) const = 0;
+};
+
+typedef boost::shared_ptr<ValueSource> ValueSourcePtr;
+
+// values read from a file or copied from another column
+class ListValueSource: public ValueSource
+{
+private:
+    std::vector<ParameterValue> valuesM;
+    bool randomM;
+public:
+    ListValueSource(bool random)
+        : randomM(random)
+    {
+    }
+
+    void add(const ParameterValue& value)
+    {
+        valuesM.push_back(value);
+    }
+
+    size_t size() const
+    {
+        return valuesM.size();
+    }
+
+    virtual void getValue(int recNo, RandomStream& random,
+        ParameterValue& value) const
+    {
+        if (valuesM.empty())
+            value.type = ParameterValue::pvNull;
+        else if (randomM)
+            value = valuesM[random.next(valuesM.size())];
+        else
+            value = valuesM[recNo % valuesM.size()];
+    }
+};
+
+// range = x,x-y,...
+class NumberValueSource: public ValueSource
+{
+private:
+    ParameterValue::Type typeM;
+    std::vector< std::pair<long,long> > rangesM;
+    long rangesizeM;
+    bool randomM;
+public:
+    NumberValueSource(ParameterValue::Type type, const wxString& range,
+            bool random)
+        : typeM(type), rangesizeM(0), randomM(random)
+    {
+        std::vector<wxString> parts(splitRange(range));
+        for (std::vector<wxString>::iterator it = parts.begin();
+            it != parts.end(); ++it)
+        {
+            wxString one(*it);
+            size_t p = one.find("-");
+            if (p == wxString::npos)
+            {
+                long l;
+                if (!one.ToLong(&l))
+                    throw FRError(_("Invalid number: ") + one);
+                rangesM.push_back(std::pair<long,long>(l, l));
+                rangesizeM++;
+            }
+            else
+            {
+                long l1, l2;
+                if (!one.Mid(0, p).ToLong(&l1) || !one.Mid(p+1).ToLong(&l2))
+                    throw FRError(_("Invalid range: ") + one);
+                rangesM.push_back(std::pair<long,long>(l1, l2));
+                rangesizeM += (l2-l1+1);
+            }
+        }
+    }
+
+    virtual void getValue(int recNo, RandomStream& random,
+        ParameterValue& value) const
+    {
+        value.type = ParameterValue::pvNull;
+        if (rangesizeM <= 0)
+            return;
+        long toget = (randomM ? random.next(rangesizeM)
+            : (recNo % rangesizeM));
+        for (std::vector< std::pair<long,long> >::const_iterator it =
+            rangesM.begin(); it != rangesM.end(); ++it)
+        {
+            long sz = (*it).second - (*it).first + 1;
+            if (sz > toget)
+            {
+                value.type = typeM;
+                value.integer = (*it).first + toget;
+                value.number = double(value.integer);
+                return;
+            }
+            toget -= sz;
+        }
+    }
+};
+
+// range = date/time or date/time-date/time, comma separated
+class DatetimeValueSource: public ValueSource
+{
+private:
+    ParameterValue::Type typeM;
+    std::vector< std::pair<int,int> > dateRangesM;
+    std::vector< std::pair<int,int> > timeRangesM;
+    int dateRangesizeM;
+    int timeRangesizeM;
+    bool randomM;
+public:
+    DatetimeValueSource(ParameterValue::Type type, const wxString& range,
+            bool random)
+        : typeM(type), dateRangesizeM(0), timeRangesizeM(0), randomM(random)
+    {
+        bool hasDate = (type == ParameterValue::pvDate
+            || type == ParameterValue::pvTimestamp);
+        bool hasTime = (type == ParameterValue::pvTime
+            || type == ParameterValue::pvTimestamp);
+        std::vector<wxString> parts(splitRange(range));
+        for (std::vector<wxString>::iterator it = parts.begin();
+            it != parts.end(); ++it)
+        {
+            wxString one(*it);
+            // convert first value
+            int date = 0, time = 0;
+            if (hasDate)
+                str2date(one.Mid(0,10), date);
+            if (type == ParameterValue::pvTime)
+                str2time(one.Mid(0,8), time);
+            if (type == ParameterValue::pvTimestamp)
+                str2time(one.Mid(11,8), time);
+
+            int date2 = date, time2 = time;
+            if (one.find("-") != wxString::npos)
+            {
+                // range, convert second date/time
+                if (type == ParameterValue::pvDate)
+                    str2date(one.Mid(11,10), date2);
+                if (type == ParameterValue::pvTimestamp)
+                {
+                    str2date(one.Mid(20,10), date2);
+                    str2time(one.Mid(31, 8), time2);
+                }
+                if (type == ParameterValue::pvTime)
+                    str2time(one.Mid( 9, 8), time2);
+            }
+            if (hasDate)
+            {
+                dateRangesM.push_back(std::pair<int,int>(date, date2));
+                dateRangesizeM += (date2-date+1);
+            }
+            if (hasTime)
+            {
+                timeRangesM.push_back(std::pair<int,int>(time, time2));
+                timeRangesizeM += ((time2-time) / 10000 + 1);
+            }
+        }
+    }
+
+    virtual void getValue(int recNo, RandomStream& random,
+        ParameterValue& value) const
+    {
+        int dateToGet, timeToGet;
+        if (randomM)
+        {
+            dateToGet = (dateRangesizeM > 0 ? random.next(dateRangesizeM) : 0);
+            timeToGet = (timeRangesizeM > 0 ? random.next(timeRangesizeM) : 0);
+        }
+        else
+        {
+            dateToGet = (dateRangesizeM > 0 ? recNo % dateRangesizeM : 0);
+            timeToGet = (timeRangesizeM > 0 ? recNo % timeRangesizeM : 0);
+        }
+
+        value.type = typeM;
+        value.date = 0;
+        value.time = 0;
+        for (std::vector< std::pair<int,int> >::const_iterator it =
+            dateRangesM.begin(); it != dateRangesM.end(); ++it)
+        {
+            int sz = (*it).second - (*it).first + 1;
+            if (sz > dateToGet)
+            {
+                value.date = (*it).first + dateToGet;
+                break;
+            }
+            dateToGet -= sz;
+        }
+        for (std::vector< std::pair<int,int> >::const_iterator it =
+            timeRangesM.begin(); it != timeRangesM.end(); ++it)
+        {
+            int sz = ((*it).second - (*it).first)/10000 + 1;
+            if (sz > timeToGet)
+            {
+                value.time = (*it).first + timeToGet*10000;
+                break;
+            }
+            timeToGet -= sz;
+        }
+    }
+};
+
+// format for values:
+// number[value or range(s)]
+// example: 25[az,AZ,09] means: 25 letters or numbers
+// example: 10[a,x,5]       means: 10 chars, each either of 'a', 'x' or '5'
+// The characters of the value sets are converted to the connection
+// character set once, the values are put together from those.
+class StringValueSource: public ValueSource
+{
+private:
+    struct Segment
+    {
+        int chars;
+        std::vector<std::string> valueset;
+    };
+    std::vector<Segment> segmentsM;
+    bool randomM;
+
+    // range = comma separated list of values or ranges
+    static void parseValueset(const wxString& range, wxMBConv* converter,
+        std::vector<std::string>& valueset)
+    {
+        std::vector<wxString> parts(splitRange(range));
+        for (std::vector<wxString>::iterator it = parts.begin();
+            it != parts.end(); ++it)
+        {
+            wxString one(*it);
+            if (one.Length() == 1)
+                valueset.push_back(wx2std(one, converter));
+            else if (one.Length() == 2)     // range
+            {
+                for (wxChar c = one[0]; c <= one[1]; c++)
+                    valueset.push_back(wx2std(wxString(c), converter));
+            }
+            else
+            {
+                throw FRError(_("Bad range: section length not 1 or 2: ")
+                    + one);
+            }
+        }
+        if (valueset.empty())
+            throw FRError(_("Bad range: no characters: ") + range);
+    }
+public:
+    StringValueSource(const wxString& range, bool random,
+            wxMBConv* converter)
+        : randomM(random)
+    {
+        long chars = 1;
+        size_t start = 0;
+        while (start < range.Length())
+        {
+            if (range.Mid(start, 1) == "[")
+            {
+                size_t p = range.find("]", start+1);
+                if (p == wxString::npos)    // invalid mask
+                    throw FRError(_("Invalid mask: missing ]"));
+                Segment segment;
+                segment.chars = chars;
+                parseValueset(range.Mid(start+1, p-start-1), converter,
+                    segment.valueset);
+                segmentsM.push_back(segment);
+                start = p+1;
+                chars = 1;
+            }
+            else
+            {
+                size_t p = range.find("[", start+1);
+                if (p == wxString::npos)    // invalid mask
+                    throw FRError(_("Invalid mask, missing ["));
+                wxString number = range.Mid(start, p-start);
+                if (!number.ToLong(&chars))
+                    throw FRError(_("Bad number: ")+number);
+                start = p;
+            }
+        }
+    }
+
+    virtual void getValue(int recNo, RandomStream& random,
+        ParameterValue& value) const
+    {
+        value.type = ParameterValue::pvString;
+        value.text.clear();
+        for (std::vector<Segment>::const_iterator it = segmentsM.begin();
+            it != segmentsM.end(); ++it)
+        {
+            const std::vector<std::string>& valueset((*it).valueset);
+            int base = valueset.size();
+            for (int i = 0; i < (*it).chars; i++)
+            {
+                if (randomM)
+                {
+                    value.text += valueset[random.next(base)];
+                    continue;
+                }
+                // sequential: we support stuff like 001,002,003 or
+                // AAA,AAB,AAC by converting the record counter to number
+                // with n-th base where n is a number of characters in
+                // valueset
+                int record = recNo;
+                for (int j = 0; j < (*it).chars - i - 1; j++)
+                    record /= base;
+                value.text += valueset[record % base];
+            }
+        }
+    }
+};
+
+// converts a line of a value file to the parameter type
+static ParameterValue parseValue(const wxString& selected,
+    ParameterValue::Type type, wxMBConv* converter)
+{
+    ParameterValue value;
+    value.type = type;
+    switch (type)
+    {
+        case ParameterValue::pvString:
+            value.text = wx2std(selected, converter);
+            break;
+        case ParameterValue::pvSmallint:
+        {
+            long l;
+            if (!selected.ToLong(&l))
+                throw FRError(_("Invalid long (smallint) value: ")+selected);
+            value.integer = l;
+            break;
+        }
+        case ParameterValue::pvLargeint:
+        {
+            wxLongLong_t ll;
+            if (!selected.ToLongLong(&ll))
+                throw FRError(_("Invalid long long numeric value: ")+selected);
+            value.integer = ll;
+            break;
+        }
+        case ParameterValue::pvInteger:
+        {
+            long l;
+            if (!selected.ToLong(&l))
+                throw FRError(_("Invalid long numeric value: ")+selected);
+            value.integer = l;
+            break;
+        }
+        case ParameterValue::pvFloat:
+            if (!selected.ToDouble(&value.number))
+                throw FRError(_("Invalid float value: ")+selected);
+            break;
+        case ParameterValue::pvDouble:
+            if (!selected.ToDouble(&value.number))
+                throw FRError(_("Invalid double numeric value: ")+selected);
+            break;
+        case ParameterValue::pvTime:
+            str2time(selected, value.time);
+            break;
+        case ParameterValue::pvDate:
+            str2date(selected, value.date);
+            break;
+        case ParameterValue::pvTimestamp:
+            str2date(selected, value.date);
+            str2time(selected.Mid(11), value.time);
+            break;
+        default:
+            break;
+    }
+    return value;
+}
+
+// the file is read only once, its lines up to the first empty one are the
+// values
+static ValueSourcePtr createFileSource(const DataGeneratorSettings& gs,
+    ParameterValue::Type type, wxMBConv* converter)
+{
+    wxFileInputStream stream(gs.fileName);
+    if (!stream.Ok())
+        throw FRError(_("Cannot open file: ")+gs.fileName);
+    wxTextInputStream text(stream);
+
+    boost::shared_ptr<ListValueSource> source(
+        new ListValueSource(gs.randomValues));
+    while (true)
+    {
+        wxString s = text.ReadLine();
+        if (s.IsEmpty())
+            break;
+        source->add(parseValue(s, type, converter));
+    }
+    return source;
+}
+
+// the source column is read only once, at most the first 100 values are
+// used for random values and no more than the number of records for
+// sequential values
+static ValueSourcePtr createColumnSource(const DataGeneratorSettings& gs,
+    ParameterValue::Type type, int records, IBPP::Database& database,
+    IBPP::Transaction& transaction, wxMBConv* converter)
+{
+    IBPP::Statement st =
+        IBPP::StatementFactory(database, transaction);
+    wxString sql = "SELECT " + gs.sourceColumn + " FROM "
+        + gs.sourceTable + " WHERE " + gs.sourceColumn
+        + " IS NOT NULL";
+    if (!gs.randomValues)
+        sql += " ORDER BY 1";
+    st->Prepare(wx2std(sql, converter));
+    st->Execute();
+
+    boost::shared_ptr<ListValueSource> source(
+        new ListValueSource(gs.randomValues));
+    size_t limit = (gs.randomValues ? 100 : size_t(records));
+    while (source->size() < limit && st->Fetch())
+    {
+        ParameterValue value;
+        value.type = type;
+        switch (type)
+        {
+            case ParameterValue::pvString:
+                st->Get(1, value.text);
+                break;
+            case ParameterValue::pvSmallint:
+            {
+                int16_t i;
+                st->Get(1, i);
+                value.integer = i;
+                break;
+            }
+            case ParameterValue::pvInteger:
+            {
+                int32_t i;
+                st->Get(1, i);
+                value.integer = i;
+                break;
+            }
+            case ParameterValue::pvLargeint:
+                st->Get(1, value.integer);
+                break;
+            case ParameterValue::pvFloat:
+            {
+                float f;
+                st->Get(1, f);
+                value.number = f;
+                break;
+            }
+            case ParameterValue::pvDouble:
+                st->Get(1, value.number);
+                break;
+            case ParameterValue::pvDate:
+            {
+                IBPP::Date d;
+                st->Get(1, d);
+                value.date = d.GetDate();
+                break;
+            }
+            case ParameterValue::pvTime:
+            {
+                IBPP::Time t;
+                st->Get(1, t);
+                value.time = t.GetTime();
+                break;
+            }
+            case ParameterValue::pvTimestamp:
+            {
+                IBPP::Timestamp ts;
+                st->Get(1, ts);
+                value.date = ts.GetDate();
+                value.time = ts.GetTime();
+                break;
+            }
+            default:
+                break;
+        }
+        source->add(value);
+    }
+    // an empty source yields only NULLs
+    if (source->size() == 0 && gs.nullPercent <= 0)
+        throw FRError(_("No records found in table: ") + gs.sourceTable);
+    return source;
+}
+
+// generated values for one column
+struct ColumnValues
+{
+    int nullPercent;
+    ValueSourcePtr source;
+};
+
+struct DataGenerator::TableJob
+{
+    wxString name;
+    wxString tableName;
+    int records;
+    unsigned long seed[4];
+    std::vector<Column*> columns;
+    std::vector<DataGeneratorSettings> settings;
+
+    // set up in the main thread when the level is started
+    BatchInsertSql sql;
+    std::vector<ColumnValues> values;
+
+    // protected by the mutex of the DataGenerator
+    int inserted;
+    bool running;
+    bool done;
+};
+
+DataGenerator::DataGenerator(Database* database, unsigned commitInterval)
+    : databaseM(database), commitIntervalM(commitInterval), nextJobM(0),
+        runningM(0), insertedM(0), committedM(0), cancelM(false)
+{
+}
+
+DataGenerator::~DataGenerator()
+{
+    for (size_t i = 0; i < attachmentsM.size(); ++i)
+        disconnectAttachment(attachmentsM[i]);
+}
+
+void DataGenerator::addLevel()
+{
+    levelsM.push_back(std::vector<TableJobPtr>());
+}
+
+void DataGenerator::addTable(Table* table, int records,
+    const std::vector<Column*>& columns,
+    const std::vector<DataGeneratorSettings>& settings)
+{
+    wxASSERT(columns.size() == settings.size());
+    if (levelsM.empty())
+        addLevel();
+
+    TableJobPtr job(new TableJob);
+    job->name = table->getName_();
+    job->records = records;
+    job->settings = settings;
+    job->tableName = table->getQuotedName();
+    job->columns = columns;
+    // every table gets a different random number stream
+    job->seed[0] = (unsigned long)time(0);
+    job->seed[1] = (unsigned long)clock();
+    job->seed[2] = (unsigned long)levelsM.size();
+    job->seed[3] = (unsigned long)levelsM.back().size();
+    job->sql.blockRows = 1;
+    job->inserted = 0;
+    job->running = false;
+    job->done = false;
+    levelsM.back().push_back(job);
+}
+
+// sets up the value sources and statements of the table, called in the main
+// thread with a transaction that sees the data of all previous levels
+void DataGenerator::prepareJob(TableJob& job, IBPP::Transaction& transaction)
+{
+    IBPP::Database db(databaseM->getIBPPDatabase());
+    wxMBConv* converter = databaseM->getCharsetConverter();
+
+    createBatchInsertSql(databaseM, transaction, job.tableName, job.columns,
+        job.records, job.sql);
+    job.values.clear();
+    for (size_t i = 0; i < job.sql.types.size(); ++i)
+    {
+        const DataGeneratorSettings& gs(job.settings[i]);
+        ColumnValues cv;
+        cv.nullPercent = gs.nullPercent;
+        ParameterValue::Type type = job.sql.types[i];
+        if (type == ParameterValue::pvBlob)
+            throw FRError(_("Blob datatype not supported"));
+        if (gs.valueType == DataGeneratorSettings::vtColumn)
+        {
+            cv.source = createColumnSource(gs, type, job.records, db,
+                transaction, converter);
+        }
+        else if (gs.valueType == DataGeneratorSettings::vtFile)
+        {
+            if (job.sql.scales[i])
+                type = ParameterValue::pvDouble;
+            cv.source = createFileSource(gs, type, converter);
+        }
+        else if (type == ParameterValue::pvString)
+            cv.source.reset(new StringValueSource(gs.range, gs.randomValues,
+                converter));
+        else if (type == ParameterValue::pvDate
+            || type == ParameterValue::pvTime
+            || type == ParameterValue::pvTimestamp)
+        {
+            cv.source.reset(new DatetimeValueSource(type, gs.range,
+                gs.randomValues));
+        }
+        else if (type != ParameterValue::pvNull)
+        {
+            cv.source.reset(new NumberValueSource(type, gs.range,
+                gs.randomValues));
+        }
+        else
+            cv.source.reset(new ListValueSource(false));
+        job.values.push_back(cv);
+    }
+}
+
+bool DataGenerator::run(ProgressIndicator* progressIndicator)
+{
+    for (size_t i = 0; i < levelsM.size(); ++i)
+    {
+        if (levelsM[i].empty())
+            continue;
+        // value sources are read with a new transaction, so data inserted
+        // (and committed) by previous levels can be copied
+        IBPP::Transaction tr =
+            IBPP::TransactionFactory(databaseM->getIBPPDatabase());
+        tr->Start();
+        for (std::vector<TableJobPtr>::iterator it = levelsM[i].begin();
+            it != levelsM[i].end(); ++it)
+        {
+            if (progressIndicator)
+            {
+                progressIndicator->setProgressMessage(
+                    _("Preparing ") + (*it)->name);
+                if (progressIndicator->isCanceled())
+                    return false;
+            }
+            prepareJob(*(*it), tr);
+        }
+        tr->Commit();
+
+        if (!fillLevel(levelsM[i], progressIndicator))
+            return false;
+    }
+    return true;
+}
+
+bool DataGenerator::fillLevel(const std::vector<TableJobPtr>& level,
+    ProgressIndicator* progressIndicator)
+{
+    size_t count = std::min(level.size(), maxConcurrentTables);
+    while (attachmentsM.size() < count)
+    {
+        IBPP::Database db(databaseM->createSecondaryAttachment());
+        db->Connect();
+        attachmentsM.push_back(db);
+    }
+
+    {
+        boost::lock_guard<boost::mutex> guard(lockM);
+        pendingM = level;
+        nextJobM = 0;
+        runningM = count;
+    }
+    boost::thread_group threads;
+    for (size_t i = 0; i < count; ++i)
+    {
+        threads.create_thread(boost::bind(&DataGenerator::fillTables, this,
+            attachmentsM[i]));
+    }
+
+    while (true)
+    {
+        size_t running;
+        {
+            boost::lock_guard<boost::mutex> guard(lockM);
+            running = runningM;
+        }
+        if (progressIndicator)
+        {
+            updateProgress(level, progressIndicator);
+            if (progressIndicator->isCanceled())
+            {
+                boost::lock_guard<boost::mutex> guard(lockM);
+                cancelM = true;
+            }
+        }
+        if (!running)
+            break;
+        wxMilliSleep(50);
+    }
+    threads.join_all();
+
+    boost::lock_guard<boost::mutex> guard(lockM);
+    if (!errorM.empty())
+        throw FRError(errorM);
+    return !cancelM;
+}
+
+void DataGenerator::updateProgress(const std::vector<TableJobPtr>& level,
+    ProgressIndicator* progressIndicator)
+{
+    wxString names;
+    int records = 0, inserted = 0;
+    size_t done = 0;
+    {
+        boost::lock_guard<boost::mutex> guard(lockM);
+        for (std::vector<TableJobPtr>::const_iterator it = level.begin();
+            it != level.end(); ++it)
+        {
+            records += (*it)->records;
+            inserted += (*it)->inserted;
+            if ((*it)->done)
+                ++done;
+            else if ((*it)->running)
+                names += (names.IsEmpty() ? "" : ", ") + (*it)->name;
+        }
+    }
+    if (names.IsEmpty())
+        names = _("Inserting into tables");
+    else
+        names = _("Inserting into ") + names;
+    progressIndicator->initProgress(names, level.size(), done);
+    progressIndicator->initProgress(
+        wxString::Format(_("Inserted %d of %d records."), inserted, records),
+        records, inserted, 2);
+}
+
+int DataGenerator::getInsertedRecords()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    return insertedM;
+}
+
+int DataGenerator::getCommittedRecords()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    return committedM;
+}
+
+DataGenerator::TableJobPtr DataGenerator::getNextJob()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    if (cancelM || nextJobM >= pendingM.size())
+        return TableJobPtr();
+    TableJobPtr job(pendingM[nextJobM++]);
+    job->running = true;
+    return job;
+}
+
+bool DataGenerator::isCanceled()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    return cancelM;
+}
+
+// the first error cancels all other threads
+void DataGenerator::setError(const std::string& error)
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    if (errorM.empty())
+        errorM = error;
+    cancelM = true;
+}
+
+// worker thread, fills tables of the current level until there are none
+// left, all of them in one transaction
+void DataGenerator::fillTables(IBPP::Database attachment)
+{
+    try
+    {
+        IBPP::Transaction tr = IBPP::TransactionFactory(attachment);
+        tr->Start();
+        unsigned uncommitted = 0;
+        TableJobPtr job;
+        while ((job = getNextJob()))
+            fillTable(job, attachment, tr, uncommitted);
+        if (isCanceled())
+            tr->Rollback();
+        else
+            commit(tr, uncommitted);
+    }
+    catch (std::exception& e)
+    {
+        setError(e.what());
+    }
+    catch (...)
+    {
+        setError("Unknown error while inserting data");
+    }
+
+    boost::lock_guard<boost::mutex> guard(lockM);
+    --runningM;
+}
+
+void DataGenerator::fillTable(TableJobPtr job, IBPP::Database& attachment,
+    IBPP::Transaction& transaction, unsigned& uncommitted)
+{
+    BatchInserter inserter(attachment, transaction, job->sql);
+    int columns = job->values.size();
+
+    RowBatchQueue queue(maxQueuedBatches);
+    boost::thread generator(boost::bind(&DataGenerator::generateRows, this,
+        job, &queue));
+    try
+    {
+        RowBatchPtr batch;
+        while (!isCanceled() && queue.pop(batch))
+        {
+            for (int row = 0; row < batch->rows; )
+            {
+                int rows = std::min(batch->rows - row,
+                    inserter.getBlockRows());
+                inserter.insert(&batch->values[row * columns], rows);
+                row += rows;
+
+                uncommitted += rows;
+                if (commitIntervalM && uncommitted >= commitIntervalM)
+                {
+                    commit(transaction, uncommitted);
+                    transaction->Start();
+                }
+            }
+            boost::lock_guard<boost::mutex> guard(lockM);
+            job->inserted += batch->rows;
+            insertedM += batch->rows;
+        }
+    }
+    catch (...)
+    {
+        queue.cancel();
+        generator.join();
+        throw;
+    }
+    queue.cancel();
+    generator.join();
+
+    boost::lock_guard<boost::mutex> guard(lockM);
+    job->running = false;
+    job->done = true;
+}
+
+// the records inserted in the transaction since its last commit are added
+// to the committed records
+void DataGenerator::commit(IBPP::Transaction& transaction,
+    unsigned& uncommitted)
+{
+    transaction->Commit();
+    boost::lock_guard<boost::mutex> guard(lockM);
+    committedM += uncommitted;
+    uncommitted = 0;
+}
+
+// generator thread of a table, stops early if the queue is canceled
+void DataGenerator::generateRows(TableJobPtr job, RowBatchQueue* queue)
+{
+    try
+    {
+        RandomStream random(job->seed, 4);
+        int columns = job->values.size();
+        int batchRows = std::max(job->sql.blockRows, minBatchRows);
+        for (int recNo = 0; recNo < job->records; )
+        {
+            RowBatchPtr batch(new RowBatch);
+            batch->rows = std::min(batchRows, job->records - recNo);
+            batch->values.resize(batch->rows * columns);
+            ParameterValue* value = &batch->values[0];
+            for (int r = 0; r < batch->rows; ++r, ++recNo)
+            {
+                for (int c = 0; c < columns; ++c, ++value)
+                {
+                    const ColumnValues& cv(job->values[c]);
+                    if (cv.nullPercent > random.next(100))
+                        value->type = ParameterValue::pvNull;
+                    else
+                        cv.source->getValue(recNo, random, *value);
+                }
+            }
+            if (!queue->push(batch))
+                return;
+        }
+    }
+    catch (std::exception& e)
+    {
+        setError(e.what());
+        queue->cancel();
+        return;
+    }
+    queue->close();
+}
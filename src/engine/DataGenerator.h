@@ -0,0 +1,123 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_DATAGENERATOR_H
+#define FR_DATAGENERATOR_H
+
+#include <wx/string.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <ibpp.h>
+
+class Database;
+class ProgressIndicator;
+class Table;
+class Column;
+class RowBatchQueue;
+
+// How the values of a column are generated, see DataGeneratorFrame for the
+// format of the range.
+struct DataGeneratorSettings
+{
+    typedef enum { vtSkip, vtRange, vtColumn, vtFile } ValueType;
+    ValueType valueType;
+    wxString range;
+    wxString sourceTable;
+    wxString sourceColumn;
+    wxString fileName;
+    bool randomValues;
+    int nullPercent;
+};
+
+// Fills tables with generated data.  The tables are grouped into levels, all
+// tables of a level must only depend on tables of earlier levels.  The value
+// sources of a level are set up in the main thread (reading value files and
+// source columns once), then the tables of the level are filled in parallel
+// on secondary attachments.  For every table a generator thread with its own
+// random number stream produces batches of parameter rows, which are
+// inserted several at a time with EXECUTE BLOCK statements.
+class DataGenerator
+{
+private:
+    struct TableJob;
+    typedef boost::shared_ptr<TableJob> TableJobPtr;
+
+    Database* databaseM;
+    unsigned commitIntervalM;
+    std::vector<std::vector<TableJobPtr> > levelsM;
+    std::vector<IBPP::Database> attachmentsM;
+
+    // state shared with the worker threads
+    boost::mutex lockM;
+    std::vector<TableJobPtr> pendingM;
+    size_t nextJobM;
+    size_t runningM;
+    int insertedM;
+    int committedM;
+    bool cancelM;
+    std::string errorM;
+
+    void prepareJob(TableJob& job, IBPP::Transaction& transaction);
+    bool fillLevel(const std::vector<TableJobPtr>& level,
+        ProgressIndicator* progressIndicator);
+    void updateProgress(const std::vector<TableJobPtr>& level,
+        ProgressIndicator* progressIndicator);
+
+    // run in worker threads
+    void fillTables(IBPP::Database attachment);
+    void fillTable(TableJobPtr job, IBPP::Database& attachment,
+        IBPP::Transaction& transaction, unsigned& uncommitted);
+    void commit(IBPP::Transaction& transaction, unsigned& uncommitted);
+    void generateRows(TableJobPtr job, RowBatchQueue* queue);
+    TableJobPtr getNextJob();
+    bool isCanceled();
+    void setError(const std::string& error);
+public:
+    // commitInterval is the number of records after which the transactions
+    // are committed, with 0 they are committed after every level
+    DataGenerator(Database* database, unsigned commitInterval = 0);
+    ~DataGenerator();
+
+    // starts a new level, the levels are filled in the order of creation
+    void addLevel();
+    // adds the table to the current level, settings contains the settings
+    // of the columns values are generated for
+    void addTable(Table* table, int records,
+        const std::vector<Column*>& columns,
+        const std::vector<DataGeneratorSettings>& settings);
+
+    // returns false if canceled, throws if value sources are invalid or
+    // inserting fails
+    bool run(ProgressIndicator* progressIndicator = 0);
+    int getInsertedRecords();
+    // records committed so far, every level is committed on its own, so
+    // they stay in the database when the generation is canceled or fails
+    int getCommittedRecords();
+};
+
+#endif // FR_DATAGENERATOR_H
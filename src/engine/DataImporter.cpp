@@ -0,0 +1,1148 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+#include <wx/tokenzr.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <locale>
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "core/FRError.h"
+#include "core/ProgressIndicator.h"
+#include "core/StringUtils.h"
+#include "engine/DataImporter.h"
+#include "engine/SharedAttachment.h"
+#include "metadata/column.h"
+#include "metadata/database.h"
+#include "metadata/table.h"
+
+// number of threads parsing and converting records
+static const size_t maxParserThreads = 4;
+// chunks that have been split off but not yet inserted
+static const size_t maxChunksInFlight = 16;
+// approximate size of a chunk, in records and in bytes
+static const int chunkRecords = 1024;
+static const size_t chunkBytes = 1024 * 1024;
+// rejected records whose details are kept for the report
+static const size_t maxReportedRejections = 1000;
+
+DataImportSettings::DataImportSettings()
+    : fieldDelimiter(','), textDelimiter('"'), headerRow(true), utf8(true),
+        nullText("NULL"), commitInterval(10000)
+{
+}
+
+DataImportPosition::DataImportPosition()
+    : offset(0), line(0), inserted(0), rejected(0)
+{
+}
+
+// a field as read from the file, with text delimiters removed
+struct ImportField
+{
+    std::string text;
+    bool quoted;
+};
+
+// position of a record in the file
+struct RecordPosition
+{
+    int64_t line;
+    size_t offset;
+    size_t size;
+};
+
+struct DataImporter::ImportChunk
+{
+    size_t sequence;
+    size_t offset;
+    size_t endOffset;
+    int64_t line;
+    int64_t endLine;
+
+    // set by the parser, the converted values of all valid records
+    int rows;
+    std::vector<ParameterValue> values;
+    std::vector<RecordPosition> positions;
+    std::vector<DataImporter::Rejection> rejections;
+};
+
+struct RejectionOffsetLess
+{
+    bool operator()(const DataImporter::Rejection& left,
+        const DataImporter::Rejection& right) const
+    {
+        return left.offset < right.offset;
+    }
+};
+
+// returns the end of the record starting at p, line is incremented for
+// every line end (including those in delimited text), the text delimiters
+// are handled the same way as by parseRecord()
+static const char* findRecordEnd(const char* p, const char* end,
+    char delimiter, char quote, int64_t& line)
+{
+    bool quoted = false;
+    // delimited text can only start at the beginning of a field
+    bool fieldStart = true;
+    for (; p < end; ++p)
+    {
+        if (*p == '\n')
+        {
+            ++line;
+            if (!quoted)
+                return p + 1;
+        }
+        else if (quoted)
+        {
+            if (*p == quote)
+            {
+                // doubled text delimiters are part of the text
+                if (p + 1 < end && p[1] == quote)
+                    ++p;
+                else
+                    quoted = false;
+            }
+        }
+        else if (*p == delimiter)
+        {
+            fieldStart = true;
+            continue;
+        }
+        else if (fieldStart && quote && *p == quote)
+            quoted = true;
+        fieldStart = false;
+    }
+    return end;
+}
+
+// splits the record starting at p into fields, fields are reused to save
+// allocations and count is set to the number of fields in the record,
+// returns the end of the record
+static const char* parseRecord(const char* p, const char* end,
+    char delimiter, char quote, std::vector<ImportField>& fields,
+    size_t& count, int64_t& lines)
+{
+    count = 0;
+    while (true)
+    {
+        if (fields.size() <= count)
+            fields.resize(count + 1);
+        ImportField& field = fields[count++];
+        field.text.clear();
+        field.quoted = false;
+        if (quote && p < end && *p == quote)
+        {
+            field.quoted = true;
+            ++p;
+            while (p < end)
+            {
+                const char* q = static_cast<const char*>(
+                    memchr(p, quote, end - p));
+                const char* stop = q ? q : end;
+                lines += std::count(p, stop, '\n');
+                field.text.append(p, stop);
+                p = stop;
+                if (!q)
+                    break;
+                // doubled text delimiters are part of the text
+                if (p + 1 < end && p[1] == quote)
+                {
+                    field.text += quote;
+                    p += 2;
+                    continue;
+                }
+                ++p;
+                break;
+            }
+        }
+        // anything between the closing text delimiter and the next field
+        // delimiter is ignored
+        const char* start = p;
+        while (p < end && *p != delimiter && *p != '\n')
+            ++p;
+        if (!field.quoted)
+            field.text.assign(start, p);
+        if (p < end && *p == delimiter)
+        {
+            ++p;
+            continue;
+        }
+        if (!field.quoted && !field.text.empty()
+            && field.text[field.text.size() - 1] == '\r')
+        {
+            field.text.erase(field.text.size() - 1);
+        }
+        if (p < end)
+        {
+            ++p;
+            ++lines;
+        }
+        return p;
+    }
+}
+
+static std::string trimmed(const std::string& text)
+{
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string::npos)
+        return std::string();
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(start, end - start + 1);
+}
+
+// the number is returned as integer with scale implied digits, further
+// fractional digits are rounded
+static bool parseScaledInteger(const std::string& text, int scale,
+    int64_t& value)
+{
+    const int64_t maxValue = std::numeric_limits<int64_t>::max();
+    const char* p = text.c_str();
+    bool negative = false;
+    if (*p == '-' || *p == '+')
+        negative = (*p++ == '-');
+    int64_t v = 0;
+    int digits = 0;
+    int fraction = -1;
+    bool roundUp = false, rounded = false;
+    for (; *p; ++p)
+    {
+        if (*p == '.' && fraction < 0)
+        {
+            fraction = 0;
+            continue;
+        }
+        if (*p < '0' || *p > '9')
+            return false;
+        if (fraction >= scale)
+        {
+            if (!rounded)
+                roundUp = (*p >= '5');
+            rounded = true;
+            continue;
+        }
+        if (v > (maxValue - 9) / 10)
+            return false;
+        v = v * 10 + (*p - '0');
+        ++digits;
+        if (fraction >= 0)
+            ++fraction;
+    }
+    if (!digits)
+        return false;
+    for (int i = (fraction < 0 ? 0 : fraction); i < scale; ++i)
+    {
+        if (v > maxValue / 10)
+            return false;
+        v *= 10;
+    }
+    if (roundUp)
+        ++v;
+    value = negative ? -v : v;
+    return true;
+}
+
+static bool parseDouble(const std::string& text, double& value)
+{
+    std::istringstream is(text);
+    is.imbue(std::locale::classic());
+    is >> value;
+    if (is.fail())
+        return false;
+    is >> std::ws;
+    return is.eof();
+}
+
+// reads up to maxDigits digits
+static bool readNumber(const char*& p, const char* end, int maxDigits,
+    int& value)
+{
+    int digits = 0;
+    value = 0;
+    while (p < end && digits < maxDigits && *p >= '0' && *p <= '9')
+    {
+        value = value * 10 + (*p++ - '0');
+        ++digits;
+    }
+    return digits > 0;
+}
+
+// yyyy-mm-dd, dd.mm.yyyy or mm/dd/yyyy
+static bool parseDate(const char*& p, const char* end, int& date)
+{
+    int n1, n2, n3;
+    if (!readNumber(p, end, 4, n1) || p >= end)
+        return false;
+    char separator = *p++;
+    if (separator != '-' && separator != '.' && separator != '/')
+        return false;
+    if (!readNumber(p, end, 2, n2) || p >= end || *p++ != separator
+        || !readNumber(p, end, 4, n3))
+    {
+        return false;
+    }
+    if (separator == '-')
+        return IBPP::itod(&date, n1, n2, n3);
+    if (separator == '.')
+        return IBPP::itod(&date, n3, n2, n1);
+    return IBPP::itod(&date, n3, n1, n2);
+}
+
+// hh:mm[:ss[.ffff]]
+static bool parseTime(const char*& p, const char* end, int& time)
+{
+    int h, m, s = 0, t = 0;
+    if (!readNumber(p, end, 2, h) || p >= end || *p++ != ':'
+        || !readNumber(p, end, 2, m))
+    {
+        return false;
+    }
+    if (p < end && *p == ':')
+    {
+        ++p;
+        if (!readNumber(p, end, 2, s))
+            return false;
+        if (p < end && *p == '.')
+        {
+            ++p;
+            const char* start = p;
+            if (!readNumber(p, end, 4, t))
+                return false;
+            for (int i = int(p - start); i < 4; ++i)
+                t *= 10;
+            // ignore digits beyond the precision of Firebird
+            while (p < end && *p >= '0' && *p <= '9')
+                ++p;
+        }
+    }
+    if (h > 23 || m > 59 || s > 59)
+        return false;
+    IBPP::itot(&time, h, m, s, t);
+    return true;
+}
+
+// converts the field to the parameter type, text is converted from UTF-8
+// to the connection character set if a converter is given
+static bool convertField(const ImportField& field, ParameterValue::Type type,
+    int scale, const std::string& nullText, wxMBConv* converter,
+    ParameterValue& value)
+{
+    bool text = (type == ParameterValue::pvString
+        || type == ParameterValue::pvBlob);
+    if ((field.text.empty() && (!field.quoted || !text))
+        || (!nullText.empty() && field.text == nullText))
+    {
+        value.type = ParameterValue::pvNull;
+        return true;
+    }
+
+    value.type = type;
+    if (text)
+    {
+        if (!converter)
+        {
+            value.text = field.text;
+            return true;
+        }
+        if (field.text.empty())
+        {
+            value.text.clear();
+            return true;
+        }
+        // an empty result means the text is not valid UTF-8
+        wxString s(field.text.data(), wxConvUTF8, field.text.size());
+        if (s.empty())
+            return false;
+        value.text = wx2std(s, converter);
+        return true;
+    }
+
+    std::string number(trimmed(field.text));
+    const char* p = number.c_str();
+    const char* end = p + number.size();
+    switch (type)
+    {
+        case ParameterValue::pvSmallint:
+            return parseScaledInteger(number, scale, value.integer)
+                && value.integer >= std::numeric_limits<int16_t>::min()
+                && value.integer <= std::numeric_limits<int16_t>::max();
+        case ParameterValue::pvInteger:
+            return parseScaledInteger(number, scale, value.integer)
+                && value.integer >= std::numeric_limits<int32_t>::min()
+                && value.integer <= std::numeric_limits<int32_t>::max();
+        case ParameterValue::pvLargeint:
+            return parseScaledInteger(number, scale, value.integer);
+        case ParameterValue::pvFloat:
+        case ParameterValue::pvDouble:
+            return parseDouble(number, value.number);
+        case ParameterValue::pvDate:
+            return parseDate(p, end, value.date) && p == end;
+        case ParameterValue::pvTime:
+            return parseTime(p, end, value.time) && p == end;
+        case ParameterValue::pvTimestamp:
+            if (!parseDate(p, end, value.date))
+                return false;
+            value.time = 0;
+            if (p == end)
+                return true;
+            if (*p != ' ' && *p != 'T')
+                return false;
+            ++p;
+            return parseTime(p, end, value.time) && p == end;
+        default:
+            value.type = ParameterValue::pvNull;
+            return true;
+    }
+}
+
+// errors that affect the whole attachment, records aren't rejected for them
+static bool isConnectionError(const IBPP::SQLException& e)
+{
+    switch (e.EngineCode())
+    {
+        case 335544528L:    // isc_shutdown
+        case 335544721L:    // isc_network_error
+        case 335544741L:    // isc_lost_db_connection
+        case 335544856L:    // isc_att_shutdown
+            return true;
+    }
+    return false;
+}
+
+// length of the UTF-8 byte order mark at the start of the data
+static size_t getBomSize(const char* data, size_t size)
+{
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+        return 3;
+    return 0;
+}
+
+DataImporter::DataImporter(Database* database, Table* table,
+        const DataImportSettings& settings)
+    : databaseM(database), tableM(table), settingsM(settings),
+        fieldCountM(0), transcodeM(false), chunkRecordsM(chunkRecords),
+        dataM(0), sizeM(0), chunksInFlightM(0), chunkCountM(0),
+        nextChunkM(0), splitDoneM(false), insertDoneM(false),
+        cancelM(false), processedM(0), insertedM(0), rejectedM(0),
+        reportedRejectionsM(0), secondsM(0)
+{
+}
+
+DataImporter::~DataImporter()
+{
+}
+
+void DataImporter::addColumn(Column* column, int field)
+{
+    columnsM.push_back(column);
+    fieldsM.push_back(field);
+    fieldCountM = std::max(fieldCountM, field + 1);
+}
+
+void DataImporter::readFirstRecord(const DataImportSettings& settings,
+    wxMBConv* converter, std::vector<wxString>& fields)
+{
+    fields.clear();
+    wxFFile file(settings.fileName, "rb");
+    if (!file.IsOpened())
+        return;
+    std::vector<char> buffer(65536);
+    size_t size = file.Read(&buffer[0], buffer.size());
+    if (!size)
+        return;
+
+    const char* start = &buffer[0];
+    if (settings.utf8)
+    {
+        start += getBomSize(start, size);
+        converter = &wxConvUTF8;
+    }
+    if (!converter)
+        converter = wxConvCurrent;
+    std::vector<ImportField> parsed;
+    size_t count;
+    int64_t lines = 0;
+    parseRecord(start, &buffer[0] + size, settings.fieldDelimiter,
+        settings.textDelimiter, parsed, count, lines);
+    for (size_t i = 0; i < count; ++i)
+    {
+        fields.push_back(wxString(parsed[i].text.c_str(), *converter,
+            parsed[i].text.size()));
+    }
+}
+
+wxString DataImporter::getStateFileName(const wxString& fileName)
+{
+    return fileName + ".import";
+}
+
+wxString DataImporter::getRejectedFileName(const wxString& fileName)
+{
+    return fileName + ".rejected";
+}
+
+// the state file is only valid for the file it was written for
+static wxString getFileSignature(const wxString& fileName)
+{
+    wxFileName fn(fileName);
+    if (!fn.FileExists())
+        return wxEmptyString;
+    return fn.GetSize().ToString() + "/"
+        + wxLongLong(fn.GetModificationTime().GetTicks()).ToString();
+}
+
+bool DataImporter::readState(const wxString& fileName, const wxString& table,
+    DataImportPosition& position)
+{
+    wxString stateFileName(getStateFileName(fileName));
+    if (!wxFileExists(stateFileName))
+        return false;
+    wxFFile file(stateFileName, "rb");
+    wxString content;
+    if (!file.IsOpened() || !file.ReadAll(&content, wxConvUTF8))
+        return false;
+
+    std::map<wxString, wxString> values;
+    wxStringTokenizer tokenizer(content, "\n");
+    while (tokenizer.HasMoreTokens())
+    {
+        wxString token(tokenizer.GetNextToken());
+        values[token.BeforeFirst('=')] = token.AfterFirst('=');
+    }
+    if (values["table"] != table
+        || values["file"] != getFileSignature(fileName))
+    {
+        return false;
+    }
+
+    wxLongLong_t offset, line, inserted, rejected;
+    if (!values["offset"].ToLongLong(&offset)
+        || !values["line"].ToLongLong(&line)
+        || !values["inserted"].ToLongLong(&inserted)
+        || !values["rejected"].ToLongLong(&rejected))
+    {
+        return false;
+    }
+    position.offset = offset;
+    position.line = line;
+    position.inserted = inserted;
+    position.rejected = rejected;
+    return true;
+}
+
+void DataImporter::writeState(const DataImportPosition& position)
+{
+    wxString content("table=" + tableM->getQuotedName() + "\n"
+        + "file=" + getFileSignature(settingsM.fileName) + "\n"
+        + "offset=" + wxLongLong(position.offset).ToString() + "\n"
+        + "line=" + wxLongLong(position.line).ToString() + "\n"
+        + "inserted=" + wxLongLong(position.inserted).ToString() + "\n"
+        + "rejected=" + wxLongLong(position.rejected).ToString() + "\n");
+    wxFFile file(getStateFileName(settingsM.fileName), "wb");
+    if (!file.IsOpened() || !file.Write(content, wxConvUTF8))
+    {
+        throw FRError(_("Cannot write file: ")
+            + getStateFileName(settingsM.fileName));
+    }
+}
+
+void DataImporter::mapFile()
+{
+    regionM.reset();
+    dataM = 0;
+    sizeM = 0;
+    wxULongLong size = wxFileName::GetSize(settingsM.fileName);
+    if (size == wxInvalidSize)
+        throw FRError(_("Cannot open file: ") + settingsM.fileName);
+    if (size == 0)
+        return;
+
+    using namespace boost::interprocess;
+    try
+    {
+        std::string name(settingsM.fileName.mb_str(*wxConvFileName));
+        file_mapping mapping(name.c_str(), read_only);
+        regionM.reset(new mapped_region(mapping, read_only));
+    }
+    catch (interprocess_exception& e)
+    {
+        throw FRError(_("Cannot map file: ") + settingsM.fileName + "\n\n"
+            + e.what());
+    }
+    dataM = static_cast<const char*>(regionM->get_address());
+    sizeM = regionM->get_size();
+}
+
+bool DataImporter::run(bool resume, ProgressIndicator* progressIndicator)
+{
+    wxStopWatch stopWatch;
+    startM = DataImportPosition();
+    if (resume && !readState(settingsM.fileName, tableM->getQuotedName(),
+        startM))
+    {
+        startM = DataImportPosition();
+    }
+    bool restart = (startM.offset == 0);
+    rejectionsM.clear();
+
+    // the statements are checked and the parameter types are read with the
+    // main attachment
+    wxMBConv* converter = databaseM->getCharsetConverter();
+    {
+        IBPP::Transaction tr =
+            IBPP::TransactionFactory(databaseM->getIBPPDatabase());
+        tr->Start();
+        createBatchInsertSql(databaseM, tr, tableM->getQuotedName(),
+            columnsM, chunkRecords, sqlM);
+        tr->Commit();
+    }
+    chunkRecordsM = sqlM.blockRows * std::max(1, chunkRecords / sqlM.blockRows);
+    wxString charset(databaseM->getConnectionCharset().Upper());
+    transcodeM = settingsM.utf8 && charset != "UTF8"
+        && charset != "UNICODE_FSS";
+    nullTextM = wx2std(settingsM.nullText,
+        settingsM.utf8 ? &wxConvUTF8 : converter);
+
+    mapFile();
+    size_t offset = size_t(startM.offset);
+    int64_t line = startM.line;
+    std::string header;
+    if (restart)
+    {
+        offset = settingsM.utf8 ? getBomSize(dataM, sizeM) : 0;
+        line = 1;
+        if (settingsM.headerRow)
+        {
+            size_t start = offset;
+            offset = findRecordEnd(dataM + offset, dataM + sizeM,
+                settingsM.fieldDelimiter, settingsM.textDelimiter, line)
+                - dataM;
+            header.assign(dataM + start, offset - start);
+        }
+        startM.offset = offset;
+        startM.line = line;
+    }
+    if (offset > sizeM)
+        throw FRError(_("The file is smaller than the imported part."));
+
+    // the rejected records are written to a file that can be imported again
+    wxString rejectedFileName(getRejectedFileName(settingsM.fileName));
+    wxFFile rejectedFile(rejectedFileName, restart ? "wb" : "ab");
+    if (!rejectedFile.IsOpened())
+        throw FRError(_("Cannot write file: ") + rejectedFileName);
+    if (!header.empty())
+        rejectedFile.Write(header.data(), header.size());
+
+    IBPP::Database attachment(databaseM->createSecondaryAttachment());
+    attachment->Connect();
+
+    parseQueueM.clear();
+    parsedM.clear();
+    chunksInFlightM = chunkCountM = nextChunkM = 0;
+    splitDoneM = insertDoneM = cancelM = false;
+    errorM.clear();
+    processedM = offset;
+    insertedM = startM.inserted;
+    rejectedM = startM.rejected;
+    committedM = startM;
+    reportedRejectionsM = 0;
+
+    size_t parsers = boost::thread::hardware_concurrency();
+    parsers = std::max(size_t(1), std::min(parsers - 1, maxParserThreads));
+    boost::thread_group threads;
+    threads.create_thread(boost::bind(&DataImporter::splitRecords, this,
+        offset, line));
+    for (size_t i = 0; i < parsers; ++i)
+    {
+        // wxMBConv objects must not be shared between threads
+        boost::shared_ptr<wxMBConv> conv;
+        if (transcodeM)
+            conv.reset(converter->Clone());
+        threads.create_thread(boost::bind(&DataImporter::parseChunks, this,
+            conv));
+    }
+    threads.create_thread(boost::bind(&DataImporter::insertRows, this,
+        attachment));
+
+    if (progressIndicator)
+    {
+        progressIndicator->initProgress(_("Importing ")
+            + wxFileName(settingsM.fileName).GetFullName(), 1000);
+    }
+    try
+    {
+        int64_t stateOffset = startM.offset;
+        while (true)
+        {
+            DataImportPosition position;
+            std::vector<Rejection> rejections;
+            std::string rejectedText;
+            size_t processed;
+            int64_t inserted, rejected;
+            bool finished;
+            {
+                boost::lock_guard<boost::mutex> guard(lockM);
+                position = committedM;
+                rejections.swap(newRejectionsM);
+                rejectedText.swap(newRejectedTextM);
+                processed = processedM;
+                inserted = insertedM;
+                rejected = rejectedM;
+                finished = insertDoneM;
+            }
+
+            if (!rejectedText.empty())
+            {
+                rejectedFile.Write(rejectedText.data(), rejectedText.size());
+                rejectedFile.Flush();
+            }
+            for (size_t i = 0; i < rejections.size()
+                && rejectionsM.size() < maxReportedRejections; ++i)
+            {
+                rejectionsM.push_back(rejections[i]);
+            }
+            if (position.offset != stateOffset)
+            {
+                writeState(position);
+                stateOffset = position.offset;
+            }
+
+            if (progressIndicator)
+            {
+                double seconds = stopWatch.Time() / 1000.0;
+                int64_t rate = (seconds > 0)
+                    ? int64_t((inserted - startM.inserted) / seconds) : 0;
+                progressIndicator->setProgressMessage(wxString::Format(
+                    _("%s records imported (%s per second), %s rejected"),
+                    wxLongLong(inserted).ToString().c_str(),
+                    wxLongLong(rate).ToString().c_str(),
+                    wxLongLong(rejected).ToString().c_str()));
+                progressIndicator->setProgressPosition(
+                    sizeM ? size_t(processed * 1000.0 / sizeM) : 1000);
+                if (progressIndicator->isCanceled())
+                {
+                    boost::lock_guard<boost::mutex> guard(lockM);
+                    cancelM = true;
+                    changedM.notify_all();
+                }
+            }
+            if (finished)
+                break;
+            wxMilliSleep(50);
+        }
+    }
+    catch (...)
+    {
+        {
+            boost::lock_guard<boost::mutex> guard(lockM);
+            cancelM = true;
+            changedM.notify_all();
+        }
+        threads.join_all();
+        throw;
+    }
+    threads.join_all();
+    secondsM = stopWatch.Time() / 1000.0;
+
+    disconnectAttachment(attachment);
+    regionM.reset();
+    dataM = 0;
+
+    if (!errorM.empty())
+        throw FRError(errorM);
+    if (cancelM)
+        return false;
+    wxRemoveFile(getStateFileName(settingsM.fileName));
+    return true;
+}
+
+DataImportPosition DataImporter::getStartPosition() const
+{
+    return startM;
+}
+
+DataImportPosition DataImporter::getPosition()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    return committedM;
+}
+
+double DataImporter::getSeconds() const
+{
+    return secondsM;
+}
+
+const std::vector<DataImporter::Rejection>& DataImporter::getRejections()
+    const
+{
+    return rejectionsM;
+}
+
+bool DataImporter::isCanceled()
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    return cancelM;
+}
+
+// the first error cancels all other threads
+void DataImporter::setError(const std::string& error)
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    if (errorM.empty())
+        errorM = error;
+    cancelM = true;
+    changedM.notify_all();
+}
+
+// makes committed data and the rejections up to that point available to the
+// main thread
+void DataImporter::publish(const DataImportPosition& position,
+    std::vector<Rejection>& rejections, std::string& rejectedText)
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    committedM = position;
+    newRejectionsM.insert(newRejectionsM.end(), rejections.begin(),
+        rejections.end());
+    newRejectedTextM += rejectedText;
+    rejections.clear();
+    rejectedText.clear();
+}
+
+// splitter thread, the chunks end at record boundaries
+void DataImporter::splitRecords(size_t offset, int64_t line)
+{
+    size_t sequence = 0;
+    try
+    {
+        const char* end = dataM + sizeM;
+        const char* p = dataM + offset;
+        while (p < end)
+        {
+            {
+                boost::unique_lock<boost::mutex> lock(lockM);
+                while (!cancelM && chunksInFlightM >= maxChunksInFlight)
+                    changedM.wait(lock);
+                if (cancelM)
+                    break;
+            }
+
+            ImportChunkPtr chunk(new ImportChunk);
+            chunk->sequence = sequence++;
+            chunk->offset = p - dataM;
+            chunk->line = line;
+            const char* limit = p + std::min(chunkBytes, size_t(end - p));
+            for (int records = 0; p < end && records < chunkRecordsM
+                && p < limit; ++records)
+            {
+                p = findRecordEnd(p, end, settingsM.fieldDelimiter,
+                    settingsM.textDelimiter, line);
+            }
+            chunk->endOffset = p - dataM;
+            chunk->endLine = line;
+
+            boost::lock_guard<boost::mutex> guard(lockM);
+            parseQueueM.push_back(chunk);
+            ++chunksInFlightM;
+            changedM.notify_all();
+        }
+    }
+    catch (std::exception& e)
+    {
+        setError(e.what());
+    }
+
+    boost::lock_guard<boost::mutex> guard(lockM);
+    splitDoneM = true;
+    chunkCountM = sequence;
+    changedM.notify_all();
+}
+
+DataImporter::ImportChunkPtr DataImporter::getChunkToParse()
+{
+    boost::unique_lock<boost::mutex> lock(lockM);
+    while (!cancelM && parseQueueM.empty() && !splitDoneM)
+        changedM.wait(lock);
+    if (cancelM || parseQueueM.empty())
+        return ImportChunkPtr();
+    ImportChunkPtr chunk(parseQueueM.front());
+    parseQueueM.pop_front();
+    return chunk;
+}
+
+// parser threads
+void DataImporter::parseChunks(boost::shared_ptr<wxMBConv> converter)
+{
+    try
+    {
+        ImportChunkPtr chunk;
+        while ((chunk = getChunkToParse()))
+        {
+            parseChunk(*chunk, converter.get());
+            boost::lock_guard<boost::mutex> guard(lockM);
+            parsedM[chunk->sequence] = chunk;
+            changedM.notify_all();
+        }
+    }
+    catch (std::exception& e)
+    {
+        setError(e.what());
+    }
+}
+
+void DataImporter::parseChunk(ImportChunk& chunk, wxMBConv* converter)
+{
+    const char* p = dataM + chunk.offset;
+    const char* end = dataM + chunk.endOffset;
+    size_t columns = columnsM.size();
+    std::vector<ImportField> fields;
+    std::vector<ParameterValue> row(columns);
+    int64_t line = chunk.line;
+    chunk.rows = 0;
+    while (p < end)
+    {
+        const char* start = p;
+        RecordPosition position;
+        position.line = line;
+        position.offset = start - dataM;
+        size_t count;
+        p = parseRecord(p, end, settingsM.fieldDelimiter,
+            settingsM.textDelimiter, fields, count, line);
+        position.size = p - start;
+
+        // empty lines are skipped
+        if (count == 1 && !fields[0].quoted && fields[0].text.empty())
+            continue;
+
+        Rejection rejection;
+        rejection.line = position.line;
+        rejection.offset = position.offset;
+        rejection.size = position.size;
+        rejection.column = -1;
+        if (int(count) < fieldCountM)
+        {
+            rejection.reason = rrFieldCount;
+            std::ostringstream os;
+            os << count;
+            rejection.detail = os.str();
+            chunk.rejections.push_back(rejection);
+            continue;
+        }
+        for (size_t i = 0; i < columns; ++i)
+        {
+            if (!convertField(fields[fieldsM[i]], sqlM.types[i],
+                sqlM.scales[i], nullTextM, converter, row[i]))
+            {
+                rejection.reason = rrValue;
+                rejection.column = int(i);
+                rejection.detail = fields[fieldsM[i]].text;
+                break;
+            }
+        }
+        if (rejection.column >= 0)
+        {
+            chunk.rejections.push_back(rejection);
+            continue;
+        }
+        chunk.values.insert(chunk.values.end(), row.begin(), row.end());
+        chunk.positions.push_back(position);
+        ++chunk.rows;
+    }
+}
+
+DataImporter::ImportChunkPtr DataImporter::getParsedChunk()
+{
+    boost::unique_lock<boost::mutex> lock(lockM);
+    while (!cancelM)
+    {
+        std::map<size_t, ImportChunkPtr>::iterator it =
+            parsedM.find(nextChunkM);
+        if (it != parsedM.end())
+        {
+            ImportChunkPtr chunk((*it).second);
+            parsedM.erase(it);
+            ++nextChunkM;
+            --chunksInFlightM;
+            changedM.notify_all();
+            return chunk;
+        }
+        if (splitDoneM && nextChunkM >= chunkCountM)
+            break;
+        changedM.wait(lock);
+    }
+    return ImportChunkPtr();
+}
+
+// inserting thread, the chunks are inserted in file order so everything up
+// to the end of the last committed chunk has been imported
+void DataImporter::insertRows(IBPP::Database attachment)
+{
+    try
+    {
+        IBPP::Transaction tr = IBPP::TransactionFactory(attachment);
+        tr->Start();
+        BatchInserter inserter(attachment, tr, sqlM);
+        DataImportPosition position(startM);
+        std::vector<Rejection> rejections;
+        std::string rejectedText;
+        unsigned uncommitted = 0;
+        ImportChunkPtr chunk;
+        while ((chunk = getParsedChunk()))
+        {
+            int inserted = insertChunk(*chunk, inserter, rejections,
+                rejectedText);
+            int rejected = int(chunk->rejections.size()) + chunk->rows
+                - inserted;
+            position.offset = chunk->endOffset;
+            position.line = chunk->endLine;
+            position.inserted += inserted;
+            position.rejected += rejected;
+            {
+                boost::lock_guard<boost::mutex> guard(lockM);
+                processedM = chunk->endOffset;
+                insertedM += inserted;
+                rejectedM += rejected;
+            }
+
+            uncommitted += chunk->rows;
+            if (settingsM.commitInterval
+                && uncommitted >= settingsM.commitInterval)
+            {
+                tr->Commit();
+                tr->Start();
+                uncommitted = 0;
+                publish(position, rejections, rejectedText);
+            }
+        }
+        if (isCanceled())
+            tr->Rollback();
+        else
+        {
+            tr->Commit();
+            publish(position, rejections, rejectedText);
+        }
+    }
+    catch (std::exception& e)
+    {
+        setError(e.what());
+    }
+
+    boost::lock_guard<boost::mutex> guard(lockM);
+    insertDoneM = true;
+    changedM.notify_all();
+}
+
+// returns the number of inserted records, the rows of a failed EXECUTE
+// BLOCK are inserted one by one to find the rejected ones
+int DataImporter::insertChunk(ImportChunk& chunk, BatchInserter& inserter,
+    std::vector<Rejection>& rejections, std::string& rejectedText)
+{
+    std::vector<Rejection> chunkRejections(chunk.rejections);
+    int columns = columnsM.size();
+    int blockRows = inserter.getBlockRows();
+    int inserted = 0;
+    for (int r = 0; r < chunk.rows; )
+    {
+        int rows = (chunk.rows - r >= blockRows) ? blockRows : 1;
+        const ParameterValue* values = &chunk.values[r * columns];
+        if (rows > 1)
+        {
+            try
+            {
+                inserter.insert(values, rows);
+                inserted += rows;
+                r += rows;
+                continue;
+            }
+            catch (IBPP::SQLException& e)
+            {
+                if (isConnectionError(e))
+                    throw;
+            }
+        }
+        for (int i = 0; i < rows; ++i)
+        {
+            try
+            {
+                inserter.insertRow(values + i * columns);
+                ++inserted;
+            }
+            catch (IBPP::SQLException& e)
+            {
+                if (isConnectionError(e))
+                    throw;
+                const RecordPosition& position(chunk.positions[r + i]);
+                Rejection rejection;
+                rejection.line = position.line;
+                rejection.reason = rrInsert;
+                rejection.column = -1;
+                rejection.detail = e.what();
+                rejection.offset = position.offset;
+                rejection.size = position.size;
+                chunkRejections.push_back(rejection);
+            }
+        }
+        r += rows;
+    }
+
+    std::sort(chunkRejections.begin(), chunkRejections.end(),
+        RejectionOffsetLess());
+    for (std::vector<Rejection>::iterator it = chunkRejections.begin();
+        it != chunkRejections.end(); ++it)
+    {
+        reject(*it, rejections, rejectedText);
+    }
+    return inserted;
+}
+
+void DataImporter::reject(const Rejection& rejection,
+    std::vector<Rejection>& rejections, std::string& rejectedText)
+{
+    if (reportedRejectionsM < maxReportedRejections)
+    {
+        rejections.push_back(rejection);
+        ++reportedRejectionsM;
+    }
+    rejectedText.append(dataM + rejection.offset, rejection.size);
+    if (rejection.size == 0 || dataM[rejection.offset + rejection.size - 1]
+        != '\n')
+    {
+        rejectedText += '\n';
+    }
+}
@@ -0,0 +1,203 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_DATAIMPORTER_H
+#define FR_DATAIMPORTER_H
+
+#include <wx/string.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <ibpp.h>
+
+#include "engine/BatchInsert.h"
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+class Column;
+class Database;
+class ProgressIndicator;
+class Table;
+
+// Format of a delimited text file and how it is imported.
+struct DataImportSettings
+{
+    wxString fileName;
+    char fieldDelimiter;
+    // '\0' if text fields aren't delimited
+    char textDelimiter;
+    bool headerRow;
+    // the file is either UTF-8 encoded or uses the connection character set
+    bool utf8;
+    // fields with this text, and empty fields without text delimiters, are
+    // imported as NULL
+    wxString nullText;
+    // number of records after which the data is committed, with 0 it is
+    // committed once at the end
+    unsigned commitInterval;
+
+    DataImportSettings();
+};
+
+// Position of the first record that hasn't been committed yet, and the
+// number of records imported and rejected before.
+struct DataImportPosition
+{
+    int64_t offset;
+    int64_t line;
+    int64_t inserted;
+    int64_t rejected;
+
+    DataImportPosition();
+};
+
+// Imports a delimited text file (like the CSV files written by the data
+// grid) into a table.  The file is memory-mapped and split into chunks of
+// records in one thread, the chunks are parsed and converted to parameter
+// values by several worker threads, and a single thread inserts them in
+// file order on a secondary attachment, committing at chunk boundaries.
+// The position of the last commit is stored next to the file, so an
+// interrupted import can be resumed.  Rejected records are written to
+// another file next to it, so they can be fixed and imported again.
+class DataImporter
+{
+public:
+    enum RejectReason { rrFieldCount, rrValue, rrInsert };
+    struct Rejection
+    {
+        int64_t line;
+        RejectReason reason;
+        // index of the column for rrValue
+        int column;
+        // field count, field value or error message
+        std::string detail;
+        // the record in the file
+        int64_t offset;
+        size_t size;
+    };
+private:
+    struct ImportChunk;
+    typedef boost::shared_ptr<ImportChunk> ImportChunkPtr;
+
+    Database* databaseM;
+    Table* tableM;
+    DataImportSettings settingsM;
+    std::vector<Column*> columnsM;
+    std::vector<int> fieldsM;
+    int fieldCountM;
+
+    // set up in the main thread before the worker threads are started
+    BatchInsertSql sqlM;
+    std::string nullTextM;
+    bool transcodeM;
+    int chunkRecordsM;
+    boost::scoped_ptr<boost::interprocess::mapped_region> regionM;
+    const char* dataM;
+    size_t sizeM;
+
+    // state shared with the worker threads
+    boost::mutex lockM;
+    boost::condition_variable changedM;
+    std::deque<ImportChunkPtr> parseQueueM;
+    std::map<size_t, ImportChunkPtr> parsedM;
+    size_t chunksInFlightM;
+    size_t chunkCountM;
+    size_t nextChunkM;
+    bool splitDoneM;
+    bool insertDoneM;
+    bool cancelM;
+    std::string errorM;
+    size_t processedM;
+    int64_t insertedM;
+    int64_t rejectedM;
+    DataImportPosition committedM;
+    std::vector<Rejection> newRejectionsM;
+    std::string newRejectedTextM;
+
+    // inserting thread only
+    size_t reportedRejectionsM;
+
+    // main thread only
+    DataImportPosition startM;
+    std::vector<Rejection> rejectionsM;
+    double secondsM;
+
+    void mapFile();
+    void writeState(const DataImportPosition& position);
+    void publish(const DataImportPosition& position,
+        std::vector<Rejection>& rejections, std::string& rejectedText);
+
+    // run in worker threads
+    void splitRecords(size_t offset, int64_t line);
+    void parseChunks(boost::shared_ptr<wxMBConv> converter);
+    void parseChunk(ImportChunk& chunk, wxMBConv* converter);
+    void insertRows(IBPP::Database attachment);
+    int insertChunk(ImportChunk& chunk, BatchInserter& inserter,
+        std::vector<Rejection>& rejections, std::string& rejectedText);
+    void reject(const Rejection& rejection,
+        std::vector<Rejection>& rejections, std::string& rejectedText);
+    ImportChunkPtr getChunkToParse();
+    ImportChunkPtr getParsedChunk();
+    bool isCanceled();
+    void setError(const std::string& error);
+public:
+    DataImporter(Database* database, Table* table,
+        const DataImportSettings& settings);
+    ~DataImporter();
+
+    // the column gets the value of the field with the (0-based) index
+    void addColumn(Column* column, int field);
+
+    // reads the fields of the first record, to be shown for the mapping
+    // the converter is used if the file isn't UTF-8 encoded
+    static void readFirstRecord(const DataImportSettings& settings,
+        wxMBConv* converter, std::vector<wxString>& fields);
+    // the files with the position of an unfinished import and with the
+    // rejected records
+    static wxString getStateFileName(const wxString& fileName);
+    static wxString getRejectedFileName(const wxString& fileName);
+    // returns true if an unfinished import of the unchanged file into the
+    // table can be resumed
+    static bool readState(const wxString& fileName, const wxString& table,
+        DataImportPosition& position);
+
+    // continues an unfinished import if resume is true, returns false if
+    // canceled, throws on errors other than rejected records
+    bool run(bool resume, ProgressIndicator* progressIndicator = 0);
+
+    // only valid after run()
+    DataImportPosition getStartPosition() const;
+    DataImportPosition getPosition();
+    double getSeconds() const;
+    // the first rejected records of this run
+    const std::vector<Rejection>& getRejections() const;
+};
+
+#endif // FR_DATAIMPORTER_H
@@ -0,0 +1,203 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <boost/bind.hpp>
+
+#include "engine/MetadataChangeDetector.h"
+
+// needs the HASH() function of Firebird 2.1 or later, hashes are reduced
+// so the combined markers can't overflow
+static const char* const objectVersionsSql =
+    "select 'R', r.rdb$relation_name, cast(r.rdb$format as bigint)"
+    " from rdb$relations r"
+    " where coalesce(r.rdb$system_flag, 0) = 0"
+    " and r.rdb$view_source is null"
+    " union all"
+    " select 'V', r.rdb$relation_name,"
+    " mod(coalesce(hash(r.rdb$view_source), 0), 1000000007) * 1000"
+    " + coalesce(r.rdb$format, 0)"
+    " from rdb$relations r"
+    " where coalesce(r.rdb$system_flag, 0) = 0"
+    " and r.rdb$view_source is not null"
+    " union all"
+    " select 'P', p.rdb$procedure_name,"
+    " mod(coalesce(hash(p.rdb$procedure_source), 0), 1000000007)"
+    " from rdb$procedures p"
+    " where coalesce(p.rdb$system_flag, 0) = 0"
+    " union all"
+    " select 'T', t.rdb$trigger_name,"
+    " (mod(coalesce(hash(t.rdb$trigger_source), 0), 1000000007) * 2"
+    " + coalesce(t.rdb$trigger_inactive, 0)) * 65536"
+    " + mod(coalesce(t.rdb$trigger_sequence, 0), 65536)"
+    " from rdb$triggers t"
+    " where coalesce(t.rdb$system_flag, 0) = 0"
+    " union all"
+    " select 'D', f.rdb$field_name,"
+    " mod(hash(f.rdb$field_type || '/' || coalesce(f.rdb$field_sub_type, 0)"
+    " || '/' || coalesce(f.rdb$field_length, 0)"
+    " || '/' || coalesce(f.rdb$field_scale, 0)"
+    " || '/' || coalesce(f.rdb$character_length, 0)"
+    " || '/' || coalesce(f.rdb$collation_id, 0)"
+    " || '/' || coalesce(f.rdb$null_flag, 0)), 1000000007)"
+    " + mod(coalesce(hash(f.rdb$default_source), 0), 1000000007)"
+    " + mod(coalesce(hash(f.rdb$validation_source), 0), 1000000007)"
+    " from rdb$fields f"
+    " where coalesce(f.rdb$system_flag, 0) = 0"
+    " and f.rdb$field_name not starting with 'RDB$'"
+    " union all"
+    " select 'E', e.rdb$exception_name,"
+    " mod(coalesce(hash(e.rdb$message), 0), 1000000007)"
+    " from rdb$exceptions e"
+    " union all"
+    " select 'G', g.rdb$generator_name, cast(0 as bigint)"
+    " from rdb$generators g"
+    " where coalesce(g.rdb$system_flag, 0) = 0"
+    " union all"
+    " select 'F', f.rdb$function_name, cast(0 as bigint)"
+    " from rdb$functions f"
+    " where coalesce(f.rdb$system_flag, 0) = 0"
+    " union all"
+    " select 'O', r.rdb$role_name, cast(0 as bigint)"
+    " from rdb$roles r"
+    " where coalesce(r.rdb$system_flag, 0) = 0";
+
+MetadataChangeDetector::MetadataChangeDetector(
+        SharedAttachmentPtr attachment)
+    : stateM(new State)
+{
+    stateM->attachment = attachment;
+    stateM->running = false;
+    stateM->cancel = false;
+    stateM->resultAvailable = false;
+    stateM->resultTag = 0;
+}
+
+MetadataChangeDetector::~MetadataChangeDetector()
+{
+    boost::lock_guard<boost::mutex> guard(stateM->lock);
+    stateM->cancel = true;
+}
+
+void MetadataChangeDetector::start(unsigned tag)
+{
+    {
+        boost::lock_guard<boost::mutex> guard(stateM->lock);
+        if (stateM->running)
+            return;
+        stateM->running = true;
+    }
+    boost::thread thread(boost::bind(&MetadataChangeDetector::run, stateM,
+        tag));
+    thread.detach();
+}
+
+bool MetadataChangeDetector::getResult(ObjectVersions& versions,
+    unsigned& tag)
+{
+    boost::lock_guard<boost::mutex> guard(stateM->lock);
+    if (!stateM->resultAvailable)
+        return false;
+    versions.swap(stateM->result);
+    stateM->result.clear();
+    stateM->resultAvailable = false;
+    tag = stateM->resultTag;
+    return true;
+}
+
+/*static*/
+bool MetadataChangeDetector::isCanceled(State& state)
+{
+    boost::lock_guard<boost::mutex> guard(state.lock);
+    return state.cancel;
+}
+
+/*static*/
+void MetadataChangeDetector::run(StatePtr state, unsigned tag)
+{
+    ObjectVersions versions;
+    bool ok = false;
+    try
+    {
+        SharedAttachment::Lock lock(*state->attachment);
+        if (!isCanceled(*state))
+        {
+            try
+            {
+                readVersions(*state, lock.getDatabase(), versions);
+                ok = !isCanceled(*state);
+            }
+            catch (IBPP::Exception&)
+            {
+                // the next check will reconnect
+                lock.disconnect();
+            }
+        }
+    }
+    catch (std::exception&)
+    {
+        // the attachment has been closed
+    }
+
+    boost::lock_guard<boost::mutex> guard(state->lock);
+    if (ok && !state->cancel)
+    {
+        state->result.swap(versions);
+        state->resultTag = tag;
+        state->resultAvailable = true;
+    }
+    state->running = false;
+}
+
+/*static*/
+void MetadataChangeDetector::readVersions(State& state,
+    IBPP::Database& database, ObjectVersions& versions)
+{
+    IBPP::Transaction tr = IBPP::TransactionFactory(database, IBPP::amRead);
+    tr->Start();
+    IBPP::Statement st1 = IBPP::StatementFactory(database, tr);
+    st1->Execute(objectVersionsSql);
+    while (st1->Fetch())
+    {
+        if (isCanceled(state))
+            break;
+        ObjectVersion ov;
+        std::string kind;
+        st1->Get(1, kind);
+        ov.kind = kind.empty() ? ' ' : kind[0];
+        st1->Get(2, ov.name);
+        ov.version = 0;
+        if (!st1->IsNull(3))
+            st1->Get(3, ov.version);
+        versions.push_back(ov);
+    }
+    tr->Commit();
+}
@@ -0,0 +1,91 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_METADATACHANGEDETECTOR_H
+#define FR_METADATACHANGEDETECTOR_H
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <ibpp.h>
+
+#include "engine/SharedAttachment.h"
+
+// Reads a version marker for every user object of a database in a
+// background thread, using the shared attachment of the database.  The markers are
+// cheap to compute on the server (record formats, hashes of the sources)
+// and change whenever the object is altered by any connection.
+class MetadataChangeDetector
+{
+public:
+    // object kinds, used as first column of the statement
+    enum ObjectKind
+    {
+        okTable = 'R', okView = 'V', okProcedure = 'P', okTrigger = 'T',
+        okDomain = 'D', okException = 'E', okGenerator = 'G',
+        okFunction = 'F', okRole = 'O'
+    };
+    struct ObjectVersion
+    {
+        char kind;
+        std::string name;
+        int64_t version;
+    };
+    typedef std::vector<ObjectVersion> ObjectVersions;
+private:
+    // shared with the thread, which may still run when the detector has
+    // been destroyed
+    struct State
+    {
+        SharedAttachmentPtr attachment;
+        boost::mutex lock;
+        bool running;
+        bool cancel;
+        bool resultAvailable;
+        unsigned resultTag;
+        ObjectVersions result;
+    };
+    typedef boost::shared_ptr<State> StatePtr;
+    StatePtr stateM;
+
+    static void run(StatePtr state, unsigned tag);
+    static bool isCanceled(State& state);
+    static void readVersions(State& state, IBPP::Database& database,
+        ObjectVersions& versions);
+public:
+    MetadataChangeDetector(SharedAttachmentPtr attachment);
+    // cancels a running check without waiting for it
+    ~MetadataChangeDetector();
+
+    // starts a new check unless one is still running, the tag is returned
+    // along with the result of the check
+    void start(unsigned tag);
+    // returns true once with the versions read by the last check, checks
+    // that failed don't return a result
+    bool getResult(ObjectVersions& versions, unsigned& tag);
+};
+
+#endif // FR_METADATACHANGEDETECTOR_H
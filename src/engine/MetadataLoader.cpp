@@ -30,6 +30,8 @@
     #include "wx/wx.h"
 #endif
 
+#include <wx/stopwatch.h>
+
 #include "engine/MetadataLoader.h"
 #include "metadata/database.h"
 
@@ -37,6 +39,10 @@ MetadataLoader::MetadataLoader(Database& database, unsigned maxStatements)
     : databaseM(database.getIBPPDatabase()), transactionM(),
         transactionLevelM(0), statementsM(), maxStatementsM(maxStatements)
 {
+    statisticsM.hits = 0;
+    statisticsM.misses = 0;
+    statisticsM.evictions = 0;
+    statisticsM.prepareMillis = 0;
 }
 
 void MetadataLoader::transactionStart()
@@ -59,19 +65,22 @@ void MetadataLoader::transactionStart()
     }
 
     if (transactionM == 0)
+    {
+        // cached statements are attached to the old transaction object
+        statementsM.clear();
+        statementIndexM.clear();
         transactionM = IBPP::TransactionFactory(databaseM, IBPP::amRead);
+    }
     if (!transactionM->Started())
         transactionM->Start();
 }
 
 void MetadataLoader::transactionCommit()
 {
+    // the transaction object is kept, so the prepared statements attached
+    // to it stay valid when it is restarted
     if (--transactionLevelM == 0 && transactionM != 0)
-    {
-        statementsM.clear();
         transactionM->Commit();
-        transactionM = 0;
-    }
 }
 
 bool MetadataLoader::transactionStarted()
@@ -89,31 +98,42 @@ IBPP::Statement MetadataLoader::createStatement(const std::string& sql)
 MetadataLoader::IBPPStatementListIterator MetadataLoader::findStatement(
     const std::string& sql)
 {
-    for (IBPPStatementListIterator it = statementsM.begin();
-        it != statementsM.end(); ++it)
-    {
-        if ((*it)->Sql() == sql)
-            return it;
-    }
-    return statementsM.end();
+    IBPPStatementMap::iterator it = statementIndexM.find(sql);
+    if (it == statementIndexM.end())
+        return statementsM.end();
+    return (*it).second;
 }
 
 IBPP::Statement& MetadataLoader::getStatement(const std::string& sql)
 {
     wxASSERT(transactionStarted());
 
-    IBPP::Statement stmt;
     IBPPStatementListIterator it = findStatement(sql);
     if (it != statementsM.end())
     {
-        stmt = (*it);
-        statementsM.erase(it);
-    }
-    else
-    {
-        stmt = IBPP::StatementFactory(databaseM, transactionM, sql);
+        // move to the front of the list, iterators stay valid
+        statementsM.splice(statementsM.begin(), statementsM, it);
+        IBPP::Statement& stmt = statementsM.front();
+        // statements are closed by IBPP when fetching fails
+        if (stmt->Type() != IBPP::stUnknown)
+        {
+            ++statisticsM.hits;
+            return stmt;
+        }
+        ++statisticsM.misses;
+        wxStopWatch sw;
+        stmt->Prepare(sql);
+        statisticsM.prepareMillis += sw.Time();
+        return stmt;
     }
+
+    ++statisticsM.misses;
+    wxStopWatch sw;
+    IBPP::Statement stmt = IBPP::StatementFactory(databaseM, transactionM,
+        sql);
+    statisticsM.prepareMillis += sw.Time();
     statementsM.push_front(stmt);
+    statementIndexM[sql] = statementsM.begin();
     limitListSize();
     return statementsM.front();
 }
@@ -123,13 +143,18 @@ void MetadataLoader::limitListSize()
     if (maxStatementsM)
     {
         while (statementsM.size() > maxStatementsM)
-            statementsM.remove(statementsM.back());
+        {
+            statementIndexM.erase(statementsM.back()->Sql());
+            statementsM.pop_back();
+            ++statisticsM.evictions;
+        }
     }
 }
 
 void MetadataLoader::releaseStatements()
 {
     statementsM.clear();
+    statementIndexM.clear();
     if (transactionM != 0 && transactionM->Started())
     {
         transactionM->Commit();
@@ -146,6 +171,22 @@ void MetadataLoader::setMaximumConcurrentStatements(unsigned count)
     }
 }
 
+unsigned MetadataLoader::getMaximumConcurrentStatements() const
+{
+    return maxStatementsM;
+}
+
+size_t MetadataLoader::getStatementCount() const
+{
+    return statementsM.size();
+}
+
+const MetadataLoader::StatementCacheStatistics&
+    MetadataLoader::getStatistics() const
+{
+    return statisticsM;
+}
+
 IBPP::Blob MetadataLoader::createBlob()
 {
     wxASSERT(transactionStarted());
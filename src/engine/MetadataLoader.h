@@ -27,6 +27,8 @@
 #include <list>
 #include <string>
 
+#include <boost/unordered_map.hpp>
+
 #include <ibpp.h>
 
 class Database;
@@ -34,9 +36,20 @@ class MetadataLoaderTransaction;
 
 class MetadataLoader
 {
+public:
+    // counters of the prepared statement cache, shown on the database page
+    struct StatementCacheStatistics
+    {
+        unsigned hits;
+        unsigned misses;
+        unsigned evictions;
+        long prepareMillis;
+    };
 private:
     typedef std::list<IBPP::Statement> IBPPStatementList;
     typedef std::list<IBPP::Statement>::iterator IBPPStatementListIterator;
+    typedef boost::unordered_map<std::string, IBPPStatementListIterator>
+        IBPPStatementMap;
 
     friend class MetadataLoaderTransaction;
 
@@ -44,8 +57,12 @@ private:
     IBPP::Transaction transactionM;
     unsigned transactionLevelM;
 
+    // statementsM holds the prepared statements with the most recently used
+    // one first, statementIndexM maps their sql to the list position
     std::list<IBPP::Statement> statementsM;
+    IBPPStatementMap statementIndexM;
     unsigned maxStatementsM;
+    StatementCacheStatistics statisticsM;
     // Returns an iterator to the prepared IBPP::Statement object
     // for the sql statement if available, else returns statementsM.end().
     IBPPStatementListIterator findStatement(const std::string& sql);
@@ -56,7 +73,9 @@ private:
     // The first call of transactionStart() starts the transaction, further
     // calls only increment transactionLevelM.  Calls to transactionCommit()
     // decrease transactionLevelM, when it reaches 0 the transaction itself
-    // is committed.
+    // is committed.  The transaction object is restarted by the next call
+    // of transactionStart(), so the prepared statements attached to it can
+    // be kept and reused.
     // Methods are private, use of MetadataLoaderTransaction class is
     // exception-safe and allows for proper synchronization with locks
     // on metadata items (first unlock the object, then commit transaction)
@@ -79,8 +98,8 @@ public:
     // statements will not be replaced.
     IBPP::Statement createStatement(const std::string& sql);
     // returns a reference to a prepared IBPP::Statement object for the
-    // sql statement, either recycled, newly created, or newly prepared
-    // using the least recently used IBPP::Statement in statementsM
+    // sql statement, either recycled, or newly prepared while releasing the
+    // least recently used IBPP::Statement in statementsM if necessary
     IBPP::Statement& getStatement(const std::string& sql);
     // releases any assigned IBPP::Statement objects while keeping the maximum
     // number of objects untouched
@@ -91,6 +110,9 @@ public:
     // statementsM list, and could possibly consume a lot of the available
     // server ressources!
     void setMaximumConcurrentStatements(unsigned count);
+    unsigned getMaximumConcurrentStatements() const;
+    size_t getStatementCount() const;
+    const StatementCacheStatistics& getStatistics() const;
 
     // Creates an IBPP::Blob object using the database and transaction
     IBPP::Blob createBlob();
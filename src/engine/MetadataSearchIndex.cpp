@@ -0,0 +1,435 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+#include <iterator>
+
+#include <boost/bind.hpp>
+
+#include "core/FRError.h"
+#include "core/StringUtils.h"
+#include "engine/MetadataSearchIndex.h"
+
+// every statement returns kind, name, description and optionally the source,
+// they are executed separately so a failing one (system table columns that
+// don't exist in older server versions) doesn't prevent the others
+static const char* const objectsSql[] =
+{
+    "select case when rdb$view_blr is null then 'R' else 'V' end,"
+    " rdb$relation_name, rdb$description, rdb$view_source"
+    " from rdb$relations where coalesce(rdb$system_flag, 0) = 0",
+
+    "select 'P', rdb$procedure_name, rdb$description, rdb$procedure_source"
+    " from rdb$procedures where coalesce(rdb$system_flag, 0) = 0",
+
+    "select 'T', rdb$trigger_name, rdb$description, rdb$trigger_source"
+    " from rdb$triggers where coalesce(rdb$system_flag, 0) = 0",
+
+    "select 'D', rdb$field_name, rdb$description, rdb$validation_source"
+    " from rdb$fields where coalesce(rdb$system_flag, 0) = 0"
+    " and rdb$field_name not starting with 'RDB$'",
+
+    "select 'E', rdb$exception_name, rdb$description, rdb$message"
+    " from rdb$exceptions",
+
+    "select 'G', rdb$generator_name, rdb$description"
+    " from rdb$generators where coalesce(rdb$system_flag, 0) = 0",
+
+    "select 'F', rdb$function_name, rdb$description"
+    " from rdb$functions where coalesce(rdb$system_flag, 0) = 0",
+
+    "select 'O', rdb$role_name, rdb$description"
+    " from rdb$roles where coalesce(rdb$system_flag, 0) = 0"
+};
+
+// columns of relations and parameters of procedures
+static const char* const fieldsSql =
+    "select 'R', rdb$relation_name, rdb$field_name"
+    " from rdb$relation_fields where coalesce(rdb$system_flag, 0) = 0"
+    " union all"
+    " select 'P', rdb$procedure_name, rdb$parameter_name"
+    " from rdb$procedure_parameters";
+
+static NodeType getNodeTypeOfKind(char kind)
+{
+    switch (kind)
+    {
+        case 'R': return ntTable;
+        case 'V': return ntView;
+        case 'P': return ntProcedure;
+        case 'T': return ntTrigger;
+        case 'D': return ntDomain;
+        case 'E': return ntException;
+        case 'G': return ntGenerator;
+        case 'F': return ntFunction;
+        case 'O': return ntRole;
+    }
+    return ntUnknown;
+}
+
+static bool isTokenChar(wxChar c)
+{
+    return wxIsalnum(c) || c == '_' || c == '$';
+}
+
+// splits text into the runs of identifier characters
+static void getTokens(const wxString& text, std::vector<wxString>& tokens)
+{
+    size_t start = wxString::npos;
+    for (size_t i = 0; i <= text.size(); ++i)
+    {
+        bool tokenChar = i < text.size() && isTokenChar(text[i]);
+        if (tokenChar && start == wxString::npos)
+            start = i;
+        else if (!tokenChar && start != wxString::npos)
+        {
+            tokens.push_back(text.Mid(start, i - start));
+            start = wxString::npos;
+        }
+    }
+}
+
+MetadataSearchIndex::MetadataSearchIndex(SharedAttachmentPtr attachment,
+        wxMBConv* converter)
+    : stateM(new State), converterM(converter), readyM(false)
+{
+    stateM->attachment = attachment;
+    stateM->generation = 0;
+    stateM->running = false;
+    stateM->resultAvailable = false;
+}
+
+MetadataSearchIndex::~MetadataSearchIndex()
+{
+    boost::lock_guard<boost::mutex> guard(stateM->lock);
+    ++stateM->generation;
+}
+
+void MetadataSearchIndex::start()
+{
+    if (readyM)
+        return;
+    unsigned generation;
+    {
+        boost::lock_guard<boost::mutex> guard(stateM->lock);
+        if (stateM->running || stateM->resultAvailable)
+            return;
+        stateM->running = true;
+        stateM->error.clear();
+        generation = stateM->generation;
+    }
+    boost::thread thread(boost::bind(&MetadataSearchIndex::run, stateM,
+        generation));
+    thread.detach();
+}
+
+bool MetadataSearchIndex::checkReady()
+{
+    if (readyM)
+        return true;
+
+    RawEntries entries;
+    {
+        boost::lock_guard<boost::mutex> guard(stateM->lock);
+        if (!stateM->error.empty())
+        {
+            wxString msg(stateM->error);
+            stateM->error.clear();
+            throw FRError(msg);
+        }
+        if (!stateM->resultAvailable)
+            return false;
+        entries.swap(stateM->result);
+        stateM->resultAvailable = false;
+    }
+    buildIndex(entries);
+    readyM = true;
+    return true;
+}
+
+void MetadataSearchIndex::invalidate()
+{
+    {
+        // a load that is running may have read the old metadata already,
+        // its result is discarded
+        boost::lock_guard<boost::mutex> guard(stateM->lock);
+        ++stateM->generation;
+        stateM->running = false;
+        stateM->resultAvailable = false;
+        stateM->result.clear();
+        stateM->error.clear();
+    }
+    readyM = false;
+    entriesM.clear();
+    for (int i = tkName; i <= tkSource; ++i)
+        tokensM[i].clear();
+}
+
+/*static*/
+bool MetadataSearchIndex::isCanceled(State& state, unsigned generation)
+{
+    boost::lock_guard<boost::mutex> guard(state.lock);
+    return state.generation != generation;
+}
+
+/*static*/
+void MetadataSearchIndex::run(StatePtr state, unsigned generation)
+{
+    RawEntries entries;
+    std::string error;
+    try
+    {
+        SharedAttachment::Lock lock(*state->attachment);
+        if (!isCanceled(*state, generation))
+        {
+            try
+            {
+                readEntries(*state, generation, lock.getDatabase(), entries);
+            }
+            catch (IBPP::Exception&)
+            {
+                // the next load will reconnect
+                lock.disconnect();
+                throw;
+            }
+        }
+    }
+    catch (std::exception& e)
+    {
+        error = e.what();
+    }
+
+    boost::lock_guard<boost::mutex> guard(state->lock);
+    // a newer load may be running already
+    if (state->generation != generation)
+        return;
+    if (error.empty())
+    {
+        state->result.swap(entries);
+        state->resultAvailable = true;
+    }
+    else
+        state->error = error;
+    state->running = false;
+}
+
+/*static*/
+void MetadataSearchIndex::readEntries(State& state, unsigned generation,
+    IBPP::Database& database, RawEntries& entries)
+{
+    IBPP::Transaction tr = IBPP::TransactionFactory(database, IBPP::amRead);
+    tr->Start();
+    IBPP::Statement st1 = IBPP::StatementFactory(database, tr);
+
+    // relations and procedures, to add their fields to
+    std::map<std::string, size_t> relations, procedures;
+    for (size_t i = 0; i < sizeof(objectsSql) / sizeof(objectsSql[0]); ++i)
+    {
+        try
+        {
+            st1->Execute(objectsSql[i]);
+        }
+        catch (IBPP::SQLException&)
+        {
+            continue;
+        }
+        while (st1->Fetch())
+        {
+            if (isCanceled(state, generation))
+                return;
+            RawEntry entry;
+            std::string kind;
+            st1->Get(1, kind);
+            entry.kind = kind.empty() ? ' ' : kind[0];
+            st1->Get(2, entry.name);
+            entry.name.erase(entry.name.find_last_not_of(' ') + 1);
+            if (!st1->IsNull(3))
+                st1->Get(3, entry.description);
+            if (st1->Columns() > 3 && !st1->IsNull(4))
+                st1->Get(4, entry.source);
+
+            if (entry.kind == 'R' || entry.kind == 'V')
+                relations[entry.name] = entries.size();
+            else if (entry.kind == 'P')
+                procedures[entry.name] = entries.size();
+            entries.push_back(entry);
+        }
+    }
+
+    st1->Execute(fieldsSql);
+    while (st1->Fetch())
+    {
+        if (isCanceled(state, generation))
+            return;
+        std::string kind, name, field;
+        st1->Get(1, kind);
+        st1->Get(2, name);
+        name.erase(name.find_last_not_of(' ') + 1);
+        st1->Get(3, field);
+
+        std::map<std::string, size_t>& owners(
+            (kind == "P") ? procedures : relations);
+        std::map<std::string, size_t>::const_iterator it = owners.find(name);
+        if (it != owners.end())
+            entries[(*it).second].fields.push_back(field);
+    }
+    tr->Commit();
+}
+
+void MetadataSearchIndex::buildIndex(RawEntries& entries)
+{
+    entriesM.clear();
+    entriesM.reserve(entries.size());
+    for (int i = tkName; i <= tkSource; ++i)
+        tokensM[i].clear();
+
+    for (RawEntries::iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+        size_t index = entriesM.size();
+        entriesM.push_back(Entry());
+        Entry& entry(entriesM.back());
+        entry.type = getNodeTypeOfKind((*it).kind);
+        entry.name = std2wxIdentifier((*it).name, converterM);
+        entry.description = wxString((*it).description.c_str(),
+            *converterM).Upper();
+        entry.source = wxString((*it).source.c_str(), *converterM).Upper();
+        for (std::vector<std::string>::iterator itf = (*it).fields.begin();
+            itf != (*it).fields.end(); ++itf)
+        {
+            entry.fields.push_back(
+                std2wxIdentifier(*itf, converterM).Upper());
+            addTokens(tkField, entry.fields.back(), index);
+        }
+        addTokens(tkName, entry.name.Upper(), index);
+        addTokens(tkDescription, entry.description, index);
+        addTokens(tkSource, entry.source, index);
+    }
+}
+
+void MetadataSearchIndex::addTokens(TextKind kind, const wxString& text,
+    size_t index)
+{
+    std::vector<wxString> tokens;
+    getTokens(text, tokens);
+    for (std::vector<wxString>::iterator it = tokens.begin();
+        it != tokens.end(); ++it)
+    {
+        // entries are added in ascending order, so the lists stay sorted
+        std::vector<size_t>& indices(tokensM[kind][*it]);
+        if (indices.empty() || indices.back() != index)
+            indices.push_back(index);
+    }
+}
+
+size_t MetadataSearchIndex::getEntryCount() const
+{
+    return entriesM.size();
+}
+
+const MetadataSearchIndex::Entry& MetadataSearchIndex::getEntry(
+    size_t index) const
+{
+    return entriesM[index];
+}
+
+void MetadataSearchIndex::getCandidates(TextKind kind,
+    const wxString& pattern, std::vector<size_t>& indices) const
+{
+    indices.clear();
+    // every run of identifier characters in the pattern has to be part of
+    // a single token of the text, wildcards and other characters separate
+    // the runs
+    std::vector<wxString> words;
+    getTokens(pattern, words);
+    if (words.empty())
+    {
+        for (size_t i = 0; i < entriesM.size(); ++i)
+            indices.push_back(i);
+        return;
+    }
+
+    const TokenMap& tokens(tokensM[kind]);
+    for (std::vector<wxString>::iterator itw = words.begin();
+        itw != words.end(); ++itw)
+    {
+        std::vector<size_t> wordIndices;
+        for (TokenMap::const_iterator itt = tokens.begin();
+            itt != tokens.end(); ++itt)
+        {
+            if ((*itt).first.find(*itw) != wxString::npos)
+            {
+                wordIndices.insert(wordIndices.end(), (*itt).second.begin(),
+                    (*itt).second.end());
+            }
+        }
+        std::sort(wordIndices.begin(), wordIndices.end());
+        wordIndices.erase(std::unique(wordIndices.begin(), wordIndices.end()),
+            wordIndices.end());
+
+        if (itw == words.begin())
+            indices.swap(wordIndices);
+        else
+        {
+            std::vector<size_t> common;
+            std::set_intersection(indices.begin(), indices.end(),
+                wordIndices.begin(), wordIndices.end(),
+                std::back_inserter(common));
+            indices.swap(common);
+        }
+        if (indices.empty())
+            return;
+    }
+}
+
+bool MetadataSearchIndex::matches(size_t index, TextKind kind,
+    const wxString& pattern) const
+{
+    const Entry& entry(entriesM[index]);
+    switch (kind)
+    {
+        case tkName:
+            return entry.name.Upper().Matches(pattern);
+        case tkDescription:
+            return entry.description.Matches(pattern);
+        case tkSource:
+            return entry.source.Matches(pattern);
+        case tkField:
+            for (std::vector<wxString>::const_iterator it =
+                entry.fields.begin(); it != entry.fields.end(); ++it)
+            {
+                if ((*it).Matches(pattern))
+                    return true;
+            }
+            break;
+    }
+    return false;
+}
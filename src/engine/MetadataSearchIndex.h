@@ -0,0 +1,123 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_METADATASEARCHINDEX_H
+#define FR_METADATASEARCHINDEX_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <ibpp.h>
+
+#include "engine/SharedAttachment.h"
+#include "metadata/metadataitem.h"
+
+// Inverted index over the names, column and parameter names, descriptions
+// and source texts of all user objects of a database.  The system tables
+// are read in a background thread, using the shared attachment of the
+// database, the
+// index is built from that data in the main thread and kept until the
+// metadata of the database changes.
+class MetadataSearchIndex
+{
+public:
+    enum TextKind { tkName, tkField, tkDescription, tkSource };
+    // descriptions, sources and field names are stored in upper case, as
+    // the search patterns are
+    struct Entry
+    {
+        NodeType type;
+        wxString name;
+        wxString description;
+        wxString source;
+        std::vector<wxString> fields;
+    };
+private:
+    // data as read from the system tables, converted in the main thread
+    struct RawEntry
+    {
+        char kind;
+        std::string name;
+        std::string description;
+        std::string source;
+        std::vector<std::string> fields;
+    };
+    typedef std::vector<RawEntry> RawEntries;
+
+    // shared with the thread, which may still run when the index has been
+    // invalidated or destroyed; a load is canceled by changing generation
+    struct State
+    {
+        SharedAttachmentPtr attachment;
+        boost::mutex lock;
+        unsigned generation;
+        bool running;
+        bool resultAvailable;
+        std::string error;
+        RawEntries result;
+    };
+    typedef boost::shared_ptr<State> StatePtr;
+    StatePtr stateM;
+    wxMBConv* converterM;
+
+    bool readyM;
+    std::vector<Entry> entriesM;
+    // all tokens of each text kind, mapped to the sorted entry indices
+    typedef std::map<wxString, std::vector<size_t> > TokenMap;
+    TokenMap tokensM[tkSource + 1];
+
+    static void run(StatePtr state, unsigned generation);
+    static bool isCanceled(State& state, unsigned generation);
+    static void readEntries(State& state, unsigned generation,
+        IBPP::Database& database, RawEntries& entries);
+    void buildIndex(RawEntries& entries);
+    void addTokens(TextKind kind, const wxString& text, size_t index);
+public:
+    MetadataSearchIndex(SharedAttachmentPtr attachment, wxMBConv* converter);
+    // cancels a running load without waiting for it
+    ~MetadataSearchIndex();
+
+    // starts loading unless the index is ready or being loaded
+    void start();
+    // builds the index once the data has been loaded, returns true if the
+    // index can be searched, throws if loading failed
+    bool checkReady();
+    // the index is rebuilt by the next call of start(), a running load is
+    // canceled without waiting for it
+    void invalidate();
+
+    size_t getEntryCount() const;
+    const Entry& getEntry(size_t index) const;
+    // sets the sorted indices of all entries whose text of the given kind
+    // may match the (upper case) pattern, the matches need to be verified
+    void getCandidates(TextKind kind, const wxString& pattern,
+        std::vector<size_t>& indices) const;
+    // returns true if the entry text of the given kind matches the pattern
+    bool matches(size_t index, TextKind kind, const wxString& pattern) const;
+};
+
+#endif // FR_METADATASEARCHINDEX_H
@@ -0,0 +1,117 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include "core/FRError.h"
+#include "engine/SharedAttachment.h"
+
+SharedAttachment::SharedAttachment(IBPP::Database database)
+    : databaseM(database), closedM(false)
+{
+}
+
+SharedAttachment::~SharedAttachment()
+{
+    // no task can hold a lock any more, it would own a reference
+    disconnect();
+}
+
+bool SharedAttachment::isClosed()
+{
+    boost::lock_guard<boost::mutex> guard(stateM);
+    return closedM;
+}
+
+void SharedAttachment::disconnect()
+{
+    disconnectAttachment(databaseM);
+}
+
+void SharedAttachment::close()
+{
+    {
+        boost::lock_guard<boost::mutex> guard(stateM);
+        closedM = true;
+    }
+    // otherwise the task using it disconnects when it releases the lock
+    if (useM.try_lock())
+    {
+        disconnect();
+        useM.unlock();
+    }
+}
+
+void SharedAttachment::closeAndWait()
+{
+    {
+        boost::lock_guard<boost::mutex> guard(stateM);
+        closedM = true;
+    }
+    boost::lock_guard<boost::mutex> guard(useM);
+    disconnect();
+}
+
+SharedAttachment::Lock::Lock(SharedAttachment& attachment)
+    : attachmentM(attachment), guardM(attachment.useM)
+{
+}
+
+SharedAttachment::Lock::~Lock()
+{
+    if (attachmentM.isClosed())
+        attachmentM.disconnect();
+}
+
+IBPP::Database& SharedAttachment::Lock::getDatabase()
+{
+    if (attachmentM.isClosed())
+        throw FRError(_("The database connection has been closed."));
+    if (!attachmentM.databaseM->Connected())
+        attachmentM.databaseM->Connect();
+    return attachmentM.databaseM;
+}
+
+void SharedAttachment::Lock::disconnect()
+{
+    attachmentM.disconnect();
+}
+
+void disconnectAttachment(IBPP::Database& database)
+{
+    try
+    {
+        if (database->Connected())
+            database->Disconnect();
+    }
+    catch (...)
+    {
+    }
+}
@@ -0,0 +1,83 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_SHAREDATTACHMENT_H
+#define FR_SHAREDATTACHMENT_H
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <ibpp.h>
+
+// A secondary attachment shared by the background tasks of a database that
+// read the system tables (the metadata change check and the loading of the
+// search index), so they need one server connection instead of one each.
+// The tasks take turns, each holding a SharedAttachment::Lock while using
+// the attachment.  It is connected on demand and disconnected when it is
+// closed or the last owner releases it.
+class SharedAttachment
+{
+private:
+    IBPP::Database databaseM;
+    // held while a task uses the attachment
+    boost::mutex useM;
+    boost::mutex stateM;
+    bool closedM;
+
+    bool isClosed();
+    void disconnect();
+public:
+    // database must be a separate attachment, it is connected on demand
+    SharedAttachment(IBPP::Database database);
+    ~SharedAttachment();
+
+    // exclusive use of the attachment, waits while another task uses it
+    class Lock
+    {
+    private:
+        SharedAttachment& attachmentM;
+        boost::lock_guard<boost::mutex> guardM;
+    public:
+        Lock(SharedAttachment& attachment);
+        // disconnects the attachment if it has been closed meanwhile
+        ~Lock();
+
+        // connects the attachment if necessary, throws if it has been closed
+        IBPP::Database& getDatabase();
+        // after an error, the next task will reconnect
+        void disconnect();
+    };
+
+    // the attachment can't be used any longer, it is disconnected at once
+    // or when the task using it is done, without waiting for it
+    void close();
+    // closes the attachment and waits until it is disconnected
+    void closeAndWait();
+};
+
+typedef boost::shared_ptr<SharedAttachment> SharedAttachmentPtr;
+
+// disconnects an attachment that is of no further use, errors are ignored
+void disconnectAttachment(IBPP::Database& database);
+
+#endif // FR_SHAREDATTACHMENT_H
@@ -0,0 +1,266 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/ffile.h>
+#include <wx/stopwatch.h>
+
+#include <algorithm>
+
+#include "core/ProgressIndicator.h"
+#include "engine/StatementBenchmark.h"
+
+StatementBenchmarkRun::StatementBenchmarkRun()
+    : warmup(false), prepareMicros(0), executeMicros(0), fetchMicros(0),
+        rows(0), fetches(0), marks(0), reads(0), writes(0), inserts(0),
+        updates(0), deletes(0), indexedReads(0), sequentialReads(0),
+        relations(0)
+{
+}
+
+int64_t StatementBenchmarkRun::getTotalMicros() const
+{
+    return prepareMicros + executeMicros + fetchMicros;
+}
+
+StatementBenchmark::StatementBenchmark(IBPP::Database database,
+        const std::string& sql, IBPP::TAM accessMode,
+        IBPP::TIL isolationLevel, IBPP::TLR lockResolution)
+    : databaseM(database), sqlM(sql), accessModeM(accessMode),
+        isolationLevelM(isolationLevel), lockResolutionM(lockResolution)
+{
+}
+
+StatementBenchmarkRun StatementBenchmark::doRun(
+    IBPP::Transaction transaction, bool warmup)
+{
+    StatementBenchmarkRun run;
+    run.warmup = warmup;
+
+    int fetch1, mark1, read1, write1, mem1;
+    int ins1, upd1, del1, ridx1, rseq1;
+    IBPP::DatabaseCounts counts1;
+    databaseM->Statistics(&fetch1, &mark1, &read1, &write1, &mem1);
+    databaseM->Counts(&ins1, &upd1, &del1, &ridx1, &rseq1);
+    databaseM->DetailedCounts(counts1);
+
+    IBPP::Statement st = IBPP::StatementFactory(databaseM, transaction);
+    wxStopWatch sw;
+    st->Prepare(sqlM);
+    run.prepareMicros = sw.TimeInMicro().GetValue();
+
+    sw.Start();
+    st->Execute();
+    run.executeMicros = sw.TimeInMicro().GetValue();
+
+    sw.Start();
+    if (st->Type() == IBPP::stSelect)
+    {
+        while (st->Fetch())
+            ++run.rows;
+    }
+    else
+    {
+        // EXECUTE PROCEDURE and INSERT ... RETURNING may throw
+        try
+        {
+            run.rows = st->AffectedRows();
+        }
+        catch (IBPP::Exception&)
+        {
+        }
+    }
+    run.fetchMicros = sw.TimeInMicro().GetValue();
+    st->Close();
+
+    int fetch2, mark2, read2, write2, mem2;
+    int ins2, upd2, del2, ridx2, rseq2;
+    IBPP::DatabaseCounts counts2;
+    databaseM->Statistics(&fetch2, &mark2, &read2, &write2, &mem2);
+    databaseM->Counts(&ins2, &upd2, &del2, &ridx2, &rseq2);
+    databaseM->DetailedCounts(counts2);
+
+    run.fetches = fetch2 - fetch1;
+    run.marks = mark2 - mark1;
+    run.reads = read2 - read1;
+    run.writes = write2 - write1;
+    run.inserts = ins2 - ins1;
+    run.updates = upd2 - upd1;
+    run.deletes = del2 - del1;
+    run.indexedReads = ridx2 - ridx1;
+    run.sequentialReads = rseq2 - rseq1;
+
+    for (IBPP::DatabaseCounts::const_iterator it = counts2.begin();
+        it != counts2.end(); ++it)
+    {
+        IBPP::CountInfo before;
+        IBPP::DatabaseCounts::const_iterator it1 = counts1.find((*it).first);
+        if (it1 != counts1.end())
+            before = (*it1).second;
+        const IBPP::CountInfo& after = (*it).second;
+        if (after.inserts != before.inserts
+            || after.updates != before.updates
+            || after.deletes != before.deletes)
+        {
+            ++run.relations;
+        }
+    }
+    return run;
+}
+
+void StatementBenchmark::execute(unsigned runs, unsigned warmupRuns,
+    ProgressIndicator* progressIndicator)
+{
+    runsM.clear();
+    runsM.reserve(runs + warmupRuns);
+
+    if (progressIndicator)
+    {
+        progressIndicator->initProgress(_("Running benchmark..."),
+            runs + warmupRuns);
+    }
+
+    IBPP::Transaction tr = IBPP::TransactionFactory(databaseM, accessModeM,
+        isolationLevelM, lockResolutionM);
+    tr->Start();
+    try
+    {
+        for (unsigned i = 0; i < runs + warmupRuns; ++i)
+        {
+            checkProgressIndicatorCanceled(progressIndicator);
+            runsM.push_back(doRun(tr, i < warmupRuns));
+            if (progressIndicator)
+                progressIndicator->stepProgress();
+        }
+    }
+    catch (...)
+    {
+        tr->Rollback();
+        throw;
+    }
+    // the benchmark must never change any data
+    tr->Rollback();
+}
+
+const std::vector<StatementBenchmarkRun>& StatementBenchmark::getRuns() const
+{
+    return runsM;
+}
+
+size_t StatementBenchmark::getMeasuredRunCount() const
+{
+    size_t count = 0;
+    for (std::vector<StatementBenchmarkRun>::const_iterator it =
+        runsM.begin(); it != runsM.end(); ++it)
+    {
+        if (!(*it).warmup)
+            ++count;
+    }
+    return count;
+}
+
+/*static*/
+int64_t StatementBenchmark::getPhaseMicros(const StatementBenchmarkRun& run,
+    Phase phase)
+{
+    switch (phase)
+    {
+        case phPrepare:
+            return run.prepareMicros;
+        case phExecute:
+            return run.executeMicros;
+        case phFetch:
+            return run.fetchMicros;
+        default:
+            return run.getTotalMicros();
+    }
+}
+
+// nearest-rank percentile of sorted values
+static int64_t getPercentile(const std::vector<int64_t>& values,
+    unsigned percent)
+{
+    size_t rank = (values.size() * percent + 99) / 100;
+    if (rank > 0)
+        --rank;
+    return values[std::min(rank, values.size() - 1)];
+}
+
+StatementBenchmark::Summary StatementBenchmark::getSummary(Phase phase) const
+{
+    std::vector<int64_t> values;
+    for (std::vector<StatementBenchmarkRun>::const_iterator it =
+        runsM.begin(); it != runsM.end(); ++it)
+    {
+        if (!(*it).warmup)
+            values.push_back(getPhaseMicros(*it, phase));
+    }
+
+    Summary s = { 0, 0, 0, 0, 0 };
+    if (values.empty())
+        return s;
+
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    s.min = values.front();
+    s.median = (values[(n - 1) / 2] + values[n / 2]) / 2;
+    s.p95 = getPercentile(values, 95);
+    s.p99 = getPercentile(values, 99);
+    s.max = values.back();
+    return s;
+}
+
+bool StatementBenchmark::saveAsCsv(const wxString& fileName) const
+{
+    wxFFile file(fileName, "w");
+    if (!file.IsOpened())
+        return false;
+
+    wxString csv("run,warmup,prepare_us,execute_us,fetch_us,total_us,rows,"
+        "fetches,marks,reads,writes,inserts,updates,deletes,"
+        "indexed_reads,sequential_reads,relations\n");
+    int runNo = 0;
+    for (std::vector<StatementBenchmarkRun>::const_iterator it =
+        runsM.begin(); it != runsM.end(); ++it)
+    {
+        const StatementBenchmarkRun& r(*it);
+        csv += wxString::Format("%d,%d,", ++runNo, r.warmup ? 1 : 0);
+        csv += wxLongLong(r.prepareMicros).ToString() + ",";
+        csv += wxLongLong(r.executeMicros).ToString() + ",";
+        csv += wxLongLong(r.fetchMicros).ToString() + ",";
+        csv += wxLongLong(r.getTotalMicros()).ToString() + ",";
+        csv += wxString::Format("%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+            r.rows, r.fetches, r.marks, r.reads, r.writes, r.inserts,
+            r.updates, r.deletes, r.indexedReads, r.sequentialReads,
+            r.relations);
+    }
+    return file.Write(csv);
+}
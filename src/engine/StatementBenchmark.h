@@ -0,0 +1,109 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_STATEMENTBENCHMARK_H
+#define FR_STATEMENTBENCHMARK_H
+
+#include <wx/string.h>
+
+#include <string>
+#include <vector>
+
+#include <ibpp.h>
+
+class ProgressIndicator;
+
+// Measurements of a single benchmark run.  Times are in microseconds, all
+// other values are the differences of the attachment statistics and record
+// counts before and after the run.
+struct StatementBenchmarkRun
+{
+    bool warmup;
+    int64_t prepareMicros;
+    int64_t executeMicros;
+    int64_t fetchMicros;
+    int rows;
+
+    int fetches;
+    int marks;
+    int reads;
+    int writes;
+
+    int inserts;
+    int updates;
+    int deletes;
+    int indexedReads;
+    int sequentialReads;
+    // number of relations with changed detailed counts
+    int relations;
+
+    StatementBenchmarkRun();
+    int64_t getTotalMicros() const;
+};
+
+class StatementBenchmark
+{
+public:
+    enum Phase { phPrepare, phExecute, phFetch, phTotal };
+    struct Summary
+    {
+        int64_t min;
+        int64_t median;
+        int64_t p95;
+        int64_t p99;
+        int64_t max;
+    };
+private:
+    IBPP::Database databaseM;
+    std::string sqlM;
+    IBPP::TAM accessModeM;
+    IBPP::TIL isolationLevelM;
+    IBPP::TLR lockResolutionM;
+    std::vector<StatementBenchmarkRun> runsM;
+
+    StatementBenchmarkRun doRun(IBPP::Transaction transaction, bool warmup);
+    static int64_t getPhaseMicros(const StatementBenchmarkRun& run,
+        Phase phase);
+public:
+    StatementBenchmark(IBPP::Database database, const std::string& sql,
+        IBPP::TAM accessMode = IBPP::amWrite,
+        IBPP::TIL isolationLevel = IBPP::ilConcurrency,
+        IBPP::TLR lockResolution = IBPP::lrWait);
+
+    // Runs the statement warmupRuns + runs times on a dedicated transaction,
+    // which is always rolled back afterwards.  Every run prepares, executes
+    // and (for selectable statements) fetches all records.
+    void execute(unsigned runs, unsigned warmupRuns,
+        ProgressIndicator* progressIndicator = 0);
+
+    const std::vector<StatementBenchmarkRun>& getRuns() const;
+    size_t getMeasuredRunCount() const;
+    // returns min, median, 95th and 99th percentile and max of the phase
+    // times of all measured (not warm-up) runs
+    Summary getSummary(Phase phase) const;
+
+    // writes one line per run (including the warm-up runs)
+    bool saveAsCsv(const wxString& fileName) const;
+};
+
+#endif // FR_STATEMENTBENCHMARK_H
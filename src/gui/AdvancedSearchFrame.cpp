@@ -29,6 +29,8 @@
 
 #include <wx/stc/stc.h>
 
+#include <algorithm>
+#include <iterator>
 #include <set>
 
 #include "frutils.h"
@@ -36,6 +38,7 @@
 #include "gui/ContextMenuMetadataItemVisitor.h"
 #include "gui/controls/DBHTreeControl.h"
 #include "gui/MainFrame.h"
+#include "engine/MetadataSearchIndex.h"
 #include "gui/ProgressDialog.h"
 #include "metadata/column.h"
 #include "metadata/CreateDDLVisitor.h"
@@ -94,7 +97,9 @@ BEGIN_EVENT_TABLE(AdjustableListCtrl, wxListCtrl)
 END_EVENT_TABLE()
 
 AdvancedSearchFrame::AdvancedSearchFrame(MainFrame* parent, RootPtr root)
-    : BaseFrame(parent, -1, _("Advanced Metadata Search"))
+    : BaseFrame(parent, -1, _("Advanced Metadata Search")),
+        searchDatabaseCountM(0), searchProgressM(0),
+        timerSearchM(this, ID_timer_search)
 {
     wxBoxSizer *mainSizer;
     mainSizer = new wxBoxSizer(wxVERTICAL);
@@ -141,6 +146,15 @@ AdvancedSearchFrame::AdvancedSearchFrame(MainFrame* parent, RootPtr root)
         ID_button_add_description, _("Add"));
     fgSizer1->Add(button_add_description, 0, wxALL, 5);
 
+    m_staticText7 = new wxStaticText(mainPanel, wxID_ANY,
+        _("Source contains"));
+    fgSizer1->Add(m_staticText7, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5);
+    textctrl_source = new wxTextCtrl(mainPanel, wxID_ANY, wxEmptyString);
+    fgSizer1->Add(textctrl_source, 0, wxALL|wxEXPAND, 5);
+    button_add_source = new wxButton(mainPanel, ID_button_add_source,
+        _("Add"));
+    fgSizer1->Add(button_add_source, 0, wxALL, 5);
+
     m_staticText4 = new wxStaticText(mainPanel, wxID_ANY, _("DDL contains"));
     fgSizer1->Add(m_staticText4, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5);
     textctrl_ddl = new wxTextCtrl(mainPanel, wxID_ANY, wxEmptyString);
@@ -263,8 +277,11 @@ void AdvancedSearchFrame::addCriteria(CriteriaItem::Type type, wxString
     if (value.IsEmpty())
         return;
     value.MakeUpper();
-    if (type == CriteriaItem::ctDDL || type == CriteriaItem::ctDescription)
+    if (type == CriteriaItem::ctDDL || type == CriteriaItem::ctDescription
+        || type == CriteriaItem::ctSource)
+    {
         value = "*" + value + "*";
+    }
     CriteriaItem c(value, db);
     for (CriteriaCollection::const_iterator
         it = searchCriteriaM.lower_bound(type);
@@ -344,6 +361,8 @@ void AdvancedSearchFrame::subjectRemoved(Subject* subject)
     //
     // Since we can't determine what it is by dynamic_cast, we try both:
     // STEP1: Check for database
+    pendingDatabasesM.erase(std::remove(pendingDatabasesM.begin(),
+        pendingDatabasesM.end(), subject), pendingDatabasesM.end());
     for (int i=choice_database->GetCount()-1; i>=0; i--)
     {   // remove from choice_database
         Database *d = (Database *)choice_database->GetClientData(i);
@@ -406,12 +425,16 @@ BEGIN_EVENT_TABLE(AdvancedSearchFrame, wxFrame)
         AdvancedSearchFrame::OnButtonAddNameClick)
     EVT_BUTTON(AdvancedSearchFrame::ID_button_add_description,
         AdvancedSearchFrame::OnButtonAddDescriptionClick)
+    EVT_BUTTON(AdvancedSearchFrame::ID_button_add_source,
+        AdvancedSearchFrame::OnButtonAddSourceClick)
     EVT_BUTTON(AdvancedSearchFrame::ID_button_add_ddl,
         AdvancedSearchFrame::OnButtonAddDDLClick)
     EVT_BUTTON(AdvancedSearchFrame::ID_button_add_field,
         AdvancedSearchFrame::OnButtonAddFieldClick)
     EVT_BUTTON(AdvancedSearchFrame::ID_button_add_database,
         AdvancedSearchFrame::OnButtonAddDatabaseClick)
+    EVT_TIMER(AdvancedSearchFrame::ID_timer_search,
+        AdvancedSearchFrame::OnTimerSearch)
 END_EVENT_TABLE()
 
 // remove item on double-click/Enter
@@ -537,115 +560,172 @@ void AdvancedSearchFrame::OnButtonStartClick(wxCommandEvent& WXUNUSED(event))
         }
     }
 
-    int database_count = 0;
+    // connect all databases first, their search indices are then loaded
+    // in the background
+    searchProgressM = new ProgressDialog(this, _("Searching..."), 2);
+    searchProgressM->doShow();
+    pendingDatabasesM.clear();
     for (CriteriaCollection::const_iterator
         cid = searchCriteriaM.lower_bound(CriteriaItem::ctDB);
         cid != searchCriteriaM.upper_bound(CriteriaItem::ctDB); ++cid)
     {
-        database_count++;
+        if (searchProgressM->isCanceled())
+        {
+            finishSearch();
+            return;
+        }
+        Database *db = (*cid).second.database;
+        if (!db->isConnected() && !connectDatabase(db, this, searchProgressM))
+            continue;
+        db->getSearchIndex().start();
+        pendingDatabasesM.push_back(db);
     }
+    searchTypesM.swap(types);
+    searchDatabaseCountM = pendingDatabasesM.size();
+    searchPendingDatabases();
+}
 
-    // foreach database
-    int current = 0;
-    ProgressDialog pd(this, _("Searching..."), 2);
-    pd.doShow();
-    for (CriteriaCollection::const_iterator
-        cid = searchCriteriaM.lower_bound(CriteriaItem::ctDB);
-        cid != searchCriteriaM.upper_bound(CriteriaItem::ctDB); ++cid)
+// searches every database as soon as its index is available, so the
+// results of fast (or already indexed) databases are shown at once
+void AdvancedSearchFrame::searchPendingDatabases()
+{
+    std::vector<Database*>::iterator it = pendingDatabasesM.begin();
+    while (it != pendingDatabasesM.end())
     {
-        if (pd.isCanceled())
-            return;
-        pd.setProgressPosition(0, 2);
-        Database *db = (*cid).second.database;
-        if (!db->isConnected() && !connectDatabase(db, this, &pd))
+        if (searchProgressM->isCanceled())
+            break;
+        Database* db = *it;
+        try
+        {
+            if (!db->getSearchIndex().checkReady())
+            {
+                ++it;
+                continue;
+            }
+        }
+        catch (std::exception& e)
+        {
+            wxMessageBox(e.what(), _("Error"), wxOK|wxICON_ERROR);
+            it = pendingDatabasesM.erase(it);
             continue;
+        }
+        searchProgressM->initProgress(_("Searching database: ")
+            + db->getName_(), searchDatabaseCountM,
+            searchDatabaseCountM - pendingDatabasesM.size(), 1);
+        searchDatabase(db, searchTypesM, *searchProgressM);
+        it = pendingDatabasesM.erase(it);
+    }
+    if (pendingDatabasesM.empty() || searchProgressM->isCanceled())
+    {
+        finishSearch();
+        return;
+    }
+    searchProgressM->initProgress(_("Waiting for the search indices..."),
+        searchDatabaseCountM,
+        searchDatabaseCountM - pendingDatabasesM.size(), 1);
+    timerSearchM.Start(50, wxTIMER_ONE_SHOT);
+}
+
+void AdvancedSearchFrame::finishSearch()
+{
+    timerSearchM.Stop();
+    pendingDatabasesM.clear();
+    searchTypesM.clear();
+    delete searchProgressM;
+    searchProgressM = 0;
+}
 
-        pd.initProgress(_("Searching database: ")+db->getName_(),
-            database_count, current++, 1);
+void AdvancedSearchFrame::OnTimerSearch(wxTimerEvent& WXUNUSED(event))
+{
+    if (searchProgressM)
+        searchPendingDatabases();
+}
 
-        std::vector<MetadataItem *> colls;
-        db->getCollections(colls, false);   // false = not system objects
-        for (std::vector<MetadataItem *>::iterator col = colls.begin(); col !=
-            colls.end(); ++col)
+// all criteria but the DDL ones are matched against the search index, only
+// the remaining objects need to be loaded
+void AdvancedSearchFrame::searchDatabase(Database* db,
+    const std::set<NodeType>& types, ProgressDialog& progress)
+{
+    const MetadataSearchIndex& index(db->getSearchIndex());
+    const CriteriaItem::Type criteriaTypes[] = { CriteriaItem::ctName,
+        CriteriaItem::ctDescription, CriteriaItem::ctSource,
+        CriteriaItem::ctField };
+    const MetadataSearchIndex::TextKind textKinds[] = {
+        MetadataSearchIndex::tkName, MetadataSearchIndex::tkDescription,
+        MetadataSearchIndex::tkSource, MetadataSearchIndex::tkField };
+
+    std::vector<size_t> found;
+    bool restricted = false;
+    for (size_t i = 0; i < sizeof(criteriaTypes) / sizeof(criteriaTypes[0]);
+        ++i)
+    {
+        if (searchCriteriaM.count(criteriaTypes[i]) == 0)
+            continue;
+        // an object needs to match one of the criteria of each type
+        std::vector<size_t> matching, candidates;
+        for (CriteriaCollection::const_iterator ci =
+            searchCriteriaM.lower_bound(criteriaTypes[i]); ci !=
+            searchCriteriaM.upper_bound(criteriaTypes[i]); ++ci)
         {
-            std::vector<MetadataItem *> ch;
-            (*col)->getChildren(ch);
-            pd.initProgress(wxEmptyString, ch.size(), 0, 2);
-            for (std::vector<MetadataItem *>::iterator it = ch.begin(); it !=
-                ch.end(); ++it)
+            const wxString& pattern((*ci).second.value);
+            index.getCandidates(textKinds[i], pattern, candidates);
+            for (std::vector<size_t>::iterator it = candidates.begin();
+                it != candidates.end(); ++it)
             {
-                if (!types.empty() &&
-                    types.find((*it)->getType()) == types.end())
-                    break;
-                pd.setProgressMessage(_("Searching ") + (*col)->getName_() +
-                    ": " + (*it)->getName_(), 2);
-                pd.stepProgress(1, 2);
-                if (pd.isCanceled())
-                    return;
-                if (searchCriteriaM.count(CriteriaItem::ctName) > 0)
-                {
-                    wxString name = (*it)->getName_();
-                    if (!match(CriteriaItem::ctName, name))
-                        continue;
-                }
-                if (searchCriteriaM.count(CriteriaItem::ctDescription) > 0)
-                {
-                    wxString desc;
-                    if (!(*it)->getDescription(desc))
-                        continue;
-                    if (!match(CriteriaItem::ctDescription, desc))
-                        continue;
-                }
-                if (searchCriteriaM.count(CriteriaItem::ctDDL) > 0)
-                {
-                    // TODO: add ProgressDialog, and link it up in here
-                    CreateDDLVisitor cdv;
-                    (*it)->acceptVisitor(&cdv);
-                    if (!match(CriteriaItem::ctDDL, cdv.getSql()))
-                        continue;
-                }
-                if (searchCriteriaM.count(CriteriaItem::ctField) > 0)
-                {
-                    Relation* r = dynamic_cast<Relation*>(*it);
-                    Procedure* p = dynamic_cast<Procedure*>(*it);
-                    if (r || p)
-                    {
-                        (*it)->ensureChildrenLoaded();
-                        bool found = false;
-                        if (r)
-                        {
-                            ColumnPtrs::iterator it;
-                            for (it = r->begin(); it != r->end(); ++it)
-                            {
-                                if (match(CriteriaItem::ctField,
-                                    (*it)->getName_()))
-                                {
-                                    found = true;
-                                    break;
-                                }
-                            }
-                        }
-                        if (p)
-                        {
-                            for (ParameterPtrs::iterator it = p->begin();
-                                it != p->end(); ++it)
-                            {
-                                if (match(CriteriaItem::ctField,
-                                    (*it)->getName_()))
-                                {
-                                    found = true;
-                                    break;
-                                }
-                            }
-                        }
-                        if (!found)     // object doesn't contain that field
-                            continue;
-                    }
-                }
-                // everything criteria is matched -> add to results
-                addResult(db, *it);
+                if (index.matches(*it, textKinds[i], pattern))
+                    matching.push_back(*it);
             }
         }
+        std::sort(matching.begin(), matching.end());
+        matching.erase(std::unique(matching.begin(), matching.end()),
+            matching.end());
+
+        if (!restricted)
+            found.swap(matching);
+        else
+        {
+            std::vector<size_t> common;
+            std::set_intersection(found.begin(), found.end(),
+                matching.begin(), matching.end(), std::back_inserter(common));
+            found.swap(common);
+        }
+        restricted = true;
+    }
+    if (!restricted)
+    {
+        for (size_t i = 0; i < index.getEntryCount(); ++i)
+            found.push_back(i);
+    }
+
+    // DDL of all found objects is needed, so load them in bulk
+    bool checkDDL = searchCriteriaM.count(CriteriaItem::ctDDL) > 0;
+    if (checkDDL && !found.empty())
+        db->loadSchemaDetails();
+
+    progress.initProgress(wxEmptyString, found.size(), 0, 2);
+    for (std::vector<size_t>::iterator it = found.begin(); it != found.end();
+        ++it)
+    {
+        const MetadataSearchIndex::Entry& entry(index.getEntry(*it));
+        if (!types.empty() && types.find(entry.type) == types.end())
+            continue;
+        progress.setProgressMessage(_("Searching ") + entry.name, 2);
+        progress.stepProgress(1, 2);
+        if (progress.isCanceled())
+            return;
+
+        MetadataItem* item = db->findByNameAndType(entry.type, entry.name);
+        if (!item)
+            continue;
+        if (checkDDL)
+        {
+            CreateDDLVisitor cdv;
+            item->acceptVisitor(&cdv);
+            if (!match(CriteriaItem::ctDDL, cdv.getSql()))
+                continue;
+        }
+        // everything criteria is matched -> add to results
+        addResult(db, item);
     }
 }
 
@@ -666,6 +746,13 @@ void AdvancedSearchFrame::OnButtonAddDescriptionClick(wxCommandEvent& WXUNUSED(e
     textctrl_description->Clear();
 }
 
+void AdvancedSearchFrame::OnButtonAddSourceClick(
+    wxCommandEvent& WXUNUSED(event))
+{
+    addCriteria(CriteriaItem::ctSource, textctrl_source->GetValue());
+    textctrl_source->Clear();
+}
+
 void AdvancedSearchFrame::OnButtonAddDDLClick(wxCommandEvent& WXUNUSED(event))
 {
     addCriteria(CriteriaItem::ctDDL, textctrl_ddl->GetValue());
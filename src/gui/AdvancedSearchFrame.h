@@ -28,14 +28,19 @@
 #include <wx/splitter.h>
 
 #include <map>
+#include <set>
 
 #include "core/Observer.h"
 #include "gui/BaseFrame.h"
+#include "metadata/metadataitem.h"
 
 class CriteriaItem
 {
 public:
-    enum Type { ctType, ctName, ctDescription, ctDDL, ctField, ctDB };
+    enum Type
+    {
+        ctType, ctName, ctDescription, ctSource, ctDDL, ctField, ctDB
+    };
     wxString value;
     Database *database; // only used for ctDB type
     long listIndex;
@@ -54,6 +59,7 @@ public:
             case ctType:        return _("Type is");
             case ctName:        return _("Name is");
             case ctDescription: return _("Description contains");
+            case ctSource:      return _("Source contains");
             case ctDDL:         return _("DDL contains");
             case ctField:       return _("Has field");
             case ctDB:          return _("In database");
@@ -68,6 +74,7 @@ class Root;
 
 class AdjustableListCtrl;   // declaration in cpp file
 class MainFrame;
+class ProgressDialog;
 class wxStyledTextCtrl;
 
 class AdvancedSearchFrame : public BaseFrame, public Observer
@@ -81,6 +88,18 @@ private:
     std::vector<MetadataItem *> results;
     void addResult(Database* db, MetadataItem* item);
     bool match(CriteriaItem::Type type, const wxString& text);
+    void searchDatabase(Database* db, const std::set<NodeType>& types,
+        ProgressDialog& progress);
+
+    // databases whose search index is still being loaded, the timer checks
+    // them until they are all searched
+    std::vector<Database*> pendingDatabasesM;
+    size_t searchDatabaseCountM;
+    std::set<NodeType> searchTypesM;
+    ProgressDialog* searchProgressM;
+    wxTimer timerSearchM;
+    void searchPendingDatabases();
+    void finishSearch();
 
     // observer stuff
     virtual void subjectRemoved(Subject* subject);
@@ -97,6 +116,9 @@ protected:
     wxStaticText *m_staticText3;
     wxTextCtrl *textctrl_description;
     wxButton *button_add_description;
+    wxStaticText *m_staticText7;
+    wxTextCtrl *textctrl_source;
+    wxButton *button_add_source;
     wxStaticText *m_staticText4;
     wxTextCtrl *textctrl_ddl;
     wxButton *button_add_ddl;
@@ -126,12 +148,14 @@ public:
         ID_button_add_type,
         ID_button_add_name,
         ID_button_add_description,
+        ID_button_add_source,
         ID_button_add_ddl,
         ID_button_add_field,
         ID_button_add_database,
         ID_checkbox_ddl,
         ID_listctrl_criteria,
-        ID_listctrl_results
+        ID_listctrl_results,
+        ID_timer_search
     };
 
     // events
@@ -141,12 +165,14 @@ public:
     void OnButtonAddTypeClick(wxCommandEvent& event);
     void OnButtonAddNameClick(wxCommandEvent& event);
     void OnButtonAddDescriptionClick(wxCommandEvent& event);
+    void OnButtonAddSourceClick(wxCommandEvent& event);
     void OnButtonAddDDLClick(wxCommandEvent& event);
     void OnButtonAddFieldClick(wxCommandEvent& event);
     void OnButtonAddDatabaseClick(wxCommandEvent& event);
     void OnListCtrlResultsRightClick(wxListEvent& event);
     void OnListCtrlResultsItemSelected(wxListEvent& event);
     void OnListCtrlCriteriaActivate(wxListEvent& event);
+    void OnTimerSearch(wxTimerEvent& event);
     DECLARE_EVENT_TABLE()
 };
 
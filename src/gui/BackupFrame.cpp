@@ -34,6 +34,7 @@
 #include <wx/filename.h>
 
 #include <algorithm>
+#include <map>
 
 #include <ibpp.h>
 
@@ -52,7 +53,7 @@ class BackupThread: public wxThread {
 public:
     BackupThread(BackupFrame* frame, wxString server, wxString username,
         wxString password, wxString dbfilename, wxString bkfilename,
-        IBPP::BRF flags);
+        IBPP::BRF flags, BackupRestoreProgressPtr progress);
 
     virtual void* Entry();
     virtual void OnExit();
@@ -64,6 +65,7 @@ private:
     wxString dbfileM;
     wxString bkfileM;
     IBPP::BRF brfM;
+    BackupRestoreProgressPtr progressM;
     void logError(wxString& msg);
     void logImportant(wxString& msg);
     void logProgress(wxString& msg);
@@ -71,8 +73,8 @@ private:
 
 BackupThread::BackupThread(BackupFrame* frame, wxString server,
         wxString username, wxString password, wxString dbfilename,
-        wxString bkfilename, IBPP::BRF flags)
-    : wxThread()
+        wxString bkfilename, IBPP::BRF flags, BackupRestoreProgressPtr progress)
+    : wxThread(), progressM(progress)
 {
     frameM = frame;
     serverM = server;
@@ -114,6 +116,7 @@ void* BackupThread::Entry()
             const char* c = svc->WaitMsg();
             if (c == 0)
             {
+                progressM->setCompleted();
                 now = wxDateTime::Now();
                 msg.Printf(_("Database backup finished %s"),
                     now.FormatTime().c_str());
@@ -121,6 +124,7 @@ void* BackupThread::Entry()
                 break;
             }
             msg = c;
+            progressM->processLine(msg);
             logProgress(msg);
         }
         svc->Disconnect();
@@ -217,6 +221,7 @@ void BackupFrame::createControls()
         _("Show complete log"));
     button_start = new wxButton(panel_controls, ID_button_start,
         _("&Start Backup"));
+    createProgressControls();
 
     text_ctrl_log = new LogTextControl(this, ID_text_ctrl_log);
 }
@@ -256,6 +261,10 @@ void BackupFrame::layoutControls()
     sizerPanelV->Add(0, styleguide().getUnrelatedControlMargin(wxVERTICAL));
     sizerPanelV->Add(sizerButtons, 0, wxEXPAND);
     sizerPanelV->Add(0, styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerPanelV->Add(gauge_progress, 0, wxEXPAND);
+    sizerPanelV->Add(0, styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerPanelV->Add(label_progress, 0, wxEXPAND);
+    sizerPanelV->Add(0, styleguide().getRelatedControlMargin(wxVERTICAL));
     wxBoxSizer* sizerPanelH = new wxBoxSizer(wxHORIZONTAL);
     sizerPanelH->Add(styleguide().getFrameMargin(wxLEFT), 0);
     sizerPanelH->Add(sizerPanelV, 1, wxEXPAND);
@@ -398,10 +407,24 @@ void BackupFrame::OnStartButtonClick(wxCommandEvent& WXUNUSED(event))
     if (checkbox_extern->IsChecked())
         flags |= (int)IBPP::brConvertExtTables;
 
+    std::map<wxString, int64_t> tableEstimates;
+    try
+    {
+        BackupRestoreProgress::estimateTableRecords(database.get(),
+            tableEstimates);
+    }
+    catch (IBPP::Exception&)
+    {
+        // the backup can run without them
+        tableEstimates.clear();
+    }
+    startProgress(operationBackup, text_ctrl_filename->GetValue(),
+        tableEstimates);
+
     std::auto_ptr<wxThread> thread(new BackupThread(this,
         server->getConnectionString(), username, password,
         database->getPath(), text_ctrl_filename->GetValue(),
-        (IBPP::BRF)flags));
+        (IBPP::BRF)flags, progressM));
     startThread(thread);
     updateControls();
 }
@@ -33,17 +33,27 @@
 #include <wx/timer.h>
 #include <wx/wupdlock.h>
 
+#include <algorithm>
+#include <cmath>
+
 #include "config/Config.h"
 #include "core/ArtProvider.h"
+#include "core/StringUtils.h"
 #include "gui/BackupRestoreBaseFrame.h"
 #include "gui/controls/DndTextControls.h"
 #include "gui/controls/LogTextControl.h"
 #include "metadata/database.h"
 #include "metadata/server.h"
 
+// number of earlier runs the throughput of a run is compared with
+static const size_t comparedRuns = 5;
+// a run slower than the earlier ones by this is shown as an error
+static const double slowdownWarning = 0.25;
+
 BackupRestoreBaseFrame::BackupRestoreBaseFrame(wxWindow* parent,
         DatabasePtr db)
-    : BaseFrame(parent, wxID_ANY, wxEmptyString), databaseM(db), threadM(0)
+    : BaseFrame(parent, wxID_ANY, wxEmptyString), databaseM(db), threadM(0),
+        operationM(operationBackup), timerProgressM(this, ID_timer_progress)
 {
     wxASSERT(db);
     db->attachObserver(this, false);
@@ -58,12 +68,74 @@ BackupRestoreBaseFrame::BackupRestoreBaseFrame(wxWindow* parent,
     button_browse = 0;
     checkbox_showlog = 0;
     button_start = 0;
+    gauge_progress = 0;
+    label_progress = 0;
     text_ctrl_log = 0;
 
     SetIcon(wxArtProvider::GetIcon(ART_Backup, wxART_FRAME_ICON));
 }
 
 //! implementation details
+void BackupRestoreBaseFrame::addMessage(const wxString& msg, MsgKind kind)
+{
+    size_t first = msgsM.GetCount();
+    msgKindsM.Add((int)kind);
+    msgsM.Add(msg + "\n");
+    updateMessages(first, msgsM.GetCount());
+}
+
+void BackupRestoreBaseFrame::addRunToHistory()
+{
+    DatabasePtr db = getDatabase();
+    // runs that failed would spoil the averages
+    if (!db || !progressM || !progressM->isCompleted()
+        || progressM->hasErrors())
+    {
+        return;
+    }
+
+    BackupRestoreHistory history(db.get(), operationM);
+    size_t count = std::min(comparedRuns, history.getRuns().size());
+    BackupRestoreRun average;
+    bool compare = history.getAverage(count, average);
+    BackupRestoreRun run(progressM->getRun());
+    history.addRun(run);
+
+    bool backup = (operationM == operationBackup);
+    addMessage(wxString::Format(backup
+            ? _("Backup took %s for %s records (%s per second).")
+            : _("Restore took %s for %s records (%s per second)."),
+        formatDuration(run.seconds).c_str(),
+        wxLongLong(run.records).ToString().c_str(),
+        wxLongLong(int64_t(run.getRecordsPerSecond())).ToString().c_str()),
+        important_message);
+    // compare the throughput, the database may have grown since
+    if (!compare || run.records == 0 || average.getRecordsPerSecond() <= 0)
+        return;
+
+    wxString msg(wxString::Format(
+        _("Average of the last %d runs: %s for %s records (%s per second)."),
+        int(count), formatDuration(average.seconds).c_str(),
+        wxLongLong(average.records).ToString().c_str(),
+        wxLongLong(int64_t(average.getRecordsPerSecond())).ToString().c_str()));
+    double change = run.getRecordsPerSecond()
+        / average.getRecordsPerSecond() - 1.0;
+    int percent = int(fabs(change) * 100 + 0.5);
+    if (percent == 0)
+        addMessage(msg, important_message);
+    else if (change > 0)
+    {
+        addMessage(msg + wxString::Format(_(" This run was %d%% faster."),
+            percent), important_message);
+    }
+    else
+    {
+        addMessage(msg + wxString::Format(_(" This run was %d%% slower."),
+            percent), (-change >= slowdownWarning) ? error_message
+                : important_message);
+    }
+}
+
 void BackupRestoreBaseFrame::addThreadMsg(const wxString msg,
     bool& notificationNeeded)
 {
@@ -90,6 +162,15 @@ void BackupRestoreBaseFrame::cancelBackupRestore()
     }
 }
 
+void BackupRestoreBaseFrame::createProgressControls()
+{
+    gauge_progress = new wxGauge(panel_controls, wxID_ANY, 100,
+        wxDefaultPosition, wxDefaultSize, wxGA_HORIZONTAL | wxGA_SMOOTH);
+    // reserve the space for the two lines shown while the job runs
+    label_progress = new wxStaticText(panel_controls, wxID_ANY, " \n ",
+        wxDefaultPosition, wxDefaultSize, wxST_NO_AUTORESIZE);
+}
+
 void BackupRestoreBaseFrame::clearLog()
 {
     msgKindsM.Clear();
@@ -152,6 +233,51 @@ void BackupRestoreBaseFrame::subjectRemoved(Subject* subject)
         Close();
 }
 
+void BackupRestoreBaseFrame::startProgress(BackupRestoreOperation operation,
+    const wxString& file, const std::map<wxString, int64_t>& tableEstimates)
+{
+    DatabasePtr db = getDatabase();
+    wxCHECK_RET(db, "Cannot start progress for unassigned database");
+    operationM = operation;
+
+    // the size of the file can only be watched on the local machine
+    wxString localFile;
+    wxString host(db->getServer()->getHostname());
+    if (host.empty() || host.CmpNoCase("localhost") == 0
+        || host == "127.0.0.1")
+    {
+        localFile = file;
+    }
+
+    int64_t records = 0, bytes = 0;
+    BackupRestoreHistory history(db.get(), operation);
+    if (!history.getRuns().empty())
+    {
+        const BackupRestoreRun& last(history.getRuns().back());
+        records = last.records;
+        bytes = last.bytes;
+        addMessage(wxString::Format(operation == operationBackup
+                ? _("Last backup (%s) took %s for %s records.")
+                : _("Last restore (%s) took %s for %s records."),
+            last.started.Format().c_str(),
+            formatDuration(last.seconds).c_str(),
+            wxLongLong(last.records).ToString().c_str()),
+            important_message);
+    }
+    else if (operation == operationRestore)
+    {
+        // a restore writes as many records as the backup before it
+        BackupRestoreHistory backups(db.get(), operationBackup);
+        if (!backups.getRuns().empty())
+            records = backups.getRuns().back().records;
+    }
+
+    progressM.reset(new BackupRestoreProgress(operation, localFile));
+    progressM->setExpectedWork(records, bytes, tableEstimates);
+    progressM->start();
+    updateProgress();
+}
+
 bool BackupRestoreBaseFrame::startThread(std::auto_ptr<wxThread> thread)
 {
     wxASSERT(threadM == 0);
@@ -159,15 +285,19 @@ bool BackupRestoreBaseFrame::startThread(std::auto_ptr<wxThread> thread)
     {
         ::wxMessageBox(_("Error creating thread!"), _("Error"),
             wxOK | wxICON_ERROR);
+        progressM.reset();
         return false;
     }
     if (wxTHREAD_NO_ERROR != thread->Run())
     {
         ::wxMessageBox(_("Error starting thread!"), _("Error"),
             wxOK | wxICON_ERROR);
+        progressM.reset();
         return false;
     }
     threadM = thread.release();
+    if (progressM)
+        timerProgressM.Start(1000);
     return true;
 }
 
@@ -214,6 +344,25 @@ void BackupRestoreBaseFrame::updateControls()
     // completely initialized yet
 }
 
+void BackupRestoreBaseFrame::updateProgress()
+{
+    if (!progressM)
+    {
+        gauge_progress->SetValue(0);
+        label_progress->SetLabel(wxEmptyString);
+        return;
+    }
+
+    BackupRestoreProgress::Status status(progressM->getStatus());
+    if (status.percent >= 0)
+        gauge_progress->SetValue(status.percent);
+    else if (getThreadRunning())
+        gauge_progress->Pulse();
+    else
+        gauge_progress->SetValue(0);
+    label_progress->SetLabel(status.phase + "\n" + status.getStatistics());
+}
+
 void BackupRestoreBaseFrame::updateMessages(size_t firstmsg, size_t lastmsg)
 {
     if (lastmsg > msgsM.GetCount())
@@ -241,6 +390,7 @@ BEGIN_EVENT_TABLE(BackupRestoreBaseFrame, BaseFrame)
     EVT_CHECKBOX(BackupRestoreBaseFrame::ID_checkbox_showlog, BackupRestoreBaseFrame::OnVerboseLogChange)
     EVT_MENU(BackupRestoreBaseFrame::ID_thread_finished, BackupRestoreBaseFrame::OnThreadFinished)
     EVT_MENU(BackupRestoreBaseFrame::ID_thread_output, BackupRestoreBaseFrame::OnThreadOutput)
+    EVT_TIMER(BackupRestoreBaseFrame::ID_timer_progress, BackupRestoreBaseFrame::OnProgressTimer)
     EVT_TEXT(BackupRestoreBaseFrame::ID_text_ctrl_filename, BackupRestoreBaseFrame::OnSettingsChange)
 END_EVENT_TABLE()
 
@@ -254,9 +404,21 @@ void BackupRestoreBaseFrame::OnThreadFinished(wxCommandEvent& event)
 {
     threadM = 0;
     OnThreadOutput(event);
+    timerProgressM.Stop();
+    if (progressM)
+    {
+        progressM->stop();
+        updateProgress();
+        addRunToHistory();
+    }
     updateControls();
 }
 
+void BackupRestoreBaseFrame::OnProgressTimer(wxTimerEvent& WXUNUSED(event))
+{
+    updateProgress();
+}
+
 void BackupRestoreBaseFrame::OnThreadOutput(wxCommandEvent& WXUNUSED(event))
 {
     wxCriticalSectionLocker locker(critsectM);
@@ -288,6 +450,8 @@ void BackupRestoreBaseFrame::OnThreadOutput(wxCommandEvent& WXUNUSED(event))
     threadMsgsM.Clear();
 
     updateMessages(first, msgsM.GetCount());
+    if (progressM)
+        updateProgress();
 }
 
 void BackupRestoreBaseFrame::OnVerboseLogChange(wxCommandEvent& WXUNUSED(event))
@@ -27,10 +27,13 @@
 
 #include <wx/wx.h>
 #include <wx/thread.h>
+#include <wx/timer.h>
 
+#include <map>
 #include <memory>
 
 #include "core/Observer.h"
+#include "engine/BackupRestoreProgress.h"
 #include "gui/BaseFrame.h"
 #include "metadata/database.h"
 #include "metadata/MetadataClasses.h"
@@ -49,7 +52,8 @@ public:
 
     enum {
         ID_thread_output = 500,
-        ID_thread_finished
+        ID_thread_finished,
+        ID_timer_progress
     };
 
     // make sure that thread gets deleted
@@ -58,6 +62,7 @@ protected:
     wxArrayString msgsM;
     wxArrayInt msgKindsM;
     bool verboseMsgsM;
+    BackupRestoreProgressPtr progressM;
 
     DatabasePtr getDatabase() const;
 
@@ -71,6 +76,11 @@ protected:
     bool startThread(std::auto_ptr<wxThread> thread);
     bool getThreadRunning() const;
 
+    // creates progressM for a new run and shows the last run from the
+    // history, file is the file written by the job on the server
+    void startProgress(BackupRestoreOperation operation,
+        const wxString& file,
+        const std::map<wxString, int64_t>& tableEstimates);
     void threadOutputMsg(const wxString msg, MsgKind kind);
     virtual void updateControls();
     BackupRestoreBaseFrame(wxWindow* parent, DatabasePtr db);
@@ -84,6 +94,12 @@ private:
     void addThreadMsg(const wxString msg, bool& notificationNeeded);
     void updateMessages(size_t firstmsg, size_t lastmsg);
 
+    BackupRestoreOperation operationM;
+    wxTimer timerProgressM;
+    void addMessage(const wxString& msg, MsgKind kind);
+    void addRunToHistory();
+    void updateProgress();
+
     // observer stuff
     virtual void subjectRemoved(Subject* subject);
     virtual void update();
@@ -104,13 +120,17 @@ protected:
     wxButton* button_browse;
     wxCheckBox* checkbox_showlog;
     wxButton* button_start;
+    wxGauge* gauge_progress;
+    wxStaticText* label_progress;
     LogTextControl* text_ctrl_log;
+    void createProgressControls();
     void setupControls();
 private:
     // event handling
     void OnSettingsChange(wxCommandEvent& event);
     void OnThreadFinished(wxCommandEvent& event);
     void OnThreadOutput(wxCommandEvent& event);
+    void OnProgressTimer(wxTimerEvent& event);
     void OnVerboseLogChange(wxCommandEvent& event);
 
     DECLARE_EVENT_TABLE()
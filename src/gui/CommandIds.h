@@ -44,6 +44,9 @@ namespace Cmds
         Query_Show_plan,
         Query_Execute_selection,
         Query_Execute_from_cursor,
+        Query_Execute_batch,
+        Query_Benchmark,
+        Query_BenchmarkPropertyPage,
         Query_Commit,
         Query_Rollback,
         // next 4: order is important, because EVT_MENU_RANGE is used
@@ -88,7 +91,8 @@ namespace Cmds
         Menu_AddColumn, Menu_RestoreIntoNew,
         Menu_MonitorEvents, Menu_GetServerVersion, Menu_AlterObject,
         Menu_DropDatabase, Menu_RecreateDatabase, Menu_DatabaseProperties,
-        Menu_GenerateData, Menu_CloneDatabase,
+        Menu_GenerateData, Menu_CloneDatabase, Menu_ExtractDDLToFile,
+        Menu_CompareSchema, Menu_ImportData, Menu_CopyData,
 
         // view menu
         Menu_ToggleStatusBar, Menu_ToggleSearchBar, Menu_ToggleDisconnected,
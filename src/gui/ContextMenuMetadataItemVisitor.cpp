@@ -94,6 +94,10 @@ void MainObjectMenuMetadataItemVisitor::visitDatabase(Database& database)
     addSeparator();
     toolsMenu->Append(Cmds::Menu_MonitorEvents, _("&Monitor events"));
     toolsMenu->Append(Cmds::Menu_GenerateData, _("&Test data generator"));
+    toolsMenu->Append(Cmds::Menu_ExtractDDLToFile,
+        _("E&xtract DDL to file..."));
+    toolsMenu->Append(Cmds::Menu_CompareSchema, _("&Compare schema with..."));
+    toolsMenu->Append(Cmds::Menu_CopyData, _("Copy table &data to..."));
 
     menuM->Append(Cmds::Menu_DropDatabase, _("Dr&op database"));
     addSeparator();
@@ -273,7 +277,10 @@ void MainObjectMenuMetadataItemVisitor::visitTable(Table& table)
     addGenerateCodeMenu(table);
     addSeparator();
     if (!table.isSystem())
+    {
         menuM->Append(Cmds::Menu_AddColumn, _("&Add column"));
+        menuM->Append(Cmds::Menu_ImportData, _("&Import data..."));
+    }
     addDropItem(table);
     addSeparator();
     // TODO: addRefreshItem();
@@ -0,0 +1,243 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/stopwatch.h>
+
+#include "engine/DataCopier.h"
+#include "gui/AdvancedMessageDialog.h"
+#include "gui/CopyDataDialog.h"
+#include "gui/ProgressDialog.h"
+#include "gui/StyleGuide.h"
+#include "metadata/table.h"
+
+CopyDataDialog::CopyDataDialog(wxWindow* parent, DatabasePtr source,
+        DatabasePtr target)
+    : BaseDialog(parent, -1, wxEmptyString), sourceM(source),
+        targetM(target)
+{
+    TablesPtr sourceTables(sourceM->getTables());
+    TablesPtr targetTables(targetM->getTables());
+    sourceTables->ensureChildrenLoaded();
+    targetTables->ensureChildrenLoaded();
+    for (Tables::iterator it = sourceTables->begin();
+        it != sourceTables->end(); ++it)
+    {
+        TablePtr target(targetTables->findByName((*it)->getName_()));
+        if (!target)
+            continue;
+        sourceTablesM.push_back((*it).get());
+        targetTablesM.push_back(target.get());
+    }
+
+    SetTitle(_("Copy Data to Database ") + targetM->getName_());
+    createControls();
+    layoutControls();
+    selectAll(true);
+    buttonCopy->SetDefault();
+}
+
+void CopyDataDialog::createControls()
+{
+    wxWindow* panel = getControlsPanel();
+    labelTables = new wxStaticText(panel, -1,
+        _("Select the tables to copy, the target tables are matched by name:"));
+    wxArrayString names;
+    for (size_t i = 0; i < sourceTablesM.size(); ++i)
+        names.Add(sourceTablesM[i]->getName_());
+    listTables = new wxCheckListBox(panel, ID_list_tables,
+        wxDefaultPosition, wxSize(-1, 250), names);
+    buttonSelectAll = new wxButton(panel, ID_button_selectall,
+        _("Select &all"));
+    buttonSelectNone = new wxButton(panel, ID_button_selectnone,
+        _("Select &none"));
+
+    labelCommit = new wxStaticText(panel, -1, _("Commit every:"));
+    spinCommit = new wxSpinCtrl(panel, -1, wxEmptyString, wxDefaultPosition,
+        wxDefaultSize, wxSP_ARROW_KEYS, 0, 10000000, 10000);
+    spinCommit->SetToolTip(_("Number of records after which the copied data is committed, with 0 it is committed after each group of tables that don't depend on each other"));
+
+    buttonCopy = new wxButton(panel, wxID_OK, _("Copy"));
+    buttonClose = new wxButton(panel, wxID_CANCEL, _("Close"));
+}
+
+void CopyDataDialog::layoutControls()
+{
+    wxSizer* sizerSelect = new wxBoxSizer(wxHORIZONTAL);
+    sizerSelect->Add(buttonSelectAll);
+    sizerSelect->AddSpacer(
+        styleguide().getBetweenButtonsMargin(wxHORIZONTAL));
+    sizerSelect->Add(buttonSelectNone);
+
+    wxSizer* sizerCommit = new wxBoxSizer(wxHORIZONTAL);
+    sizerCommit->Add(labelCommit, 0, wxALIGN_CENTER_VERTICAL);
+    sizerCommit->AddSpacer(styleguide().getControlLabelMargin());
+    sizerCommit->Add(spinCommit, 0, wxALIGN_CENTER_VERTICAL);
+
+    wxSizer* sizerControls = new wxBoxSizer(wxVERTICAL);
+    sizerControls->Add(labelTables, 0, wxEXPAND);
+    sizerControls->AddSpacer(
+        styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerControls->Add(listTables, 1, wxEXPAND);
+    sizerControls->AddSpacer(
+        styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerControls->Add(sizerSelect, 0, wxEXPAND);
+    sizerControls->AddSpacer(
+        styleguide().getUnrelatedControlMargin(wxVERTICAL));
+    sizerControls->Add(sizerCommit, 0, wxEXPAND);
+
+    // create sizer for buttons -> styleguide class will align it correctly
+    wxSizer* sizerButtons = styleguide().createButtonSizer(buttonCopy,
+        buttonClose);
+    // use method in base class to set everything up
+    layoutSizers(sizerControls, sizerButtons, true);
+}
+
+const wxString CopyDataDialog::getName() const
+{
+    return "CopyDataDialog";
+}
+
+void CopyDataDialog::selectAll(bool select)
+{
+    for (unsigned i = 0; i < listTables->GetCount(); ++i)
+        listTables->Check(i, select);
+    updateButtons();
+}
+
+void CopyDataDialog::updateButtons()
+{
+    bool checked = false;
+    for (unsigned i = 0; i < listTables->GetCount() && !checked; ++i)
+        checked = listTables->IsChecked(i);
+    buttonCopy->Enable(checked);
+}
+
+// returns true if the copy has been completed
+bool CopyDataDialog::copyData()
+{
+    DataCopier copier(sourceM.get(), targetM.get(), spinCommit->GetValue());
+    wxString skipped;
+    for (unsigned i = 0; i < listTables->GetCount(); ++i)
+    {
+        if (listTables->IsChecked(i)
+            && !copier.addTable(sourceTablesM[i], targetTablesM[i]))
+        {
+            skipped += "\n" + sourceTablesM[i]->getName_();
+        }
+    }
+
+    wxStopWatch stopWatch;
+    bool completed = false;
+    bool failed = false;
+    wxString error;
+    try
+    {
+        ProgressDialog pd(this, _("Copying data"),
+            DataCopier::getProgressLevelCount());
+        pd.doShow();
+        completed = copier.run(&pd);
+    }
+    catch (std::exception& e)
+    {
+        failed = true;
+        error = e.what();
+    }
+    if (!completed)
+    {
+        // the workers commit on their own, so tell the user about the
+        // records that were not rolled back
+        wxString committed;
+        if (int64_t count = copier.getCommittedRecords())
+        {
+            committed = wxString::Format(
+                _("%s records had already been committed and remain in the target database."),
+                wxLongLong(count).ToString().c_str());
+        }
+        if (failed)
+        {
+            if (!committed.IsEmpty())
+                error += "\n\n" + committed;
+            showErrorDialog(this, _("Copying data failed"), error,
+                AdvancedMessageDialogButtonsOk());
+        }
+        else if (!committed.IsEmpty())
+        {
+            showWarningDialog(this, _("Copying data canceled"), committed,
+                AdvancedMessageDialogButtonsOk());
+        }
+        return false;
+    }
+
+    double seconds = stopWatch.Time() / 1000.0;
+    int64_t records = copier.getCopiedRecords();
+    int64_t rate = (seconds > 0) ? int64_t(records / seconds) : 0;
+    wxString text(wxString::Format(
+        _("%s records were copied in %.1f seconds (%s per second)."),
+        wxLongLong(records).ToString().c_str(), seconds,
+        wxLongLong(rate).ToString().c_str()));
+    if (!skipped.IsEmpty())
+    {
+        text += "\n\n" + _("These tables have no columns with the same name and were skipped:") + skipped;
+    }
+    showInformationDialog(this, _("Copying data done"), text,
+        AdvancedMessageDialogButtonsOk());
+    return true;
+}
+
+//! event handling
+BEGIN_EVENT_TABLE(CopyDataDialog, BaseDialog)
+    EVT_BUTTON(wxID_OK, CopyDataDialog::OnCopyButtonClick)
+    EVT_BUTTON(CopyDataDialog::ID_button_selectall, CopyDataDialog::OnSelectAllButtonClick)
+    EVT_BUTTON(CopyDataDialog::ID_button_selectnone, CopyDataDialog::OnSelectNoneButtonClick)
+    EVT_CHECKLISTBOX(CopyDataDialog::ID_list_tables, CopyDataDialog::OnTablesChange)
+END_EVENT_TABLE()
+
+void CopyDataDialog::OnCopyButtonClick(wxCommandEvent& WXUNUSED(event))
+{
+    if (copyData())
+        EndModal(wxID_OK);
+}
+
+void CopyDataDialog::OnSelectAllButtonClick(wxCommandEvent& WXUNUSED(event))
+{
+    selectAll(true);
+}
+
+void CopyDataDialog::OnSelectNoneButtonClick(wxCommandEvent& WXUNUSED(event))
+{
+    selectAll(false);
+}
+
+void CopyDataDialog::OnTablesChange(wxCommandEvent& WXUNUSED(event))
+{
+    updateButtons();
+}
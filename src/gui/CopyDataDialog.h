@@ -0,0 +1,80 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_COPYDATADIALOG_H
+#define FR_COPYDATADIALOG_H
+
+#include <wx/wx.h>
+#include <wx/spinctrl.h>
+
+#include <vector>
+
+#include "gui/BaseDialog.h"
+#include "metadata/database.h"
+
+class Table;
+
+class CopyDataDialog: public BaseDialog
+{
+private:
+    DatabasePtr sourceM;
+    DatabasePtr targetM;
+    // tables with the same name in both databases
+    std::vector<Table*> sourceTablesM;
+    std::vector<Table*> targetTablesM;
+
+    wxStaticText* labelTables;
+    wxCheckListBox* listTables;
+    wxButton* buttonSelectAll;
+    wxButton* buttonSelectNone;
+    wxStaticText* labelCommit;
+    wxSpinCtrl* spinCommit;
+    wxButton* buttonCopy;
+    wxButton* buttonClose;
+
+    void createControls();
+    void layoutControls();
+
+    void selectAll(bool select);
+    void updateButtons();
+    bool copyData();
+protected:
+    virtual const wxString getName() const;
+public:
+    CopyDataDialog(wxWindow* parent, DatabasePtr source, DatabasePtr target);
+private:
+    // event handling
+    enum {
+        ID_list_tables = 100,
+        ID_button_selectall,
+        ID_button_selectnone
+    };
+    void OnCopyButtonClick(wxCommandEvent& event);
+    void OnSelectAllButtonClick(wxCommandEvent& event);
+    void OnSelectNoneButtonClick(wxCommandEvent& event);
+    void OnTablesChange(wxCommandEvent& event);
+
+    DECLARE_EVENT_TABLE()
+};
+
+#endif // FR_COPYDATADIALOG_H
@@ -39,12 +39,10 @@
 #include <wx/txtstrm.h>
 #include <wx/xml/xml.h>
 
-// needed for random
-#include <stdlib.h>
-
 #include "core/ArtProvider.h"
 #include "core/FRError.h"
 #include "core/StringUtils.h"
+#include "engine/DataGenerator.h"
 #include "gui/AdvancedMessageDialog.h"
 #include "gui/controls/DBHTreeControl.h"
 #include "gui/DataGeneratorFrame.h"
@@ -54,36 +52,6 @@
 #include "metadata/domain.h"
 #include "metadata/table.h"
 
-// returns a value between 0 and (maxval-1)
-// I wrote this as I don't know how much is rand from stdlib portable
-int frRandom(double maxval)
-{
-    return (int)(maxval*rand()/(RAND_MAX+1.0));
-}
-
-// dd.mm.yyyy
-void str2date(const wxString& str, int& date)
-{
-    long d,m,y;
-    if (!str.Mid(0,2).ToLong(&d) || !str.Mid(3,2).ToLong(&m) ||
-        !str.Mid(6,4).ToLong(&y) || !IBPP::itod(&date, y,m,d))
-    {
-        throw FRError(_("Invalid date: ") + str);
-    }
-}
-
-// HH:MM:SS
-void str2time(const wxString& str, int& mytime)
-{
-    long h = 0, m = 0, s = 0;
-    if (!str.Mid(0, 2).ToLong(&h) || !str.Mid(3, 2).ToLong(&m)
-        || !str.Mid(6, 2).ToLong(&s))
-    {
-        throw FRError(_("Invalid time: ") + str);
-    }
-    IBPP::itot(&mytime, h, m, s, 0);
-}
-
 // only used in function OnGenerateButtonClick
 class TableDep
 {
@@ -165,18 +133,9 @@ void parseTable(wxXmlNode* xmln, std::map<wxString, int>& tr)
         tr.insert(std::pair<wxString, int>(tablename, records));
 }
 
-class GeneratorSettings
+class GeneratorSettings: public DataGeneratorSettings
 {
 public:
-    typedef enum { vtSkip, vtRange, vtColumn, vtFile } ValueType;
-    ValueType valueType;
-    wxString range;
-    wxString sourceTable;
-    wxString sourceColumn;
-    wxString fileName;
-    bool randomValues;
-    int nullPercent;
-
     GeneratorSettings();
     GeneratorSettings(GeneratorSettings* other);
     void toXML(wxXmlNode *parent);
@@ -188,14 +147,8 @@ GeneratorSettings::GeneratorSettings()
 }
 
 GeneratorSettings::GeneratorSettings(GeneratorSettings* other)
+    : DataGeneratorSettings(*other)
 {
-    valueType = other->valueType;
-    range = other->range;
-    sourceTable = other->sourceTable;
-    sourceColumn = other->sourceColumn;
-    fileName = other->fileName;
-    randomValues = other->randomValues;
-    nullPercent = other->nullPercent;
 }
 
 void GeneratorSettings::toXML(wxXmlNode *parent)
@@ -419,6 +372,17 @@ DataGeneratorFrame::DataGeneratorFrame(wxWindow* parent, Database* db)
     wxBoxSizer* buttonSizer;
     buttonSizer = new wxBoxSizer( wxHORIZONTAL );
 
+    commitLabel = new wxStaticText( outerPanel, wxID_ANY, "Commit every", wxDefaultPosition, wxDefaultSize, 0 );
+    buttonSizer->Add( commitLabel, 0, wxALIGN_CENTER_VERTICAL|wxTOP|wxBOTTOM|wxLEFT, 5 );
+
+    commitSpin = new wxSpinCtrl( outerPanel, wxID_ANY, wxEmptyString, wxDefaultPosition,
+        wxDefaultSize, wxSP_ARROW_KEYS, 0, 10000000, 0);
+    commitSpin->SetToolTip(_("Number of records after which the inserted data is committed, with 0 it is committed after each group of tables that don't depend on each other"));
+    buttonSizer->Add( commitSpin, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+
+    commitRecordsLabel = new wxStaticText( outerPanel, wxID_ANY, "records", wxDefaultPosition, wxDefaultSize, 0 );
+    buttonSizer->Add( commitRecordsLabel, 0, wxALIGN_CENTER_VERTICAL|wxTOP|wxBOTTOM|wxRIGHT, 5 );
+
     buttonSizer->Add( 0, 0, 1, wxALL, 5 );
 
     saveButton = new wxButton( outerPanel, ID_button_save, "Save settings", wxDefaultPosition, wxDefaultSize, 0 );
@@ -968,62 +932,78 @@ void DataGeneratorFrame::OnGenerateButtonClick(wxCommandEvent& WXUNUSED(event))
 {
     saveSetting(mainTree->GetSelection());  // save current item if changed
 
-    std::list<Table *> order;
-    if (sortTables(order))
-        generateData(order);
+    std::vector<std::vector<Table *> > levels;
+    if (!sortTables(levels))
+        return;
+    int records = 0;
+    if (!generateData(levels, records))
+        return;
 
-    // perhaps add a comment like: "A total of XYZ records were inserted."
     showInformationDialog(this, _("Generator done"),
-        _("Data generation completed."),
+        wxString::Format(_("Data generation completed. A total of %d records were inserted."),
+            records),
         AdvancedMessageDialogButtonsOk());
 }
 
-bool DataGeneratorFrame::sortTables(std::list<Table *>& order)
+// tables are sorted into levels, the tables of a level only depend on tables
+// of the previous levels and can be filled at the same time
+bool DataGeneratorFrame::sortTables(std::vector<std::vector<Table *> >& levels)
 {
     // collect list of tables
     // if some table is dropped from the database, it would be
     // removed from tree, but it will remain in tableRecordsM
     // That's why we just search for existing tables that are
     // also present in tableRecordsM
-    std::list<TableDep *> deps;
+    std::vector<Table *> tables;
     TablesPtr t = databaseM->getTables();
     for (Tables::iterator it = t->begin(); it != t->end(); ++it)
     {
         std::map<wxString, int>::iterator i2 =
             tableRecordsM.find((*it)->getQuotedName());
         if (i2 != tableRecordsM.end() && (*i2).second > 0)
-        {
-            TableDep *td = new TableDep((*it).get(), tableRecordsM);
-            deps.push_back(td);
-        }
+            tables.push_back((*it).get());
+    }
+    // foreign keys are needed for sorting and columns for inserting
+    Table::loadConstraintsOf(databaseM->getDatabase(), tables);
+    Relation::loadColumnsOf(databaseM->getDatabase(),
+        std::vector<Relation *>(tables.begin(), tables.end()));
+
+    std::list<TableDep *> deps;
+    for (std::vector<Table *>::iterator it = tables.begin();
+        it != tables.end(); ++it)
+    {
+        deps.push_back(new TableDep(*it, tableRecordsM));
     }
 
     // Topological sorting:
-    // take out independent tables one by one and remove them from
-    // dependency lists of those depending on them
+    // take out all independent tables and remove them from dependency lists
+    // of those depending on them, repeat with the remaining tables
     while (!deps.empty())
     {
-        bool removed = false;
+        std::vector<Table *> level;
         for (std::list<TableDep *>::iterator it = deps.begin();
-            it != deps.end(); ++it)
+            it != deps.end(); )
         {
             if ((*it)->dependsOn.size() != 0)   // has dependencies
+            {
+                ++it;
                 continue;
-            order.push_back((*it)->table);
-            wxString tablename = (*it)->table->getQuotedName();
+            }
+            level.push_back((*it)->table);
+            delete (*it);
+            it = deps.erase(it);
+        }
+        for (std::vector<Table *>::iterator it = level.begin();
+            it != level.end(); ++it)
+        {
+            wxString tablename = (*it)->getQuotedName();
             for (std::list<TableDep *>::iterator i2 = deps.begin();
                 i2 != deps.end(); ++i2)
             {
                 (*i2)->remove(tablename);
             }
-
-            delete (*it);
-            deps.erase(it);
-            removed = true;
-            break;
         }
-
-        if (!removed)
+        if (level.empty())
         {
             showWarningDialog(this, _("Circular dependency"),
                 _("A circular dependency was detected among your tables. We are unable to determine to correct order of tables for insert. Currently, the only cure is to first generate data for just one of the tables."),
@@ -1037,557 +1017,84 @@ bool DataGeneratorFrame::sortTables(std::list<Table *>& order)
             }
             return false;
         }
+        levels.push_back(level);
     }
     return true;
 }
 
-// range = comma separated list of values or ranges
-wxString getCharFromRange(const wxString& range, bool rnd, int recNo,
-    int charNo, int chars)
-{
-    wxString valueset;
-    size_t start = 0;
-    while (start < range.Length())
-    {
-        // last
-        wxString one = range.Mid(start);
-        size_t p = range.find(",", start);
-        if (p != wxString::npos)
-        {
-            one = range.Mid(start, p-start);
-            start = p + 1;
-        }
-        else
-            start = range.Length(); // exit on next loop
-        if (one.Length() == 1)
-            valueset += one;
-        else if (one.Length() == 2)     // range
-        {
-            for (wxChar c = one[0]; c <= one[1]; c++)
-                valueset += c;
-        }
-        else
-            throw FRError(_("Bad range: section length not 1 or 2: ") + one);
-    }
-
-    if (rnd)
-        return valueset.Mid(frRandom(valueset.Length()), 1);
-
-    // sequential: we support stuff like 001,002,003 or AAA,AAB,AAC
-    //             by converting the record counter to number with n-th base
-    //             where n is a number of characters in valueset
-    int base = valueset.Length();
-    int record = recNo;
-    for (int i=0; i<chars-charNo-1; i++)    // get the charNo-th digit
-        record /= base;
-    return valueset.Mid(record % base, 1);
-}
-
-void setFromFile(IBPP::Statement st, int param,
-    GeneratorSettings *gs, int recNo)
-{
-    // load strings from file to vector
-    wxFileInputStream stream(gs->fileName);
-    if (!stream.Ok())
-        throw FRError(_("Cannot open file: ")+gs->fileName);
-    wxTextInputStream text(stream);
-
-    std::vector<wxString> values;
-    while (true)
-    {
-        wxString s = text.ReadLine();
-        if (s.IsEmpty())
-            break;
-        values.push_back(s);
-    }
-    if (values.empty())
-        return;
-
-    // select (random/sequential) string from vector
-    wxString selected;
-    if (gs->randomValues)
-        selected = values[frRandom(values.size())];
-    else
-        selected = values[recNo % values.size()];
-
-    // convert string to datatype
-    int mydate, mytime;
-    IBPP::SDT dt = st->ParameterType(param);
-    if (st->ParameterScale(param))
-        dt = IBPP::sdDouble;
-    switch (dt)
-    {
-        case IBPP::sdString:
-            st->Set(param, wx2std(selected));   break;
-        case IBPP::sdSmallint:
-        {
-            long l;
-            if (!selected.ToLong(&l))
-                throw FRError(_("Invalid long (smallint) value: ")+selected);
-            int16_t t = l;
-            st->Set(param, t);
-            break;
-        }
-        case IBPP::sdLargeint:
-        {
-            wxLongLong_t ll;
-            if (!selected.ToLongLong(&ll))
-                throw FRError(_("Invalid long long numeric value: ")+selected);
-            int64_t t = ll;
-            st->Set(param, t);
-            break;
-        }
-        case IBPP::sdInteger:
-        {
-            long l;
-            if (!selected.ToLong(&l))
-                throw FRError(_("Invalid long numeric value: ")+selected);
-            int32_t t = l;
-            st->Set(param, t);
-            break;
-        }
-        case IBPP::sdFloat:
-        {
-            double d;
-            if (!selected.ToDouble(&d))
-                throw FRError(_("Invalid float value: ")+selected);
-            float f = d;
-            st->Set(param, f);
-            break;
-        }
-        case IBPP::sdDouble:
-        {
-            double d;
-            if (!selected.ToDouble(&d))
-                throw FRError(_("Invalid double numeric value: ")+selected);
-            st->Set(param, d);
-            break;
-        }
-        case IBPP::sdTime:
-            str2time(selected, mytime);
-            st->Set(param, IBPP::Time(mytime));
-            break;
-        case IBPP::sdDate:
-            str2date(selected, mydate);
-            st->Set(param, IBPP::Date(mydate));
-            break;
-        case IBPP::sdTimestamp:
-        {
-            str2date(selected, mydate);
-            str2time(selected.Mid(11), mytime);
-            int y, mo, d, h, mi, s, t;
-            IBPP::dtoi(mydate, &y, &mo, &d);
-            IBPP::ttoi(mytime, &h, &mi, &s, &t);
-            st->Set(param, IBPP::Timestamp(y, mo, d, h, mi, s, t));
-            break;
-        }
-        case IBPP::sdBlob:
-            throw FRError(_("Blob datatype not supported"));
-        case IBPP::sdArray:
-            throw FRError(_("Array datatype not supported"));
-    };
-}
-
-template<typename T>
-void setFromOther(IBPP::Statement st, int param,
-    GeneratorSettings *gs, size_t recNo)
-{
-    IBPP::Statement st2 =
-        IBPP::StatementFactory(st->DatabasePtr(), st->TransactionPtr());
-
-    wxString sql = "SELECT " + gs->sourceColumn + " FROM "
-        + gs->sourceTable + " WHERE " + gs->sourceColumn
-        + " IS NOT NULL";
-    if (!gs->randomValues)
-        sql += " ORDER BY 1";
-    st2->Prepare(wx2std(sql));
-    st2->Execute();
-    std::vector<T> values;
-    while (st2->Fetch())
-    {
-        T value;
-        st2->Get(1, value);
-        values.push_back(value);
-        if (values.size() > recNo && !gs->randomValues)
-        {
-            st->Set(param, value);
-            return;
-        }
-        if (values.size() > 99 && gs->randomValues)
-            break;
-    }
-    if (values.size() == 0)
-    {
-        if (gs->nullPercent > 0)
-        {
-            st->SetNull(param);
-            return;
-        }
-        else
-            throw FRError(_("No records found in table: ") + gs->sourceTable);
-    }
-
-    if (gs->randomValues)
-        st->Set(param, values[frRandom(values.size())]);
-    else
-        st->Set(param, values[recNo % values.size()]);
-}
-
-// format for values:
-// number[value or range(s)]
-// example: 25[az,AZ,09] means: 25 letters or numbers
-// example: 10[a,x,5]       means: 10 chars, each either of 'a', 'x' or '5'
-void DataGeneratorFrame::setString(IBPP::Statement st, int param,
-    GeneratorSettings* gs, int recNo)
-{
-    wxString value;
-    long chars = 1;
-    size_t start = 0;
-    while (start < gs->range.Length())
-    {
-        if (gs->range.Mid(start, 1) == "[")
-        {
-            size_t p = gs->range.find("]", start+1);
-            if (p == wxString::npos)    // invalid mask
-                throw FRError(_("Invalid mask: missing ]"));
-            for (int i = 0; i < chars; i++)
-            {
-                value += getCharFromRange(gs->range.Mid(start+1,
-                    p-start-1), gs->randomValues, recNo, i, chars);
-            }
-            start = p+1;
-            chars = 1;
-        }
-        else
-        {
-            size_t p = gs->range.find("[", start+1);
-            if (p == wxString::npos)    // invalid mask
-                throw FRError(_("Invalid mask, missing ["));
-            wxString number = gs->range.Mid(start, p-start);
-            if (!number.ToLong(&chars))
-                throw FRError(_("Bad number: ")+number);
-            start = p;
-        }
-    }
-    st->Set(param, wx2std(value, databaseM->getCharsetConverter()));
-}
-
-// gs->range = x,x-y,...
-template<typename T>
-void setNumber(IBPP::Statement st, int param, GeneratorSettings* gs, int recNo)
-{
-    std::vector< std::pair<long,long> > ranges;
-    long rangesize = 0;
-    size_t start = 0;
-    while (start < gs->range.Length())
-    {
-        // last
-        wxString one = gs->range.Mid(start);
-        size_t p = gs->range.find(",", start);
-        if (p != wxString::npos)
-        {
-            one = gs->range.Mid(start, p-start);
-            start = p + 1;
-        }
-        else
-            start = gs->range.Length(); // exit on next loop
-
-        p = one.find("-");
-        if (p == wxString::npos)
-        {
-            long l;
-            if (!one.ToLong(&l))
-                throw FRError(_("Invalid number: ") + one);
-            ranges.push_back(std::pair<long,long>(l, l));
-            rangesize++;
-        }
-        else
-        {
-            long l1, l2;
-            if (!one.Mid(0, p).ToLong(&l1) || !one.Mid(p+1).ToLong(&l2))
-                throw FRError(_("Invalid range: ") + one);
-            ranges.push_back(std::pair<long,long>(l1, l2));
-            rangesize += (l2-l1+1);
-        }
-    }
-
-    long toget = (gs->randomValues ?
-        frRandom(rangesize) : (recNo % rangesize));
 
-    for (std::vector< std::pair<long,long> >::iterator it =
-        ranges.begin(); it != ranges.end(); ++it)
-    {
-        long sz = (*it).second - (*it).first + 1;
-        if (sz > toget)
-        {
-            st->Set(param, (T)((*it).first + toget));
-            return;
-        }
-        toget -= sz;
-    }
-}
-
-void setDatetime(IBPP::Statement st, int param, GeneratorSettings* gs,
-    int recNo)
+bool DataGeneratorFrame::generateData(
+    std::vector<std::vector<Table *> >& levels, int& records)
 {
-    std::vector< std::pair<int,int> > dateRanges;
-    std::vector< std::pair<int,int> > timeRanges;
-    int dateRangesize = 0;
-    int timeRangesize = 0;
-
-    IBPP::SDT dt = st->ParameterType(param);
-    size_t start = 0;
-    while (start < gs->range.Length())
+    DataGenerator generator(databaseM, commitSpin->GetValue());
+    for (std::vector<std::vector<Table *> >::iterator level = levels.begin();
+        level != levels.end(); ++level)
     {
-        // last
-        wxString one = gs->range.Mid(start);
-        size_t p = gs->range.find(",", start);
-        if (p != wxString::npos)
+        generator.addLevel();
+        for (std::vector<Table *>::iterator it = (*level).begin();
+            it != (*level).end(); ++it)
         {
-            one = gs->range.Mid(start, p-start);
-            start = p + 1;
-        }
-        else
-            start = gs->range.Length(); // exit on next loop
-
-        // convert first value
-        int date, time;
-        if ((dt == IBPP::sdDate || dt == IBPP::sdTimestamp))
-            str2date(one.Mid(0,10), date);
-        if (dt == IBPP::sdTime)
-            str2time(one.Mid(0,8), time);
-        if (dt == IBPP::sdTimestamp)
-            str2time(one.Mid(11,8), time);
-
-        p = one.find("-");
-        if (p == wxString::npos)
-        {
-            if (dt == IBPP::sdDate || dt == IBPP::sdTimestamp)
+            std::map<wxString, int>::iterator i2 =
+                tableRecordsM.find((*it)->getQuotedName());
+
+            // collect columns and their settings
+            (*it)->ensureChildrenLoaded();
+            std::vector<Column *> columns;
+            std::vector<DataGeneratorSettings> colSet;
+            for (ColumnPtrs::iterator col = (*it)->begin();
+                col != (*it)->end(); ++col)
             {
-                dateRanges.push_back(std::pair<int,int>(date, date));
-                dateRangesize++;
+                GeneratorSettings *gs = getSettings((*col).get());   // load or create
+                if (gs->valueType == GeneratorSettings::vtSkip)
+                    continue;
+                columns.push_back((*col).get());
+                colSet.push_back(*gs);
             }
-            if (dt == IBPP::sdTime || dt == IBPP::sdTimestamp)
-            {
-                timeRanges.push_back(std::pair<int,int>(time, time));
-                timeRangesize++;
-            }
-        }
-        else    // range, convert second date/time
-        {
-            int date2, time2;
-            if (dt == IBPP::sdDate)
-                str2date(one.Mid(11,10), date2);
-            if (dt == IBPP::sdTimestamp)
-                str2date(one.Mid(20,10), date2);
-            if (dt == IBPP::sdTime)
-                str2time(one.Mid( 9, 8), time2);
-            if (dt == IBPP::sdTimestamp)
-                str2time(one.Mid(31, 8), time2);
-
-            if (dt == IBPP::sdDate || dt == IBPP::sdTimestamp)
-            {
-                dateRanges.push_back(std::pair<int,int>(date, date2));
-                dateRangesize += (date2-date+1);
-            }
-            if (dt == IBPP::sdTime || dt == IBPP::sdTimestamp)
-            {
-                timeRanges.push_back(std::pair<int,int>(time, time2));
-                timeRangesize += ((time2-time) / 10000 + 1);
-            }
-        }
-    }
-
-    int dateToGet, timeToGet;
-    if (gs->randomValues)
-    {
-        dateToGet = (dateRangesize ? frRandom(dateRangesize) : 0);
-        timeToGet = (timeRangesize ? frRandom(timeRangesize) : 0);
-    }
-    else
-    {
-        dateToGet = (dateRangesize ? recNo % dateRangesize : 0);
-        timeToGet = (timeRangesize ? recNo % timeRangesize : 0);
-    }
-
-    int myDate = 0;
-    int myTime = 0;
-    for (std::vector< std::pair<int,int> >::iterator it =
-        dateRanges.begin(); it != dateRanges.end(); ++it)
-    {
-        int sz = (*it).second - (*it).first + 1;
-        if (sz > dateToGet)
-        {
-            myDate = ((*it).first + dateToGet);
-            break;
-        }
-        dateToGet -= sz;
-    }
-    for (std::vector< std::pair<int,int> >::iterator it =
-        timeRanges.begin(); it != timeRanges.end(); ++it)
-    {
-        int sz = ((*it).second - (*it).first)/10000 + 1;
-        if (sz > timeToGet)
-        {
-            myTime = ((*it).first + timeToGet*10000);
-            break;
+            if (columns.empty())
+                continue;
+            generator.addTable(*it, (*i2).second, columns, colSet);
         }
-        timeToGet -= sz;
     }
 
-    if (dt == IBPP::sdDate)
-        st->Set(param, IBPP::Date(myDate));
-    if (dt == IBPP::sdTime)
-        st->Set(param, IBPP::Time(myTime));
-    if (dt == IBPP::sdTimestamp)
+    bool completed = false;
+    bool failed = false;
+    wxString error;
+    try
     {
-        int y, mo, d, h, mi, s, t;
-        IBPP::dtoi(myDate, &y, &mo, &d);
-        IBPP::ttoi(myTime, &h, &mi, &s, &t);
-        st->Set(param, IBPP::Timestamp(y, mo, d, h, mi, s, t));
+        ProgressDialog pd(this, _("Generating data"), 2);
+        pd.doShow();
+        pd.initProgress(_("Inserting into tables"));
+        completed = generator.run(&pd);
     }
-}
-
-void DataGeneratorFrame::setParam(IBPP::Statement st, int param,
-    GeneratorSettings* gs, int recNo)
-{
-    if (gs->nullPercent > frRandom(100))
+    catch (std::exception& e)
     {
-        st->SetNull(param);
-        return;
+        failed = true;
+        error = e.what();
     }
-
-    if (gs->valueType == GeneratorSettings::vtColumn)   // copy from column
+    records = generator.getInsertedRecords();
+    if (completed)
+        return true;
+
+    // every level is committed on its own, so tell the user about the
+    // records that were not rolled back
+    wxString committed;
+    if (int count = generator.getCommittedRecords())
     {
-        switch (st->ParameterType(param))
-        {
-            case IBPP::sdString:
-                setFromOther<std::string>(st, param, gs, recNo);  break;
-            case IBPP::sdSmallint:
-                setFromOther<int16_t>(st, param, gs, recNo);      break;
-            case IBPP::sdInteger:
-                setFromOther<int32_t>(st, param, gs, recNo);      break;
-            case IBPP::sdLargeint:
-                setFromOther<int64_t>(st, param, gs, recNo);      break;
-            case IBPP::sdFloat:
-                setFromOther<float>(st, param, gs, recNo);        break;
-            case IBPP::sdDouble:
-                setFromOther<double>(st, param, gs, recNo);       break;
-            case IBPP::sdDate:
-                setFromOther<IBPP::Date>(st, param, gs, recNo);   break;
-            case IBPP::sdTime:
-                setFromOther<IBPP::Time>(st, param, gs, recNo);   break;
-            case IBPP::sdTimestamp:
-                setFromOther<IBPP::Timestamp>(st, param, gs, recNo);  break;
-            case IBPP::sdBlob:
-                throw FRError(_("Blob datatype not supported"));
-            case IBPP::sdArray:
-                throw FRError(_("Array datatype not supported"));
-        };
-        return;
+        committed = wxString::Format(
+            _("%d records had already been committed and remain in the database."),
+            count);
     }
-
-    if (gs->valueType == GeneratorSettings::vtRange)
+    if (failed)
     {
-        switch (st->ParameterType(param))
-        {
-            case IBPP::sdString:
-                setString(st, param, gs, recNo);          break;
-            case IBPP::sdSmallint:
-                setNumber<int16_t>(st, param, gs, recNo); break;
-            case IBPP::sdInteger:
-                setNumber<int32_t>(st, param, gs, recNo); break;
-            case IBPP::sdLargeint:
-                setNumber<int64_t>(st, param, gs, recNo); break;
-            case IBPP::sdFloat:
-                setNumber<float>  (st, param, gs, recNo); break;
-            case IBPP::sdDouble:
-                setNumber<double> (st, param, gs, recNo); break;
-            case IBPP::sdDate:
-            case IBPP::sdTime:
-            case IBPP::sdTimestamp:
-                setDatetime(st, param, gs, recNo);
-                break;
-            case IBPP::sdBlob:
-                throw FRError(_("Blob datatype not supported"));
-            case IBPP::sdArray:
-                throw FRError(_("Array datatype not supported"));
-            default:
-                st->SetNull(param);
-        };
+        if (!committed.IsEmpty())
+            error += "\n\n" + committed;
+        showErrorDialog(this, _("Generating data failed"), error,
+            AdvancedMessageDialogButtonsOk());
     }
-
-    if (gs->valueType == GeneratorSettings::vtFile)
-        setFromFile(st, param, gs, recNo);
-}
-
-void DataGeneratorFrame::generateData(std::list<Table *>& order)
-{
-    ProgressDialog pd(this, _("Generating data"), 2);
-    pd.doShow();
-    pd.initProgress(_("Inserting into tables"), order.size());
-
-    // one big transaction (perhaps this should be configurable)
-    IBPP::Transaction tr =
-        IBPP::TransactionFactory(databaseM->getIBPPDatabase());
-    tr->Start();
-
-    for (std::list<Table *>::iterator it = order.begin();
-        it != order.end(); ++it)
+    else if (!committed.IsEmpty())
     {
-        pd.setProgressMessage((*it)->getName_(), 1);
-        pd.stepProgress();
-
-        std::map<wxString, int>::iterator i2 =
-            tableRecordsM.find((*it)->getQuotedName());
-        int records = (*i2).second;
-
-        pd.initProgress(wxString::Format(_("Inserting %d records."), records),
-            records, 0, 2);
-
-        // collect columns + create insert statement
-        wxString ins = "INSERT INTO " + (*it)->getQuotedName()
-            + " (";
-        wxString params(") VALUES (");
-        (*it)->ensureChildrenLoaded();
-        bool first = true;
-        std::vector<GeneratorSettings *> colSet;
-        for (ColumnPtrs::iterator col = (*it)->begin();
-            col != (*it)->end(); ++col)
-        {
-            GeneratorSettings *gs = getSettings((*col).get());   // load or create
-            if (gs->valueType == GeneratorSettings::vtSkip)
-                continue;
-
-            if (first)
-                first = false;
-            else
-            {
-                ins += ", ";
-                params += ",";
-            }
-            ins += (*col)->getQuotedName();
-            params += "?";
-            colSet.push_back(gs);
-        }
-        if (first)  // no columns
-            continue;
-
-        IBPP::Statement st =
-            IBPP::StatementFactory(databaseM->getIBPPDatabase(), tr);
-        st->Prepare(wx2std(ins + params + ")"));
-
-        for (int i = 0; i < records; i++)
-        {
-            if (pd.isCanceled())
-                return;
-            pd.stepProgress(1, 2);
-            for (int p = 0; p < st->Parameters(); ++p)
-                setParam(st, p+1, colSet[p], i);
-            st->Execute();
-        }
+        showWarningDialog(this, _("Generating data canceled"), committed,
+            AdvancedMessageDialogButtonsOk());
     }
-
-    tr->Commit();
+    return false;
 }
-
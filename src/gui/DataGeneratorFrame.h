@@ -28,8 +28,7 @@
 #include <wx/splitter.h>
 
 #include <map>
-
-#include <ibpp.h>
+#include <vector>
 
 #include "core/Observer.h"
 #include "core/StringUtils.h"
@@ -56,13 +55,11 @@ protected:
     void saveSetting(wxTreeItemId item);
     void loadSetting(wxTreeItemId newitem);
     bool loadColumns(const wxString& tableName, wxChoice* c);
-    bool sortTables(std::list<Table *>& order);
-    void generateData(std::list<Table *>& order);
-
-    void setParam( IBPP::Statement st, int param, GeneratorSettings* gs,
-        int recNo);
-    void setString(IBPP::Statement st, int param, GeneratorSettings* gs,
-        int recNo);
+    bool sortTables(std::vector<std::vector<Table *> >& levels);
+    // returns false if canceled, records is set to the number of inserted
+    // records in any case
+    bool generateData(std::vector<std::vector<Table *> >& levels,
+        int& records);
 
     enum
     {
@@ -110,6 +107,9 @@ protected:
     wxChoice* copyChoice;
     wxChoice* copyColumnChoice;
     wxButton* copyButton;
+    wxStaticText* commitLabel;
+    wxSpinCtrl* commitSpin;
+    wxStaticText* commitRecordsLabel;
     wxButton* saveButton;
     wxButton* loadButton;
     wxButton* generateButton;
@@ -34,11 +34,13 @@
 #include <wx/dnd.h>
 #include <wx/file.h>
 #include <wx/fontdlg.h>
+#include <wx/numdlg.h>
 #include <wx/stopwatch.h>
 #include <wx/tokenzr.h>
 
 #include <algorithm>
 #include <map>
+#include <set>
 #include <vector>
 
 #include "config/Config.h"
@@ -48,6 +50,7 @@
 #include "core/StringUtils.h"
 #include "core/URIProcessor.h"
 #include "engine/MetadataLoader.h"
+#include "engine/StatementBenchmark.h"
 #include "gui/AdvancedMessageDialog.h"
 #include "gui/CommandIds.h"
 #include "gui/CommandManager.h"
@@ -57,6 +60,7 @@
 #include "gui/GUIURIHandlerHelper.h"
 #include "gui/MetadataItemPropertiesFrame.h"
 #include "gui/ProgressDialog.h"
+#include "gui/PropertyPageBenchmark.h"
 #include "gui/EditBlobDialog.h"
 #include "gui/ExecuteSql.h"
 #include "gui/ExecuteSqlFrame.h"
@@ -77,6 +81,7 @@
 #include "metadata/server.h"
 #include "metadata/table.h"
 #include "metadata/view.h"
+#include "sql/ExecutionPlan.h"
 #include "sql/Identifier.h"
 #include "sql/IncompleteStatement.h"
 #include "sql/MultiStatement.h"
@@ -525,6 +530,11 @@ ExecuteSqlFrame::ExecuteSqlFrame(wxWindow* WXUNUSED(parent), int id,
     updateEditorCaretPosM = true;
     updateFrameTitleM = true;
 
+    batchModeM = false;
+    batchSlowestCountM = 0;
+    batchStatementCountM = 0;
+    batchTotalMillisM = 0;
+
     transactionIsolationLevelM = IBPP::ilConcurrency;
     transactionLockResolutionM = IBPP::lrWait;
     transactionAccessModeM = IBPP::amWrite;
@@ -554,6 +564,10 @@ ExecuteSqlFrame::ExecuteSqlFrame(wxWindow* WXUNUSED(parent), int id,
     grid_data = new DataGrid(notebook_pane_2, ID_grid_data);
     notebook_1->AddPage(notebook_pane_2, _("Data"));
 
+    notebook_pane_3 = new wxPanel(notebook_1, -1);
+    list_relation_io = new RelationIOListCtrl(notebook_pane_3);
+    notebook_1->AddPage(notebook_pane_3, _("Table I/O"));
+
     statusbar_1 = CreateStatusBar(4);
     SetStatusBarPane(-1);
 
@@ -726,6 +740,12 @@ void ExecuteSqlFrame::buildMainMenu(CommandManager& cm)
         cm.getMainMenuItemText(_("Execute &selection"), Cmds::Query_Execute_selection));
     statementMenu->Append(Cmds::Query_Execute_from_cursor,
         cm.getMainMenuItemText(_("Exec&ute from cursor"), Cmds::Query_Execute_from_cursor));
+    statementMenu->Append(Cmds::Query_Execute_batch,
+        cm.getMainMenuItemText(_("Execute as &batch"), Cmds::Query_Execute_batch));
+    statementMenu->Append(Cmds::Query_Benchmark,
+        cm.getMainMenuItemText(_("Bench&mark statement..."), Cmds::Query_Benchmark));
+    statementMenu->Append(Cmds::Query_BenchmarkPropertyPage,
+        cm.getMainMenuItemText(_("Benchmark table p&roperty page..."), Cmds::Query_BenchmarkPropertyPage));
     statementMenu->AppendSeparator();
 
     wxMenu* stmtPropMenu = new wxMenu();
@@ -818,6 +838,11 @@ void ExecuteSqlFrame::do_layout()
     sizerPane2->Add(grid_data, 1, wxEXPAND);
     notebook_pane_2->SetSizer(sizerPane2);
 
+    // per-table I/O notebook pane
+    wxBoxSizer* sizerPane3 = new wxBoxSizer(wxHORIZONTAL);
+    sizerPane3->Add(list_relation_io, 1, wxEXPAND);
+    notebook_pane_3->SetSizer(sizerPane3);
+
     // splitter is only control in panel_contents
     wxBoxSizer* sizerContents = new wxBoxSizer(wxHORIZONTAL);
     sizerContents->Add(splitter_window_1, 1, wxEXPAND);
@@ -864,6 +889,8 @@ void ExecuteSqlFrame::doBeforeDestroy()
     // prevent editor from updating the invalid dataset
     if (grid_data->IsCellEditControlEnabled())
         grid_data->EnableCellEditControl(false);
+    // write the statements logged by this frame
+    Logger::flush();
     // make sure that further calls to update() will not call Close() again
     databaseM = 0;
 }
@@ -942,10 +969,16 @@ BEGIN_EVENT_TABLE(ExecuteSqlFrame, wxFrame)
     EVT_MENU(Cmds::Query_Show_plan,           ExecuteSqlFrame::OnMenuShowPlan)
     EVT_MENU(Cmds::Query_Execute_selection,   ExecuteSqlFrame::OnMenuExecuteSelection)
     EVT_MENU(Cmds::Query_Execute_from_cursor, ExecuteSqlFrame::OnMenuExecuteFromCursor)
+    EVT_MENU(Cmds::Query_Execute_batch,       ExecuteSqlFrame::OnMenuExecuteBatch)
+    EVT_MENU(Cmds::Query_Benchmark,           ExecuteSqlFrame::OnMenuBenchmark)
+    EVT_MENU(Cmds::Query_BenchmarkPropertyPage, ExecuteSqlFrame::OnMenuBenchmarkPropertyPage)
     EVT_UPDATE_UI(Cmds::Query_Execute,             ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
     EVT_UPDATE_UI(Cmds::Query_Show_plan,           ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
     EVT_UPDATE_UI(Cmds::Query_Execute_selection,   ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
     EVT_UPDATE_UI(Cmds::Query_Execute_from_cursor, ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
+    EVT_UPDATE_UI(Cmds::Query_Execute_batch,       ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
+    EVT_UPDATE_UI(Cmds::Query_Benchmark,           ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
+    EVT_UPDATE_UI(Cmds::Query_BenchmarkPropertyPage, ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible)
     EVT_MENU(Cmds::Query_Commit,              ExecuteSqlFrame::OnMenuCommit)
     EVT_MENU(Cmds::Query_Rollback,            ExecuteSqlFrame::OnMenuRollback)
     EVT_UPDATE_UI(Cmds::Query_Commit,         ExecuteSqlFrame::OnMenuUpdateWhenInTransaction)
@@ -1586,6 +1619,35 @@ void ExecuteSqlFrame::OnMenuExecuteSelection(wxCommandEvent& WXUNUSED(event))
             );
 }
 
+void ExecuteSqlFrame::OnMenuExecuteBatch(wxCommandEvent& WXUNUSED(event))
+{
+    clearLogBeforeExecution();
+
+    wxString sql;
+    int selectionOffset = 0;
+    if (styled_text_ctrl_sql->hasSelection()
+        && config().get("OnlyExecuteSelected", false))
+    {
+        sql = styled_text_ctrl_sql->GetSelectedText();
+        selectionOffset = styled_text_ctrl_sql->GetSelectionStart();
+    }
+    else
+        sql = styled_text_ctrl_sql->GetText();
+
+    bool ok;
+    {
+        BatchScope batch(this);
+        ok = parseStatements(sql, false, false, selectionOffset);
+    }
+
+    if (ok || config().get("historyStoreUnsuccessful", true))
+    {
+        StatementHistory& sh = StatementHistory::get(databaseM);
+        sh.add(styled_text_ctrl_sql->GetText());
+        historyPositionM = sh.size();
+    }
+}
+
 void ExecuteSqlFrame::OnMenuGridFetchAll(wxCommandEvent& WXUNUSED(event))
 {
     grid_data->fetchAll();
@@ -2089,6 +2151,9 @@ bool ExecuteSqlFrame::parseStatements(const wxString& statements,
 {
     wxBusyCursor cr;
     MultiStatement ms(statements);
+    bool continueAfterErrors = batchModeM
+        && config().get("SQLEditorBatchContinueOnError", true);
+    bool allSucceeded = true;
     while (true)
     {
         SingleStatement ss = ms.getNextStatement();
@@ -2127,18 +2192,33 @@ bool ExecuteSqlFrame::parseStatements(const wxString& statements,
                 return false;
             }
         }
-        else if (!ss.isEmptyStatement()
-            && !execute(ss.getSql(), ms.getTerminator(), prepareOnly))
+        else if (!ss.isEmptyStatement())
         {
             int stmtStart = selectionOffset + ms.getStart();
-            // STC uses UTF-8 internally in Unicode build
-            // account for possible differences in string length
-            // if system charset != UTF-8
-            std::string stmt(wx2std(ss.getSql(), &wxConvUTF8));
-            int stmtEnd = stmtStart + stmt.size();
-            styled_text_ctrl_sql->markText(stmtStart, stmtEnd);
-            styled_text_ctrl_sql->SetFocus();
-            return false;
+            wxStopWatch sw;
+            bool ok = execute(ss.getSql(), ms.getTerminator(), prepareOnly);
+            if (batchModeM)
+            {
+                addBatchStatement(ss.getSql(),
+                    styled_text_ctrl_sql->LineFromPosition(stmtStart) + 1,
+                    sw.Time(), ok);
+                if (!ok && continueAfterErrors)
+                {
+                    allSucceeded = false;
+                    continue;
+                }
+            }
+            if (!ok)
+            {
+                // STC uses UTF-8 internally in Unicode build
+                // account for possible differences in string length
+                // if system charset != UTF-8
+                std::string stmt(wx2std(ss.getSql(), &wxConvUTF8));
+                int stmtEnd = stmtStart + stmt.size();
+                styled_text_ctrl_sql->markText(stmtStart, stmtEnd);
+                styled_text_ctrl_sql->SetFocus();
+                return false;
+            }
         }
     }
 
@@ -2150,7 +2230,7 @@ bool ExecuteSqlFrame::parseStatements(const wxString& statements,
 
     ScrollAtEnd sae(styled_text_ctrl_stats);
     log(_("Script execution finished."));
-    return true;
+    return allSucceeded;
 }
 
 void ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible(wxUpdateUIEvent& event)
@@ -2185,54 +2265,150 @@ wxString IBPPtype2string(Database *db, IBPP::SDT t, int subtype, int size,
     }
 }
 
-void ExecuteSqlFrame::compareCounts(IBPP::DatabaseCounts& one,
-    IBPP::DatabaseCounts& two)
+// returns a lower bound of the number of data pages of the relation
+int ExecuteSqlFrame::getRelationDataPages(const wxString& relationName)
 {
-    for (IBPP::DatabaseCounts::iterator it = two.begin(); it != two.end();
-        ++it)
+    // RDB$PAGES lists the pointer pages of a relation but not its data
+    // pages, a new pointer page is only allocated when the previous one is
+    // full, so all but the last one point to as many data pages as fit on
+    // them: 32 bits for the page number plus 2 (ODS 11) or 8 (ODS 12)
+    // flag bits per data page after a header of less than 40 bytes
+    try
     {
-        wxString s;
-        IBPP::DatabaseCounts::iterator i2 = one.find((*it).first);
-        IBPP::CountInfo c;
-        IBPP::CountInfo& r1 = (*it).second;
-        IBPP::CountInfo& r2 = c;
-        if (i2 != one.end())
-            r2 = (*i2).second;
-        if (r1.inserts > r2.inserts)
-            s += wxString::Format(_("%d inserts. "), r1.inserts - r2.inserts);
-        if (r1.updates > r2.updates)
-            s += wxString::Format(_("%d updates. "), r1.updates - r2.updates);
-        if (r1.deletes > r2.deletes)
-            s += wxString::Format(_("%d deletes. "), r1.deletes - r2.deletes);
-        if (!s.IsEmpty())
+        int pageSize = databaseM->getInfo().getPageSize();
+        if (pageSize <= 0)
+            return 0;
+        int bitsPerDataPage =
+            databaseM->getInfo().getODSVersionIsHigherOrEqualTo(12) ? 40 : 34;
+        int dataPagesPerPointerPage = (pageSize - 40) * 8 / bitsPerDataPage;
+
+        MetadataLoader* loader = databaseM->getMetadataLoader();
+        MetadataLoaderTransaction tr(loader);
+        IBPP::Statement& st1 = loader->getStatement(
+            "select count(*) from rdb$pages p "
+            "join rdb$relations r on r.rdb$relation_id = p.rdb$relation_id "
+            "where r.rdb$relation_name = ? and p.rdb$page_type = 4");
+        st1->Set(1, wx2std(relationName, databaseM->getCharsetConverter()));
+        st1->Execute();
+        if (st1->Fetch())
         {
-            wxString relName;
-            try
-            {
-                IBPP::Statement st = IBPP::StatementFactory(
-                    databaseM->getIBPPDatabase(), transactionM);
-                st->Prepare(
-                    "select rdb$relation_name "
-                    "from rdb$relations where rdb$relation_id = ?");
-                st->Set(1, (*it).first);
-                st->Execute();
-                if (st->Fetch())
-                {
-                    std::string s;
-                    st->Get(1, s);
-                    relName = std2wxIdentifier(s, databaseM->getCharsetConverter());
-                }
-            }
-            catch (...)
+            int pointerPages;
+            st1->Get(1, pointerPages);
+            // nothing is known about the last pointer page
+            if (pointerPages <= 1)
+                return 0;
+            return (pointerPages - 1) * dataPagesPerPointerPage;
+        }
+    }
+    catch (IBPP::Exception&)
+    {
+    }
+    return 0;
+}
+
+std::vector<wxString> ExecuteSqlFrame::checkPlan(const wxString& sql,
+    const wxString& planText)
+{
+    std::vector<wxString> relationNames;
+    ExecutionPlan plan(planText);
+    if (plan.isEmpty())
+        return relationNames;
+
+    StatementHistory& sh = StatementHistory::get(databaseM);
+    wxString hash(ExecutionPlan::getStatementHash(sql));
+    wxString previousText(sh.getPlan(hash));
+    if (!previousText.IsEmpty())
+    {
+        ExecutionPlan previous(previousText);
+        if (!plan.equals(previous))
+        {
+            log(_("Plan has changed since the previous execution, the previous plan was:"),
+                ttError);
+            log(previous.toString());
+            std::vector<ExecutionPlanChange> changes(plan.compareTo(previous));
+            for (std::vector<ExecutionPlanChange>::const_iterator it =
+                changes.begin(); it != changes.end(); ++it)
             {
+                log(wxString::Format(_("%s: %s -> %s"), (*it).name.c_str(),
+                    (*it).previousAccess.c_str(), (*it).currentAccess.c_str()),
+                    (*it).isRegression ? ttError : ttSql);
             }
-            if (relName.IsEmpty())
-                relName.Format(_("Relation #%d"), (*it).first);
-            log(relName + ": " + s, ttSql);
+        }
+    }
+    sh.setPlan(hash, plan.toString());
+
+    std::vector<const ExecutionPlanNode*> scans(plan.getNaturalScans());
+    std::set<wxString> scannedRelations;
+    for (std::vector<const ExecutionPlanNode*>::const_iterator it =
+        scans.begin(); it != scans.end(); ++it)
+    {
+        // legacy plans show aliases, try them as relation names
+        wxString relationName((*it)->relationName);
+        if (relationName.IsEmpty())
+        {
+            Relation* r = databaseM->findRelation(Identifier((*it)->name));
+            if (!r)
+                continue;
+            relationName = r->getName_();
+        }
+        // self joins scan the same relation more than once
+        if (scannedRelations.insert(relationName).second)
+            relationNames.push_back(relationName);
+    }
+    return relationNames;
+}
+
+void ExecuteSqlFrame::checkNaturalScans(
+    const std::vector<wxString>& relationNames)
+{
+    int largePages = config().get("PlanLargeTableDataPages", 1000);
+    if (largePages <= 0)
+        return;
+    for (std::vector<wxString>::const_iterator it = relationNames.begin();
+        it != relationNames.end(); ++it)
+    {
+        int pages = getRelationDataPages(*it);
+        if (pages >= largePages)
+        {
+            log(wxString::Format(_("Full scan of large table %s (at least %d data pages)."),
+                (*it).c_str(), pages), ttError);
         }
     }
 }
 
+void ExecuteSqlFrame::compareCounts(IBPP::DatabaseCounts& one,
+    IBPP::DatabaseCounts& two)
+{
+    std::vector<IBPP::CountInfo> deltas;
+    std::vector<int> ids(
+        RelationIOListCtrl::getChangedRelations(one, two, deltas));
+
+    std::vector<RelationIOCounts> counts;
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        RelationIOCounts rc;
+        rc.counts = deltas[i];
+        if (Relation* r = databaseM->findRelationById(ids[i]))
+            rc.relationName = r->getName_();
+        else
+            rc.relationName = databaseM->getRelationNameById(ids[i]);
+        if (rc.relationName.IsEmpty())
+            rc.relationName = wxString::Format(_("Relation #%d"), ids[i]);
+        counts.push_back(rc);
+
+        wxString s;
+        if (rc.counts.inserts > 0)
+            s += wxString::Format(_("%d inserts. "), rc.counts.inserts);
+        if (rc.counts.updates > 0)
+            s += wxString::Format(_("%d updates. "), rc.counts.updates);
+        if (rc.counts.deletes > 0)
+            s += wxString::Format(_("%d deletes. "), rc.counts.deletes);
+        if (!s.IsEmpty())
+            log(rc.relationName + ": " + s, ttSql);
+    }
+    list_relation_io->setCounts(counts);
+}
+
 wxString millisToTimeString(long millis)
 {
     if (millis >= 60 * 1000)
@@ -2250,10 +2426,323 @@ wxString millisToTimeString(long millis)
         return wxString::Format("%.3fs", 0.001 * millis);
 }
 
+static wxString microsToString(int64_t micros)
+{
+    if (micros < 10000)
+        return wxLongLong(micros).ToString() + " us";
+    return millisToTimeString(long(micros / 1000));
+}
+
+void ExecuteSqlFrame::OnMenuBenchmark(wxCommandEvent& WXUNUSED(event))
+{
+    wxString sql;
+    if (styled_text_ctrl_sql->hasSelection())
+        sql = styled_text_ctrl_sql->GetSelectedText();
+    else
+    {
+        MultiStatement ms(styled_text_ctrl_sql->GetText());
+        sql = ms.getStatementAt(styled_text_ctrl_sql->GetCurrentPos()).getSql();
+    }
+    sql.Trim(true).Trim(false);
+    if (sql.IsEmpty())
+        return;
+
+    long runs = ::wxGetNumberFromUser(
+        _("The statement is executed repeatedly in a separate transaction\nthat is always rolled back afterwards."),
+        _("Number of measured runs:"), _("Benchmark Statement"),
+        config().get("SQLEditorBenchmarkRuns", 20), 1, 10000, this);
+    if (runs < 1)
+        return;
+    long warmupRuns = ::wxGetNumberFromUser(
+        _("Warm-up runs are executed first and excluded from the summary."),
+        _("Number of warm-up runs:"), _("Benchmark Statement"),
+        config().get("SQLEditorBenchmarkWarmupRuns", 3), 0, 1000, this);
+    if (warmupRuns < 0)
+        return;
+    config().setValue("SQLEditorBenchmarkRuns", int(runs));
+    config().setValue("SQLEditorBenchmarkWarmupRuns", int(warmupRuns));
+
+    clearLogBeforeExecution();
+    splitScreen();
+    ScrollAtEnd sae(styled_text_ctrl_stats);
+    log(_("Benchmarking statement:"));
+    log(sql, ttSql);
+
+    StatementBenchmark benchmark(databaseM->getIBPPDatabase(),
+        wx2std(sql, databaseM->getCharsetConverter()),
+        transactionAccessModeM, transactionIsolationLevelM,
+        transactionLockResolutionM);
+    try
+    {
+        ProgressDialog pd(this, _("Benchmark Statement"));
+        pd.doShow();
+        benchmark.execute(runs, warmupRuns, &pd);
+    }
+    catch (CancelProgressException&)
+    {
+        log(_("Benchmark canceled."), ttError);
+        return;
+    }
+    catch (IBPP::Exception& e)
+    {
+        wxString msg(e.what(), *databaseM->getCharsetConverter());
+        log(_("Error: ") + msg + "\n", ttError);
+        return;
+    }
+    catch (std::exception& e)
+    {
+        log(_("Error: ") + e.what() + "\n", ttError);
+        return;
+    }
+
+    const std::vector<StatementBenchmarkRun>& results(benchmark.getRuns());
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const StatementBenchmarkRun& r(results[i]);
+        wxString warmup;
+        if (r.warmup)
+            warmup = _(" (warm-up)");
+        wxString s(wxString::Format(_("Run %d%s: %s (prepare %s, execute %s, fetch %s), %d rows, "),
+            int(i + 1), warmup.c_str(),
+            microsToString(r.getTotalMicros()).c_str(),
+            microsToString(r.prepareMicros).c_str(),
+            microsToString(r.executeMicros).c_str(),
+            microsToString(r.fetchMicros).c_str(), r.rows));
+        s += wxString::Format(_("%d fetches, %d marks, %d reads, %d writes, "),
+            r.fetches, r.marks, r.reads, r.writes);
+        s += wxString::Format(_("%d indexed reads, %d non-indexed reads"),
+            r.indexedReads, r.sequentialReads);
+        log(s);
+    }
+
+    log(wxString::Format(_("Summary of %d measured runs (min / median / 95%% / 99%% / max):"),
+        int(benchmark.getMeasuredRunCount())));
+    const StatementBenchmark::Phase phases[] = {
+        StatementBenchmark::phPrepare, StatementBenchmark::phExecute,
+        StatementBenchmark::phFetch, StatementBenchmark::phTotal };
+    const wxString phaseNames[] = {
+        _("Prepare"), _("Execute"), _("Fetch"), _("Total") };
+    for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); ++i)
+    {
+        StatementBenchmark::Summary s(benchmark.getSummary(phases[i]));
+        log(wxString::Format("%s: %s / %s / %s / %s / %s",
+            phaseNames[i].c_str(), microsToString(s.min).c_str(),
+            microsToString(s.median).c_str(), microsToString(s.p95).c_str(),
+            microsToString(s.p99).c_str(), microsToString(s.max).c_str()));
+    }
+
+    if (wxMessageBox(_("Do you want to save the individual benchmark runs to a CSV file?"),
+        _("Benchmark Statement"), wxYES_NO | wxICON_QUESTION, this) != wxYES)
+    {
+        return;
+    }
+    wxString filename = ::wxFileSelector(_("Select a file"), "",
+        "benchmark.csv", "csv", _("CSV files (*.csv)|*.csv|All files (*.*)|*.*"),
+        wxFD_SAVE | wxFD_OVERWRITE_PROMPT, this);
+    if (!filename.IsEmpty() && !benchmark.saveAsCsv(filename))
+    {
+        log(wxString::Format(_("Could not write file \"%s\"."),
+            filename.c_str()), ttError);
+    }
+}
+
+void ExecuteSqlFrame::OnMenuBenchmarkPropertyPage(
+    wxCommandEvent& WXUNUSED(event))
+{
+    PropertyPageBenchmark benchmark(databaseM, this);
+    long runs = ::wxGetNumberFromUser(
+        wxString::Format(_("A table with %d columns is created, its property page is rendered\nwith a cleared and a filled template cache, and the table is dropped."),
+            int(benchmark.getColumnCount())),
+        _("Number of measured runs:"), _("Benchmark Property Page"),
+        config().get("SQLEditorPropertyPageBenchmarkRuns", 10), 1, 1000,
+        this);
+    if (runs < 1)
+        return;
+    config().setValue("SQLEditorPropertyPageBenchmarkRuns", int(runs));
+
+    clearLogBeforeExecution();
+    splitScreen();
+    ScrollAtEnd sae(styled_text_ctrl_stats);
+    log(wxString::Format(_("Benchmarking TABLE.html for a table with %d columns:"),
+        int(benchmark.getColumnCount())));
+    try
+    {
+        ProgressDialog pd(this, _("Benchmark Property Page"));
+        pd.doShow();
+        benchmark.execute(runs, &pd);
+    }
+    catch (CancelProgressException&)
+    {
+        log(_("Benchmark canceled."), ttError);
+        return;
+    }
+    catch (IBPP::Exception& e)
+    {
+        wxString msg(e.what(), *databaseM->getCharsetConverter());
+        log(_("Error: ") + msg + "\n", ttError);
+        return;
+    }
+    catch (std::exception& e)
+    {
+        log(_("Error: ") + e.what() + "\n", ttError);
+        return;
+    }
+
+    log(wxString::Format(_("Summary of %d runs (min / median / max):"),
+        int(benchmark.getRunCount())));
+    PropertyPageBenchmark::Summary cold(benchmark.getColdSummary());
+    log(wxString::Format(_("Cold template cache: %s / %s / %s"),
+        microsToString(cold.min).c_str(), microsToString(cold.median).c_str(),
+        microsToString(cold.max).c_str()));
+    PropertyPageBenchmark::Summary warm(benchmark.getWarmSummary());
+    log(wxString::Format(_("Warm template cache: %s / %s / %s"),
+        microsToString(warm.min).c_str(), microsToString(warm.median).c_str(),
+        microsToString(warm.max).c_str()));
+}
+
+void ExecuteSqlFrame::beginBatch()
+{
+    batchModeM = true;
+    batchLogM.clear();
+    batchSlowestCountM = config().get("SQLEditorBatchSlowestCount", 10);
+    batchStatementCountM = 0;
+    batchTotalMillisM = 0;
+    batchSlowestM.clear();
+    batchFailedM.clear();
+}
+
+ExecuteSqlFrame::BatchScope::BatchScope(ExecuteSqlFrame* frame)
+    : frameM(frame)
+{
+    frameM->beginBatch();
+}
+
+ExecuteSqlFrame::BatchScope::~BatchScope()
+{
+    frameM->endBatch();
+}
+
+// only the first line of the statement is kept for the summary
+static wxString getBatchStatementCaption(const wxString& sql)
+{
+    wxString caption(sql);
+    caption.Trim(false);
+    wxString::size_type p = caption.find_first_of("\r\n");
+    if (p != wxString::npos)
+        caption.erase(p);
+    const wxString::size_type maxLen = 80;
+    if (caption.length() > maxLen)
+        caption = caption.substr(0, maxLen) + "...";
+    return caption;
+}
+
+void ExecuteSqlFrame::addBatchStatement(const wxString& sql, int line,
+    long millis, bool success)
+{
+    ++batchStatementCountM;
+    batchTotalMillisM += millis;
+
+    bool isSlow = batchSlowestCountM > 0
+        && (batchSlowestM.size() < batchSlowestCountM
+            || millis > batchSlowestM.back().millis);
+    if (success && !isSlow)
+        return;
+
+    BatchStatementInfo info;
+    info.index = batchStatementCountM;
+    info.line = line;
+    info.millis = millis;
+    info.sql = getBatchStatementCaption(sql);
+
+    if (!success)
+        batchFailedM.push_back(info);
+    if (isSlow)
+    {
+        // keep the list sorted by descending execution time
+        std::vector<BatchStatementInfo>::iterator it = batchSlowestM.begin();
+        while (it != batchSlowestM.end() && (*it).millis >= millis)
+            ++it;
+        batchSlowestM.insert(it, info);
+        if (batchSlowestM.size() > batchSlowestCountM)
+            batchSlowestM.pop_back();
+    }
+}
+
+void ExecuteSqlFrame::endBatch()
+{
+    batchModeM = false;
+
+    ScrollAtEnd sae(styled_text_ctrl_stats);
+    if (!batchLogM.empty())
+    {
+        // add all buffered messages in one go, then style them line by line
+        wxString text;
+        for (size_t i = 0; i < batchLogM.size(); ++i)
+            text += batchLogM[i].first + "\n";
+        int startpos = styled_text_ctrl_stats->GetLength();
+        int line = styled_text_ctrl_stats->LineFromPosition(startpos);
+        styled_text_ctrl_stats->SetCurrentPos(startpos);
+        styled_text_ctrl_stats->AddText(text);
+
+        for (size_t i = 0; i < batchLogM.size(); ++i)
+        {
+            // a message can span several lines
+            int lines = batchLogM[i].first.Freq('\n') + 1;
+            int pos = styled_text_ctrl_stats->PositionFromLine(line);
+            int endpos = styled_text_ctrl_stats->PositionFromLine(
+                line + lines);
+            line += lines;
+            if (batchLogM[i].second == ttNormal)
+                continue;
+            styled_text_ctrl_stats->StartStyling(pos, 255);
+            styled_text_ctrl_stats->SetStyling(endpos - pos - 1,
+                getTextStyle(batchLogM[i].second));
+        }
+        batchLogM.clear();
+    }
+
+    log(wxEmptyString);
+    log(_("Batch execution summary:"), ttSql);
+    log(wxString::Format(_("%d statement(s) executed, %d failed."),
+        int(batchStatementCountM), int(batchFailedM.size())));
+    log(wxString::Format(_("Total execution time: %s"),
+        millisToTimeString(batchTotalMillisM).c_str()));
+
+    if (!batchSlowestM.empty())
+    {
+        log(wxString::Format(_("%d slowest statement(s):"),
+            int(batchSlowestM.size())));
+        for (std::vector<BatchStatementInfo>::const_iterator it =
+            batchSlowestM.begin(); it != batchSlowestM.end(); ++it)
+        {
+            log(wxString::Format(_("  #%d (line %d), %s: %s"),
+                int((*it).index), (*it).line,
+                millisToTimeString((*it).millis).c_str(),
+                (*it).sql.c_str()), ttSql);
+        }
+    }
+    if (!batchFailedM.empty())
+    {
+        log(_("Failed statement(s):"));
+        for (std::vector<BatchStatementInfo>::const_iterator it =
+            batchFailedM.begin(); it != batchFailedM.end(); ++it)
+        {
+            log(wxString::Format(_("  #%d (line %d): %s"),
+                int((*it).index), (*it).line, (*it).sql.c_str()), ttError);
+        }
+    }
+
+    batchSlowestM.clear();
+    batchFailedM.clear();
+}
+
 bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
     bool prepareOnly)
 {
     ScrollAtEnd sae(styled_text_ctrl_stats);
+    // log output is buffered in batch mode, nothing to scroll to
+    if (batchModeM)
+        sae.cancel();
 
     // check if sql only contains comments
     SqlTokenizer tk(sql);
@@ -2318,9 +2807,11 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
             del1 = 0, ridx1 = 0, rseq1 = 0, mem1 = 0;
         int fetch2, mark2, read2, write2, ins2, upd2, del2, ridx2, rseq2, mem2;
         IBPP::DatabaseCounts counts1, counts2;
-        bool doShowStats = config().get("SQLEditorShowStats", true);
+        bool doShowStats = !batchModeM
+            && config().get("SQLEditorShowStats", true);
         if (!prepareOnly && doShowStats)
         {
+            list_relation_io->clearCounts();
             databaseM->getIBPPDatabase()->
                 Statistics(&fetch1, &mark1, &read1, &write1, &mem1);
             databaseM->getIBPPDatabase()->
@@ -2374,17 +2865,40 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
         // for some statements (DDL) it is never available
         // for INSERTs, it is available sometimes (insert into ... select ... )
         // but if it not, IBPP throws an exception
-        try
+        // (the plan is not retrieved in batch mode at all)
+        std::vector<wxString> scannedRelations;
+        if (!batchModeM)
         {
-            std::string plan;
-            statementM->Plan(plan);
-            log(wxString(plan.c_str(), *databaseM->getCharsetConverter()));
+            try
+            {
+                std::string plan;
+                statementM->Plan(plan);
+                wxString planText(plan.c_str(), *databaseM->getCharsetConverter());
+                log(planText);
+
+                // the explained plan has the real relation names
+                std::string explained;
+                if (statementM->ExplainPlan(explained))
+                {
+                    planText = wxString(explained.c_str(),
+                        *databaseM->getCharsetConverter());
+                }
+                if (config().get("SQLEditorComparePlans", true))
+                    scannedRelations = checkPlan(sql, planText);
+            }
+            catch(IBPP::Exception&)
+            {
+                log(_("Plan not available."));
+            }
         }
-        catch(IBPP::Exception&)
+
+        // the size of the scanned tables is only queried when it doesn't
+        // distort the statistics of the statement
+        if (prepareOnly || !doShowStats)
         {
-            log(_("Plan not available."));
+            checkNaturalScans(scannedRelations);
+            scannedRelations.clear();
         }
-
         if (prepareOnly)
             return true;
 
@@ -2420,6 +2934,7 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
             log(wxString::Format(_("Delta memory: %d bytes."), mem2-mem1));
             databaseM->getIBPPDatabase()->DetailedCounts(counts2);
             compareCounts(counts1, counts2);
+            checkNaturalScans(scannedRelations);
         }
 
         if (type != IBPP::stSelect) // for other statements: show rows affected
@@ -2450,7 +2965,8 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
             if (stm.isDDL())
                 type = IBPP::stDDL;
             executedStatementsM.push_back(stm);
-            setViewMode(vmEditor);
+            if (!batchModeM)
+                setViewMode(vmEditor);
             if (type == IBPP::stDDL && autoCommitM)
             {
                 if (!commitTransaction())
@@ -2593,6 +3109,8 @@ bool ExecuteSqlFrame::commitTransaction()
         statusbar_1->SetStatusText(_("Transaction committed"), 3);
         inTransaction(false);
 
+        // all objects affected by the statements are updated once at the end
+        NotificationBatch batch("Commit");
         SubjectLocker locker(databaseM);
         // log statements, done before parsing in case parsing crashes FR
         if (menuBarM->IsChecked(Cmds::History_EnableLogging))
@@ -2908,19 +3426,29 @@ void ExecuteSqlFrame::setKeywords()
 // or we can also log to some .txt file, etc.
 void ExecuteSqlFrame::log(wxString s, TextType type)
 {
+    if (batchModeM)
+    {
+        batchLogM.push_back(std::make_pair(s, type));
+        return;
+    }
+
     int startpos = styled_text_ctrl_stats->GetLength();
     styled_text_ctrl_stats->SetCurrentPos(startpos);
     styled_text_ctrl_stats->AddText(s + "\n");
     int endpos = styled_text_ctrl_stats->GetLength();
 
-    int style = 0;
+    styled_text_ctrl_stats->StartStyling(startpos, 255);
+    styled_text_ctrl_stats->SetStyling(endpos-startpos-1, getTextStyle(type));
+}
+
+/*static*/
+int ExecuteSqlFrame::getTextStyle(TextType type)
+{
     if (type == ttError)
-        style = 1;
+        return 1;
     if (type == ttSql)
-        style = 2;
-
-    styled_text_ctrl_stats->StartStyling(startpos, 255);
-    styled_text_ctrl_stats->SetStyling(endpos-startpos-1, style);
+        return 2;
+    return 0;
 }
 
 const wxString ExecuteSqlFrame::getName() const
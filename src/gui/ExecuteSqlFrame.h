@@ -32,11 +32,15 @@
 #include <wx/splitter.h>
 #include <wx/stc/stc.h>
 
+#include <utility>
+#include <vector>
+
 #include <ibpp.h>
 
 #include "core/Observer.h"
 #include "core/StringUtils.h"
 #include "controls/DataGridTable.h"
+#include "controls/RelationIOListCtrl.h"
 #include "gui/BaseFrame.h"
 #include "gui/EditBlobDialog.h"
 #include "gui/FindDialog.h"
@@ -97,11 +101,51 @@ private:
     wxDateTime filenameModificationTimeM;
 
     void compareCounts(IBPP::DatabaseCounts& one, IBPP::DatabaseCounts& two);
+    // compares the plan with the previous one and returns the names of the
+    // relations it scans in natural order
+    std::vector<wxString> checkPlan(const wxString& sql,
+        const wxString& planText);
+    // runs queries, so it must not be called between the statistics
+    // taken before and after a statement
+    void checkNaturalScans(const std::vector<wxString>& relationNames);
+    int getRelationDataPages(const wxString& relationName);
+
+    // batch mode skips the per-statement column info, plan and statistics,
+    // buffers all log output and writes a summary when the script is done
+    struct BatchStatementInfo
+    {
+        size_t index;
+        int line;
+        long millis;
+        wxString sql;
+    };
+    typedef enum { ttNormal, ttSql, ttError } TextType;
+    bool batchModeM;
+    std::vector<std::pair<wxString, TextType> > batchLogM;
+    size_t batchSlowestCountM;
+    size_t batchStatementCountM;
+    long batchTotalMillisM;
+    std::vector<BatchStatementInfo> batchSlowestM;
+    std::vector<BatchStatementInfo> batchFailedM;
+    void beginBatch();
+    void addBatchStatement(const wxString& sql, int line, long millis,
+        bool success);
+    void endBatch();
+    // leaves the batch mode when it goes out of scope, also when an
+    // exception is thrown
+    class BatchScope
+    {
+    private:
+        ExecuteSqlFrame* frameM;
+    public:
+        BatchScope(ExecuteSqlFrame* frame);
+        ~BatchScope();
+    };
 
     void showProperties(wxString objectName);
 
-    typedef enum { ttNormal, ttSql, ttError } TextType;
     void log(wxString s, TextType type = ttNormal);     // write messages to textbox
+    static int getTextStyle(TextType type);
     void clearLogBeforeExecution();
 
     void splitScreen();
@@ -207,6 +251,9 @@ private:
     void OnMenuShowPlan(wxCommandEvent& event);
     void OnMenuExecuteSelection(wxCommandEvent& event);
     void OnMenuExecuteFromCursor(wxCommandEvent& event);
+    void OnMenuExecuteBatch(wxCommandEvent& event);
+    void OnMenuBenchmark(wxCommandEvent& event);
+    void OnMenuBenchmarkPropertyPage(wxCommandEvent& event);
     void OnMenuCommit(wxCommandEvent& event);
     void OnMenuRollback(wxCommandEvent& event);
     void OnMenuUpdateWhenInTransaction(wxUpdateUIEvent& event);
@@ -268,7 +315,9 @@ protected:
     wxNotebook* notebook_1;
     wxPanel* notebook_pane_1;
     wxPanel* notebook_pane_2;
+    wxPanel* notebook_pane_3;
     DataGrid* grid_data;
+    RelationIOListCtrl* list_relation_io;
     wxStyledTextCtrl* styled_text_ctrl_stats;
 
     wxStatusBar* statusbar_1;
@@ -31,6 +31,7 @@
 #endif
 
 #include "core/StringUtils.h"
+#include "core/TemplateCache.h"
 #include "frutils.h"
 #include "gui/HtmlHeaderMetadataItemVisitor.h"
 #include "metadata/metadataitem.h"
@@ -62,7 +63,8 @@ void HtmlTemplateProcessor::processCommand(const wxString& cmdName,
         HtmlHeaderMetadataItemVisitor v(pages);
         metadataItem->acceptVisitor(&v);
 
-        wxString page = loadEntireFile(getTemplatePath() + "header.html");
+        wxString page = getTemplateCache().loadFile(
+            getTemplatePath() + "header.html");
         bool first = true;
         while (!page.Strip().IsEmpty())
         {
@@ -0,0 +1,436 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/filename.h>
+
+#include "engine/DataImporter.h"
+#include "gui/AdvancedMessageDialog.h"
+#include "gui/ImportDataDialog.h"
+#include "gui/ProgressDialog.h"
+#include "gui/StyleGuide.h"
+#include "metadata/column.h"
+#include "metadata/database.h"
+#include "metadata/table.h"
+
+// number of rejected records listed after the import
+static const size_t maxListedRejections = 20;
+
+ImportDataDialog::ImportDataDialog(wxWindow* parent, Table* table)
+    : BaseDialog(parent, -1, wxEmptyString), tableM(table)
+{
+    // can't do anything if no table is given
+    wxASSERT(table);
+
+    // computed columns can't be inserted into
+    tableM->ensureChildrenLoaded();
+    for (ColumnPtrs::const_iterator it = tableM->begin();
+        it != tableM->end(); ++it)
+    {
+        if ((*it)->getComputedSource().IsEmpty())
+            columnsM.push_back((*it).get());
+    }
+
+    SetTitle(_("Import Data into Table ") + table->getName_());
+    createControls();
+    layoutControls();
+    updateButtons();
+    buttonImport->SetDefault();
+}
+
+void ImportDataDialog::createControls()
+{
+    wxWindow* panel = getControlsPanel();
+    labelFile = new wxStaticText(panel, -1, _("File:"));
+    textFile = new wxTextCtrl(panel, ID_text_file, wxEmptyString);
+    buttonBrowse = new wxButton(panel, ID_button_browse, "...",
+        wxDefaultPosition, wxDefaultSize, wxBU_EXACTFIT);
+
+    labelFieldDelimiter = new wxStaticText(panel, -1, _("Field delimiter:"));
+    const wxString fieldDelimiters[] = { ",", ";", _("Tab"), "|" };
+    choiceFieldDelimiter = new wxChoice(panel, ID_choice_fielddelimiter,
+        wxDefaultPosition, wxDefaultSize,
+        sizeof(fieldDelimiters) / sizeof(wxString), fieldDelimiters);
+    choiceFieldDelimiter->SetSelection(0);
+
+    labelTextDelimiter = new wxStaticText(panel, -1, _("Text delimiter:"));
+    const wxString textDelimiters[] = { "\"", "'", _("None") };
+    choiceTextDelimiter = new wxChoice(panel, ID_choice_textdelimiter,
+        wxDefaultPosition, wxDefaultSize,
+        sizeof(textDelimiters) / sizeof(wxString), textDelimiters);
+    choiceTextDelimiter->SetSelection(0);
+
+    labelNull = new wxStaticText(panel, -1, _("NULL text:"));
+    textNull = new wxTextCtrl(panel, -1, "NULL");
+    textNull->SetToolTip(_("Fields with this text are imported as NULL, as are empty fields without text delimiters"));
+
+    labelCommit = new wxStaticText(panel, -1, _("Commit every:"));
+    spinCommit = new wxSpinCtrl(panel, -1, wxEmptyString, wxDefaultPosition,
+        wxDefaultSize, wxSP_ARROW_KEYS, 0, 10000000, 10000);
+    spinCommit->SetToolTip(_("Number of records after which the imported data is committed, with 0 it is committed at the end of the import"));
+
+    checkHeader = new wxCheckBox(panel, ID_check_header,
+        _("First row contains column names"));
+    checkHeader->SetValue(true);
+    checkUtf8 = new wxCheckBox(panel, ID_check_utf8,
+        _("File is UTF-8 encoded"));
+    checkUtf8->SetValue(true);
+    checkUtf8->SetToolTip(_("Otherwise the file has to use the character set of the connection"));
+
+    labelColumns = new wxStaticText(panel, -1,
+        _("Select the field to import into each column:"));
+    panelColumns = new wxScrolledWindow(panel, -1, wxDefaultPosition,
+        wxSize(-1, 200), wxVSCROLL | wxBORDER_THEME);
+    panelColumns->SetScrollRate(0, 10);
+    wxFlexGridSizer* sizerColumns = new wxFlexGridSizer(2,
+        styleguide().getRelatedControlMargin(wxVERTICAL),
+        styleguide().getControlLabelMargin());
+    sizerColumns->AddGrowableCol(1);
+    for (std::vector<Column*>::iterator it = columnsM.begin();
+        it != columnsM.end(); ++it)
+    {
+        wxStaticText* label = new wxStaticText(panelColumns, -1,
+            (*it)->getName_());
+        wxChoice* choice = new wxChoice(panelColumns, -1);
+        choicesColumns.push_back(choice);
+        sizerColumns->Add(label, 0, wxALIGN_CENTER_VERTICAL | wxLEFT,
+            styleguide().getControlLabelMargin());
+        sizerColumns->Add(choice, 1, wxEXPAND | wxRIGHT,
+            styleguide().getControlLabelMargin());
+    }
+    wxBoxSizer* sizerPanel = new wxBoxSizer(wxVERTICAL);
+    sizerPanel->Add(sizerColumns, 0, wxEXPAND | wxTOP | wxBOTTOM,
+        styleguide().getRelatedControlMargin(wxVERTICAL));
+    panelColumns->SetSizer(sizerPanel);
+    updateColumnChoices();
+
+    checkResume = new wxCheckBox(panel, -1,
+        _("Resume the unfinished import of this file"));
+    checkResume->Enable(false);
+
+    buttonImport = new wxButton(panel, wxID_OK, _("Import"));
+    buttonClose = new wxButton(panel, wxID_CANCEL, _("Close"));
+}
+
+void ImportDataDialog::layoutControls()
+{
+    wxSizer* sizerFile = new wxBoxSizer(wxHORIZONTAL);
+    sizerFile->Add(labelFile, 0, wxALIGN_CENTER_VERTICAL);
+    sizerFile->AddSpacer(styleguide().getControlLabelMargin());
+    sizerFile->Add(textFile, 1, wxALIGN_CENTER_VERTICAL);
+    sizerFile->Add(buttonBrowse, 0, wxLEFT | wxALIGN_CENTER_VERTICAL,
+        styleguide().getBrowseButtonMargin());
+
+    int dx = styleguide().getUnrelatedControlMargin(wxHORIZONTAL)
+        - styleguide().getControlLabelMargin();
+    if (dx < 0)
+        dx = 0;
+    wxFlexGridSizer* sizerFormat = new wxFlexGridSizer(4,
+        styleguide().getRelatedControlMargin(wxVERTICAL),
+        styleguide().getControlLabelMargin());
+    sizerFormat->AddGrowableCol(1);
+    sizerFormat->AddGrowableCol(3);
+    sizerFormat->Add(labelFieldDelimiter, 0, wxALIGN_CENTER_VERTICAL);
+    sizerFormat->Add(choiceFieldDelimiter, 1, wxEXPAND);
+    sizerFormat->Add(labelTextDelimiter, 0, wxLEFT | wxALIGN_CENTER_VERTICAL,
+        dx);
+    sizerFormat->Add(choiceTextDelimiter, 1, wxEXPAND);
+    sizerFormat->Add(labelNull, 0, wxALIGN_CENTER_VERTICAL);
+    sizerFormat->Add(textNull, 1, wxEXPAND);
+    sizerFormat->Add(labelCommit, 0, wxLEFT | wxALIGN_CENTER_VERTICAL, dx);
+    sizerFormat->Add(spinCommit, 1, wxEXPAND);
+
+    wxSizer* sizerControls = new wxBoxSizer(wxVERTICAL);
+    sizerControls->Add(sizerFile, 0, wxEXPAND);
+    sizerControls->AddSpacer(
+        styleguide().getUnrelatedControlMargin(wxVERTICAL));
+    sizerControls->Add(sizerFormat, 0, wxEXPAND);
+    sizerControls->AddSpacer(
+        styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerControls->Add(checkHeader, 0, wxEXPAND);
+    sizerControls->AddSpacer(
+        styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerControls->Add(checkUtf8, 0, wxEXPAND);
+    sizerControls->AddSpacer(
+        styleguide().getUnrelatedControlMargin(wxVERTICAL));
+    sizerControls->Add(labelColumns, 0, wxEXPAND);
+    sizerControls->AddSpacer(
+        styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerControls->Add(panelColumns, 1, wxEXPAND);
+    sizerControls->AddSpacer(
+        styleguide().getUnrelatedControlMargin(wxVERTICAL));
+    sizerControls->Add(checkResume, 0, wxEXPAND);
+
+    // create sizer for buttons -> styleguide class will align it correctly
+    wxSizer* sizerButtons = styleguide().createButtonSizer(buttonImport,
+        buttonClose);
+    // use method in base class to set everything up
+    layoutSizers(sizerControls, sizerButtons, true);
+}
+
+const wxString ImportDataDialog::getName() const
+{
+    return "ImportDataDialog";
+}
+
+void ImportDataDialog::getSettings(DataImportSettings& settings)
+{
+    const char fieldDelimiters[] = { ',', ';', '\t', '|' };
+    const char textDelimiters[] = { '"', '\'', '\0' };
+    settings.fileName = textFile->GetValue();
+    settings.fieldDelimiter =
+        fieldDelimiters[choiceFieldDelimiter->GetSelection()];
+    settings.textDelimiter =
+        textDelimiters[choiceTextDelimiter->GetSelection()];
+    settings.headerRow = checkHeader->IsChecked();
+    settings.utf8 = checkUtf8->IsChecked();
+    settings.nullText = textNull->GetValue();
+    settings.commitInterval = spinCommit->GetValue();
+}
+
+// the fields of the first record are offered for every column, columns are
+// mapped to fields with the same name, or to the field at the same position
+// if the file has no header row
+void ImportDataDialog::updateColumnChoices()
+{
+    DataImportSettings settings;
+    getSettings(settings);
+    std::vector<wxString> fields;
+    if (wxFileName::FileExists(settings.fileName))
+    {
+        DataImporter::readFirstRecord(settings,
+            tableM->getDatabase()->getCharsetConverter(), fields);
+    }
+
+    wxArrayString items;
+    items.Add(_("(skip)"));
+    for (size_t i = 0; i < fields.size(); ++i)
+    {
+        if (settings.headerRow)
+        {
+            items.Add(wxString::Format("%d: %s", int(i + 1),
+                fields[i].c_str()));
+        }
+        else
+            items.Add(wxString::Format(_("Field %d"), int(i + 1)));
+    }
+
+    for (size_t c = 0; c < columnsM.size(); ++c)
+    {
+        int selection = 0;
+        if (settings.headerRow)
+        {
+            wxString name(columnsM[c]->getName_());
+            for (size_t i = 0; i < fields.size(); ++i)
+            {
+                if (fields[i].Strip(wxString::both).IsSameAs(name, false))
+                {
+                    selection = int(i + 1);
+                    break;
+                }
+            }
+        }
+        else if (c < fields.size())
+            selection = int(c + 1);
+        choicesColumns[c]->Set(items);
+        choicesColumns[c]->SetSelection(selection);
+    }
+    panelColumns->FitInside();
+}
+
+void ImportDataDialog::updateResume()
+{
+    DataImportPosition position;
+    bool canResume = DataImporter::readState(textFile->GetValue(),
+        tableM->getQuotedName(), position);
+    checkResume->Enable(canResume);
+    checkResume->SetValue(canResume);
+    if (canResume)
+    {
+        checkResume->SetToolTip(wxString::Format(
+            _("Continue at line %s, after %s records have been imported"),
+            wxLongLong(position.line).ToString().c_str(),
+            wxLongLong(position.inserted).ToString().c_str()));
+    }
+    else
+        checkResume->UnsetToolTip();
+}
+
+void ImportDataDialog::updateButtons()
+{
+    buttonImport->Enable(!columnsM.empty()
+        && wxFileName::FileExists(textFile->GetValue()));
+}
+
+static wxString getRejectionText(const DataImporter::Rejection& rejection,
+    const std::vector<Column*>& columns, wxMBConv* converter)
+{
+    wxString detail(rejection.detail.c_str(), *converter);
+    wxString text(wxString::Format(_("Line %s: "),
+        wxLongLong(rejection.line).ToString().c_str()));
+    switch (rejection.reason)
+    {
+        case DataImporter::rrFieldCount:
+            return text + wxString::Format(_("only %s fields"),
+                detail.c_str());
+        case DataImporter::rrValue:
+            return text + wxString::Format(
+                _("invalid value \"%s\" for column %s"), detail.c_str(),
+                columns[rejection.column]->getName_().c_str());
+        default:
+            // only the first line of the error message
+            return text + detail.Strip(wxString::both).BeforeFirst('\n');
+    }
+}
+
+// returns true if the import has been completed
+bool ImportDataDialog::importData()
+{
+    DataImportSettings settings;
+    getSettings(settings);
+    Database* database = tableM->getDatabase().get();
+    DataImporter importer(database, tableM, settings);
+    std::vector<Column*> columns;
+    for (size_t c = 0; c < columnsM.size(); ++c)
+    {
+        int field = choicesColumns[c]->GetSelection();
+        if (field > 0)
+        {
+            importer.addColumn(columnsM[c], field - 1);
+            columns.push_back(columnsM[c]);
+        }
+    }
+    if (columns.empty())
+    {
+        showWarningDialog(this, _("No columns selected"),
+            _("Select the fields to import into at least one column."),
+            AdvancedMessageDialogButtonsOk());
+        return false;
+    }
+
+    bool completed;
+    try
+    {
+        ProgressDialog pd(this, _("Importing data"), 1);
+        pd.doShow();
+        completed = importer.run(checkResume->IsEnabled()
+            && checkResume->IsChecked(), &pd);
+    }
+    catch (std::exception& e)
+    {
+        updateResume();
+        showErrorDialog(this, _("Import failed"), e.what(),
+            AdvancedMessageDialogButtonsOk());
+        return false;
+    }
+    updateResume();
+
+    DataImportPosition start(importer.getStartPosition());
+    DataImportPosition position(importer.getPosition());
+    int64_t inserted = position.inserted - start.inserted;
+    int64_t rejected = position.rejected - start.rejected;
+    double seconds = importer.getSeconds();
+    int64_t rate = (seconds > 0) ? int64_t(inserted / seconds) : 0;
+    wxString text(wxString::Format(
+        _("%s records were imported in %.1f seconds (%s per second)."),
+        wxLongLong(inserted).ToString().c_str(), seconds,
+        wxLongLong(rate).ToString().c_str()));
+    if (rejected)
+    {
+        text += "\n\n" + wxString::Format(
+            _("%s records were rejected and written to the file \"%s\":"),
+            wxLongLong(rejected).ToString().c_str(),
+            DataImporter::getRejectedFileName(settings.fileName).c_str());
+        wxMBConv* converter = database->getCharsetConverter();
+        const std::vector<DataImporter::Rejection>& rejections =
+            importer.getRejections();
+        for (size_t i = 0; i < rejections.size()
+            && i < maxListedRejections; ++i)
+        {
+            // field values are in the encoding of the file
+            wxMBConv* conv = (rejections[i].reason == DataImporter::rrValue
+                && settings.utf8) ? &wxConvUTF8 : converter;
+            text += "\n" + getRejectionText(rejections[i], columns,
+                conv ? conv : wxConvCurrent);
+        }
+        if (rejections.size() > maxListedRejections)
+            text += "\n...";
+    }
+
+    if (!completed)
+    {
+        showInformationDialog(this, _("Import canceled"),
+            text + "\n\n" + _("The data committed so far has been kept, the import can be resumed."),
+            AdvancedMessageDialogButtonsOk());
+        return false;
+    }
+    showInformationDialog(this, _("Import done"), text,
+        AdvancedMessageDialogButtonsOk());
+    return true;
+}
+
+//! event handling
+BEGIN_EVENT_TABLE(ImportDataDialog, BaseDialog)
+    EVT_BUTTON(ImportDataDialog::ID_button_browse, ImportDataDialog::OnBrowseButtonClick)
+    EVT_BUTTON(wxID_OK, ImportDataDialog::OnImportButtonClick)
+    EVT_TEXT(ImportDataDialog::ID_text_file, ImportDataDialog::OnFileChange)
+    EVT_CHOICE(ImportDataDialog::ID_choice_fielddelimiter, ImportDataDialog::OnFormatChange)
+    EVT_CHOICE(ImportDataDialog::ID_choice_textdelimiter, ImportDataDialog::OnFormatChange)
+    EVT_CHECKBOX(ImportDataDialog::ID_check_header, ImportDataDialog::OnFormatChange)
+    EVT_CHECKBOX(ImportDataDialog::ID_check_utf8, ImportDataDialog::OnFormatChange)
+END_EVENT_TABLE()
+
+void ImportDataDialog::OnBrowseButtonClick(wxCommandEvent& WXUNUSED(event))
+{
+    wxString path = ::wxFileSelector(_("Select file to import"), "", "", "",
+        _("CSV files (*.csv)|*.csv|Text files (*.txt)|*.txt|All files (*.*)|*.*"),
+        wxFD_OPEN | wxFD_FILE_MUST_EXIST, this);
+    if (!path.empty())
+        textFile->SetValue(path);
+}
+
+void ImportDataDialog::OnFileChange(wxCommandEvent& WXUNUSED(event))
+{
+    updateColumnChoices();
+    updateResume();
+    updateButtons();
+}
+
+void ImportDataDialog::OnFormatChange(wxCommandEvent& WXUNUSED(event))
+{
+    updateColumnChoices();
+}
+
+void ImportDataDialog::OnImportButtonClick(wxCommandEvent& WXUNUSED(event))
+{
+    if (importData())
+        EndModal(wxID_OK);
+}
@@ -0,0 +1,94 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_IMPORTDATADIALOG_H
+#define FR_IMPORTDATADIALOG_H
+
+#include <wx/wx.h>
+#include <wx/spinctrl.h>
+
+#include <vector>
+
+#include "gui/BaseDialog.h"
+
+class Column;
+class Table;
+struct DataImportSettings;
+
+class ImportDataDialog: public BaseDialog
+{
+private:
+    Table* tableM;
+    std::vector<Column*> columnsM;
+
+    wxStaticText* labelFile;
+    wxTextCtrl* textFile;
+    wxButton* buttonBrowse;
+    wxStaticText* labelFieldDelimiter;
+    wxChoice* choiceFieldDelimiter;
+    wxStaticText* labelTextDelimiter;
+    wxChoice* choiceTextDelimiter;
+    wxStaticText* labelNull;
+    wxTextCtrl* textNull;
+    wxStaticText* labelCommit;
+    wxSpinCtrl* spinCommit;
+    wxCheckBox* checkHeader;
+    wxCheckBox* checkUtf8;
+    wxStaticText* labelColumns;
+    wxScrolledWindow* panelColumns;
+    std::vector<wxChoice*> choicesColumns;
+    wxCheckBox* checkResume;
+    wxButton* buttonImport;
+    wxButton* buttonClose;
+
+    void createControls();
+    void layoutControls();
+
+    void getSettings(DataImportSettings& settings);
+    void updateColumnChoices();
+    void updateResume();
+    void updateButtons();
+    bool importData();
+protected:
+    virtual const wxString getName() const;
+public:
+    ImportDataDialog(wxWindow* parent, Table* table);
+private:
+    // event handling
+    enum {
+        ID_text_file = 100,
+        ID_button_browse,
+        ID_choice_fielddelimiter,
+        ID_choice_textdelimiter,
+        ID_check_header,
+        ID_check_utf8
+    };
+    void OnBrowseButtonClick(wxCommandEvent& event);
+    void OnFileChange(wxCommandEvent& event);
+    void OnFormatChange(wxCommandEvent& event);
+    void OnImportButtonClick(wxCommandEvent& event);
+
+    DECLARE_EVENT_TABLE()
+};
+
+#endif // FR_IMPORTDATADIALOG_H
@@ -48,12 +48,14 @@
 #include "gui/BackupFrame.h"
 #include "gui/CommandIds.h"
 #include "gui/ContextMenuMetadataItemVisitor.h"
+#include "gui/CopyDataDialog.h"
 #include "gui/controls/DBHTreeControl.h"
 #include "gui/DataGeneratorFrame.h"
 #include "gui/DatabaseRegistrationDialog.h"
 #include "gui/EventWatcherFrame.h"
 #include "gui/ExecuteSql.h"
 #include "gui/ExecuteSqlFrame.h"
+#include "gui/ImportDataDialog.h"
 #include "gui/MainFrame.h"
 #include "gui/MetadataItemPropertiesFrame.h"
 #include "gui/PreferencesDialog.h"
@@ -61,14 +63,17 @@
 #include "gui/RestoreFrame.h"
 #include "gui/ServerRegistrationDialog.h"
 #include "gui/SimpleHtmlFrame.h"
+#include "logger.h"
 #include "main.h"
 #include "metadata/column.h"
+#include "metadata/DDLScriptWriter.h"
 #include "metadata/domain.h"
 #include "metadata/generator.h"
 #include "metadata/MetadataItemCreateStatementVisitor.h"
 #include "metadata/MetadataTemplateManager.h"
 #include "metadata/procedure.h"
 #include "metadata/root.h"
+#include "metadata/SchemaComparer.h"
 #include "metadata/server.h"
 #include "metadata/table.h"
 #include "metadata/trigger.h"
@@ -129,10 +134,38 @@ public:
 };
 #endif
 
+MetadataTimer::MetadataTimer(wxEvtHandler* owner, int id)
+    : wxTimer(owner, id), ConfigCache(config()), stoppedM(false)
+{
+}
+
+void MetadataTimer::start()
+{
+    if (stoppedM)
+        return;
+    int interval = 1000 * config().get("MetadataChangeCheckInterval", 60);
+    if (interval <= 0)
+        Stop();
+    else if (!IsRunning() || GetInterval() != interval)
+        Start(interval);
+}
+
+void MetadataTimer::stop()
+{
+    stoppedM = true;
+    Stop();
+}
+
+void MetadataTimer::update()
+{
+    ConfigCache::update();
+    start();
+}
+
 MainFrame::MainFrame(wxWindow* parent, int id, const wxString& title,
         const wxPoint& pos, const wxSize& size, long style)
     : BaseFrame(parent, id, title, pos, size, style, "FlameRobin_main"),
-        rootM(new Root())
+        rootM(new Root()), metadataTimerM(this, ID_timer_metadata)
 {
     wxArtProvider::Push(new ArtProvider);
 
@@ -179,6 +212,8 @@ MainFrame::MainFrame(wxWindow* parent, int id, const wxString& title,
         searchPanelSizerM->Show(searchPanelM, false, true);    // recursive
         searchPanelSizerM->Layout();
     }
+
+    metadataTimerM.start();
 }
 
 void MainFrame::buildMainMenu()
@@ -382,6 +417,12 @@ BEGIN_EVENT_TABLE(MainFrame, wxFrame)
     EVT_UPDATE_UI(Cmds::Menu_MonitorEvents, MainFrame::OnMenuUpdateIfDatabaseConnectedOrAutoConnect)
     EVT_MENU(Cmds::Menu_GenerateData, MainFrame::OnMenuGenerateData)
     EVT_UPDATE_UI(Cmds::Menu_GenerateData, MainFrame::OnMenuUpdateIfDatabaseConnectedOrAutoConnect)
+    EVT_MENU(Cmds::Menu_ExtractDDLToFile, MainFrame::OnMenuExtractDDLToFile)
+    EVT_UPDATE_UI(Cmds::Menu_ExtractDDLToFile, MainFrame::OnMenuUpdateIfDatabaseConnectedOrAutoConnect)
+    EVT_MENU(Cmds::Menu_CompareSchema, MainFrame::OnMenuCompareSchema)
+    EVT_UPDATE_UI(Cmds::Menu_CompareSchema, MainFrame::OnMenuUpdateIfDatabaseConnectedOrAutoConnect)
+    EVT_MENU(Cmds::Menu_CopyData, MainFrame::OnMenuCopyData)
+    EVT_UPDATE_UI(Cmds::Menu_CopyData, MainFrame::OnMenuUpdateIfDatabaseConnectedOrAutoConnect)
     EVT_MENU(Cmds::Menu_CloneDatabase, MainFrame::OnMenuCloneDatabase)
     EVT_UPDATE_UI(Cmds::Menu_CloneDatabase, MainFrame::OnMenuUpdateIfDatabaseSelected)
     EVT_MENU(Cmds::Menu_DatabaseRegistrationInfo, MainFrame::OnMenuDatabaseRegistrationInfo)
@@ -412,6 +453,8 @@ BEGIN_EVENT_TABLE(MainFrame, wxFrame)
 
     EVT_MENU(Cmds::Menu_BrowseData, MainFrame::OnMenuBrowseData)
     EVT_MENU(Cmds::Menu_AddColumn, MainFrame::OnMenuAddColumn)
+    EVT_MENU(Cmds::Menu_ImportData, MainFrame::OnMenuImportData)
+    EVT_UPDATE_UI(Cmds::Menu_ImportData, MainFrame::OnMenuUpdateIfDatabaseConnectedOrAutoConnect)
     EVT_MENU(Cmds::Menu_ExecuteProcedure, MainFrame::OnMenuExecuteProcedure)
 
     EVT_MENU(Cmds::Menu_ShowAllGeneratorValues, MainFrame::OnMenuShowAllGeneratorValues)
@@ -455,6 +498,7 @@ BEGIN_EVENT_TABLE(MainFrame, wxFrame)
     EVT_TREE_ITEM_ACTIVATED(DBHTreeControl::ID_tree_ctrl, MainFrame::OnTreeItemActivate)
 
     EVT_SET_FOCUS(MainFrame::OnSetFocus)
+    EVT_TIMER(MainFrame::ID_timer_metadata, MainFrame::OnMetadataTimer)
 END_EVENT_TABLE()
 
 void MainFrame::OnMainMenuOpen(wxMenuEvent& event)
@@ -686,6 +730,9 @@ void MainFrame::doBeforeDestroy()
     // on some distros, the wxSafeYield call is needed as well
     // as it doesn't hurt for others, we can leave it all here, at least until
     // Firebird packagers for various distros figure out how to properly use NPTL
+    metadataTimerM.stop();
+    // write the logged statements before the databases are disconnected
+    Logger::shutdown();
     treeMainM->Freeze();
     rootM->disconnectAllDatabases();
     wxSafeYield();
@@ -1034,6 +1081,122 @@ void MainFrame::OnMenuGenerateData(wxCommandEvent& WXUNUSED(event))
     f->Show();
 }
 
+void MainFrame::OnMenuExtractDDLToFile(wxCommandEvent& WXUNUSED(event))
+{
+    DatabasePtr db = getDatabase(treeMainM->getSelectedMetadataItem());
+    if (!checkValidDatabase(db))
+        return;
+    if (!tryAutoConnectDatabase(db))
+        return;
+
+    wxFileDialog fd(this, _("Select file to save"), "",
+        db->getName_() + ".sql",
+        _("SQL script files (*.sql)|*.sql|All files (*.*)|*.*"),
+        wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if (wxID_OK != fd.ShowModal())
+        return;
+
+    try
+    {
+        ProgressDialog pd(this, _("Extracting DDL Definitions"), 2);
+        pd.doShow();
+        DDLScriptWriter writer(db, &pd);
+        writer.writeTo(fd.GetPath());
+    }
+    catch (std::exception& e)
+    {
+        wxMessageBox(e.what(), _("Error"), wxOK | wxICON_ERROR);
+    }
+}
+
+void MainFrame::OnMenuCompareSchema(wxCommandEvent& WXUNUSED(event))
+{
+    DatabasePtr db = getDatabase(treeMainM->getSelectedMetadataItem());
+    if (!checkValidDatabase(db))
+        return;
+    if (!tryAutoConnectDatabase(db))
+        return;
+
+    DatabasePtr target = selectOtherConnectedDatabase(db,
+        _("Select the database that should be changed to match\n")
+            + db->getName_(),
+        _("Compare Schema"));
+    if (!target)
+        return;
+
+    wxString sql;
+    try
+    {
+        ProgressDialog pd(this, _("Comparing Schemas"), 2);
+        pd.doShow();
+        SchemaComparer comparer(db, target, &pd);
+        if (!comparer.compare())
+            return;
+        sql = comparer.getAlterScript();
+    }
+    catch (std::exception& e)
+    {
+        wxMessageBox(e.what(), _("Error"), wxOK | wxICON_ERROR);
+        return;
+    }
+    if (sql.empty())
+    {
+        wxMessageBox(_("The schemas of both databases are the same."),
+            _("Compare Schema"), wxOK | wxICON_INFORMATION);
+        return;
+    }
+    showSql(this, _("Schema changes"), target, sql);
+}
+
+void MainFrame::OnMenuCopyData(wxCommandEvent& WXUNUSED(event))
+{
+    DatabasePtr db = getDatabase(treeMainM->getSelectedMetadataItem());
+    if (!checkValidDatabase(db))
+        return;
+    if (!tryAutoConnectDatabase(db))
+        return;
+
+    DatabasePtr target = selectOtherConnectedDatabase(db,
+        _("Select the database to copy the table data of\n")
+            + db->getName_() + _("\ninto"),
+        _("Copy Table Data"));
+    if (!target)
+        return;
+    CopyDataDialog cdd(this, db, target);
+    cdd.ShowModal();
+}
+
+DatabasePtr MainFrame::selectOtherConnectedDatabase(DatabasePtr database,
+    const wxString& message, const wxString& caption)
+{
+    wxArrayString names;
+    DatabasePtrs targets;
+    ServerPtrs servers(rootM->getServers());
+    for (ServerPtrs::iterator its = servers.begin(); its != servers.end();
+        ++its)
+    {
+        DatabasePtrs databases((*its)->getDatabases());
+        for (DatabasePtrs::iterator itdb = databases.begin();
+            itdb != databases.end(); ++itdb)
+        {
+            if (*itdb == database || !(*itdb)->isConnected())
+                continue;
+            names.Add((*its)->getName_() + "::" + (*itdb)->getName_());
+            targets.push_back(*itdb);
+        }
+    }
+    if (targets.empty())
+    {
+        wxMessageBox(_("Connect to the other database first."), caption,
+            wxOK | wxICON_INFORMATION);
+        return DatabasePtr();
+    }
+    int index = ::wxGetSingleChoiceIndex(message, caption, names, this);
+    if (index == -1)
+        return DatabasePtr();
+    return targets[index];
+}
+
 void MainFrame::OnMenuMonitorEvents(wxCommandEvent& WXUNUSED(event))
 {
     DatabasePtr db = getDatabase(treeMainM->getSelectedMetadataItem());
@@ -1346,6 +1509,19 @@ void MainFrame::OnMenuAddColumn(wxCommandEvent& WXUNUSED(event))
     getURIProcessor().handleURI(uri);
 }
 
+void MainFrame::OnMenuImportData(wxCommandEvent& WXUNUSED(event))
+{
+    Table* t = dynamic_cast<Table*>(treeMainM->getSelectedMetadataItem());
+    if (!t)
+        return;
+    DatabasePtr db = t->getDatabase();
+    if (!checkValidDatabase(db) || !tryAutoConnectDatabase(db))
+        return;
+
+    ImportDataDialog idd(this, t);
+    idd.ShowModal();
+}
+
 void MainFrame::OnMenuToggleDisconnected(wxCommandEvent& event)
 {
     config().setValue("HideDisconnectedDatabases", !event.IsChecked());
@@ -1479,7 +1655,8 @@ void MainFrame::OnMenuObjectRefresh(wxCommandEvent& WXUNUSED(event))
         if (!tryAutoConnectDatabase())
             return;
 
-        // make sure notifyObservers() is called only once
+        // make sure notifyObservers() is called only once per object
+        NotificationBatch batch("Refresh");
         SubjectLocker lock(mi);
 
         mi->invalidate();
@@ -1709,6 +1886,31 @@ void MainFrame::OnSetFocus(wxFocusEvent& event)
     event.Skip();
 }
 
+void MainFrame::OnMetadataTimer(wxTimerEvent& WXUNUSED(event))
+{
+    ServerPtrs servers(rootM->getServers());
+    for (ServerPtrs::iterator its = servers.begin(); its != servers.end();
+        ++its)
+    {
+        DatabasePtrs databases((*its)->getDatabases());
+        for (DatabasePtrs::iterator itdb = databases.begin();
+            itdb != databases.end(); ++itdb)
+        {
+            if (!(*itdb)->isConnected())
+                continue;
+            // errors are not reported, the user didn't start the check and
+            // the next one will be tried anyway
+            try
+            {
+                (*itdb)->checkForMetadataChanges();
+            }
+            catch (std::exception&)
+            {
+            }
+        }
+    }
+}
+
 void MainFrame::executeSysTemplate(const wxString& name, MetadataItem* item,
     wxWindow* parentWindow)
 {
@@ -31,6 +31,7 @@
 
 #include <vector>
 
+#include "config/Config.h"
 #include "gui/BaseFrame.h"
 #include "gui/GUIURIHandlerHelper.h"
 #include "metadata/MetadataClasses.h"
@@ -41,6 +42,22 @@ class LabelPanel;
 class TemplateProcessor;
 class wxFileName;
 
+// timer for the periodic check for metadata changes, restarts itself when
+// the interval is changed in the preferences
+class MetadataTimer: public wxTimer, public ConfigCache
+{
+private:
+    bool stoppedM;
+protected:
+    virtual void update();
+public:
+    MetadataTimer(wxEvtHandler* owner, int id);
+
+    void start();
+    // stops the timer for good, the settings are no longer observed
+    void stop();
+};
+
 class MainFrame: public BaseFrame, private URIHandler,
     private MetadataItemURIHandlerHelper, private GUIURIHandlerHelper
 {
@@ -71,6 +88,9 @@ public:
     void OnMenuGetServerVersion(wxCommandEvent& event);
     void OnMenuMonitorEvents(wxCommandEvent& event);
     void OnMenuGenerateData(wxCommandEvent& event);
+    void OnMenuExtractDDLToFile(wxCommandEvent& event);
+    void OnMenuCompareSchema(wxCommandEvent& event);
+    void OnMenuCopyData(wxCommandEvent& event);
     void OnMenuBackup(wxCommandEvent& event);
     void OnMenuExecuteStatements(wxCommandEvent& event);
     void OnMenuInsert(wxCommandEvent& event);
@@ -84,6 +104,7 @@ public:
     void OnMenuToggleDisconnected(wxCommandEvent& event);
     void OnMenuCreateObject(wxCommandEvent& event);
     void OnMenuAddColumn(wxCommandEvent& event);
+    void OnMenuImportData(wxCommandEvent& event);
     void OnMenuObjectProperties(wxCommandEvent& event);
     void OnMenuObjectRefresh(wxCommandEvent& event);
     void OnMenuDropObject(wxCommandEvent& event);
@@ -124,6 +145,7 @@ public:
     void OnTreeSelectionChanged(wxTreeEvent& event);
     void OnTreeItemActivate(wxTreeEvent& event);
     void OnSetFocus(wxFocusEvent& event);
+    void OnMetadataTimer(wxTimerEvent& event);
 
     // search stuff (IDs 600+ are taken!)
     enum {
@@ -131,7 +153,8 @@ public:
         ID_button_prev,
         ID_button_next,
         ID_search_box,
-        ID_notebook
+        ID_notebook,
+        ID_timer_metadata
     };
     void OnSearchTextChange(wxCommandEvent& event);
     void OnSearchBoxEnter(wxCommandEvent& event);
@@ -147,6 +170,8 @@ public:
     bool handleURI(URI& uri);
 private:
     RootPtr rootM;
+    // periodically checks the connected databases for metadata changes
+    MetadataTimer metadataTimerM;
 
     virtual bool doCanClose();
     virtual void doBeforeDestroy();
@@ -156,6 +181,9 @@ private:
     bool tryAutoConnectDatabase(DatabasePtr database);
 
     void unregisterDatabase(DatabasePtr database);
+    // lets the user choose one of the other connected databases
+    DatabasePtr selectOtherConnectedDatabase(DatabasePtr database,
+        const wxString& message, const wxString& caption);
 
     bool connect();
     void showGeneratorValue(Generator* g);
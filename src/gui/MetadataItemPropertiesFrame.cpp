@@ -34,10 +34,12 @@
 #include <wx/file.h>
 #include <wx/filedlg.h>
 #include <wx/platform.h>
+#include <wx/stopwatch.h>
 #include <wx/tipwin.h>
 #include <wx/wupdlock.h>
 
 #include <list>
+#include <memory>
 
 #include "config/Config.h"
 #include "core/ArtProvider.h"
@@ -66,9 +68,23 @@ private:
     bool htmlReloadRequestedM;
     PrintableHtmlWindow* html_window;
 
+    // the page is processed in idle time, a few top-level template commands
+    // at a time, so large pages don't block the user interface
+    std::auto_ptr<HtmlTemplateProcessor> processorM;
+    // only shown by the commands that take a long time, created once for
+    // the whole page
+    std::auto_ptr<ProgressDialog> progressDialogM;
+    wxString htmlPageM;
+    bool showPartialPageM;
+    wxStopWatch displayTimerM;
+
     // load page in idle handler, only request a reload in update()
     void requestLoadPage(bool showLoadingPage);
-    void loadPage();
+    void resetProcessor();
+    wxString getPageFileName();
+    // returns true if the page hasn't been processed completely yet
+    bool processPage();
+    void showPage();
 
     // observer stuff
     virtual void subjectRemoved(Subject* subject);
@@ -97,7 +113,7 @@ static MIPPanels mipPanels;
 MetadataItemPropertiesPanel::MetadataItemPropertiesPanel(
         MetadataItemPropertiesFrame* parent, MetadataItem* object)
     : wxPanel(parent, wxID_ANY), pageTypeM(ptSummary), objectM(object),
-        htmlReloadRequestedM(false)
+        htmlReloadRequestedM(false), showPartialPageM(false)
 {
     wxASSERT(object);
     mipPanels.push_back(this);
@@ -147,22 +163,33 @@ MetadataItem* MetadataItemPropertiesPanel::getObservedObject() const
 //! defer (possibly expensive) creation and display of html page to idle time
 void MetadataItemPropertiesPanel::requestLoadPage(bool showLoadingPage)
 {
-    if (!htmlReloadRequestedM)
+    // a partially processed page is outdated now
+    resetProcessor();
+    if (showLoadingPage)
     {
-        if (showLoadingPage)
-        {
-            html_window->LoadFile(config().getHtmlTemplatesPath()
-                + "ALLloading.html");
-        }
+        html_window->LoadFile(config().getHtmlTemplatesPath()
+            + "ALLloading.html");
+        // show the sections of the new page as they are processed,
+        // reloads of the same page keep the old one until they are done
+        showPartialPageM = true;
+    }
 
+    if (!htmlReloadRequestedM)
+    {
         Connect(wxID_ANY, wxEVT_IDLE,
             wxIdleEventHandler(MetadataItemPropertiesPanel::OnIdle));
         htmlReloadRequestedM = true;
     }
 }
 
-//! determine the path, load and display html page
-void MetadataItemPropertiesPanel::loadPage()
+void MetadataItemPropertiesPanel::resetProcessor()
+{
+    processorM.reset();
+    progressDialogM.reset();
+}
+
+//! determine the path of the html page
+wxString MetadataItemPropertiesPanel::getPageFileName()
 {
     wxString fileName = config().getHtmlTemplatesPath();
     switch (pageTypeM)
@@ -189,6 +216,16 @@ void MetadataItemPropertiesPanel::loadPage()
             fileName += "DDL.html";
             break;
     }
+    return fileName;
+}
+
+//! process the page for a short time, and display it when done
+bool MetadataItemPropertiesPanel::processPage()
+{
+    // time slice after which control returns to the event loop
+    static const long sliceMillis = 50;
+    // interval between displays of partially processed pages
+    static const long displayMillis = 300;
 
     wxBusyCursor bc;
 
@@ -197,19 +234,48 @@ void MetadataItemPropertiesPanel::loadPage()
     MetadataLoaderTransaction tr((db) ? db->getMetadataLoader() : 0);
     SubjectLocker lock(objectM);
 
-    ProgressDialog pd(this, _("Processing template..."));
-    pd.doShow();
+    if (!processorM.get())
+    {
+        processorM.reset(new HtmlTemplateProcessor(objectM, this));
+        progressDialogM.reset(new ProgressDialog(this,
+            _("Processing template...")));
+        htmlPageM.clear();
+        displayTimerM.Start();
+        processorM->startProcessingFile(getPageFileName(), 0);
+    }
 
-    wxString htmlpage;
-    HtmlTemplateProcessor tp(objectM, this);
-    tp.processTemplateFile(htmlpage, fileName, 0, &pd);
+    wxStopWatch sw;
+    bool more;
+    do
+        more = processorM->processNextCommand(htmlPageM, progressDialogM.get());
+    while (more && sw.Time() < sliceMillis);
+    // other windows are usable between the time slices
+    if (progressDialogM->IsShown())
+        progressDialogM->doHide();
 
-    pd.SetTitle(_("Rendering page..."));
+    if (more)
+    {
+        if (showPartialPageM && displayTimerM.Time() >= displayMillis)
+        {
+            showPage();
+            displayTimerM.Start();
+        }
+        return true;
+    }
+
+    resetProcessor();
+    showPartialPageM = false;
+    showPage();
+    htmlPageM.clear();
+    return false;
+}
 
+void MetadataItemPropertiesPanel::showPage()
+{
     wxWindowUpdateLocker freeze(html_window);
     int x = 0, y = 0;
     html_window->GetViewStart(&x, &y);         // save scroll position
-    html_window->setPageSource(htmlpage);
+    html_window->setPageSource(htmlPageM);
     html_window->Scroll(x, y);                 // restore scroll position
 
     // set title
@@ -351,12 +417,39 @@ void MetadataItemPropertiesPanel::OnHtmlCellHover(wxHtmlCellEvent& event)
     }
 }
 
-void MetadataItemPropertiesPanel::OnIdle(wxIdleEvent& WXUNUSED(event))
+void MetadataItemPropertiesPanel::OnIdle(wxIdleEvent& event)
 {
-    Disconnect(wxID_ANY, wxEVT_IDLE);
-    wxBusyCursor bc;
-    loadPage();
-    htmlReloadRequestedM = false;
+    if (!objectM)
+        return;
+    // pages of hidden tabs are processed when they are shown again,
+    // partial results are dropped when the user moves on to another page
+    if (!IsShownOnScreen())
+    {
+        resetProcessor();
+        return;
+    }
+
+    bool more = false;
+    try
+    {
+        more = processPage();
+    }
+    catch (...)
+    {
+        resetProcessor();
+        showPartialPageM = false;
+        Disconnect(wxID_ANY, wxEVT_IDLE);
+        htmlReloadRequestedM = false;
+        throw;
+    }
+
+    if (more)
+        event.RequestMore();
+    else
+    {
+        Disconnect(wxID_ANY, wxEVT_IDLE);
+        htmlReloadRequestedM = false;
+    }
 }
 
 void MetadataItemPropertiesPanel::OnRefresh(wxCommandEvent& WXUNUSED(event))
@@ -0,0 +1,181 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+
+#include <algorithm>
+
+#include "config/Config.h"
+#include "core/FRError.h"
+#include "core/ProgressIndicator.h"
+#include "core/StringUtils.h"
+#include "core/Subject.h"
+#include "core/TemplateCache.h"
+#include "engine/MetadataLoader.h"
+#include "gui/HtmlTemplateProcessor.h"
+#include "gui/PropertyPageBenchmark.h"
+#include "metadata/database.h"
+
+static const wxString benchmarkTableName("FLAMEROBIN$BENCHMARK");
+
+PropertyPageBenchmark::PropertyPageBenchmark(Database* database,
+        wxWindow* window, unsigned columns)
+    : databaseM(database), windowM(window), columnsM(columns)
+{
+}
+
+void PropertyPageBenchmark::executeDdl(const wxString& sql)
+{
+    IBPP::Transaction tr = IBPP::TransactionFactory(
+        databaseM->getIBPPDatabase());
+    tr->Start();
+    IBPP::Statement st = IBPP::StatementFactory(
+        databaseM->getIBPPDatabase(), tr);
+    st->Prepare(wx2std(sql, databaseM->getCharsetConverter()));
+    st->Execute();
+    tr->Commit();
+}
+
+// renders the page the way MetadataItemPropertiesPanel::processPage() does
+boost::int64_t PropertyPageBenchmark::render(MetadataItem* table)
+{
+    wxStopWatch sw;
+    MetadataLoaderTransaction tr(databaseM->getMetadataLoader());
+    SubjectLocker lock(table);
+
+    HtmlTemplateProcessor tp(table, windowM);
+    tp.startProcessingFile(
+        wxFileName(config().getHtmlTemplatesPath() + "TABLE.html"), 0);
+    wxString htmlPage;
+    while (tp.processNextCommand(htmlPage))
+        ;
+    return sw.TimeInMicro().GetValue();
+}
+
+void PropertyPageBenchmark::execute(unsigned runs,
+    ProgressIndicator* progressIndicator)
+{
+    coldMicrosM.clear();
+    warmMicrosM.clear();
+
+    if (databaseM->findByNameAndType(ntTable, benchmarkTableName))
+    {
+        throw FRError(wxString::Format(_("The table %s already exists."),
+            benchmarkTableName.c_str()));
+    }
+    // mix the data types, so that the page shows different domains
+    const wxString types[] = { "VARCHAR(40)", "NUMERIC(18,4)",
+        "TIMESTAMP", "INTEGER" };
+    wxString sql("CREATE TABLE " + benchmarkTableName
+        + " (C1 INTEGER NOT NULL PRIMARY KEY");
+    for (unsigned i = 2; i <= columnsM; ++i)
+        sql += wxString::Format(", C%u %s", i, types[i % 4].c_str());
+    sql += ")";
+    executeDdl(sql);
+    databaseM->addObject(ntTable, benchmarkTableName);
+    MetadataItem* table = databaseM->findByNameAndType(ntTable,
+        benchmarkTableName);
+
+    try
+    {
+        if (progressIndicator)
+        {
+            progressIndicator->initProgress(_("Rendering property page..."),
+                2 * runs + 1);
+        }
+        // the first render loads the columns, constraints, etc.
+        render(table);
+        for (unsigned i = 0; i < runs; ++i)
+        {
+            checkProgressIndicatorCanceled(progressIndicator);
+            getTemplateCache().clear();
+            coldMicrosM.push_back(render(table));
+            if (progressIndicator)
+                progressIndicator->stepProgress();
+            warmMicrosM.push_back(render(table));
+            if (progressIndicator)
+                progressIndicator->stepProgress();
+        }
+    }
+    catch (...)
+    {
+        // report the error of the benchmark, not of the cleanup
+        try
+        {
+            executeDdl("DROP TABLE " + benchmarkTableName);
+            databaseM->dropObject(table);
+        }
+        catch (...)
+        {
+        }
+        throw;
+    }
+    executeDdl("DROP TABLE " + benchmarkTableName);
+    databaseM->dropObject(table);
+}
+
+unsigned PropertyPageBenchmark::getColumnCount() const
+{
+    return columnsM;
+}
+
+size_t PropertyPageBenchmark::getRunCount() const
+{
+    return coldMicrosM.size();
+}
+
+/*static*/
+PropertyPageBenchmark::Summary PropertyPageBenchmark::getSummary(
+    std::vector<boost::int64_t> values)
+{
+    Summary s = { 0, 0, 0 };
+    if (values.empty())
+        return s;
+
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    s.min = values.front();
+    s.median = (values[(n - 1) / 2] + values[n / 2]) / 2;
+    s.max = values.back();
+    return s;
+}
+
+PropertyPageBenchmark::Summary PropertyPageBenchmark::getColdSummary() const
+{
+    return getSummary(coldMicrosM);
+}
+
+PropertyPageBenchmark::Summary PropertyPageBenchmark::getWarmSummary() const
+{
+    return getSummary(warmMicrosM);
+}
@@ -0,0 +1,77 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_PROPERTYPAGEBENCHMARK_H
+#define FR_PROPERTYPAGEBENCHMARK_H
+
+#include <wx/string.h>
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "metadata/MetadataClasses.h"
+
+class ProgressIndicator;
+class wxWindow;
+
+// Measures the rendering of the TABLE.html property page for a generated
+// table with many columns, with the template cache cold (cleared before
+// the run) and warm (after a run of the same page).  Times are in
+// microseconds.
+class PropertyPageBenchmark
+{
+public:
+    struct Summary
+    {
+        boost::int64_t min;
+        boost::int64_t median;
+        boost::int64_t max;
+    };
+private:
+    Database* databaseM;
+    wxWindow* windowM;
+    unsigned columnsM;
+    std::vector<boost::int64_t> coldMicrosM;
+    std::vector<boost::int64_t> warmMicrosM;
+
+    void executeDdl(const wxString& sql);
+    boost::int64_t render(MetadataItem* table);
+    static Summary getSummary(std::vector<boost::int64_t> values);
+public:
+    PropertyPageBenchmark(Database* database, wxWindow* window,
+        unsigned columns = 300);
+
+    // Creates the table FLAMEROBIN$BENCHMARK and renders its page once to
+    // load the metadata.  Every run then renders the page with a cleared
+    // template cache and again with the cache filled by that render.  The
+    // table is dropped again afterwards.
+    void execute(unsigned runs, ProgressIndicator* progressIndicator = 0);
+
+    unsigned getColumnCount() const;
+    size_t getRunCount() const;
+    Summary getColdSummary() const;
+    Summary getWarmSummary() const;
+};
+
+#endif // FR_PROPERTYPAGEBENCHMARK_H
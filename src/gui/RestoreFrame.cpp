@@ -34,6 +34,7 @@
 #include <wx/filename.h>
 
 #include <algorithm>
+#include <map>
 
 #include <ibpp.h>
 
@@ -53,7 +54,7 @@ class RestoreThread: public wxThread {
 public:
     RestoreThread(RestoreFrame* frame, wxString server, wxString username,
         wxString password, wxString bkfilename, wxString dbfilename,
-        int pagesize, IBPP::BRF flags);
+        int pagesize, IBPP::BRF flags, BackupRestoreProgressPtr progress);
 
     virtual void* Entry();
     virtual void OnExit();
@@ -66,6 +67,7 @@ private:
     wxString dbfileM;
     int pagesizeM;
     IBPP::BRF brfM;
+    BackupRestoreProgressPtr progressM;
     void logError(wxString& msg);
     void logImportant(wxString& msg);
     void logProgress(wxString& msg);
@@ -73,8 +75,9 @@ private:
 
 RestoreThread::RestoreThread(RestoreFrame* frame, wxString server,
         wxString username, wxString password, wxString bkfilename,
-        wxString dbfilename, int pagesize, IBPP::BRF flags)
-    : wxThread()
+        wxString dbfilename, int pagesize, IBPP::BRF flags,
+        BackupRestoreProgressPtr progress)
+    : wxThread(), progressM(progress)
 {
     frameM = frame;
     serverM = server;
@@ -117,6 +120,7 @@ void* RestoreThread::Entry()
             const char* c = svc->WaitMsg();
             if (c == 0)
             {
+                progressM->setCompleted();
                 now = wxDateTime::Now();
                 msg.Printf(_("Database restore finished %s"),
                     now.FormatTime().c_str());
@@ -124,6 +128,7 @@ void* RestoreThread::Entry()
                 break;
             }
             msg = c;
+            progressM->processLine(msg);
             logProgress(msg);
         }
         svc->Disconnect();
@@ -229,6 +234,7 @@ void RestoreFrame::createControls()
         _("Show complete log"));
     button_start = new wxButton(panel_controls, ID_button_start,
         _("&Start Restore"));
+    createProgressControls();
 
     text_ctrl_log = new LogTextControl(this, ID_text_ctrl_log);
 }
@@ -281,6 +287,10 @@ void RestoreFrame::layoutControls()
     sizerPanelV->Add(0, styleguide().getUnrelatedControlMargin(wxVERTICAL));
     sizerPanelV->Add(sizerButtons, 0, wxEXPAND);
     sizerPanelV->Add(0, styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerPanelV->Add(gauge_progress, 0, wxEXPAND);
+    sizerPanelV->Add(0, styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerPanelV->Add(label_progress, 0, wxEXPAND);
+    sizerPanelV->Add(0, styleguide().getRelatedControlMargin(wxVERTICAL));
     wxBoxSizer* sizerPanelH = new wxBoxSizer(wxHORIZONTAL);
     sizerPanelH->Add(styleguide().getFrameMargin(wxLEFT), 0);
     sizerPanelH->Add(sizerPanelV, 1, wxEXPAND);
@@ -441,10 +451,13 @@ void RestoreFrame::OnStartButtonClick(wxCommandEvent& WXUNUSED(event))
     if (!choice_pagesize->GetStringSelection().ToULong(&pagesize))
         pagesize = 0;
 
+    startProgress(operationRestore, database->getPath(),
+        std::map<wxString, int64_t>());
+
     std::auto_ptr<wxThread> thread(new RestoreThread(this,
         server->getConnectionString(), username, password,
         text_ctrl_filename->GetValue(), database->getPath(), pagesize,
-        (IBPP::BRF)flags));
+        (IBPP::BRF)flags, progressM));
     startThread(thread);
     updateControls();
 }
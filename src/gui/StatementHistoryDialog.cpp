@@ -208,19 +208,24 @@ void StatementHistoryDialog::OnButtonSearchClick(wxCommandEvent&
     listbox_search->Clear();
     wxString searchString = textctrl_search->GetValue().Upper();
     setSearching(true);
-    StatementHistory::Position total = historyM->size();
+    // the trigram index of the history narrows down the entries to check
+    std::vector<StatementHistory::Position> candidates(
+        historyM->findCandidates(searchString));
+    size_t total = candidates.size();
     gauge_progress->SetRange((int)total);
     wxString last = wxEmptyString;
-    for (StatementHistory::Position p = total - 1; (int)p >= 0; --p)
+    for (size_t i = 0; i < total; ++i)
     {
-        wxYield();
+        if (i % 100 == 0)
+            wxYield();
         if (!isSearchingM)
         {
             gauge_progress->SetValue(0);
             return;
         }
 
-        gauge_progress->SetValue((int)(total - p - 1));
+        gauge_progress->SetValue((int)i);
+        StatementHistory::Position p = candidates[total - i - 1];
         wxString s(historyM->get(p));
         if (s == last)  // ignore duplicates
             continue;
@@ -39,6 +39,8 @@
 #include <map>
 #include <vector>
 
+#include <boost/unordered_set.hpp>
+
 #include "config/Config.h"
 #include "core/ArtProvider.h"
 #include "core/Observer.h"
@@ -646,9 +648,10 @@ TreeSelectionRestorer::~TreeSelectionRestorer()
     if ((*pos).second.decRef() == 0)
     {
         MetadataItem* origSelItem = (*pos).second.getSelectedItem();
+        // erase first, selecting may create (and update) nodes
+        getSelections().erase(pos);
         if (origSelItem != treeM->getSelectedMetadataItem())
             treeM->selectMetadataItem(origSelItem);
-        getSelections().erase(pos);
     }
 }
 
@@ -666,32 +669,37 @@ class DBHTreeItemData: public wxTreeItemData, public Observer
 private:
     DBHTreeControl* treeM;
     MetadataItem* observedItemM;
+    // child nodes are created when the node is expanded for the first time
+    bool childrenRequestedM;
 protected:
     virtual void update();
 public:
     DBHTreeItemData(DBHTreeControl* tree);
+    ~DBHTreeItemData();
 
     wxTreeItemId findSubNode(MetadataItem* item);
     MetadataItem* getObservedMetadata();
     void setObservedMetadata(MetadataItem* item);
+    void requestChildren();
 };
 
 DBHTreeItemData::DBHTreeItemData(DBHTreeControl* tree)
-    : Observer(), treeM(tree), observedItemM(0)
+    : Observer(), treeM(tree), observedItemM(0), childrenRequestedM(false)
+{
+}
+
+DBHTreeItemData::~DBHTreeItemData()
 {
+    if (observedItemM)
+        treeM->unregisterNode(observedItemM, GetId());
 }
 
 //! returns tree subnode that points to given metadata object
 wxTreeItemId DBHTreeItemData::findSubNode(MetadataItem* item)
 {
-    wxTreeItemIdValue cookie;
-    wxTreeItemId id = GetId();
-    for (wxTreeItemId ci = treeM->GetFirstChild(id, cookie); ci.IsOk();
-        ci = treeM->GetNextChild(id, cookie))
-    {
-        if (treeM->getMetadataItem(ci) == item)
-            return ci;
-    }
+    wxTreeItemId ci = treeM->findNode(item);
+    if (ci.IsOk() && treeM->GetItemParent(ci) == GetId())
+        return ci;
     return wxTreeItemId();
 }
 
@@ -705,10 +713,25 @@ void DBHTreeItemData::setObservedMetadata(MetadataItem* item)
     if (observedItemM != item)
     {
         if (observedItemM)
+        {
             observedItemM->detachObserver(this);
+            treeM->unregisterNode(observedItemM, GetId());
+        }
         observedItemM = item;
         if (observedItemM)
+        {
+            treeM->registerNode(observedItemM, GetId());
             observedItemM->attachObserver(this, true);
+        }
+    }
+}
+
+void DBHTreeItemData::requestChildren()
+{
+    if (!childrenRequestedM)
+    {
+        childrenRequestedM = true;
+        update();
     }
 }
 
@@ -783,6 +806,15 @@ struct MetadataItemSorter
     };
 };
 
+// properties of a child node, collected before the nodes are changed
+struct ChildNode
+{
+    MetadataItem* item;
+    wxString text;
+    int image;
+    bool configSensitive;
+};
+
 //! parent nodes are responsible for "insert" / "delete"
 //! node is responsible for "update"
 void DBHTreeItemData::update()
@@ -808,78 +840,42 @@ void DBHTreeItemData::update()
     if (treeM->GetItemImage(id) != tivObject.getNodeImage())
         treeM->SetItemImage(id, tivObject.getNodeImage());
 
-    // track number of visible child nodes for SetItemHasChildren() calls
-    unsigned numVisibleChildren = 0;
-    // check subitems
-    std::vector<MetadataItem*> children;
-    std::vector<MetadataItem*>::iterator itChild;
+    // only the root node and nodes that have been expanded once get child
+    // nodes, for all others it's enough to know whether there is a visible
+    // child to show the expander
+    bool createChildNodes = childrenRequestedM || id == treeM->GetRootItem();
+
+    // visible child items in tree order, with their node properties
+    std::vector<ChildNode> children;
     if (tivObject.getShowChildren())
     {
-        if (object->getChildren(children))
+        std::vector<MetadataItem*> items;
+        if (object->getChildren(items))
         {
             // sort child nodes if necessary
-            if (tivObject.getSortChildren())
+            if (createChildNodes && tivObject.getSortChildren())
             {
                 MetadataItemSorter sorter;
-                std::sort(children.begin(), children.end(), sorter);
+                std::sort(items.begin(), items.end(), sorter);
             }
 
-            wxTreeItemId prevId;
-            // create or update child nodes
-            for (itChild = children.begin(); itChild != children.end(); ++itChild)
+            std::vector<MetadataItem*>::iterator itItem;
+            for (itItem = items.begin(); itItem != items.end(); ++itItem)
             {
                 DBHTreeItemVisitor tivChild(treeM);
-                (*itChild)->loadPendingData();
-                (*itChild)->acceptVisitor(&tivChild);
+                (*itItem)->loadPendingData();
+                (*itItem)->acceptVisitor(&tivChild);
                 if (!tivChild.getNodeVisible())
                     continue;
-                ++numVisibleChildren;
-
-                wxTreeItemId childId = findSubNode(*itChild);
-                // order of child nodes may have changed
-                // since nodes can't be moved they have to be recreated
-                if (childId.IsOk())
-                {
-                    wxTreeItemId prevChildId = treeM->GetPrevSibling(childId);
-                    if (prevChildId != prevId)
-                    {
-                        treeM->Delete(childId);
-                        childId.Unset();
-                    }
-                }
-
-                if (!childId.IsOk())
-                {
-                    DBHTreeItemData* newItem = new DBHTreeItemData(treeM);
-                    if (prevId.IsOk())
-                    {
-                        childId = treeM->InsertItem(id, prevId,
-                            tivChild.getNodeText(), tivChild.getNodeImage(),
-                            -1, newItem);
-                    }
-                    else // first
-                    {
-                        childId = treeM->PrependItem(id, tivChild.getNodeText(),
-                            tivChild.getNodeImage(), -1, newItem);
-                    }
-                    // setObservedMetadata() calls attachObserver(), which
-                    // calls update() on the newly created child node
-                    // this will correctly populate the tree
-                    newItem->setObservedMetadata(*itChild);
-                    // tree node data objects may optionally observe the settings
-                    // cache object, for example to create / delete column and
-                    // parameter nodes if the "ShowColumnsInTree" setting changes
-                    if (tivChild.isConfigSensitive())
-                        DBHTreeConfigCache::get().attachObserver(newItem, false);
-                }
-                else
-                {
-                    if (treeM->GetItemText(childId) != tivChild.getNodeText())
-                        treeM->SetItemText(childId, tivChild.getNodeText());
-                    if (treeM->GetItemImage(childId) != tivChild.getNodeImage())
-                        treeM->SetItemImage(childId, tivChild.getNodeImage());
-                }
-                prevId = childId;
+
+                ChildNode child;
+                child.item = *itItem;
+                child.text = tivChild.getNodeText();
+                child.image = tivChild.getNodeImage();
+                child.configSensitive = tivChild.isConfigSensitive();
+                children.push_back(child);
+                if (!createChildNodes)
+                    break;
             }
         }
     }
@@ -888,7 +884,7 @@ void DBHTreeItemData::update()
         || (treeM->GetWindowStyle() & wxTR_HIDE_ROOT) == 0;
 
     // remove all children at once
-    if (numVisibleChildren == 0)
+    if (children.empty())
     {
         if (treeM->ItemHasChildren(id))
         {
@@ -902,43 +898,107 @@ void DBHTreeItemData::update()
         return;
     }
     treeM->SetItemHasChildren(id, true);
+    if (!createChildNodes)
+    {
+        treeM->SetItemBold(id, true);
+        return;
+    }
 
-    // remove delete items - one by one
-    bool itemsDeleted = false;
+    // remove nodes of deleted (or hidden) items, collect the remaining ones
+    boost::unordered_set<MetadataItem*> visibleItems;
+    for (std::vector<ChildNode>::iterator it = children.begin();
+        it != children.end(); ++it)
+    {
+        visibleItems.insert((*it).item);
+    }
+    std::vector<wxTreeItemId> nodes, deletedNodes;
+    std::vector<MetadataItem*> nodeItems;
     wxTreeItemIdValue cookie;
-    wxTreeItemId item = treeM->GetFirstChild(id, cookie);
-    while (item.IsOk())
+    for (wxTreeItemId ci = treeM->GetFirstChild(id, cookie); ci.IsOk();
+        ci = treeM->GetNextChild(id, cookie))
     {
-        itChild = find(children.begin(), children.end(),
-            treeM->getMetadataItem(item));
-        // we may need to hide disconnected databases
-        if (DBHTreeConfigCache::get().getHideDisconnectedDatabases()
-            && itChild != children.end())
-        {
-            Database* db = dynamic_cast<Database*>(*itChild);
-            if (db && !db->isConnected())
-                itChild = children.end();
-        }
-        // delete tree node and all children if metadata item not found
-        if (itChild == children.end())
+        MetadataItem* mi = treeM->getMetadataItem(ci);
+        if (visibleItems.find(mi) != visibleItems.end())
         {
-            itemsDeleted = true;
-            treeM->DeleteChildren(item);
-            treeM->Delete(item);
-            item = treeM->GetFirstChild(id, cookie);
-            continue;
+            nodes.push_back(ci);
+            nodeItems.push_back(mi);
         }
-        item = treeM->GetNextChild(id, cookie);
+        else
+            deletedNodes.push_back(ci);
     }
-    // force-collapse node if all children deleted
-    if (itemsDeleted && 0 == treeM->GetChildrenCount(id, false)
-        && canCollapseNode)
+    for (std::vector<wxTreeItemId>::iterator it = deletedNodes.begin();
+        it != deletedNodes.end(); ++it)
     {
+        treeM->DeleteChildren(*it);
+        treeM->Delete(*it);
+    }
+    // force-collapse node if all children deleted
+    if (!deletedNodes.empty() && nodes.empty() && canCollapseNode)
         treeM->Collapse(id);
+
+    // merge the child items with the existing nodes, both are in tree order
+    // so this needs a single pass
+    // since nodes can't be moved, nodes out of order have to be recreated
+    boost::unordered_set<MetadataItem*> recreatedItems;
+    size_t nodeIndex = 0;
+    wxTreeItemId prevId;
+    for (std::vector<ChildNode>::iterator it = children.begin();
+        it != children.end(); ++it)
+    {
+        while (nodeIndex < nodes.size() && recreatedItems.find(
+            nodeItems[nodeIndex]) != recreatedItems.end())
+        {
+            ++nodeIndex;
+        }
+
+        wxTreeItemId childId;
+        if (nodeIndex < nodes.size() && nodeItems[nodeIndex] == (*it).item)
+            childId = nodes[nodeIndex++];
+        else
+        {
+            childId = findSubNode((*it).item);
+            if (childId.IsOk())
+            {
+                recreatedItems.insert((*it).item);
+                treeM->Delete(childId);
+                childId.Unset();
+            }
+        }
+
+        if (!childId.IsOk())
+        {
+            DBHTreeItemData* newItem = new DBHTreeItemData(treeM);
+            if (prevId.IsOk())
+            {
+                childId = treeM->InsertItem(id, prevId, (*it).text,
+                    (*it).image, -1, newItem);
+            }
+            else // first
+            {
+                childId = treeM->PrependItem(id, (*it).text, (*it).image,
+                    -1, newItem);
+            }
+            // setObservedMetadata() calls attachObserver(), which
+            // calls update() on the newly created child node
+            // this will correctly populate the tree
+            newItem->setObservedMetadata((*it).item);
+            // tree node data objects may optionally observe the settings
+            // cache object, for example to create / delete column and
+            // parameter nodes if the "ShowColumnsInTree" setting changes
+            if ((*it).configSensitive)
+                DBHTreeConfigCache::get().attachObserver(newItem, false);
+        }
+        else
+        {
+            if (treeM->GetItemText(childId) != (*it).text)
+                treeM->SetItemText(childId, (*it).text);
+            if (treeM->GetItemImage(childId) != (*it).image)
+                treeM->SetItemImage(childId, (*it).image);
+        }
+        prevId = childId;
     }
 
-    treeM->SetItemBold(id, tivObject.getNodeTextBold()
-        || treeM->ItemHasChildren(id));
+    treeM->SetItemBold(id, true);
 }
 
 BEGIN_EVENT_TABLE(DBHTreeControl, wxTreeCtrl)
@@ -1022,6 +1082,7 @@ void DBHTreeControl::OnTreeItemExpanding(wxTreeEvent& event)
     MetadataItem* mi = getMetadataItem(event.GetItem());
     if (mi)
         mi->ensureChildrenLoaded();
+    createChildNodes(event.GetItem());
     event.Skip();
 }
 
@@ -1039,6 +1100,12 @@ DBHTreeControl::DBHTreeControl(wxWindow* parent, const wxPoint& pos,
     SetImageList(&DBHTreeImageList::get());
 }
 
+DBHTreeControl::~DBHTreeControl()
+{
+    // item data objects unregister from nodesM when they are deleted
+    DeleteAllItems();
+}
+
 void DBHTreeControl::allowContextMenu(bool doAllow)
 {
     allowContextMenuM = doAllow;
@@ -1082,33 +1149,84 @@ MetadataItem* DBHTreeControl::getMetadataItem(wxTreeItemId item)
     return 0;
 }
 
-// recursively searches children for item
-bool DBHTreeControl::findMetadataItem(MetadataItem *item, wxTreeItemId parent)
+void DBHTreeControl::registerNode(MetadataItem* item, wxTreeItemId id)
 {
-    wxTreeItemIdValue cookie;
-    if (item == getMetadataItem(parent))
+    nodesM[item] = id;
+}
+
+void DBHTreeControl::unregisterNode(MetadataItem* item, wxTreeItemId id)
+{
+    NodeMap::iterator it = nodesM.find(item);
+    if (it != nodesM.end() && (*it).second == id)
+        nodesM.erase(it);
+}
+
+wxTreeItemId DBHTreeControl::findNode(MetadataItem* item)
+{
+    NodeMap::iterator it = nodesM.find(item);
+    if (it != nodesM.end())
+        return (*it).second;
+    return wxTreeItemId();
+}
+
+void DBHTreeControl::createChildNodes(wxTreeItemId id)
+{
+    if (id.IsOk())
     {
-        SelectItem(parent);
-        EnsureVisible(parent);
-        return true;
+        if (DBHTreeItemData* tid = (DBHTreeItemData*)GetItemData(id))
+            tid->requestChildren();
     }
-    for (wxTreeItemId node = GetFirstChild(parent, cookie); node.IsOk();
-        node = GetNextChild(parent, cookie))
+}
+
+wxTreeItemId DBHTreeControl::findOrCreateNode(MetadataItem* item)
+{
+    wxTreeItemId id = findNode(item);
+    if (id.IsOk() || !item->getParent())
+        return id;
+    wxTreeItemId parentId = findOrCreateNode(item->getParent());
+    if (!parentId.IsOk())
+        return id;
+
+    createChildNodes(parentId);
+    id = findNode(item);
+    if (id.IsOk())
+        return id;
+
+    // collection nodes are shown between the database and its objects
+    wxTreeItemIdValue cookie;
+    for (wxTreeItemId ci = GetFirstChild(parentId, cookie); ci.IsOk();
+        ci = GetNextChild(parentId, cookie))
     {
-        if (findMetadataItem(item, node))
-            return true;
+        std::vector<MetadataItem*> children;
+        MetadataItem* mi = getMetadataItem(ci);
+        if (mi && mi->getChildren(children)
+            && std::find(children.begin(), children.end(), item)
+                != children.end())
+        {
+            createChildNodes(ci);
+            break;
+        }
     }
-    return false;
+    return findNode(item);
 }
 
 bool DBHTreeControl::selectMetadataItem(MetadataItem* item)
 {
-    return item && findMetadataItem(item, GetRootItem());
+    if (!item)
+        return false;
+    wxTreeItemId id = findOrCreateNode(item);
+    if (!id.IsOk())
+        return false;
+    SelectItem(id);
+    EnsureVisible(id);
+    return true;
 }
 
 //! recursively get the last child of item
 wxTreeItemId DBHTreeControl::getLastItem(wxTreeItemId id)
 {
+    if (ItemHasChildren(id))
+        createChildNodes(id);
     wxTreeItemId temp = GetLastChild(id);
     if (temp.IsOk())
         return getLastItem(temp);
@@ -1138,7 +1256,11 @@ wxTreeItemId DBHTreeControl::getNextItem(wxTreeItemId current)
 {
     wxTreeItemId temp = current;
     wxTreeItemIdValue cookie;   // dummy - not really used
+    // child nodes of never expanded nodes are created when the search gets
+    // there, this doesn't load anything that isn't loaded already
     if (ItemHasChildren(temp))
+        createChildNodes(temp);
+    if (GetChildrenCount(temp, false) > 0)
         temp = GetFirstChild(temp, cookie);
     else
     {
@@ -27,13 +27,27 @@
 #include <wx/wx.h>
 #include <wx/treectrl.h>
 
+#include <boost/unordered_map.hpp>
+
+class DBHTreeItemData;
 class MetadataItem;
 
 class DBHTreeControl: public wxTreeCtrl
 {
 private:
-    // recursive function used by selectMetadataItem
-    bool findMetadataItem(MetadataItem *item, wxTreeItemId parent);
+    friend class DBHTreeItemData;
+
+    // every metadata item has at most one node in the tree, the map is
+    // maintained by the DBHTreeItemData objects
+    typedef boost::unordered_map<MetadataItem*, wxTreeItemId> NodeMap;
+    NodeMap nodesM;
+    void registerNode(MetadataItem* item, wxTreeItemId id);
+    void unregisterNode(MetadataItem* item, wxTreeItemId id);
+
+    // returns the node of the item, creating the child nodes of its
+    // ancestors if necessary - used by selectMetadataItem
+    wxTreeItemId findOrCreateNode(MetadataItem* item);
+    void createChildNodes(wxTreeItemId id);
     bool allowContextMenuM;
 
 protected:
@@ -51,6 +65,9 @@ public:
 
     wxTreeItemId addRootNode(MetadataItem* rootItem);
 
+    // Returns the tree item of the metadata item, if it has been created
+    wxTreeItemId findNode(MetadataItem* item);
+
     // Returns observed metadata item based on specified tree item
     MetadataItem *getMetadataItem(wxTreeItemId item);
 
@@ -69,6 +86,7 @@ public:
 
     DBHTreeControl(wxWindow* parent, const wxPoint& pos = wxDefaultPosition,
         const wxSize& size = wxDefaultSize, long style = wxTR_HAS_BUTTONS);
+    ~DBHTreeControl();
 
     DECLARE_EVENT_TABLE()
 };
@@ -0,0 +1,251 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/ffile.h>
+
+#include <algorithm>
+
+#include "gui/controls/RelationIOListCtrl.h"
+
+namespace {
+
+enum { colRelation, colSeqReads, colIdxReads, colInserts, colUpdates,
+    colDeletes, colBackouts, colPurges, colExpunges, colCount };
+
+int getCountValue(const IBPP::CountInfo& ci, int column)
+{
+    switch (column)
+    {
+        case colSeqReads:   return ci.seqReads;
+        case colIdxReads:   return ci.idxReads;
+        case colInserts:    return ci.inserts;
+        case colUpdates:    return ci.updates;
+        case colDeletes:    return ci.deletes;
+        case colBackouts:   return ci.backouts;
+        case colPurges:     return ci.purges;
+        case colExpunges:   return ci.expunges;
+        default:            return 0;
+    }
+}
+
+class RelationIOCountsSorter
+{
+private:
+    int columnM;
+    bool ascendingM;
+public:
+    RelationIOCountsSorter(int column, bool ascending)
+        : columnM(column), ascendingM(ascending)
+    {
+    }
+    bool operator()(const RelationIOCounts& lhs,
+        const RelationIOCounts& rhs) const
+    {
+        if (columnM == colRelation)
+        {
+            int cmp = lhs.relationName.CmpNoCase(rhs.relationName);
+            return ascendingM ? cmp < 0 : cmp > 0;
+        }
+        int l = getCountValue(lhs.counts, columnM);
+        int r = getCountValue(rhs.counts, columnM);
+        return ascendingM ? l < r : l > r;
+    }
+};
+
+const int ID_EXPORT = 1000;
+
+} // namespace
+
+RelationIOListCtrl::RelationIOListCtrl(wxWindow* parent, wxWindowID id)
+    : wxListCtrl(parent, id, wxDefaultPosition, wxDefaultSize,
+        wxLC_REPORT | wxLC_VRULES | wxBORDER_THEME),
+    sortColumnM(colSeqReads), sortAscendingM(false)
+{
+    InsertColumn(colRelation, _("Relation"));
+    InsertColumn(colSeqReads, _("Non-indexed reads"), wxLIST_FORMAT_RIGHT);
+    InsertColumn(colIdxReads, _("Indexed reads"), wxLIST_FORMAT_RIGHT);
+    InsertColumn(colInserts, _("Inserts"), wxLIST_FORMAT_RIGHT);
+    InsertColumn(colUpdates, _("Updates"), wxLIST_FORMAT_RIGHT);
+    InsertColumn(colDeletes, _("Deletes"), wxLIST_FORMAT_RIGHT);
+    InsertColumn(colBackouts, _("Backouts"), wxLIST_FORMAT_RIGHT);
+    InsertColumn(colPurges, _("Purges"), wxLIST_FORMAT_RIGHT);
+    InsertColumn(colExpunges, _("Expunges"), wxLIST_FORMAT_RIGHT);
+    SetColumnWidth(colRelation, 200);
+}
+
+void RelationIOListCtrl::setCounts(const std::vector<RelationIOCounts>& counts)
+{
+    countsM = counts;
+    sortCounts();
+    fillItems();
+}
+
+void RelationIOListCtrl::clearCounts()
+{
+    countsM.clear();
+    DeleteAllItems();
+}
+
+bool RelationIOListCtrl::hasCounts() const
+{
+    return !countsM.empty();
+}
+
+void RelationIOListCtrl::sortCounts()
+{
+    std::stable_sort(countsM.begin(), countsM.end(),
+        RelationIOCountsSorter(sortColumnM, sortAscendingM));
+}
+
+void RelationIOListCtrl::fillItems()
+{
+    Freeze();
+    DeleteAllItems();
+    for (size_t i = 0; i < countsM.size(); ++i)
+    {
+        long item = InsertItem(long(i), countsM[i].relationName);
+        for (int col = colSeqReads; col < colCount; ++col)
+        {
+            SetItem(item, col, wxString::Format("%d",
+                getCountValue(countsM[i].counts, col)));
+        }
+    }
+    Thaw();
+}
+
+bool RelationIOListCtrl::exportToCsv(const wxString& fileName) const
+{
+    wxFFile file(fileName, "w");
+    if (!file.IsOpened())
+        return false;
+
+    wxString csv("relation,non_indexed_reads,indexed_reads,inserts,updates,"
+        "deletes,backouts,purges,expunges\n");
+    for (std::vector<RelationIOCounts>::const_iterator it = countsM.begin();
+        it != countsM.end(); ++it)
+    {
+        wxString name((*it).relationName);
+        name.Replace("\"", "\"\"");
+        csv += "\"" + name + "\"";
+        for (int col = colSeqReads; col < colCount; ++col)
+            csv += wxString::Format(",%d", getCountValue((*it).counts, col));
+        csv += "\n";
+    }
+    return file.Write(csv);
+}
+
+/*static*/
+std::vector<int> RelationIOListCtrl::getChangedRelations(
+    const IBPP::DatabaseCounts& before, const IBPP::DatabaseCounts& after,
+    std::vector<IBPP::CountInfo>& deltas)
+{
+    std::vector<int> ids;
+    deltas.clear();
+    for (IBPP::DatabaseCounts::const_iterator it = after.begin();
+        it != after.end(); ++it)
+    {
+        IBPP::CountInfo c1;
+        IBPP::DatabaseCounts::const_iterator it1 = before.find((*it).first);
+        if (it1 != before.end())
+            c1 = (*it1).second;
+        const IBPP::CountInfo& c2 = (*it).second;
+
+        IBPP::CountInfo delta;
+        delta.inserts = c2.inserts - c1.inserts;
+        delta.updates = c2.updates - c1.updates;
+        delta.deletes = c2.deletes - c1.deletes;
+        delta.seqReads = c2.seqReads - c1.seqReads;
+        delta.idxReads = c2.idxReads - c1.idxReads;
+        delta.backouts = c2.backouts - c1.backouts;
+        delta.purges = c2.purges - c1.purges;
+        delta.expunges = c2.expunges - c1.expunges;
+        if (delta.inserts || delta.updates || delta.deletes
+            || delta.seqReads || delta.idxReads || delta.backouts
+            || delta.purges || delta.expunges)
+        {
+            ids.push_back((*it).first);
+            deltas.push_back(delta);
+        }
+    }
+    return ids;
+}
+
+BEGIN_EVENT_TABLE(RelationIOListCtrl, wxListCtrl)
+    EVT_LIST_COL_CLICK(wxID_ANY, RelationIOListCtrl::OnColumnClick)
+    EVT_CONTEXT_MENU(RelationIOListCtrl::OnContextMenu)
+    EVT_MENU(ID_EXPORT, RelationIOListCtrl::OnExport)
+    EVT_UPDATE_UI(ID_EXPORT, RelationIOListCtrl::OnUpdateExport)
+END_EVENT_TABLE()
+
+void RelationIOListCtrl::OnColumnClick(wxListEvent& event)
+{
+    int column = event.GetColumn();
+    if (column < 0)
+        return;
+    // clicking the same column again reverses the sort order, counts are
+    // initially sorted descending, names ascending
+    if (column == sortColumnM)
+        sortAscendingM = !sortAscendingM;
+    else
+    {
+        sortColumnM = column;
+        sortAscendingM = (column == colRelation);
+    }
+    sortCounts();
+    fillItems();
+}
+
+void RelationIOListCtrl::OnContextMenu(wxContextMenuEvent& WXUNUSED(event))
+{
+    wxMenu m;
+    m.Append(ID_EXPORT, _("&Export to CSV file..."));
+    PopupMenu(&m);
+}
+
+void RelationIOListCtrl::OnExport(wxCommandEvent& WXUNUSED(event))
+{
+    wxString filename = ::wxFileSelector(_("Select a file"), "",
+        "table_io.csv", "csv", _("CSV files (*.csv)|*.csv|All files (*.*)|*.*"),
+        wxFD_SAVE | wxFD_OVERWRITE_PROMPT, this);
+    if (filename.IsEmpty())
+        return;
+    if (!exportToCsv(filename))
+    {
+        wxMessageBox(wxString::Format(_("Could not write file \"%s\"."),
+            filename.c_str()), _("Error"), wxOK | wxICON_ERROR, this);
+    }
+}
+
+void RelationIOListCtrl::OnUpdateExport(wxUpdateUIEvent& event)
+{
+    event.Enable(hasCounts());
+}
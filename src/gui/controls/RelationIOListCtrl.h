@@ -0,0 +1,71 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_RELATIONIOLISTCTRL_H
+#define FR_RELATIONIOLISTCTRL_H
+
+#include <wx/listctrl.h>
+
+#include <vector>
+
+#include <ibpp.h>
+
+struct RelationIOCounts
+{
+    wxString relationName;
+    IBPP::CountInfo counts;
+};
+
+// Sortable list of the per-relation record counts of a statement
+// (the difference of two IBPP::DatabaseCounts snapshots).
+class RelationIOListCtrl: public wxListCtrl
+{
+private:
+    std::vector<RelationIOCounts> countsM;
+    int sortColumnM;
+    bool sortAscendingM;
+
+    void sortCounts();
+    void fillItems();
+public:
+    RelationIOListCtrl(wxWindow* parent, wxWindowID id = wxID_ANY);
+
+    void setCounts(const std::vector<RelationIOCounts>& counts);
+    void clearCounts();
+    bool hasCounts() const;
+    bool exportToCsv(const wxString& fileName) const;
+
+    // computes the counts of all relations that differ between snapshots
+    static std::vector<int> getChangedRelations(
+        const IBPP::DatabaseCounts& before, const IBPP::DatabaseCounts& after,
+        std::vector<IBPP::CountInfo>& deltas);
+private:
+    void OnColumnClick(wxListEvent& event);
+    void OnContextMenu(wxContextMenuEvent& event);
+    void OnExport(wxCommandEvent& event);
+    void OnUpdateExport(wxUpdateUIEvent& event);
+
+    DECLARE_EVENT_TABLE()
+};
+
+#endif
@@ -1070,6 +1070,7 @@ private:
 
     // Internal Methods
     void CursorFree();
+    void CursorClosed();
 
 public:
     // Properties and Attributes Access Methods
@@ -1180,6 +1181,7 @@ public:
     int Parameters();
 
     void Plan(std::string&);
+    bool ExplainPlan(std::string&);
 
     IBPP::Database DatabasePtr() const;
     IBPP::Transaction TransactionPtr() const;
@@ -150,6 +150,16 @@ void RB::GetDetailedCounts(IBPP::DatabaseCounts& counts, char token)
             (*it).second.updates += value;
         if (token == isc_info_delete_count)
             (*it).second.deletes += value;
+        if (token == isc_info_read_seq_count)
+            (*it).second.seqReads += value;
+        if (token == isc_info_read_idx_count)
+            (*it).second.idxReads += value;
+        if (token == isc_info_backout_count)
+            (*it).second.backouts += value;
+        if (token == isc_info_purge_count)
+            (*it).second.purges += value;
+        if (token == isc_info_expunge_count)
+            (*it).second.expunges += value;
         p += 6;
         len -= 6;
 	}
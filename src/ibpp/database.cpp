@@ -343,9 +343,16 @@ void DatabaseImpl::DetailedCounts(IBPP::DatabaseCounts& counts)
     char items[] = {isc_info_insert_count,
                     isc_info_update_count,
                     isc_info_delete_count,
+                    isc_info_read_seq_count,
+                    isc_info_read_idx_count,
+                    isc_info_backout_count,
+                    isc_info_purge_count,
+                    isc_info_expunge_count,
                     isc_info_end};
     IBS status;
-    RB result(1024);
+    // 6 bytes per relation for each of the items, the buffer length
+    // passed to isc_database_info() is limited to a short
+    RB result(32767);
 
     status.Reset();
     (*gds.Call()->m_database_info)(status.Self(), &mHandle, sizeof(items), items,
@@ -356,6 +363,11 @@ void DatabaseImpl::DetailedCounts(IBPP::DatabaseCounts& counts)
     result.GetDetailedCounts(counts, isc_info_insert_count);
     result.GetDetailedCounts(counts, isc_info_update_count);
     result.GetDetailedCounts(counts, isc_info_delete_count);
+    result.GetDetailedCounts(counts, isc_info_read_seq_count);
+    result.GetDetailedCounts(counts, isc_info_read_idx_count);
+    result.GetDetailedCounts(counts, isc_info_backout_count);
+    result.GetDetailedCounts(counts, isc_info_purge_count);
+    result.GetDetailedCounts(counts, isc_info_expunge_count);
 }
 
 void DatabaseImpl::Users(std::vector<std::string>& users)
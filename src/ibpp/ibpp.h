@@ -530,10 +530,16 @@ namespace IBPP
     class CountInfo
     {
     public:
-        CountInfo(): inserts(0), updates(0), deletes(0) {}
+        CountInfo(): inserts(0), updates(0), deletes(0), seqReads(0),
+            idxReads(0), backouts(0), purges(0), expunges(0) {}
         int inserts;
         int updates;
         int deletes;
+        int seqReads;
+        int idxReads;
+        int backouts;
+        int purges;
+        int expunges;
     };
     typedef std::map<int, CountInfo> DatabaseCounts; // int = relation ID
 
@@ -772,6 +778,7 @@ namespace IBPP
         virtual int Parameters() = 0;
 
         virtual void Plan(std::string&) = 0;
+        virtual bool ExplainPlan(std::string&) = 0;
 
         virtual Database DatabasePtr() const = 0;
         virtual Transaction TransactionPtr() const = 0;
@@ -249,6 +249,38 @@ void StatementImpl::Plan(std::string& plan)
 	if (plan[0] == '\n') plan.erase(0, 1);
 }
 
+// The detailed (explained) plan is only available with Firebird 3 and
+// later, returns false if the server does not support it.
+bool StatementImpl::ExplainPlan(std::string& plan)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ExplainPlan", _("No statement has been prepared."));
+	if (mDatabase == 0)
+		throw LogicExceptionImpl("Statement::ExplainPlan", _("A Database must be attached."));
+	if (mDatabase->GetHandle() == 0)
+		throw LogicExceptionImpl("Statement::ExplainPlan", _("Database must be connected."));
+
+	IBS status;
+	RB result(32768);
+	char itemsReq[] = {isc_info_sql_explain_plan};
+
+	(*gds.Call()->m_dsql_sql_info)(status.Self(), &mHandle, 1, itemsReq,
+								   result.Size(), result.Self());
+	if (status.Errors())
+		return false;
+
+	try
+	{
+		result.GetString(isc_info_sql_explain_plan, plan);
+	}
+	catch (LogicExceptionImpl&)
+	{
+		return false;
+	}
+	if (!plan.empty() && plan[0] == '\n') plan.erase(0, 1);
+	return !plan.empty();
+}
+
 void StatementImpl::Execute(const std::string& sql)
 {
 	if (! sql.empty()) Prepare(sql);
@@ -1257,6 +1289,14 @@ void StatementImpl::DetachTransactionImpl()
 	mTransaction = 0;
 }
 
+// The cursor was closed by the end of its transaction, it must not be freed
+// again by the next Execute() of the (still prepared) statement
+void StatementImpl::CursorClosed()
+{
+	mResultSetAvailable = false;
+	mCursorOpened = false;
+}
+
 void StatementImpl::CursorFree()
 {
 	if (mCursorOpened)
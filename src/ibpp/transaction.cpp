@@ -153,11 +153,10 @@ void TransactionImpl::Commit()
         throw SQLExceptionImpl(status, "Transaction::Commit");
     mHandle = 0;    // Should be, better be sure
 
-    /*
+    // the server has closed all cursors of the transaction
     size_t i;
     for (i = mStatements.size(); i != 0; i--)
-        mStatements[i-1]->CursorFree();
-    */
+        mStatements[i-1]->CursorClosed();
 }
 
 void TransactionImpl::CommitRetain()
@@ -183,11 +182,10 @@ void TransactionImpl::Rollback()
         throw SQLExceptionImpl(status, "Transaction::Rollback");
     mHandle = 0;    // Should be, better be sure
 
-    /*
+    // the server has closed all cursors of the transaction
     size_t i;
     for (i = mStatements.size(); i != 0; i--)
-        mStatements[i-1]->CursorFree();
-    */
+        mStatements[i-1]->CursorClosed();
 }
 
 void TransactionImpl::RollbackRetain()
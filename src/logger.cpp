@@ -30,71 +30,467 @@
 #endif
 
 #include <wx/datetime.h>
-#include <wx/file.h>
+#include <wx/ffile.h>
 #include <wx/filename.h>
 
+#include <deque>
+#include <map>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
 #include "config/DatabaseConfig.h"
 #include "core/StringUtils.h"
+#include "engine/SharedAttachment.h"
 #include "frversion.h"
 #include "gui/AdvancedMessageDialog.h"
 #include "logger.h"
 #include "sql/SqlStatement.h"
 #include "metadata/database.h"
 
-bool Logger::log2database(Config *cfg, const SqlStatement& stm, Database* db)
+// statements that are queued but not yet written, and their text size
+static const size_t maxQueuedEntries = 1000;
+static const size_t maxQueuedSize = 16 * 1024 * 1024;
+// the attachments are disconnected when nothing was logged for some time
+static const int idleSeconds = 30;
+
+// A statement to be written to the log, encoded for its destination.
+struct LogEntry
 {
-    wxMBConv* conv = db->getCharsetConverter();
+    enum Destination { ldDatabase, ldFile, ldMultiFile };
+    Destination destination;
 
-    IBPP::Transaction tr = IBPP::TransactionFactory(db->getIBPPDatabase());
+    // ldDatabase: the log table is filled on a separate attachment, ids are
+    // either taken from the generator or from the custom SELECT.  The
+    // attachment is created and owned by the writer thread, IBPP handles
+    // must not be shared between threads
+    std::string attachmentKey;
+    std::string serverName;
+    std::string databaseName;
+    std::string userName;
+    std::string password;
+    std::string roleName;
+    std::string charset;
+    std::string customSelect;
+    bool isDDL;
+    std::string objectType;
+    std::string objectName;
+
+    // ldFile and ldMultiFile: the file name or the pattern for the numbered
+    // file names, text is UTF-8 encoded
+    wxString fileName;
+    int fileStart;
+
+    std::string text;
+};
+
+typedef boost::shared_ptr<LogEntry> LogEntryPtr;
+
+// Writes log entries in a background thread.  Consecutive entries for the
+// same database are inserted in one transaction, log files are kept open
+// until the thread is stopped.
+class LogWriter
+{
+private:
+    boost::mutex lockM;
+    boost::condition_variable changedM;
+    std::deque<LogEntryPtr> queueM;
+    // keys of the attachments to be disconnected by the writer thread
+    std::vector<std::string> releasedM;
+    size_t queuedSizeM;
+    bool writingM;
+    bool stopM;
+    size_t droppedM;
+    std::vector<wxString> errorsM;
+    boost::scoped_ptr<boost::thread> threadM;
+
+    // writer thread only, one attachment per database
+    std::map<std::string, IBPP::Database> connectedM;
+    std::map<wxString, boost::shared_ptr<wxFFile> > filesM;
+
+    void run();
+    void disconnect();
+    void disconnect(const std::string& key);
+    IBPP::Database connect(const LogEntry& entry);
+    void write(std::vector<LogEntryPtr>& entries);
+    void writeToDatabase(std::vector<LogEntryPtr>& entries, size_t& index);
+    void writeToFile(const LogEntry& entry);
+    void writeToNewFile(const LogEntry& entry);
+    void addError(const wxString& error);
+public:
+    LogWriter();
+
+    // writes all queued entries and disconnects the attachment of db
+    void release(Database* db);
+    // returns false if the entry was dropped because the queue is full
+    bool add(LogEntryPtr entry);
+    void flush();
+    void stop();
+    // returns the errors of the writer thread and the number of dropped
+    // entries since the last call
+    void getErrors(std::vector<wxString>& errors, size_t& dropped);
+};
+
+LogWriter::LogWriter()
+    : queuedSizeM(0), writingM(false), stopM(false), droppedM(0)
+{
+}
+
+static LogWriter& getLogWriter()
+{
+    static LogWriter writer;
+    return writer;
+}
+
+static std::string getAttachmentKey(Database* db)
+{
+    IBPP::Database ibppdb(db->getIBPPDatabase());
+    return std::string(ibppdb->ServerName()) + "|" + ibppdb->DatabaseName()
+        + "|" + ibppdb->Username() + "|" + ibppdb->RoleName() + "|"
+        + ibppdb->CharSet();
+}
+
+// the connection parameters are copied, so the writer thread can create
+// its own attachment
+static void setConnectionParameters(LogEntry& entry, Database* db)
+{
+    IBPP::Database ibppdb(db->getIBPPDatabase());
+    entry.attachmentKey = getAttachmentKey(db);
+    entry.serverName = ibppdb->ServerName();
+    entry.databaseName = ibppdb->DatabaseName();
+    entry.userName = ibppdb->Username();
+    entry.password = ibppdb->UserPassword();
+    entry.roleName = ibppdb->RoleName();
+    entry.charset = ibppdb->CharSet();
+}
+
+bool LogWriter::add(LogEntryPtr entry)
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    if (queueM.size() >= maxQueuedEntries
+        || queuedSizeM + entry->text.size() > maxQueuedSize)
+    {
+        ++droppedM;
+        return false;
+    }
+    queueM.push_back(entry);
+    queuedSizeM += entry->text.size();
+    if (!threadM)
+        threadM.reset(new boost::thread(boost::bind(&LogWriter::run, this)));
+    changedM.notify_all();
+    return true;
+}
+
+void LogWriter::flush()
+{
+    boost::unique_lock<boost::mutex> lock(lockM);
+    while (threadM && (writingM || !queueM.empty()))
+        changedM.wait(lock);
+}
+
+void LogWriter::release(Database* db)
+{
+    std::string key(getAttachmentKey(db));
+    boost::unique_lock<boost::mutex> lock(lockM);
+    if (!threadM)
+        return;
+    releasedM.push_back(key);
+    changedM.notify_all();
+    while (writingM || !queueM.empty() || !releasedM.empty())
+        changedM.wait(lock);
+}
+
+void LogWriter::stop()
+{
+    {
+        boost::lock_guard<boost::mutex> guard(lockM);
+        stopM = true;
+        changedM.notify_all();
+    }
+    if (threadM)
+    {
+        threadM->join();
+        threadM.reset();
+    }
+}
+
+void LogWriter::getErrors(std::vector<wxString>& errors, size_t& dropped)
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    errors.swap(errorsM);
+    errorsM.clear();
+    dropped = droppedM;
+    droppedM = 0;
+}
+
+void LogWriter::addError(const wxString& error)
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    errorsM.push_back(error);
+}
+
+// writer thread, takes all queued entries at once, writes all remaining
+// entries when stopped
+void LogWriter::run()
+{
+    while (true)
+    {
+        std::vector<LogEntryPtr> entries;
+        std::vector<std::string> released;
+        {
+            boost::unique_lock<boost::mutex> lock(lockM);
+            writingM = false;
+            changedM.notify_all();
+            boost::system_time idleTime = boost::get_system_time()
+                + boost::posix_time::seconds(idleSeconds);
+            bool idle = connectedM.empty();
+            while (!stopM && queueM.empty() && releasedM.empty())
+            {
+                if (idle)
+                    changedM.wait(lock);
+                else if (!changedM.timed_wait(lock, idleTime))
+                {
+                    lock.unlock();
+                    disconnect();
+                    lock.lock();
+                    idle = true;
+                }
+            }
+            if (queueM.empty() && releasedM.empty())
+                break;
+            entries.assign(queueM.begin(), queueM.end());
+            queueM.clear();
+            queuedSizeM = 0;
+            released.swap(releasedM);
+            writingM = true;
+        }
+        write(entries);
+        for (size_t i = 0; i < released.size(); ++i)
+            disconnect(released[i]);
+    }
+
+    disconnect();
+    filesM.clear();
+}
+
+void LogWriter::disconnect()
+{
+    for (std::map<std::string, IBPP::Database>::iterator it =
+        connectedM.begin(); it != connectedM.end(); ++it)
+    {
+        disconnectAttachment((*it).second);
+    }
+    connectedM.clear();
+}
+
+// returns the attachment for the database of entry, connects it if needed
+IBPP::Database LogWriter::connect(const LogEntry& entry)
+{
+    std::map<std::string, IBPP::Database>::iterator it =
+        connectedM.find(entry.attachmentKey);
+    if (it != connectedM.end() && (*it).second->Connected())
+        return (*it).second;
+    IBPP::Database db(IBPP::DatabaseFactory(entry.serverName,
+        entry.databaseName, entry.userName, entry.password, entry.roleName,
+        entry.charset, ""));
+    db->Connect();
+    connectedM[entry.attachmentKey] = db;
+    return db;
+}
+
+void LogWriter::disconnect(const std::string& key)
+{
+    std::map<std::string, IBPP::Database>::iterator it = connectedM.find(key);
+    if (it == connectedM.end())
+        return;
+    disconnectAttachment((*it).second);
+    connectedM.erase(it);
+}
+
+void LogWriter::write(std::vector<LogEntryPtr>& entries)
+{
+    for (size_t i = 0; i < entries.size(); )
+    {
+        if (entries[i]->destination == LogEntry::ldDatabase)
+        {
+            writeToDatabase(entries, i);
+            continue;
+        }
+        if (entries[i]->destination == LogEntry::ldFile)
+            writeToFile(*entries[i]);
+        else
+            writeToNewFile(*entries[i]);
+        ++i;
+    }
+    // the data of the open files is written at the end of every batch
+    for (std::map<wxString, boost::shared_ptr<wxFFile> >::iterator it =
+        filesM.begin(); it != filesM.end(); ++it)
+    {
+        (*it).second->Flush();
+    }
+}
+
+// writes the entries for the database of entries[index] up to the first
+// entry for another destination, index is set to that entry
+void LogWriter::writeToDatabase(std::vector<LogEntryPtr>& entries,
+    size_t& index)
+{
+    size_t first = index;
+    std::string key(entries[first]->attachmentKey);
+    while (index < entries.size()
+        && entries[index]->destination == LogEntry::ldDatabase
+        && entries[index]->attachmentKey == key)
+    {
+        ++index;
+    }
+    int count = int(index - first);
     try
     {
+        IBPP::Database db(connect(*entries[first]));
+        IBPP::Transaction tr = IBPP::TransactionFactory(db);
         tr->Start();
-        IBPP::Statement st = IBPP::StatementFactory(db->getIBPPDatabase(), tr);
+        IBPP::Statement st = IBPP::StatementFactory(db, tr);
 
-        // find next id
-        wxString sql = "SELECT gen_id(FLAMEROBIN$LOG_GEN, 1) FROM rdb$database";
-        if (cfg->get("LoggingUsesCustomSelect", false))
+        // with the generator all ids are reserved at once, the custom
+        // SELECT may use anything and is run for every entry, it sees the
+        // rows inserted before in the same transaction
+        int id = 1;
+        IBPP::Statement idSt;
+        if (entries[first]->customSelect.empty())
         {
-            sql = cfg->get("LoggingCustomSelect",
-                wxString("SELECT 1+MAX(ID) FROM FLAMEROBIN$LOG"));
+            st->Prepare(wx2std(wxString::Format(
+                "SELECT gen_id(FLAMEROBIN$LOG_GEN, %d) FROM rdb$database",
+                count)));
+            st->Execute();
+            if (st->Fetch() && !st->IsNull(1))
+                st->Get(1, id);
+            id -= count - 1;
+        }
+        else
+        {
+            idSt = IBPP::StatementFactory(db, tr);
+            idSt->Prepare(entries[first]->customSelect);
         }
-        st->Prepare(wx2std(sql, conv));
-        st->Execute();
-        int cnt = 1;
-        if (st->Fetch() && !st->IsNull(1))
-            st->Get(1, cnt);
 
         st->Prepare("INSERT INTO FLAMEROBIN$LOG (id, object_type, \
             object_name, sql_statement) values (?,?,?,?)");
-        st->Set(1, cnt);
-        if (stm.isDDL())
+        for (size_t i = first; i < index; ++i, ++id)
         {
-            st->Set(2, wx2std(getNameOfType(stm.getObjectType()), conv));
-            st->Set(3, wx2std(stm.getName(), conv));
-        }
-        else
-        {
-            st->SetNull(2);
-            st->SetNull(3);
+            const LogEntry& entry(*entries[i]);
+            if (idSt != 0)
+            {
+                id = 1;
+                idSt->Execute();
+                if (idSt->Fetch() && !idSt->IsNull(1))
+                    idSt->Get(1, id);
+            }
+            st->Set(1, id);
+            if (entry.isDDL)
+            {
+                st->Set(2, entry.objectType);
+                st->Set(3, entry.objectName);
+            }
+            else
+            {
+                st->SetNull(2);
+                st->SetNull(3);
+            }
+            IBPP::Blob bl = IBPP::BlobFactory(db, tr);
+            bl->Save(entry.text);
+            st->Set(4, bl);
+            st->Execute();
         }
-        IBPP::Blob bl = IBPP::BlobFactory(st->DatabasePtr(), tr);
-        bl->Save(wx2std(stm.getStatement(), conv));
-        st->Set(4, bl);
-        st->Execute();
         tr->Commit();
-        return true;
     }
-    catch (IBPP::Exception &e)
+    catch (std::exception& e)
     {
-        showWarningDialog(0, _("Logging to database failed"),
-            wxString(e.what(), *conv), AdvancedMessageDialogButtonsOk());
+        addError(_("Logging to database failed") + "\n\n"
+            + wxString(e.what(), *wxConvCurrent));
     }
     catch (...)
     {
-        showWarningDialog(0, _("Logging to database failed"),
-            _("Unexpected C++ exception"), AdvancedMessageDialogButtonsOk());
+        addError(_("Logging to database failed") + "\n\n"
+            + _("Unexpected C++ exception"));
     }
-    return false;
+}
+
+void LogWriter::writeToFile(const LogEntry& entry)
+{
+    boost::shared_ptr<wxFFile>& f = filesM[entry.fileName];
+    if (!f || !f->IsOpened())
+    {
+        f.reset(new wxFFile(entry.fileName, "ab"));
+        if (!f->IsOpened())
+        {
+            f.reset();
+            addError(_("Logging to file failed") + "\n\n"
+                + _("Cannot open log file for writing."));
+            return;
+        }
+    }
+    if (f->Write(entry.text.data(), entry.text.size()) != entry.text.size())
+    {
+        f.reset();
+        addError(_("Logging to file failed") + "\n\n"
+            + _("Cannot write to log file."));
+    }
+}
+
+// filename should contain stuff like: %d, %02d, %05d, etc.
+void LogWriter::writeToNewFile(const LogEntry& entry)
+{
+    wxFFile f;
+    wxString test;
+    for (int i = entry.fileStart; i < 100000; ++i) // dummy test for 100000
+    {
+        test.Printf(entry.fileName, i);
+        wxFileName fn(test);
+
+        if (!wxDirExists(fn.GetPath()))  // directory doesn't exist
+        {
+            addError(_("Logging to file failed") + "\n\n"
+                + wxString::Format(_("Directory %s does not exist"),
+                    fn.GetPath().c_str()));
+            return;
+        }
+
+        if (!wxFileExists(test))
+        {
+            if (f.Open(test, "wb"))
+                break;
+        }
+    }
+    if (!f.IsOpened()
+        || f.Write(entry.text.data(), entry.text.size()) != entry.text.size())
+    {
+        addError(_("Logging to file failed") + "\n\n"
+            + _("Cannot open log file."));
+    }
+}
+
+bool Logger::log2database(Config *cfg, const SqlStatement& stm, Database* db)
+{
+    wxMBConv* conv = db->getCharsetConverter();
+
+    LogEntryPtr entry(new LogEntry);
+    entry->destination = LogEntry::ldDatabase;
+    setConnectionParameters(*entry, db);
+    if (cfg->get("LoggingUsesCustomSelect", false))
+    {
+        entry->customSelect = wx2std(cfg->get("LoggingCustomSelect",
+            wxString("SELECT 1+MAX(ID) FROM FLAMEROBIN$LOG")), conv);
+    }
+    entry->isDDL = stm.isDDL();
+    if (entry->isDDL)
+    {
+        entry->objectType = wx2std(getNameOfType(stm.getObjectType()), conv);
+        entry->objectName = wx2std(stm.getName(), conv);
+    }
+    entry->text = wx2std(stm.getStatement(), conv);
+    getLogWriter().add(entry);
+    return true;
 }
 
 bool Logger::log2file(Config *cfg, const SqlStatement& st,
@@ -116,7 +512,9 @@ bool Logger::log2file(Config *cfg, const SqlStatement& st,
             sql += st.getTerminator();
     }
 
-    wxFile f;
+    LogEntryPtr entry(new LogEntry);
+    entry->destination = LogEntry::ldFile;
+    entry->fileName = filename;
     if (logToFileType == multiFile)
     {   // filename should contain stuff like: %d, %02d, %05d, etc.
         if (filename.find_last_of("%") == wxString::npos) // % not found
@@ -126,69 +524,61 @@ bool Logger::log2file(Config *cfg, const SqlStatement& st,
                 AdvancedMessageDialogButtonsOk());
             return false;
         }
-        wxString test;
-        int start = 1;
-        cfg->getValue("IncrementalLogFileStart", start);
-        for (int i=start; i < 100000; ++i) // dummy test for 100000
-        {
-            test.Printf(filename, i);
-            wxFileName fn(test);
-
-            if (!wxDirExists(fn.GetPath()))  // directory doesn't exist
-            {
-                showWarningDialog(0, _("Logging to file failed"),
-                    wxString::Format(_("Directory %s does not exist"), fn.GetPath().c_str()),
-                    AdvancedMessageDialogButtonsOk());
-                return false;
-            }
-
-            if (!wxFileExists(test))
-            {
-                if (f.Open(test, wxFile::write))
-                    break;
-            }
-        }
-        if (!f.IsOpened())
-        {
-            showWarningDialog(0, _("Logging to file failed"),
-                _("Cannot open log file."), AdvancedMessageDialogButtonsOk());
-            return false;
-        }
-    }
-    else if (!f.Open(filename, wxFile::write_append )) // cannot open
-    {
-        showWarningDialog(0, _("Logging to file failed"),
-            _("Cannot open log file for writing."),
-            AdvancedMessageDialogButtonsOk());
-        return false;
+        entry->destination = LogEntry::ldMultiFile;
+        entry->fileStart = 1;
+        cfg->getValue("IncrementalLogFileStart", entry->fileStart);
     }
 
+    wxString text;
     bool loggingAddHeader = true;
     cfg->getValue("LoggingAddHeader", loggingAddHeader);
     if (loggingAddHeader)
     {
-        wxString header = wxString::Format(
+        text = wxString::Format(
             _("\n/* Logged by FlameRobin %d.%d.%d at %s\n   User: %s    Database: %s */\n"),
             FR_VERSION_MAJOR, FR_VERSION_MINOR, FR_VERSION_RLS,
             wxDateTime::Now().Format().c_str(),
             db->getUsername().c_str(),
             db->getPath().c_str()
         );
-        f.Write(header);
     }
     else
-        f.Write("\n");
+        text = "\n";
     if (logSetTerm && st.getTerminator() != ";")
-        f.Write("SET TERM " + st.getTerminator() + " ;\n");
-    f.Write(sql);
+        text += "SET TERM " + st.getTerminator() + " ;\n";
+    text += sql;
     if (logSetTerm && st.getTerminator() != ";")
-        f.Write("\nSET TERM ; " + st.getTerminator() + "\n");
-    f.Close();
+        text += "\nSET TERM ; " + st.getTerminator() + "\n";
+    entry->text = wx2std(text, &wxConvUTF8);
+    getLogWriter().add(entry);
     return true;
 }
 
+// shows the errors of the writer thread and the number of dropped entries
+void Logger::reportErrors()
+{
+    std::vector<wxString> errors;
+    size_t dropped;
+    getLogWriter().getErrors(errors, dropped);
+    if (dropped)
+    {
+        showWarningDialog(0, _("Logging failed"),
+            wxString::Format(_("%d statements were not logged, because too many statements were waiting to be written."),
+                int(dropped)),
+            AdvancedMessageDialogButtonsOk());
+    }
+    for (size_t i = 0; i < errors.size(); ++i)
+    {
+        showWarningDialog(0, errors[i].BeforeFirst('\n'),
+            errors[i].AfterFirst('\n').Strip(wxString::leading),
+            AdvancedMessageDialogButtonsOk());
+    }
+}
+
 bool Logger::logStatement(const SqlStatement& st, Database* db)
 {
+    // earlier failures don't keep this statement from being logged
+    reportErrors();
     DatabaseConfig dc(db, config());
     bool result = logStatementByConfig(&dc, st, db);
     if (!dc.get("ExcludeFromGlobalLogging", false))
@@ -199,6 +589,22 @@ bool Logger::logStatement(const SqlStatement& st, Database* db)
     return result;
 }
 
+void Logger::flush()
+{
+    getLogWriter().flush();
+    reportErrors();
+}
+
+void Logger::releaseDatabase(Database* db)
+{
+    getLogWriter().release(db);
+}
+
+void Logger::shutdown()
+{
+    getLogWriter().stop();
+}
+
 bool Logger::prepareDatabase(Database *db)
 {
     IBPP::Transaction tr = IBPP::TransactionFactory(db->getIBPPDatabase());
@@ -280,4 +686,3 @@ bool Logger::logStatementByConfig(Config* cfg, const SqlStatement& st,
     }
     return true;
 }
-
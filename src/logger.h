@@ -32,6 +32,12 @@ class SqlStatement;
 class Database;
 class Config;
 
+// The statements are formatted in the calling (main) thread and written in a
+// background thread, so logging never waits for the database or the disk.
+// Statements logged to a database are inserted in batches on a separate
+// attachment, log files are kept open.  If the queue of unwritten
+// statements is full new statements are dropped, errors and dropped
+// statements are reported on the next call.
 class Logger            // maybe we'll extend this later
 {
 private:
@@ -39,8 +45,16 @@ private:
     static bool log2database(Config *, const SqlStatement& st, Database *db);
     static bool log2file(Config *, const SqlStatement& st, Database *db, const wxString& filename);
     static bool logStatementByConfig(Config *cfg, const SqlStatement& st, Database *db);
+    static void reportErrors();
 public:
     static bool logStatement(const SqlStatement& st, Database *db);
+    // waits until all logged statements have been written
+    static void flush();
+    // writes the logged statements of the database and disconnects its log
+    // attachment, must be called before the database is disconnected
+    static void releaseDatabase(Database *db);
+    // writes all logged statements and stops the background thread
+    static void shutdown();
 };
 
 #endif
@@ -77,6 +77,16 @@ wxString CreateDDLVisitor::getSuffixSql() const
     return postSqlM + grantSqlM;
 }
 
+wxString CreateDDLVisitor::getPostSql() const
+{
+    return postSqlM;
+}
+
+wxString CreateDDLVisitor::getGrantSql() const
+{
+    return grantSqlM;
+}
+
 // this one is not called from "outside", but from visit(Table) function
 void CreateDDLVisitor::visitColumn(Column& c)
 {
@@ -169,6 +179,8 @@ void CreateDDLVisitor::visitDatabase(Database& d)
 
     try
     {
+        d.loadSchemaDetails();
+
         preSqlM << "/********************* ROLES **********************/\n\n";
         iterateit<RolesPtr, Role>(this, d.getRoles(), progressIndicatorM);
 
@@ -46,6 +46,9 @@ public:
     wxString getSql() const;
     wxString getPrefixSql() const;
     wxString getSuffixSql() const;
+    // the two parts of the suffix, kept apart in database scripts
+    wxString getPostSql() const;
+    wxString getGrantSql() const;
 
     virtual void visitColumn(Column& column);
     virtual void visitDatabase(Database& database);
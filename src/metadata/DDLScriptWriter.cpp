@@ -0,0 +1,392 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <utility>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "core/FRError.h"
+#include "core/ProgressIndicator.h"
+#include "engine/MetadataLoader.h"
+#include "metadata/CreateDDLVisitor.h"
+#include "metadata/DDLScriptWriter.h"
+#include "metadata/DependencyGraph.h"
+#include "metadata/domain.h"
+#include "metadata/exception.h"
+#include "metadata/function.h"
+#include "metadata/generator.h"
+#include "metadata/procedure.h"
+#include "metadata/role.h"
+#include "metadata/table.h"
+#include "metadata/trigger.h"
+#include "metadata/view.h"
+
+// Writes the parts of the script to three temporary files in a background
+// thread, and appends the last two to the first one at the end.  The first
+// one is created next to the output file and renamed to it when the script
+// is complete, so an existing file is only replaced by a complete script.
+// The text is converted to UTF-8 before it is queued, so no wxString
+// instances are shared between the threads.
+class ScriptFileWriter
+{
+public:
+    enum Part { partCreate, partAlter, partGrant, partCount };
+private:
+    wxString fileNameM;
+    wxString tempFileNamesM[partCount];
+    wxFFile filesM[partCount];
+
+    boost::shared_ptr<boost::thread> threadM;
+    boost::mutex lockM;
+    boost::condition_variable changedM;
+    std::deque<std::pair<int, std::string> > queueM;
+    bool finishM;
+    bool cancelM;
+    std::string errorM;
+
+    void run();
+    bool writeData(Part part, const std::string& data);
+    bool appendFile(Part part);
+    bool setError(const char* message, Part part);
+    void checkError();
+    void removeTempFiles();
+public:
+    ScriptFileWriter(const wxString& fileName);
+    // leaves the output file alone unless finish() has been successful
+    ~ScriptFileWriter();
+
+    void write(Part part, const wxString& text);
+    // waits until everything has been written, throws on write errors
+    void finish();
+};
+
+// limits the memory used for text that has not been written yet
+static const size_t maxQueuedChunks = 256;
+static const size_t fileBufferSize = 1024 * 1024;
+
+ScriptFileWriter::ScriptFileWriter(const wxString& fileName)
+    : fileNameM(fileName), finishM(false), cancelM(false)
+{
+    // in the same directory, so it can be renamed
+    wxFileName outputName(fileName);
+    outputName.MakeAbsolute();
+    wxString outputPrefix(outputName.GetPathWithSep() + "fr");
+    for (int i = partCreate; i < partCount; ++i)
+    {
+        tempFileNamesM[i] = wxFileName::CreateTempFileName(
+            (i == partCreate) ? outputPrefix : wxString("fr"), &filesM[i]);
+        if (tempFileNamesM[i].empty())
+        {
+            removeTempFiles();
+            if (i == partCreate)
+                throw FRError(_("Can not open file: ") + fileName);
+            throw FRError(_("Can not create temporary file."));
+        }
+        setvbuf(filesM[i].fp(), 0, _IOFBF, fileBufferSize);
+    }
+
+    threadM.reset(new boost::thread(
+        boost::bind(&ScriptFileWriter::run, this)));
+}
+
+ScriptFileWriter::~ScriptFileWriter()
+{
+    {
+        boost::lock_guard<boost::mutex> guard(lockM);
+        cancelM = true;
+    }
+    changedM.notify_all();
+    if (threadM)
+        threadM->join();
+    removeTempFiles();
+}
+
+void ScriptFileWriter::removeTempFiles()
+{
+    for (int i = partCreate; i < partCount; ++i)
+    {
+        filesM[i].Close();
+        if (!tempFileNamesM[i].empty())
+            wxRemoveFile(tempFileNamesM[i]);
+        tempFileNamesM[i].clear();
+    }
+}
+
+void ScriptFileWriter::write(Part part, const wxString& text)
+{
+    if (text.empty())
+        return;
+    std::string data(text.utf8_str());
+
+    boost::unique_lock<boost::mutex> lock(lockM);
+    while (queueM.size() >= maxQueuedChunks && errorM.empty())
+        changedM.wait(lock);
+    if (!errorM.empty())
+    {
+        lock.unlock();
+        checkError();
+    }
+    queueM.push_back(std::make_pair(int(part), std::string()));
+    queueM.back().second.swap(data);
+    changedM.notify_all();
+}
+
+void ScriptFileWriter::finish()
+{
+    {
+        boost::lock_guard<boost::mutex> guard(lockM);
+        finishM = true;
+    }
+    changedM.notify_all();
+    threadM->join();
+    checkError();
+
+    if (!filesM[partCreate].Close()
+        || !wxRenameFile(tempFileNamesM[partCreate], fileNameM, true))
+    {
+        throw FRError(_("Can not write to file: ") + fileNameM);
+    }
+    tempFileNamesM[partCreate].clear();
+}
+
+void ScriptFileWriter::checkError()
+{
+    wxString msg;
+    {
+        boost::lock_guard<boost::mutex> guard(lockM);
+        if (errorM.empty())
+            return;
+        msg = wxString(errorM.c_str(), wxConvUTF8);
+    }
+    throw FRError(msg);
+}
+
+void ScriptFileWriter::run()
+{
+    while (true)
+    {
+        std::pair<int, std::string> chunk;
+        {
+            boost::unique_lock<boost::mutex> lock(lockM);
+            while (queueM.empty() && !finishM && !cancelM)
+                changedM.wait(lock);
+            if (cancelM)
+                return;
+            if (queueM.empty())
+                break;  // finished
+            chunk.first = queueM.front().first;
+            chunk.second.swap(queueM.front().second);
+            queueM.pop_front();
+        }
+        changedM.notify_all();
+
+        if (!writeData(Part(chunk.first), chunk.second))
+            return;
+    }
+
+    // same layout as the script created by CreateDDLVisitor::visitDatabase()
+    if (writeData(partCreate, "\n"))
+    {
+        if (appendFile(partAlter))
+            appendFile(partGrant);
+    }
+}
+
+bool ScriptFileWriter::writeData(Part part, const std::string& data)
+{
+    if (fwrite(data.data(), 1, data.size(), filesM[part].fp()) == data.size())
+        return true;
+    return setError("Can not write to file: ", part);
+}
+
+// always returns false, to be returned by the failing method
+bool ScriptFileWriter::setError(const char* message, Part part)
+{
+    boost::lock_guard<boost::mutex> guard(lockM);
+    errorM = message;
+    errorM += (part == partCreate) ? std::string(fileNameM.utf8_str())
+        : std::string(tempFileNamesM[part].utf8_str());
+    changedM.notify_all();
+    return false;
+}
+
+bool ScriptFileWriter::appendFile(Part part)
+{
+    FILE* source = filesM[part].fp();
+    if (fflush(source) != 0 || fseek(source, 0, SEEK_SET) != 0)
+        return setError("Can not read from file: ", part);
+
+    std::string buffer(64 * 1024, '\0');
+    while (size_t count = fread(&buffer[0], 1, buffer.size(), source))
+    {
+        if (!writeData(partCreate, buffer.substr(0, count)))
+            return false;
+        boost::lock_guard<boost::mutex> guard(lockM);
+        if (cancelM)
+            return false;
+    }
+    if (ferror(source))
+        return setError("Can not read from file: ", part);
+    return true;
+}
+
+DDLScriptWriter::DDLScriptWriter(DatabasePtr database,
+        ProgressIndicator* progressIndicator)
+    : databaseM(database), progressIndicatorM(progressIndicator)
+{
+}
+
+template <class C>
+void getItems(C collection, std::vector<MetadataItem*>& items)
+{
+    wxASSERT(collection);
+    items.clear();
+    collection->getChildren(items);
+}
+
+void DDLScriptWriter::writeSection(ScriptFileWriter& writer,
+    const wxString& header, const wxString& name,
+    std::vector<MetadataItem*>& items)
+{
+    ProgressIndicator* pi = progressIndicatorM;
+    if (pi)
+    {
+        pi->setProgressMessage(_("Extracting ") + name);
+        pi->stepProgress();
+        pi->initProgress(wxEmptyString, items.size(), 0, 2);
+    }
+
+    writer.write(ScriptFileWriter::partCreate, header);
+    for (std::vector<MetadataItem*>::iterator it = items.begin();
+        it != items.end(); ++it)
+    {
+        if (pi)
+        {
+            checkProgressIndicatorCanceled(pi);
+            pi->setProgressMessage(_("Extracting ") + (*it)->getName_(), 2);
+            pi->stepProgress(1, 2);
+        }
+        CreateDDLVisitor cdv;
+        (*it)->acceptVisitor(&cdv);
+        writer.write(ScriptFileWriter::partCreate, cdv.getPrefixSql());
+        writer.write(ScriptFileWriter::partAlter, cdv.getPostSql());
+        writer.write(ScriptFileWriter::partGrant, cdv.getGrantSql());
+    }
+}
+
+bool DDLScriptWriter::writeTo(const wxString& fileName)
+{
+    ProgressIndicator* pi = progressIndicatorM;
+    if (pi)
+        pi->initProgress(wxEmptyString, 10, 0, 1);
+
+    ScriptFileWriter writer(fileName);
+    try
+    {
+        // use a single read-only transaction for metadata loading
+        MetadataLoaderTransaction tr(databaseM->getMetadataLoader());
+        databaseM->loadSchemaDetails();
+
+        std::vector<MetadataItem*> items;
+        getItems(databaseM->getRoles(), items);
+        writeSection(writer,
+            "/********************* ROLES **********************/\n\n",
+            databaseM->getRoles()->getName_(), items);
+
+        getItems(databaseM->getFunctions(), items);
+        writeSection(writer,
+            "/********************* UDFS ***********************/\n\n",
+            databaseM->getFunctions()->getName_(), items);
+
+        getItems(databaseM->getGenerators(), items);
+        writeSection(writer,
+            "/****************** SEQUENCES ********************/\n\n",
+            databaseM->getGenerators()->getName_(), items);
+
+        getItems(databaseM->getDomains(), items);
+        writeSection(writer,
+            "/******************** DOMAINS *********************/\n\n",
+            databaseM->getDomains()->getName_(), items);
+
+        getItems(databaseM->getProcedures(), items);
+        writeSection(writer,
+            "/******************* PROCEDURES ******************/\n\n",
+            databaseM->getProcedures()->getName_(), items);
+
+        getItems(databaseM->getTables(), items);
+        writeSection(writer,
+            "/******************** TABLES **********************/\n\n",
+            databaseM->getTables()->getName_(), items);
+
+        // views may select from other views, so they need to be created
+        // after the views they depend on
+        getItems(databaseM->getViews(), items);
+        databaseM->getDependencyGraph().sortTopologically(items, false);
+        writeSection(writer,
+            "/********************* VIEWS **********************/\n\n",
+            databaseM->getViews()->getName_(), items);
+
+        getItems(databaseM->getExceptions(), items);
+        writeSection(writer,
+            "/******************* EXCEPTIONS *******************/\n\n",
+            databaseM->getExceptions()->getName_(), items);
+
+        getItems(databaseM->getTriggers(), items);
+        writeSection(writer,
+            "/******************** TRIGGERS ********************/\n\n",
+            databaseM->getTriggers()->getName_(), items);
+
+        if (pi)
+            pi->setProgressMessage(_("Writing file..."));
+        writer.finish();
+    }
+    catch (CancelProgressException&)
+    {
+        // this is expected if user cancels the extraction
+        return false;
+    }
+
+    if (pi)
+    {
+        pi->initProgress(_("Extraction complete."), 1, 1);
+        pi->initProgress(_("Done."), 1, 1, 2);
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_DDLSCRIPTWRITER_H
+#define FR_DDLSCRIPTWRITER_H
+
+#include <vector>
+
+#include "metadata/database.h"
+
+class ProgressIndicator;
+class ScriptFileWriter;
+
+// Writes the DDL script of an entire database to a file, object by object,
+// so the script never has to be kept in memory as a whole.  The parts of
+// the script (CREATE statements, ALTER statements and comments, grants) go
+// to separate files in a background thread and are joined at the end.
+class DDLScriptWriter
+{
+private:
+    DatabasePtr databaseM;
+    ProgressIndicator* progressIndicatorM;
+
+    void writeSection(ScriptFileWriter& writer, const wxString& header,
+        const wxString& name, std::vector<MetadataItem*>& items);
+public:
+    DDLScriptWriter(DatabasePtr database,
+        ProgressIndicator* progressIndicator = 0);
+
+    // returns false if the extraction has been canceled, the file is not
+    // created or changed then (and on errors)
+    bool writeTo(const wxString& fileName);
+};
+
+#endif // FR_DDLSCRIPTWRITER_H
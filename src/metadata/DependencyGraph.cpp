@@ -0,0 +1,542 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+#include <deque>
+
+#include "core/FRError.h"
+#include "core/StringUtils.h"
+#include "engine/MetadataLoader.h"
+#include "metadata/database.h"
+#include "metadata/DependencyGraph.h"
+
+namespace
+{
+
+// dependencies of all objects: RDB$DEPENDENCIES, computed columns (which
+// depend on other objects through their RDB$ domain) and view columns
+// columns: dependent type and name, depended-on type and name, field of
+// the depended-on object, field listed for the dependent object
+const char* dependenciesSql[] = {
+    "select d.rdb$dependent_type, d.rdb$dependent_name, "
+    "  d.rdb$depended_on_type, d.rdb$depended_on_name, "
+    "  d.rdb$field_name, d.rdb$field_name "
+    "from rdb$dependencies d ",
+        "where d.rdb$dependent_name = ? ",
+    "union all "
+    "select cast(0 as smallint), f.rdb$relation_name, "
+    "  d.rdb$depended_on_type, d.rdb$depended_on_name, "
+    "  d.rdb$field_name, f.rdb$field_name "
+    "from rdb$relation_fields f "
+    "join rdb$dependencies d on d.rdb$dependent_name = f.rdb$field_source "
+    "where d.rdb$dependent_type = 3 ",
+        "and f.rdb$relation_name = ? ",
+    "union all "
+    "select cast(1 as smallint), f.rdb$relation_name, "
+    "  cast(0 as smallint), vr.rdb$relation_name, "
+    "  f.rdb$base_field, f.rdb$base_field "
+    "from rdb$relation_fields f "
+    "join rdb$view_relations vr on f.rdb$view_context = vr.rdb$view_context "
+    "  and f.rdb$relation_name = vr.rdb$view_name ",
+        "where vr.rdb$view_name = ? "
+};
+
+const char* foreignKeysSql =
+    "select r1.rdb$relation_name, i1.rdb$field_name, "
+    "  r2.rdb$relation_name, i2.rdb$field_name "
+    "from rdb$relation_constraints r1 "
+    "join rdb$ref_constraints c "
+    "  on r1.rdb$constraint_name = c.rdb$constraint_name "
+    "join rdb$relation_constraints r2 "
+    "  on c.rdb$const_name_uq = r2.rdb$constraint_name "
+    "join rdb$index_segments i1 on r1.rdb$index_name = i1.rdb$index_name "
+    "join rdb$index_segments i2 on r2.rdb$index_name = i2.rdb$index_name "
+    "  and i1.rdb$field_position = i2.rdb$field_position "
+    "where r1.rdb$constraint_type = 'FOREIGN KEY' ";
+
+const char* checkTriggersSql =
+    "select distinct c.rdb$trigger_name, r.rdb$relation_name "
+    "from rdb$relation_constraints r "
+    "join rdb$check_constraints c "
+    "  on r.rdb$constraint_name = c.rdb$constraint_name "
+    "where r.rdb$constraint_type = 'CHECK' ";
+
+// the statement for all objects, or with the conditions for a single one
+std::string getDependenciesSql(bool singleObject)
+{
+    std::string sql;
+    for (size_t i = 0; i < sizeof(dependenciesSql) / sizeof(char*); ++i)
+    {
+        if (i % 2 == 0 || singleObject)
+            sql += dependenciesSql[i];
+    }
+    return sql;
+}
+
+} // namespace
+
+DependencyGraph::DependencyGraph(Database* database)
+    : databaseM(database), loadedM(false)
+{
+}
+
+NodeType DependencyGraph::getKind(NodeType type)
+{
+    switch (type)
+    {
+        case ntTable:
+        case ntSysTable:
+        case ntView:
+            return ntTable;
+        case ntTrigger:
+        case ntProcedure:
+        case ntException:
+        case ntGenerator:
+        case ntFunction:
+            return type;
+        default:
+            return ntUnknown;
+    }
+}
+
+// maps RDB$DEPENDENT_TYPE and RDB$DEPENDED_ON_TYPE to the object kind,
+// other types (domains, indices, ...) are not interesting for us
+NodeType DependencyGraph::getKindOfDependencyType(int type)
+{
+    switch (type)
+    {
+        case 0:
+        case 1:
+            return ntTable;
+        case 2:
+            return ntTrigger;
+        case 5:
+            return ntProcedure;
+        case 7:
+            return ntException;
+        case 14:
+            return ntGenerator;
+        case 15:
+            return ntFunction;
+        default:
+            return ntUnknown;
+    }
+}
+
+DependencyGraph::ObjectKey DependencyGraph::getKey(MetadataItem* item) const
+{
+    NodeType kind = getKind(item->getType());
+    if (kind == ntUnknown)
+        throw FRError(_("Unsupported type"));
+    return ObjectKey(kind, item->getName_());
+}
+
+MetadataItem* DependencyGraph::findObject(const ObjectKey& key) const
+{
+    if (key.first != ntTable)
+        return databaseM->findByNameAndType(key.first, key.second);
+
+    MetadataItem* m = databaseM->findByNameAndType(ntTable, key.second);
+    if (!m)
+        m = databaseM->findByNameAndType(ntView, key.second);
+    if (!m)
+        m = databaseM->findByNameAndType(ntSysTable, key.second);
+    return m;
+}
+
+void DependencyGraph::addEdge(const Edge& edge)
+{
+    dependenciesM.insert(std::make_pair(edge.dependentM, edge));
+    dependentsM.insert(std::make_pair(edge.dependedOnM, edge));
+}
+
+void DependencyGraph::removeDependenciesOf(const ObjectKey& key)
+{
+    std::pair<EdgeMap::iterator, EdgeMap::iterator> edges =
+        dependenciesM.equal_range(key);
+    for (EdgeMap::iterator it = edges.first; it != edges.second; ++it)
+    {
+        std::pair<EdgeMap::iterator, EdgeMap::iterator> reverse =
+            dependentsM.equal_range((*it).second.dependedOnM);
+        for (EdgeMap::iterator itr = reverse.first; itr != reverse.second; )
+        {
+            if ((*itr).second.dependentM == key)
+                dependentsM.erase(itr++);
+            else
+                ++itr;
+        }
+    }
+    dependenciesM.erase(edges.first, edges.second);
+}
+
+void DependencyGraph::readDependencies(IBPP::Statement& st,
+    const ObjectKey* onlyDependent)
+{
+    wxMBConv* conv = databaseM->getCharsetConverter();
+    st->Execute();
+    while (st->Fetch())
+    {
+        int dependentType, dependedOnType;
+        st->Get(1, dependentType);
+        st->Get(3, dependedOnType);
+        Edge edge;
+        edge.dependentM.first = getKindOfDependencyType(dependentType);
+        edge.dependedOnM.first = getKindOfDependencyType(dependedOnType);
+        if (edge.dependentM.first == ntUnknown
+            || edge.dependedOnM.first == ntUnknown)
+        {
+            continue;
+        }
+
+        std::string s;
+        st->Get(2, s);
+        edge.dependentM.second = std2wxIdentifier(s, conv);
+        if (onlyDependent && edge.dependentM != *onlyDependent)
+            continue;
+        st->Get(4, s);
+        edge.dependedOnM.second = std2wxIdentifier(s, conv);
+        if (!st->IsNull(5))
+        {
+            st->Get(5, s);
+            edge.fieldM = std2wxIdentifier(s, conv);
+        }
+        if (!st->IsNull(6))
+        {
+            st->Get(6, s);
+            edge.dependentFieldM = std2wxIdentifier(s, conv);
+        }
+        addEdge(edge);
+    }
+}
+
+void DependencyGraph::readForeignKeys(IBPP::Statement& st)
+{
+    wxMBConv* conv = databaseM->getCharsetConverter();
+    st->Execute();
+    while (st->Fetch())
+    {
+        std::string s;
+        Edge edge;
+        edge.dependentM.first = ntTable;
+        st->Get(1, s);
+        edge.dependentM.second = std2wxIdentifier(s, conv);
+        st->Get(2, s);
+        edge.dependentFieldM = std2wxIdentifier(s, conv);
+        edge.dependedOnM.first = ntTable;
+        st->Get(3, s);
+        edge.dependedOnM.second = std2wxIdentifier(s, conv);
+        st->Get(4, s);
+        edge.fieldM = std2wxIdentifier(s, conv);
+        addEdge(edge);
+    }
+}
+
+void DependencyGraph::readCheckTriggers(IBPP::Statement& st,
+    std::vector<ObjectKey>* triggers)
+{
+    wxMBConv* conv = databaseM->getCharsetConverter();
+    st->Execute();
+    while (st->Fetch())
+    {
+        std::string s;
+        st->Get(1, s);
+        wxString trigger(std2wxIdentifier(s, conv));
+        st->Get(2, s);
+        checkTriggersM[trigger] = std2wxIdentifier(s, conv);
+        if (triggers)
+            triggers->push_back(ObjectKey(ntTrigger, trigger));
+    }
+}
+
+void DependencyGraph::load()
+{
+    dependenciesM.clear();
+    dependentsM.clear();
+    checkTriggersM.clear();
+    staleObjectsM.clear();
+
+    MetadataLoader* loader = databaseM->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+
+    IBPP::Statement st = loader->createStatement(getDependenciesSql(false));
+    readDependencies(st);
+    st = loader->createStatement(foreignKeysSql);
+    readForeignKeys(st);
+    st = loader->createStatement(checkTriggersSql);
+    readCheckTriggers(st);
+    loadedM = true;
+}
+
+void DependencyGraph::reloadStaleObjects()
+{
+    MetadataLoader* loader = databaseM->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    wxMBConv* conv = databaseM->getCharsetConverter();
+
+    for (std::set<ObjectKey>::const_iterator it = staleObjectsM.begin();
+        it != staleObjectsM.end(); ++it)
+    {
+        std::string name(wx2std((*it).second, conv));
+        std::vector<ObjectKey> keys(1, *it);
+        if ((*it).first == ntTable)
+        {
+            // the system triggers of the check constraints are dropped and
+            // recreated together with the constraints of the table
+            std::map<wxString, wxString>::iterator itc =
+                checkTriggersM.begin();
+            while (itc != checkTriggersM.end())
+            {
+                if ((*itc).second == (*it).second)
+                {
+                    keys.push_back(ObjectKey(ntTrigger, (*itc).first));
+                    checkTriggersM.erase(itc++);
+                }
+                else
+                    ++itc;
+            }
+            IBPP::Statement& st = loader->getStatement(
+                std::string(checkTriggersSql) + "and r.rdb$relation_name = ?");
+            st->Set(1, name);
+            readCheckTriggers(st, &keys);
+        }
+
+        for (std::vector<ObjectKey>::const_iterator itk = keys.begin();
+            itk != keys.end(); ++itk)
+        {
+            removeDependenciesOf(*itk);
+        }
+        for (std::vector<ObjectKey>::const_iterator itk = keys.begin();
+            itk != keys.end(); ++itk)
+        {
+            IBPP::Statement& st = loader->getStatement(
+                getDependenciesSql(true));
+            std::string keyName(wx2std((*itk).second, conv));
+            for (int i = 1; i <= 3; ++i)
+                st->Set(i, keyName);
+            readDependencies(st, &(*itk));
+        }
+
+        if ((*it).first == ntTable)
+        {
+            IBPP::Statement& st = loader->getStatement(
+                std::string(foreignKeysSql) + "and r1.rdb$relation_name = ?");
+            st->Set(1, name);
+            readForeignKeys(st);
+        }
+    }
+    staleObjectsM.clear();
+}
+
+void DependencyGraph::ensureLoaded()
+{
+    if (!loadedM)
+        load();
+    else if (!staleObjectsM.empty())
+        reloadStaleObjects();
+}
+
+void DependencyGraph::invalidate()
+{
+    loadedM = false;
+    dependenciesM.clear();
+    dependentsM.clear();
+    checkTriggersM.clear();
+    staleObjectsM.clear();
+}
+
+void DependencyGraph::invalidateObject(NodeType type, const wxString& name)
+{
+    if (!loadedM)
+        return;
+    NodeType kind = getKind(type);
+    // statements the parser can't classify could have changed anything
+    if (kind == ntUnknown)
+    {
+        if (type == ntUnknown)
+            invalidate();
+        return;
+    }
+    staleObjectsM.insert(ObjectKey(kind, name));
+}
+
+void DependencyGraph::getAdjacent(const ObjectKey& key, bool ofObject,
+    AdjacencyMap& adjacent) const
+{
+    if (ofObject)
+    {
+        std::vector<ObjectKey> keys(1, key);
+        // check constraints are implemented as system triggers, objects
+        // used in the check conditions are dependencies of the table
+        if (key.first == ntTable)
+        {
+            for (std::map<wxString, wxString>::const_iterator it =
+                checkTriggersM.begin(); it != checkTriggersM.end(); ++it)
+            {
+                if ((*it).second == key.second)
+                    keys.push_back(ObjectKey(ntTrigger, (*it).first));
+            }
+        }
+        for (std::vector<ObjectKey>::const_iterator itk = keys.begin();
+            itk != keys.end(); ++itk)
+        {
+            std::pair<EdgeMap::const_iterator, EdgeMap::const_iterator> edges
+                = dependenciesM.equal_range(*itk);
+            for (EdgeMap::const_iterator it = edges.first;
+                it != edges.second; ++it)
+            {
+                const Edge& e = (*it).second;
+                if (itk != keys.begin() && e.dependedOnM == key)
+                    continue;
+                std::vector<wxString>& fields = adjacent[e.dependedOnM];
+                if (!e.fieldM.empty())
+                    fields.push_back(e.fieldM);
+            }
+        }
+        return;
+    }
+
+    std::pair<EdgeMap::const_iterator, EdgeMap::const_iterator> edges =
+        dependentsM.equal_range(key);
+    for (EdgeMap::const_iterator it = edges.first; it != edges.second; ++it)
+    {
+        const Edge& e = (*it).second;
+        ObjectKey dependent(e.dependentM);
+        // the system trigger of a check constraint stands for its table
+        if (dependent.first == ntTrigger)
+        {
+            std::map<wxString, wxString>::const_iterator itc =
+                checkTriggersM.find(dependent.second);
+            if (itc != checkTriggersM.end())
+            {
+                dependent = ObjectKey(ntTable, (*itc).second);
+                if (dependent == key)
+                    continue;
+            }
+        }
+        std::vector<wxString>& fields = adjacent[dependent];
+        if (!e.dependentFieldM.empty())
+            fields.push_back(e.dependentFieldM);
+    }
+}
+
+void DependencyGraph::getDependencies(MetadataItem* item, bool ofObject,
+    std::vector<Dependency>& list)
+{
+    ObjectKey key(getKey(item));
+    ensureLoaded();
+
+    AdjacencyMap adjacent;
+    getAdjacent(key, ofObject, adjacent);
+    for (AdjacencyMap::iterator it = adjacent.begin(); it != adjacent.end();
+        ++it)
+    {
+        MetadataItem* object = findObject((*it).first);
+        if (!object)
+            continue;
+        std::vector<wxString>& fields = (*it).second;
+        std::sort(fields.begin(), fields.end());
+        fields.erase(std::unique(fields.begin(), fields.end()), fields.end());
+        Dependency de(object);
+        de.setFields(fields);
+        list.push_back(de);
+    }
+}
+
+void DependencyGraph::getClosure(MetadataItem* item, bool ofObject,
+    std::vector<MetadataItem*>& items, NodeType type)
+{
+    ObjectKey start(getKey(item));
+    ensureLoaded();
+
+    std::set<ObjectKey> visited;
+    visited.insert(start);
+    std::deque<ObjectKey> pending(1, start);
+    while (!pending.empty())
+    {
+        AdjacencyMap adjacent;
+        getAdjacent(pending.front(), ofObject, adjacent);
+        pending.pop_front();
+        for (AdjacencyMap::const_iterator it = adjacent.begin();
+            it != adjacent.end(); ++it)
+        {
+            if (!visited.insert((*it).first).second)
+                continue;
+            MetadataItem* object = findObject((*it).first);
+            if (!object || (type != ntUnknown && object->getType() != type))
+                continue;
+            items.push_back(object);
+            pending.push_back((*it).first);
+        }
+    }
+}
+
+void DependencyGraph::visitTopologically(const ObjectKey& key,
+    bool dependentsFirst, const std::map<ObjectKey, MetadataItem*>& items,
+    std::set<ObjectKey>& visited, std::vector<MetadataItem*>& sorted)
+{
+    if (!visited.insert(key).second)
+        return;
+    // everything that has to come first is output before the item itself
+    AdjacencyMap adjacent;
+    getAdjacent(key, !dependentsFirst, adjacent);
+    for (AdjacencyMap::const_iterator it = adjacent.begin();
+        it != adjacent.end(); ++it)
+    {
+        if (items.find((*it).first) != items.end())
+            visitTopologically((*it).first, dependentsFirst, items, visited,
+                sorted);
+    }
+    sorted.push_back((*items.find(key)).second);
+}
+
+void DependencyGraph::sortTopologically(std::vector<MetadataItem*>& items,
+    bool dependentsFirst)
+{
+    ensureLoaded();
+
+    std::map<ObjectKey, MetadataItem*> keyed;
+    for (std::vector<MetadataItem*>::const_iterator it = items.begin();
+        it != items.end(); ++it)
+    {
+        keyed.insert(std::make_pair(getKey(*it), *it));
+    }
+
+    std::set<ObjectKey> visited;
+    std::vector<MetadataItem*> sorted;
+    for (std::vector<MetadataItem*>::const_iterator it = items.begin();
+        it != items.end(); ++it)
+    {
+        visitTopologically(getKey(*it), dependentsFirst, keyed, visited,
+            sorted);
+    }
+    items.swap(sorted);
+}
@@ -0,0 +1,117 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_DEPENDENCYGRAPH_H
+#define FR_DEPENDENCYGRAPH_H
+
+#include <wx/string.h>
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <ibpp.h>
+
+#include "metadata/metadataitem.h"
+
+class Database;
+
+// Holds the dependencies between all objects of a database.  They are read
+// with one query from RDB$DEPENDENCIES (extended by the columns of views
+// and computed columns) and one query each for foreign keys and check
+// constraints, and are kept until the database is disconnected.
+// Objects are stored by kind and name, tables and views share the kind
+// ntTable as they do in RDB$DEPENDENCIES.  DDL statements mark the changed
+// objects as stale, only their dependencies are reloaded on the next query.
+class DependencyGraph
+{
+public:
+    typedef std::pair<NodeType, wxString> ObjectKey;
+private:
+    struct Edge
+    {
+        ObjectKey dependentM;
+        ObjectKey dependedOnM;
+        // the field of the depended-on object, and the field listed for the
+        // dependent object (for computed columns and foreign keys this is
+        // the column of the dependent table)
+        wxString fieldM;
+        wxString dependentFieldM;
+    };
+    typedef std::multimap<ObjectKey, Edge> EdgeMap;
+    typedef std::map<ObjectKey, std::vector<wxString> > AdjacencyMap;
+
+    Database* databaseM;
+    bool loadedM;
+    // the same edges, keyed by dependent and by depended-on object
+    EdgeMap dependenciesM;
+    EdgeMap dependentsM;
+    // system triggers of check constraints, and their tables
+    std::map<wxString, wxString> checkTriggersM;
+    std::set<ObjectKey> staleObjectsM;
+
+    static NodeType getKind(NodeType type);
+    static NodeType getKindOfDependencyType(int type);
+    ObjectKey getKey(MetadataItem* item) const;
+    MetadataItem* findObject(const ObjectKey& key) const;
+
+    void addEdge(const Edge& edge);
+    void removeDependenciesOf(const ObjectKey& key);
+    void readDependencies(IBPP::Statement& st,
+        const ObjectKey* onlyDependent = 0);
+    void readForeignKeys(IBPP::Statement& st);
+    void readCheckTriggers(IBPP::Statement& st,
+        std::vector<ObjectKey>* triggers = 0);
+    void load();
+    void reloadStaleObjects();
+    void ensureLoaded();
+
+    void getAdjacent(const ObjectKey& key, bool ofObject,
+        AdjacencyMap& adjacent) const;
+    void visitTopologically(const ObjectKey& key, bool dependentsFirst,
+        const std::map<ObjectKey, MetadataItem*>& items,
+        std::set<ObjectKey>& visited, std::vector<MetadataItem*>& sorted);
+public:
+    DependencyGraph(Database* database);
+
+    // drops all dependencies, they are loaded again when next needed
+    void invalidate();
+    // marks the dependencies of a created, altered or dropped object stale
+    void invalidateObject(NodeType type, const wxString& name);
+
+    // ofObject = true   => objects the item depends on
+    // ofObject = false  => objects that depend on the item
+    void getDependencies(MetadataItem* item, bool ofObject,
+        std::vector<Dependency>& list);
+    // appends all objects reachable from the item, directly or indirectly,
+    // if type is given only objects of that type are followed
+    void getClosure(MetadataItem* item, bool ofObject,
+        std::vector<MetadataItem*>& items, NodeType type = ntUnknown);
+    // orders the items so that every item comes before the items it depends
+    // on (dependentsFirst) or after them, removes duplicates
+    void sortTopologically(std::vector<MetadataItem*>& items,
+        bool dependentsFirst);
+};
+
+#endif // FR_DEPENDENCYGRAPH_H
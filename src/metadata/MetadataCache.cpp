@@ -0,0 +1,269 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+
+#include "config/Config.h"
+#include "metadata/MetadataCache.h"
+
+namespace
+{
+
+// file layout: magic, format version, ODS major and minor version, database
+// path and the number of collections, followed by the collections with
+// their key, the number of names and the names, followed by the number of
+// object versions and the versions with their key
+// all numbers are little endian, all strings UTF-8 with their length
+const char cacheMagic[4] = { 'F', 'R', 'M', 'C' };
+const wxUint32 cacheFormatVersion = 2;
+
+void putUint32(std::string& buf, wxUint32 value)
+{
+    for (int i = 0; i < 4; ++i)
+        buf += char((value >> (8 * i)) & 0xFF);
+}
+
+void putInt64(std::string& buf, boost::int64_t value)
+{
+    boost::uint64_t u = boost::uint64_t(value);
+    for (int i = 0; i < 8; ++i)
+        buf += char((u >> (8 * i)) & 0xFF);
+}
+
+void putString(std::string& buf, const std::string& value)
+{
+    putUint32(buf, wxUint32(value.size()));
+    buf += value;
+}
+
+void putString(std::string& buf, const wxString& value)
+{
+    wxScopedCharBuffer utf8(value.utf8_str());
+    putString(buf, std::string(utf8.data(), utf8.length()));
+}
+
+class CacheReader
+{
+private:
+    const std::string& bufM;
+    size_t posM;
+public:
+    CacheReader(const std::string& buf)
+        : bufM(buf), posM(0)
+    {
+    }
+
+    bool getUint32(wxUint32& value)
+    {
+        if (posM + 4 > bufM.size())
+            return false;
+        value = 0;
+        for (int i = 3; i >= 0; --i)
+            value = (value << 8) | (unsigned char)bufM[posM + i];
+        posM += 4;
+        return true;
+    }
+
+    bool getInt64(boost::int64_t& value)
+    {
+        if (posM + 8 > bufM.size())
+            return false;
+        boost::uint64_t u = 0;
+        for (int i = 7; i >= 0; --i)
+            u = (u << 8) | (unsigned char)bufM[posM + i];
+        value = boost::int64_t(u);
+        posM += 8;
+        return true;
+    }
+
+    bool getString(std::string& value)
+    {
+        wxUint32 len;
+        if (!getUint32(len) || posM + len > bufM.size())
+            return false;
+        value.assign(bufM, posM, len);
+        posM += len;
+        return true;
+    }
+
+    bool getString(wxString& value)
+    {
+        std::string s;
+        if (!getString(s))
+            return false;
+        value = wxString::FromUTF8(s.data(), s.size());
+        return true;
+    }
+};
+
+} // namespace
+
+MetadataCache::MetadataCache(const wxString& databaseId,
+        const wxString& databasePath, int odsMajor, int odsMinor)
+    : databasePathM(databasePath), odsMajorM(odsMajor), odsMinorM(odsMinor)
+{
+    wxString dir(config().getUserHomePath() + "cache");
+    if (!wxDirExists(dir))
+        wxMkdir(dir);
+    fileNameM = dir + wxFileName::GetPathSeparator() + "DATABASE"
+        + databaseId + ".metadata";
+}
+
+bool MetadataCache::load()
+{
+    collectionsM.clear();
+    objectVersionsM.clear();
+    if (!wxFileExists(fileNameM))
+        return false;
+
+    std::string buf;
+    {
+        wxFFile f(fileNameM, "rb");
+        wxFileOffset len = f.IsOpened() ? f.Length() : 0;
+        if (len <= 0)
+            return false;
+        buf.resize(size_t(len));
+        if (f.Read(&buf[0], buf.size()) != buf.size())
+            return false;
+    }
+
+    if (buf.compare(0, sizeof(cacheMagic),
+        std::string(cacheMagic, sizeof(cacheMagic))) != 0)
+    {
+        return false;
+    }
+    CacheReader reader(buf.substr(sizeof(cacheMagic)));
+    wxUint32 version, odsMajor, odsMinor, count;
+    wxString path;
+    if (!reader.getUint32(version) || version != cacheFormatVersion
+        || !reader.getUint32(odsMajor) || int(odsMajor) != odsMajorM
+        || !reader.getUint32(odsMinor) || int(odsMinor) != odsMinorM
+        || !reader.getString(path) || path != databasePathM
+        || !reader.getUint32(count))
+    {
+        return false;
+    }
+
+    CollectionMap collections;
+    for (wxUint32 i = 0; i < count; ++i)
+    {
+        wxString key;
+        wxUint32 names;
+        if (!reader.getString(key) || !reader.getUint32(names))
+            return false;
+        wxArrayString& c(collections[key]);
+        for (wxUint32 j = 0; j < names; ++j)
+        {
+            wxString name;
+            if (!reader.getString(name))
+                return false;
+            c.push_back(name);
+        }
+    }
+    ObjectVersions versions;
+    if (!reader.getUint32(count))
+        return false;
+    for (wxUint32 i = 0; i < count; ++i)
+    {
+        wxString key;
+        boost::int64_t version;
+        if (!reader.getString(key) || !reader.getInt64(version))
+            return false;
+        versions[key] = version;
+    }
+    collectionsM.swap(collections);
+    objectVersionsM.swap(versions);
+    return true;
+}
+
+bool MetadataCache::save()
+{
+    std::string buf(cacheMagic, sizeof(cacheMagic));
+    putUint32(buf, cacheFormatVersion);
+    putUint32(buf, wxUint32(odsMajorM));
+    putUint32(buf, wxUint32(odsMinorM));
+    putString(buf, databasePathM);
+    putUint32(buf, wxUint32(collectionsM.size()));
+    for (CollectionMap::const_iterator it = collectionsM.begin();
+        it != collectionsM.end(); ++it)
+    {
+        putString(buf, (*it).first);
+        const wxArrayString& names((*it).second);
+        putUint32(buf, wxUint32(names.size()));
+        for (size_t i = 0; i < names.size(); ++i)
+            putString(buf, names[i]);
+    }
+    putUint32(buf, wxUint32(objectVersionsM.size()));
+    for (ObjectVersions::const_iterator it = objectVersionsM.begin();
+        it != objectVersionsM.end(); ++it)
+    {
+        putString(buf, (*it).first);
+        putInt64(buf, (*it).second);
+    }
+
+    // write to a temporary file first, so a crash can't leave a truncated
+    // cache behind
+    wxString tempName(fileNameM + ".tmp");
+    {
+        wxFFile f(tempName, "wb");
+        if (!f.IsOpened() || f.Write(buf.data(), buf.size()) != buf.size())
+            return false;
+    }
+    return wxRenameFile(tempName, fileNameM, true);
+}
+
+bool MetadataCache::getNames(const wxString& collection,
+    wxArrayString& names) const
+{
+    CollectionMap::const_iterator it = collectionsM.find(collection);
+    if (it == collectionsM.end())
+        return false;
+    names = (*it).second;
+    return true;
+}
+
+void MetadataCache::setNames(const wxString& collection,
+    const wxArrayString& names)
+{
+    collectionsM[collection] = names;
+}
+
+const MetadataCache::ObjectVersions& MetadataCache::getObjectVersions() const
+{
+    return objectVersionsM;
+}
+
+void MetadataCache::setObjectVersions(const ObjectVersions& versions)
+{
+    objectVersionsM = versions;
+}
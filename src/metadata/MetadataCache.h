@@ -0,0 +1,70 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_METADATACACHE_H
+#define FR_METADATACACHE_H
+
+#include <wx/arrstr.h>
+#include <wx/string.h>
+
+#include <map>
+
+#include <boost/cstdint.hpp>
+
+// Stores the names of the objects in the metadata collections of a database
+// in a binary file in the user directory, so they don't need to be read
+// from the system tables on every connect.  Along with them the version
+// markers of the MetadataChangeDetector are stored, the first check after
+// the connect compares them with the database and reloads what differs.
+// Columns, parameters, dependencies and sources are not cached, they are
+// loaded from the server on demand as before.
+class MetadataCache
+{
+public:
+    typedef std::map<wxString, boost::int64_t> ObjectVersions;
+private:
+    typedef std::map<wxString, wxArrayString> CollectionMap;
+
+    wxString fileNameM;
+    wxString databasePathM;
+    int odsMajorM;
+    int odsMinorM;
+    CollectionMap collectionsM;
+    ObjectVersions objectVersionsM;
+public:
+    // databaseId identifies the registered database, the cache file is
+    // ignored if it was written for a different path or ODS version
+    MetadataCache(const wxString& databaseId, const wxString& databasePath,
+        int odsMajor, int odsMinor);
+
+    bool load();
+    bool save();
+
+    // returns false if the collection isn't cached
+    bool getNames(const wxString& collection, wxArrayString& names) const;
+    void setNames(const wxString& collection, const wxArrayString& names);
+    const ObjectVersions& getObjectVersions() const;
+    void setObjectVersions(const ObjectVersions& versions);
+};
+
+#endif // FR_METADATACACHE_H
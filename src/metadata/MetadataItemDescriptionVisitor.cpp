@@ -235,6 +235,8 @@ void SaveDescriptionVisitor::saveDescription(MetadataItem* object,
 
     st1->Execute();
     tr1->Commit();
+    // descriptions are part of the search index
+    d->invalidateSearchIndex();
 }
 
 void SaveDescriptionVisitor::visitColumn(Column& column)
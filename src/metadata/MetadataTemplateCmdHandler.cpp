@@ -32,7 +32,9 @@
 
 #include "core/ProcessableObject.h"
 #include "core/StringUtils.h"
+#include "core/Subject.h"
 #include "core/TemplateProcessor.h"
+#include "engine/MetadataLoader.h"
 #include "metadata/CreateDDLVisitor.h"
 #include "metadata/column.h"
 #include "metadata/database.h"
@@ -151,6 +153,10 @@ void MetadataTemplateCmdHandler::handleTemplateCmd(TemplateProcessor *tp,
             if (!r)
                 return;
             r->ensureChildrenLoaded();
+            // the rows of wide tables are processed one per step
+            std::vector<ProcessableObjectPtr> columns(r->begin(), r->end());
+            if (tp->deferIterations(columns, sep, cmdParams.from(2)))
+                return;
             bool firstItem = true;
             for (ColumnPtrs::iterator it = r->begin(); it != r->end(); ++it)
             {
@@ -339,14 +345,20 @@ void MetadataTemplateCmdHandler::handleTemplateCmd(TemplateProcessor *tp,
             SubjectLocker locker(p);
             p->ensureChildrenLoaded();
             bool isOut = (cmdParams[2] == "output");
-            bool firstItem = true;
+            std::vector<ProcessableObjectPtr> params;
             for (ParameterPtrs::iterator it = p->begin(); it != p->end(); ++it)
             {
                 if ((*it)->isOutputParameter() == isOut)
-                {
-                    Local::foreachIteration(firstItem, tp, processedText, sep,
-                        cmdParams.from(3), (*it).get());
-                }
+                    params.push_back(*it);
+            }
+            if (tp->deferIterations(params, sep, cmdParams.from(3)))
+                return;
+            bool firstItem = true;
+            for (std::vector<ProcessableObjectPtr>::iterator it =
+                params.begin(); it != params.end(); ++it)
+            {
+                Local::foreachIteration(firstItem, tp, processedText, sep,
+                    cmdParams.from(3), (*it).get());
             }
         }
 
@@ -764,6 +776,53 @@ void MetadataTemplateCmdHandler::handleTemplateCmd(TemplateProcessor *tp,
             db->getConnectedUsers(users);
             processedText += wxArrayToString(users, ",");
         }
+        else if (cmdParams[0] == "statement_cache_size")
+        {
+            MetadataLoader* loader = db->getMetadataLoader();
+            processedText += wxString() << loader->getStatementCount() << "/"
+                << loader->getMaximumConcurrentStatements();
+        }
+        else if (cmdParams[0] == "statement_cache_hits")
+        {
+            processedText += wxString()
+                << db->getMetadataLoader()->getStatistics().hits;
+        }
+        else if (cmdParams[0] == "statement_cache_misses")
+        {
+            processedText += wxString()
+                << db->getMetadataLoader()->getStatistics().misses;
+        }
+        else if (cmdParams[0] == "statement_cache_evictions")
+        {
+            processedText += wxString()
+                << db->getMetadataLoader()->getStatistics().evictions;
+        }
+        else if (cmdParams[0] == "statement_prepare_time")
+        {
+            processedText += wxString::Format("%ld ms",
+                db->getMetadataLoader()->getStatistics().prepareMillis);
+        }
+        // counted since program start, over all databases
+        else if (cmdParams[0] == "notifications_requested")
+        {
+            processedText += wxString()
+                << NotificationBatch::getStatistics().requested;
+        }
+        else if (cmdParams[0] == "notifications_coalesced")
+        {
+            processedText += wxString()
+                << NotificationBatch::getStatistics().coalesced;
+        }
+        else if (cmdParams[0] == "notifications_delivered")
+        {
+            processedText += wxString()
+                << NotificationBatch::getStatistics().delivered;
+        }
+        else if (cmdParams[0] == "observer_updates")
+        {
+            processedText += wxString()
+                << NotificationBatch::getStatistics().observerUpdates;
+        }
     }
 
     // {%privilegeinfo:<property>%}
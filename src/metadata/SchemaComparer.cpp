@@ -0,0 +1,695 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/tokenzr.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include "core/ProgressIndicator.h"
+#include "core/Subject.h"
+#include "engine/MetadataLoader.h"
+#include "metadata/column.h"
+#include "metadata/constraints.h"
+#include "metadata/CreateDDLVisitor.h"
+#include "metadata/DependencyGraph.h"
+#include "metadata/domain.h"
+#include "metadata/exception.h"
+#include "metadata/function.h"
+#include "metadata/generator.h"
+#include "metadata/procedure.h"
+#include "metadata/role.h"
+#include "metadata/SchemaComparer.h"
+#include "metadata/table.h"
+#include "metadata/trigger.h"
+#include "metadata/view.h"
+
+// appends all user objects of the database, in the order they need to be
+// created in (the same as in CreateDDLVisitor::visitDatabase())
+static void getSchemaObjects(DatabasePtr database,
+    std::vector<MetadataItem*>& items)
+{
+    MetadataItem* collections[] = {
+        database->getRoles().get(), database->getFunctions().get(),
+        database->getGenerators().get(), database->getDomains().get(),
+        database->getProcedures().get(), database->getTables().get(),
+        database->getViews().get(), database->getExceptions().get(),
+        database->getTriggers().get()
+    };
+    for (size_t i = 0; i < sizeof(collections) / sizeof(*collections); ++i)
+    {
+        std::vector<MetadataItem*> children;
+        collections[i]->getChildren(children);
+        // views may select from other views
+        if (collections[i] == database->getViews().get())
+            database->getDependencyGraph().sortTopologically(children, false);
+        items.insert(items.end(), children.begin(), children.end());
+    }
+}
+
+static wxString getFingerprintKey(MetadataItem* item)
+{
+    return wxString::Format("%d.", int(item->getType())) + item->getName_();
+}
+
+// splits DDL created by CreateDDLVisitor into statements, the blocks that
+// are enclosed in SET TERM statements are kept together
+static void splitStatements(const wxString& sql,
+    std::vector<wxString>& statements)
+{
+    wxString statement;
+    bool inBlock = false;
+    wxStringTokenizer lines(sql, "\n");
+    while (lines.HasMoreTokens())
+    {
+        wxString line(lines.GetNextToken());
+        wxString trimmed(line.Strip(wxString::both));
+        if (trimmed.empty() && statement.empty())
+            continue;
+        statement += line + "\n";
+
+        bool endsStatement = !inBlock && trimmed.EndsWith(";");
+        if (trimmed.Upper().StartsWith("SET TERM"))
+        {
+            inBlock = !inBlock;
+            endsStatement = !inBlock;
+        }
+        if (endsStatement)
+        {
+            statements.push_back(statement);
+            statement.clear();
+        }
+    }
+    if (!statement.Strip(wxString::both).empty())
+        statements.push_back(statement);
+}
+
+// collapses all whitespace outside of quoted strings and identifiers, so
+// that formatting differences don't count as changes
+static wxString normalizeStatement(const wxString& statement)
+{
+    static const wxString noSpaceAfter("(,");
+    static const wxString noSpaceBefore(",);");
+
+    wxString result;
+    result.reserve(statement.length());
+    wxChar quote = 0;
+    bool whitespace = false;
+    for (wxString::const_iterator it = statement.begin();
+        it != statement.end(); ++it)
+    {
+        wxChar c = *it;
+        if (quote)
+        {
+            result += c;
+            if (c == quote)
+                quote = 0;
+            continue;
+        }
+        if (wxIsspace(c))
+        {
+            whitespace = true;
+            continue;
+        }
+        if (whitespace && !result.empty()
+            && noSpaceAfter.find(result.Last()) == wxString::npos
+            && noSpaceBefore.find(c) == wxString::npos)
+        {
+            result += ' ';
+        }
+        whitespace = false;
+        if (c == '\'' || c == '"')
+            quote = c;
+        result += c;
+    }
+    return result;
+}
+
+static void getNormalizedStatements(const wxString& sql,
+    std::set<wxString>& statements)
+{
+    std::vector<wxString> split;
+    splitStatements(sql, split);
+    for (std::vector<wxString>::iterator it = split.begin();
+        it != split.end(); ++it)
+    {
+        statements.insert(normalizeStatement(*it));
+    }
+}
+
+// 64 bit FNV-1a hash of the sorted normalized statements
+static boost::uint64_t getFingerprintHash(MetadataItem* item)
+{
+    CreateDDLVisitor cdv;
+    item->acceptVisitor(&cdv);
+    std::set<wxString> statements;
+    getNormalizedStatements(cdv.getPrefixSql() + "\n" + cdv.getPostSql()
+        + "\n" + cdv.getGrantSql(), statements);
+
+    boost::uint64_t hash = 14695981039346656037ULL;
+    for (std::set<wxString>::iterator it = statements.begin();
+        it != statements.end(); ++it)
+    {
+        wxCharBuffer buf((*it).utf8_str());
+        // include the terminating zero to separate the statements
+        for (const char* p = buf.data(); ; ++p)
+        {
+            hash = (hash ^ static_cast<unsigned char>(*p)) * 1099511628211ULL;
+            if (*p == 0)
+                break;
+        }
+    }
+    return hash;
+}
+
+// the parts of the script, in the order they are joined
+struct ScriptParts
+{
+    wxString dropConstraintSql;
+    wxString dropSql;
+    wxString createSql;
+    wxString postSql;
+    wxString grantSql;
+    wxString reviewSql;
+};
+
+// the normalized statements of the suffix that add something to a table,
+// with the statement that drops it again (empty if that is done by the
+// changes of the table definition)
+typedef std::map<wxString, wxString> DropStatements;
+
+// adds the statements that exist only in the source to sql, and the ones
+// that exist only in the target to dropSql if they can be dropped, or else
+// to the statements to be reviewed
+static void addStatementChanges(const std::vector<wxString>& source,
+    const std::vector<wxString>& target, wxString& sql, wxString& reviewSql,
+    const DropStatements* drops = 0, wxString* dropSql = 0)
+{
+    std::set<wxString> sourceSet, targetSet;
+    for (std::vector<wxString>::const_iterator it = target.begin();
+        it != target.end(); ++it)
+    {
+        targetSet.insert(normalizeStatement(*it));
+    }
+    for (std::vector<wxString>::const_iterator it = source.begin();
+        it != source.end(); ++it)
+    {
+        wxString normalized(normalizeStatement(*it));
+        sourceSet.insert(normalized);
+        if (targetSet.find(normalized) == targetSet.end())
+            sql += *it;
+    }
+    for (std::vector<wxString>::const_iterator it = target.begin();
+        it != target.end(); ++it)
+    {
+        wxString normalized(normalizeStatement(*it));
+        if (sourceSet.find(normalized) != sourceSet.end())
+            continue;
+        DropStatements::const_iterator drop;
+        if (drops && (drop = drops->find(normalized)) != drops->end())
+            *dropSql += (*drop).second;
+        else
+            reviewSql += *it;
+    }
+}
+
+static void addStatementChanges(const wxString& sourceSql,
+    const wxString& targetSql, wxString& sql, wxString& reviewSql,
+    const DropStatements* drops = 0, wxString* dropSql = 0)
+{
+    std::vector<wxString> source, target;
+    splitStatements(sourceSql, source);
+    splitStatements(targetSql, target);
+    addStatementChanges(source, target, sql, reviewSql, drops, dropSql);
+}
+
+static wxString getColumnDefinition(Column* column)
+{
+    CreateDDLVisitor cdv;
+    column->acceptVisitor(&cdv);
+    return cdv.getPrefixSql();  // empty for computed columns
+}
+
+// the normalized statement that adds the computed column
+static wxString getComputedColumnSql(Column* column)
+{
+    if (column->getComputedSource().empty())
+        return wxEmptyString;
+    CreateDDLVisitor cdv;
+    column->acceptVisitor(&cdv);
+    return normalizeStatement(cdv.getPostSql());
+}
+
+static wxString getColumnType(Column* column)
+{
+    DomainPtr domain(column->getDomain());
+    if (!domain)
+        return column->getSource();
+    if (domain->isSystem())
+        return domain->getDatatypeAsString();
+    return domain->getQuotedName();
+}
+
+static void getKeyConstraintStatements(Table& table,
+    std::vector<wxString>& statements)
+{
+    if (PrimaryKeyConstraint* pk = table.getPrimaryKey())
+    {
+        CreateDDLVisitor cdv;
+        pk->acceptVisitor(&cdv);
+        statements.push_back(cdv.getSql());
+    }
+    if (std::vector<UniqueConstraint>* uc = table.getUniqueConstraints())
+    {
+        for (std::vector<UniqueConstraint>::iterator it = uc->begin();
+            it != uc->end(); ++it)
+        {
+            CreateDDLVisitor cdv;
+            (*it).acceptVisitor(&cdv);
+            statements.push_back(cdv.getSql());
+        }
+    }
+}
+
+static void addColumnChanges(Column& source, Column& target,
+    ScriptParts& parts)
+{
+    wxString alter("ALTER TABLE " + target.getTable()->getQuotedName()
+        + " ALTER " + target.getQuotedName());
+    wxString sourceType(getColumnType(&source));
+    if (sourceType != getColumnType(&target))
+        parts.createSql += alter + " TYPE " + sourceType + ";\n";
+
+    wxString sourceDefault, targetDefault;
+    bool sourceHasDefault = source.getDefault(IgnoreDomainDefault,
+        sourceDefault);
+    bool targetHasDefault = target.getDefault(IgnoreDomainDefault,
+        targetDefault);
+    if (sourceHasDefault != targetHasDefault
+        || sourceDefault != targetDefault)
+    {
+        if (sourceHasDefault)
+            parts.createSql += alter + " SET DEFAULT " + sourceDefault + ";\n";
+        else
+            parts.createSql += alter + " DROP DEFAULT;\n";
+    }
+
+    if (source.isNullable(IgnoreDomainNullability)
+            != target.isNullable(IgnoreDomainNullability)
+        || source.getCollation() != target.getCollation())
+    {
+        parts.reviewSql += _("Nullability or collation differs:") + "\n"
+            + getColumnDefinition(&source) + "\n";
+    }
+}
+
+// CreateDDLVisitor adds computed columns, foreign keys and check
+// constraints in the suffix, a changed one has to be dropped before the
+// new definition can be added
+static void getTableDropStatements(Table& table, DropStatements& drops)
+{
+    wxString alter("ALTER TABLE " + table.getQuotedName());
+    for (ColumnPtrs::iterator it = table.begin(); it != table.end(); ++it)
+    {
+        // dropped by addTableChanges()
+        wxString sql(getComputedColumnSql((*it).get()));
+        if (!sql.empty())
+            drops[sql] = wxEmptyString;
+    }
+    if (std::vector<ForeignKey>* fk = table.getForeignKeys())
+    {
+        for (std::vector<ForeignKey>::iterator it = fk->begin();
+            it != fk->end(); ++it)
+        {
+            CreateDDLVisitor cdv;
+            (*it).acceptVisitor(&cdv);
+            drops[normalizeStatement(cdv.getSql())] = alter
+                + " DROP CONSTRAINT " + (*it).getQuotedName() + ";\n";
+        }
+    }
+    if (std::vector<CheckConstraint>* chk = table.getCheckConstraints())
+    {
+        for (std::vector<CheckConstraint>::iterator it = chk->begin();
+            it != chk->end(); ++it)
+        {
+            // the same statement as in CreateDDLVisitor::visitTable()
+            wxString sql(alter + " ADD ");
+            if (!(*it).isSystem())
+                sql += "CONSTRAINT " + (*it).getQuotedName();
+            sql += "\n  " + (*it).getSource() + ";\n";
+            drops[normalizeStatement(sql)] = alter + " DROP CONSTRAINT "
+                + (*it).getQuotedName() + ";\n";
+        }
+    }
+}
+
+static void addTableChanges(Table& source, Table& target, ScriptParts& parts)
+{
+    wxString alter("ALTER TABLE " + target.getQuotedName());
+    // drop the columns that don't exist in the source first, and those
+    // that change between computed and stored
+    for (ColumnPtrs::iterator it = target.begin(); it != target.end(); ++it)
+    {
+        ColumnPtr column(source.findColumn((*it)->getName_()));
+        if (!column)
+            parts.createSql += (*it)->getDropSqlStatement() + ";\n";
+        else if (column->getComputedSource().empty()
+                != (*it)->getComputedSource().empty()
+            || normalizeStatement(column->getComputedSource())
+                != normalizeStatement((*it)->getComputedSource()))
+        {
+            parts.createSql += (*it)->getDropSqlStatement() + ";\n";
+            // computed columns are added by the statements of the suffix
+            if (column->getComputedSource().empty())
+            {
+                parts.createSql += alter + " ADD "
+                    + getColumnDefinition(column.get()) + ";\n";
+            }
+        }
+    }
+    for (ColumnPtrs::iterator it = source.begin(); it != source.end(); ++it)
+    {
+        if (!(*it)->getComputedSource().empty())
+            continue;
+        ColumnPtr column(target.findColumn((*it)->getName_()));
+        if (!column)
+        {
+            parts.createSql += alter + " ADD "
+                + getColumnDefinition((*it).get()) + ";\n";
+        }
+        else if (column->getComputedSource().empty()
+            && normalizeStatement(getColumnDefinition((*it).get()))
+                != normalizeStatement(getColumnDefinition(column.get())))
+        {
+            addColumnChanges(*(*it), *column, parts);
+        }
+    }
+
+    // primary key and unique constraints are part of CREATE TABLE
+    std::vector<wxString> sourceKeys, targetKeys;
+    getKeyConstraintStatements(source, sourceKeys);
+    getKeyConstraintStatements(target, targetKeys);
+    addStatementChanges(sourceKeys, targetKeys, parts.createSql,
+        parts.reviewSql);
+}
+
+static void addDomainChanges(Domain& source, Domain& target,
+    ScriptParts& parts)
+{
+    wxString alter("ALTER DOMAIN " + target.getQuotedName());
+    wxString sourceType(source.getDatatypeAsString());
+    if (sourceType != target.getDatatypeAsString())
+        parts.createSql += alter + " TYPE " + sourceType + ";\n";
+
+    wxString sourceDefault, targetDefault;
+    bool sourceHasDefault = source.getDefault(sourceDefault);
+    bool targetHasDefault = target.getDefault(targetDefault);
+    if (sourceHasDefault != targetHasDefault
+        || sourceDefault != targetDefault)
+    {
+        if (sourceHasDefault)
+            parts.createSql += alter + " SET DEFAULT " + sourceDefault + ";\n";
+        else
+            parts.createSql += alter + " DROP DEFAULT;\n";
+    }
+
+    wxString sourceCheck(source.getCheckConstraint());
+    wxString targetCheck(target.getCheckConstraint());
+    if (normalizeStatement(sourceCheck) != normalizeStatement(targetCheck))
+    {
+        if (!targetCheck.empty())
+            parts.createSql += alter + " DROP CONSTRAINT;\n";
+        if (!sourceCheck.empty())   // already contains CHECK keyword
+            parts.createSql += alter + " ADD " + sourceCheck + ";\n";
+    }
+
+    if (source.isNullable() != target.isNullable()
+        || source.getCharset() != target.getCharset()
+        || source.getCollation() != target.getCollation())
+    {
+        CreateDDLVisitor cdv;
+        source.acceptVisitor(&cdv);
+        parts.reviewSql += _("Nullability, character set or collation differs:")
+            + "\n" + cdv.getPrefixSql();
+    }
+}
+
+// changes the definition of the object, that is the part that
+// CreateDDLVisitor puts into the prefix
+static void addDefinitionChanges(MetadataItem* source, MetadataItem* target,
+    ScriptParts& parts)
+{
+    if (Table* t = dynamic_cast<Table*>(source))
+        addTableChanges(*t, *dynamic_cast<Table*>(target), parts);
+    else if (View* v = dynamic_cast<View*>(source))
+    {
+        wxString sql(v->getCreateSql());
+        sql.Replace("CREATE", "ALTER", false);  // just first
+        parts.createSql += sql;
+    }
+    else if (Trigger* t = dynamic_cast<Trigger*>(source))
+        parts.createSql += t->getAlterSql() + "\n";
+    else if (Domain* d = dynamic_cast<Domain*>(source))
+        addDomainChanges(*d, *dynamic_cast<Domain*>(target), parts);
+    else if (Exception* e = dynamic_cast<Exception*>(source))
+        parts.createSql += e->getAlterSql() + "\n";
+    else if (Function* f = dynamic_cast<Function*>(source))
+    {
+        parts.createSql += f->getDropSqlStatement() + "\n"
+            + f->getCreateSql() + "\n";
+    }
+    // procedures are changed by the ALTER PROCEDURE statement in the
+    // suffix, roles and sequences have nothing but their name
+}
+
+static void addChanges(MetadataItem* source, MetadataItem* target,
+    ScriptParts& parts)
+{
+    CreateDDLVisitor sourceDDL, targetDDL;
+    source->acceptVisitor(&sourceDDL);
+    target->acceptVisitor(&targetDDL);
+
+    std::set<wxString> sourceStatements, targetStatements;
+    getNormalizedStatements(sourceDDL.getPrefixSql(), sourceStatements);
+    getNormalizedStatements(targetDDL.getPrefixSql(), targetStatements);
+    DropStatements drops;
+    if (Table* t = dynamic_cast<Table*>(target))
+    {
+        // computed columns are part of the table definition, even though
+        // they are added in the suffix
+        Table* s = dynamic_cast<Table*>(source);
+        for (ColumnPtrs::iterator it = s->begin(); it != s->end(); ++it)
+            sourceStatements.insert(getComputedColumnSql((*it).get()));
+        for (ColumnPtrs::iterator it = t->begin(); it != t->end(); ++it)
+            targetStatements.insert(getComputedColumnSql((*it).get()));
+        // stored columns add an empty statement
+        sourceStatements.erase(wxEmptyString);
+        targetStatements.erase(wxEmptyString);
+        getTableDropStatements(*t, drops);
+    }
+    if (sourceStatements != targetStatements)
+        addDefinitionChanges(source, target, parts);
+
+    wxString reviewSql;
+    addStatementChanges(sourceDDL.getPostSql(), targetDDL.getPostSql(),
+        parts.postSql, reviewSql, &drops, &parts.dropConstraintSql);
+    addStatementChanges(sourceDDL.getGrantSql(), targetDDL.getGrantSql(),
+        parts.grantSql, reviewSql);
+    parts.reviewSql += reviewSql;
+}
+
+SchemaComparer::SchemaComparer(DatabasePtr source, DatabasePtr target,
+        ProgressIndicator* progressIndicator)
+    : sourceM(source), targetM(target),
+        progressIndicatorM(progressIndicator)
+{
+}
+
+void SchemaComparer::loadFingerprints(DatabasePtr database,
+    std::vector<MetadataItem*>& items, Fingerprints& fingerprints)
+{
+    ProgressIndicator* pi = progressIndicatorM;
+    if (pi)
+    {
+        pi->setProgressMessage(_("Loading metadata of ")
+            + database->getName_());
+        pi->stepProgress();
+    }
+
+    // use a single read-only transaction for metadata loading
+    MetadataLoaderTransaction tr(database->getMetadataLoader());
+    database->loadSchemaDetails();
+    getSchemaObjects(database, items);
+
+    if (pi)
+        pi->initProgress(wxEmptyString, items.size(), 0, 2);
+    fingerprints.rehash(items.size());
+    for (std::vector<MetadataItem*>::iterator it = items.begin();
+        it != items.end(); ++it)
+    {
+        if (pi)
+        {
+            checkProgressIndicatorCanceled(pi);
+            pi->setProgressMessage(_("Comparing ") + (*it)->getName_(), 2);
+            pi->stepProgress(1, 2);
+        }
+        Fingerprint& fp = fingerprints[getFingerprintKey(*it)];
+        fp.item = *it;
+        fp.hash = getFingerprintHash(*it);
+    }
+}
+
+bool SchemaComparer::compare()
+{
+    differencesM.clear();
+    ProgressIndicator* pi = progressIndicatorM;
+    if (pi)
+        pi->initProgress(wxEmptyString, 2, 0, 1);
+
+    try
+    {
+        // loading the details of all objects changes most of them
+        NotificationBatch batch("Schema compare");
+
+        std::vector<MetadataItem*> sourceItems, targetItems;
+        Fingerprints source, target;
+        loadFingerprints(sourceM, sourceItems, source);
+        loadFingerprints(targetM, targetItems, target);
+
+        // objects that exist only in the target are dropped before
+        // anything else, the ones that depend on others first
+        std::vector<MetadataItem*> extraItems;
+        for (std::vector<MetadataItem*>::iterator it = targetItems.begin();
+            it != targetItems.end(); ++it)
+        {
+            if (source.find(getFingerprintKey(*it)) == source.end())
+                extraItems.push_back(*it);
+        }
+        targetM->getDependencyGraph().sortTopologically(extraItems, true);
+        for (std::vector<MetadataItem*>::iterator it = extraItems.begin();
+            it != extraItems.end(); ++it)
+        {
+            Difference d = { dtExtra, 0, *it };
+            differencesM.push_back(d);
+        }
+
+        for (std::vector<MetadataItem*>::iterator it = sourceItems.begin();
+            it != sourceItems.end(); ++it)
+        {
+            wxString key(getFingerprintKey(*it));
+            Fingerprints::iterator fp = target.find(key);
+            if (fp == target.end())
+            {
+                Difference d = { dtMissing, *it, 0 };
+                differencesM.push_back(d);
+            }
+            else if (fp->second.hash != source[key].hash)
+            {
+                Difference d = { dtChanged, *it, fp->second.item };
+                differencesM.push_back(d);
+            }
+        }
+    }
+    catch (CancelProgressException&)
+    {
+        // this is expected if user cancels the comparison
+        differencesM.clear();
+        return false;
+    }
+
+    if (pi)
+    {
+        pi->initProgress(_("Comparison complete."), 1, 1);
+        pi->initProgress(_("Done."), 1, 1, 2);
+    }
+    return true;
+}
+
+const std::vector<SchemaComparer::Difference>&
+    SchemaComparer::getDifferences() const
+{
+    return differencesM;
+}
+
+wxString SchemaComparer::getAlterScript()
+{
+    ScriptParts parts;
+    for (std::vector<Difference>::iterator it = differencesM.begin();
+        it != differencesM.end(); ++it)
+    {
+        switch ((*it).type)
+        {
+            case dtExtra:
+                parts.dropSql += (*it).targetItem->getDropSqlStatement()
+                    + "\n";
+                break;
+            case dtMissing:
+            {
+                CreateDDLVisitor cdv;
+                (*it).sourceItem->acceptVisitor(&cdv);
+                parts.createSql += cdv.getPrefixSql();
+                parts.postSql += cdv.getPostSql();
+                parts.grantSql += cdv.getGrantSql();
+                break;
+            }
+            case dtChanged:
+                addChanges((*it).sourceItem, (*it).targetItem, parts);
+                break;
+        }
+    }
+
+    wxString sql;
+    if (!parts.dropConstraintSql.empty() || !parts.dropSql.empty())
+    {
+        // the constraints may refer to the dropped objects
+        sql << "/**************** DROPPED OBJECTS *****************/\n\n"
+            << parts.dropConstraintSql << parts.dropSql << "\n";
+    }
+    if (!parts.createSql.empty() || !parts.postSql.empty()
+        || !parts.grantSql.empty())
+    {
+        sql << "/*********** CREATED AND ALTERED OBJECTS **********/\n\n"
+            << parts.createSql << "\n" << parts.postSql << parts.grantSql;
+    }
+    if (!parts.reviewSql.empty())
+    {
+        // commented out, as they can't be reverted automatically
+        sql << "\n/*************** REVIEW MANUALLY ******************/\n"
+            << "-- " << _("Differences not handled by this script:")
+            << "\n";
+        wxStringTokenizer lines(parts.reviewSql, "\n");
+        while (lines.HasMoreTokens())
+            sql << "-- " << lines.GetNextToken() << "\n";
+    }
+    return sql;
+}
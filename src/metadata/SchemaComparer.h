@@ -0,0 +1,84 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_SCHEMACOMPARER_H
+#define FR_SCHEMACOMPARER_H
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "metadata/database.h"
+
+class ProgressIndicator;
+
+// Compares the schemas of two databases and creates the script that changes
+// the target database to match the source database.
+// Every object is reduced to a fingerprint, a hash of its DDL statements
+// with the whitespace normalized and the statements sorted, so only objects
+// with different fingerprints need their DDL compared statement by
+// statement.
+class SchemaComparer
+{
+public:
+    enum DifferenceType { dtMissing, dtChanged, dtExtra };
+    struct Difference
+    {
+        DifferenceType type;
+        // the item in the source database, 0 for dtExtra
+        MetadataItem* sourceItem;
+        // the item in the target database, 0 for dtMissing
+        MetadataItem* targetItem;
+    };
+private:
+    struct Fingerprint
+    {
+        MetadataItem* item;
+        boost::uint64_t hash;
+    };
+    typedef boost::unordered_map<wxString, Fingerprint, wxStringHash,
+        wxStringEqual> Fingerprints;
+
+    DatabasePtr sourceM;
+    DatabasePtr targetM;
+    ProgressIndicator* progressIndicatorM;
+    std::vector<Difference> differencesM;
+
+    void loadFingerprints(DatabasePtr database,
+        std::vector<MetadataItem*>& items, Fingerprints& fingerprints);
+public:
+    SchemaComparer(DatabasePtr source, DatabasePtr target,
+        ProgressIndicator* progressIndicator = 0);
+
+    // returns false if the comparison has been canceled
+    bool compare();
+    // the differences found by the last call of compare(), in the order
+    // the changes need to be applied
+    const std::vector<Difference>& getDifferences() const;
+    // needs to be called right after compare(), as the differences refer
+    // to the metadata objects that were loaded then
+    wxString getAlterScript();
+};
+
+#endif // FR_SCHEMACOMPARER_H
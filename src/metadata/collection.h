@@ -30,6 +30,9 @@
 
 #include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <wx/hashmap.h>
 
 #include "metadata/database.h"
 
@@ -57,18 +60,23 @@ protected:
         }
     };
 
-    struct InsertionPosByName
+    // helper struct for upper_bound() on the alphabetically sorted items
+    struct NameLess
     {
-        wxString nameM;
-
-        InsertionPosByName(const wxString& name) : nameM(name) {}
-        bool operator()(const MetadataItemPtr item)
+        bool operator()(const wxString& name, const MetadataItemPtr item)
         {
             wxASSERT(item);
-            return item->getName_() > nameM;
+            return name < item->getName_();
         }
     };
 
+    // helper for the name index, items are stored under their normalized
+    // identifier (as Identifier::equals() compares those)
+    static wxString getIndexKey(const wxString& name)
+    {
+        return Identifier(name).get();
+    }
+
 public:
     virtual DatabasePtr getDatabase() const
     {
@@ -87,17 +95,26 @@ public:
     typedef typename CollectionType::iterator iterator;
     typedef typename CollectionType::const_iterator const_iterator;
 private:
+    typedef typename boost::unordered_map<wxString, ItemType,
+        wxStringHash, wxStringEqual> IndexType;
+
+    // itemsM keeps the alphabetical order used for iteration (and thus for
+    // the tree), indexM allows for lookups by name in constant time
     CollectionType itemsM;
+    IndexType indexM;
 
-    iterator getPosition(const wxString& name)
+    ItemType getIndexed(const wxString& name) const
     {
-        Identifier id(name);
+        typename IndexType::const_iterator it = indexM.find(getIndexKey(name));
+        return (it != indexM.end()) ? it->second : ItemType();
+    }
+
+    void rebuildIndex()
+    {
+        indexM.clear();
+        indexM.rehash(itemsM.size());
         for (iterator it = itemsM.begin(); it != itemsM.end(); ++it)
-        {
-            if ((*it)->getIdentifier().equals(id))
-                return it;
-        }
-        return itemsM.end();
+            indexM[(*it)->getIdentifier().get()] = *it;
     }
 
 protected:
@@ -112,11 +129,12 @@ public:
     // order of item names, and returns pointer to it
     ItemType insert(const wxString& name)
     {
-        iterator pos = std::find_if(itemsM.begin(), itemsM.end(),
-            InsertionPosByName(name));
+        iterator pos = std::upper_bound(itemsM.begin(), itemsM.end(),
+            name, NameLess());
         ItemType item(new T(getDatabase(), name));
         initializeLockCount(item, getLockCount());
         itemsM.insert(pos, item);
+        indexM[item->getIdentifier().get()] = item;
         notifyObservers();
         return item;
     }
@@ -126,8 +144,13 @@ public:
     {
         if (!item)
             return;
+        typename IndexType::iterator indexPos =
+            indexM.find(item->getIdentifier().get());
+        if (indexPos == indexM.end() || indexPos->second.get() != item)
+            return;
         iterator pos = std::find_if(itemsM.begin(), itemsM.end(),
             FindByAddress(item));
+        indexM.erase(indexPos);
         if (pos != itemsM.end())
         {
             itemsM.erase(pos);
@@ -141,16 +164,13 @@ public:
         CollectionType newItems;
         for (size_t i = 0; i < names.size(); ++i)
         {
-            wxString itemName(names[i]);
-            iterator oldPos = getPosition(itemName);
-            if (oldPos == itemsM.end())
+            ItemType item(getIndexed(names[i]));
+            if (!item)
             {
-                ItemType item(new T(database, names[i]));
-                newItems.push_back(item);
+                item.reset(new T(database, names[i]));
                 initializeLockCount(item, getLockCount());
             }
-            else
-                newItems.push_back(*oldPos);
+            newItems.push_back(item);
         }
         setItems(newItems);
     }
@@ -160,6 +180,7 @@ public:
         if (itemsM != items)
         {
             itemsM = items;
+            rebuildIndex();
             notifyObservers();
         }
         setChildrenLoaded(true);
@@ -189,14 +210,14 @@ public:
         if (!itemsM.empty())
         {
             itemsM.clear();
+            indexM.clear();
             notifyObservers();
         }
     };
 
     ItemType findByName(const wxString& name)
     {
-        iterator it = getPosition(name);
-        return (it != itemsM.end()) ? (*it) : ItemType();
+        return getIndexed(name);
     };
 
     // returns vector of all subnodes
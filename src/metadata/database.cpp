@@ -35,7 +35,10 @@
 
 #include <algorithm>
 #include <functional>
+#include <set>
+#include <vector>
 
+#include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/thread.hpp>
 
@@ -44,14 +47,20 @@
 #include "core/FRError.h"
 #include "core/ProgressIndicator.h"
 #include "core/StringUtils.h"
+#include "engine/MetadataChangeDetector.h"
 #include "engine/MetadataLoader.h"
+#include "engine/MetadataSearchIndex.h"
+#include "engine/SharedAttachment.h"
+#include "logger.h"
 #include "MasterPassword.h"
 #include "metadata/column.h"
 #include "metadata/database.h"
+#include "metadata/DependencyGraph.h"
 #include "metadata/domain.h"
 #include "metadata/exception.h"
 #include "metadata/function.h"
 #include "metadata/generator.h"
+#include "metadata/MetadataCache.h"
 #include "metadata/MetadataItemVisitor.h"
 #include "metadata/parameter.h"
 #include "metadata/procedure.h"
@@ -312,7 +321,8 @@ bool DatabaseAuthenticationMode::getUseEncryptedPassword() const
 // Database class
 Database::Database()
     : MetadataItem(ntDatabase), metadataLoaderM(0), connectedM(false),
-        connectionCredentialsM(0), charsetConverterM(0), dialectM(3), idM(0)
+        connectionCredentialsM(0), charsetConverterM(0), dialectM(3), idM(0),
+        objectVersionsLoadedM(false), localChangeCountM(0)
 {
 }
 
@@ -507,21 +517,13 @@ wxString Database::getTableForIndex(const wxString& indexName)
 
 void Database::loadGeneratorValues()
 {
-    MetadataLoader* loader = getMetadataLoader();
-    // first start a transaction for metadata loading, then lock the database
-    // when objects go out of scope and are destroyed, database will be
-    // unlocked before the transaction is committed - any update() calls on
-    // observers can possibly use the same transaction
-    MetadataLoaderTransaction tr(loader);
-    SubjectLocker lock(this);
-
+    std::vector<Generator*> generators;
     for (Generators::iterator it = generatorsM->begin();
         it != generatorsM->end(); ++it)
     {
-        // make sure generator value is reloaded from database
-        (*it)->invalidate();
-        (*it)->ensurePropertiesLoaded();
+        generators.push_back((*it).get());
     }
+    Generator::loadValuesOf(getDatabase(), generators);
 }
 
 DatabasePtr Database::getDatabase() const
@@ -603,6 +605,227 @@ Relation* Database::findRelation(const Identifier& name)
     return 0;
 }
 
+void Database::loadRelationNames()
+{
+    relationNamesM.clear();
+
+    MetadataLoader* loader = getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    wxMBConv* converter = getCharsetConverter();
+
+    IBPP::Statement& st1 = loader->getStatement(
+        "select rdb$relation_id, rdb$relation_name from rdb$relations "
+        "where rdb$relation_id is not null");
+    st1->Execute();
+    while (st1->Fetch())
+    {
+        int id;
+        std::string name;
+        st1->Get(1, id);
+        st1->Get(2, name);
+        relationNamesM[id] = std2wxIdentifier(name, converter);
+    }
+}
+
+wxString Database::getRelationNameById(int relationId)
+{
+    if (!isConnected())
+        return wxEmptyString;
+
+    std::map<int, wxString>::const_iterator it =
+        relationNamesM.find(relationId);
+    if (it == relationNamesM.end())
+    {
+        // the relation may have been created since the names were loaded
+        loadRelationNames();
+        it = relationNamesM.find(relationId);
+        if (it == relationNamesM.end())
+            return wxEmptyString;
+    }
+    return (*it).second;
+}
+
+Relation* Database::findRelationById(int relationId)
+{
+    wxString name(getRelationNameById(relationId));
+    if (name.IsEmpty())
+        return 0;
+    return findRelation(Identifier(name));
+}
+
+void Database::loadSchemaDetails()
+{
+    if (!isConnected())
+        return;
+
+    DatabasePtr db(getDatabase());
+    std::vector<Relation*> relations;
+    std::vector<Table*> tables;
+    for (Tables::iterator it = tablesM->begin(); it != tablesM->end(); ++it)
+    {
+        relations.push_back((*it).get());
+        tables.push_back((*it).get());
+    }
+    for (Views::iterator it = viewsM->begin(); it != viewsM->end(); ++it)
+        relations.push_back((*it).get());
+    Relation::loadColumnsOf(db, relations);
+    Relation::loadPrivilegesOf(db, relations);
+    Table::loadConstraintsOf(db, tables);
+
+    std::vector<Procedure*> procedures;
+    for (Procedures::iterator it = proceduresM->begin();
+        it != proceduresM->end(); ++it)
+    {
+        procedures.push_back((*it).get());
+    }
+    Procedure::loadParametersOf(db, procedures);
+    Procedure::loadPrivilegesOf(db, procedures);
+
+    std::vector<Trigger*> triggers;
+    for (Triggers::iterator it = triggersM->begin(); it != triggersM->end();
+        ++it)
+    {
+        triggers.push_back((*it).get());
+    }
+    Trigger::loadPropertiesOf(db, triggers);
+}
+
+void Database::loadDescriptions(MetadataItem* item)
+{
+    // casting blobs to varchar needs Firebird 2.1
+    if (!isConnected() || !getInfo().getODSVersionIsHigherOrEqualTo(11, 1))
+        return;
+
+    std::string table, nameColumn, parentColumn;
+    MetadataItem* parent = 0;
+    std::vector<MetadataItem*> items;
+    switch (item->getType())
+    {
+        case ntTable:
+        case ntSysTable:
+        case ntView:
+            table = "rdb$relations";
+            nameColumn = "rdb$relation_name";
+            tablesM->getChildren(items);
+            sysTablesM->getChildren(items);
+            viewsM->getChildren(items);
+            break;
+        case ntProcedure:
+            table = "rdb$procedures";
+            nameColumn = "rdb$procedure_name";
+            proceduresM->getChildren(items);
+            break;
+        case ntTrigger:
+            table = "rdb$triggers";
+            nameColumn = "rdb$trigger_name";
+            triggersM->getChildren(items);
+            break;
+        case ntGenerator:
+            table = "rdb$generators";
+            nameColumn = "rdb$generator_name";
+            generatorsM->getChildren(items);
+            break;
+        case ntException:
+            table = "rdb$exceptions";
+            nameColumn = "rdb$exception_name";
+            exceptionsM->getChildren(items);
+            break;
+        case ntFunction:
+            table = "rdb$functions";
+            nameColumn = "rdb$function_name";
+            functionsM->getChildren(items);
+            break;
+        case ntRole:
+        case ntSysRole:
+            table = "rdb$roles";
+            nameColumn = "rdb$role_name";
+            rolesM->getChildren(items);
+            sysRolesM->getChildren(items);
+            break;
+        case ntDomain:
+        case ntSysDomain:
+            table = "rdb$fields";
+            nameColumn = "rdb$field_name";
+            userDomainsM->getChildren(items);
+            sysDomainsM->getChildren(items);
+            break;
+        case ntColumn:
+            table = "rdb$relation_fields";
+            nameColumn = "rdb$field_name";
+            parentColumn = "rdb$relation_name";
+            parent = item->getParent();
+            break;
+        case ntParameter:
+            table = "rdb$procedure_parameters";
+            nameColumn = "rdb$parameter_name";
+            parentColumn = "rdb$procedure_name";
+            parent = item->getParent();
+            break;
+        default:
+            return;
+    }
+    if (parent)
+        parent->getChildren(items);
+    // temporary objects and objects of other databases are loaded singly
+    if (std::find(items.begin(), items.end(), item) == items.end())
+        return;
+
+    // short descriptions are read as varchar, only longer ones as blobs
+    std::string sql("select " + nameColumn + ", "
+        "case when char_length(rdb$description) <= 8000 then "
+        "cast(rdb$description as varchar(8000) character set unicode_fss) "
+        "end, "
+        "case when char_length(rdb$description) > 8000 then "
+        "rdb$description end "
+        "from " + table + " where rdb$description is not null");
+    if (parent)
+        sql += " and " + parentColumn + " = ?";
+
+    std::map<wxString, wxString> descriptions;
+    try
+    {
+        MetadataLoader* loader = getMetadataLoader();
+        MetadataLoaderTransaction tr(loader);
+        wxMBConv* converter = getCharsetConverter();
+
+        IBPP::Statement& st1 = loader->getStatement(sql);
+        if (parent)
+            st1->Set(1, wx2std(parent->getName_(), converter));
+        st1->Execute();
+        while (st1->Fetch())
+        {
+            std::string s;
+            st1->Get(1, s);
+            wxString name(std2wxIdentifier(s, converter));
+            if (!st1->IsNull(2))
+                st1->Get(2, s);
+            else
+            {
+                IBPP::Blob b = loader->createBlob();
+                st1->Get(3, b);
+                b->Load(s);
+            }
+            descriptions[name] = wxString(s.c_str(), *converter);
+        }
+    }
+    catch (IBPP::SQLException&)
+    {
+        // the descriptions are loaded for each object then
+        return;
+    }
+
+    for (std::vector<MetadataItem*>::iterator it = items.begin();
+        it != items.end(); ++it)
+    {
+        std::map<wxString, wxString>::const_iterator itd =
+            descriptions.find((*it)->getName_());
+        if (itd != descriptions.end())
+            (*it)->setLoadedDescription((*itd).second);
+        else
+            (*it)->setLoadedDescription(wxEmptyString);
+    }
+}
+
 Relation* Database::getRelationForTrigger(Trigger* trigger)
 {
     if (!trigger)
@@ -718,11 +941,30 @@ void Database::parseCommitedSql(const SqlStatement& stm)
     if (!stm.isDDL())
         return;    // return false only on IBPP exception
 
+    // not to be reported again by the next check for metadata changes
+    addLocalChange(stm.getObjectType(), stm.getName());
+
+    // ids of dropped relations may be reused
+    if (stm.actionIs(actDROP))
+        relationNamesM.clear();
+
+    // dependencies of the changed object are reloaded when next needed
+    if (dependencyGraphM.get())
+        dependencyGraphM->invalidateObject(stm.getObjectType(), stm.getName());
+    invalidateSearchIndex();
+
     if (stm.actionIs(actGRANT))
     {
         MetadataItem *obj = stm.getObject();
         if (obj)
+        {
+            // privileges are cached by the relations and procedures
+            if (Relation* r = dynamic_cast<Relation*>(obj))
+                r->invalidatePrivileges();
+            else if (Procedure* p = dynamic_cast<Procedure*>(obj))
+                p->invalidatePrivileges();
             obj->notifyObservers();
+        }
         return;
     }
 
@@ -869,17 +1111,7 @@ void Database::parseCommitedSql(const SqlStatement& stm)
                 }
             case ntDomain:
                 object->invalidate();
-                // notify all table columns with that domain
-                for (Tables::iterator it = tablesM->begin();
-                    it != tablesM->end(); ++it)
-                {
-                    for (ColumnPtrs::iterator itColumn = (*it)->begin();
-                        itColumn != (*it)->end(); ++itColumn)
-                    {
-                        if ((*itColumn)->getSource() == stm.getName())
-                            (*itColumn)->invalidate();
-                    }
-                }
+                invalidateColumnsOfDomain(stm.getName());
                 break;
             default:
                 // calls notifyObservers() only in the base class
@@ -890,6 +1122,278 @@ void Database::parseCommitedSql(const SqlStatement& stm)
     }
 }
 
+// notify all table columns with that domain
+void Database::invalidateColumnsOfDomain(const wxString& domainName)
+{
+    for (Tables::iterator it = tablesM->begin(); it != tablesM->end(); ++it)
+    {
+        for (ColumnPtrs::iterator itColumn = (*it)->begin();
+            itColumn != (*it)->end(); ++itColumn)
+        {
+            if ((*itColumn)->getSource() == domainName)
+                (*itColumn)->invalidate();
+        }
+    }
+}
+
+void Database::checkForMetadataChanges()
+{
+    // the version markers need the HASH() function of Firebird 2.1
+    if (!isConnected() || !getInfo().getODSVersionIsHigherOrEqualTo(11, 1))
+        return;
+
+    if (!changeDetectorM.get())
+    {
+        changeDetectorM.reset(
+            new MetadataChangeDetector(getBackgroundAttachment()));
+    }
+    MetadataChangeDetector::ObjectVersions result;
+    unsigned localChangeCount;
+    if (changeDetectorM->getResult(result, localChangeCount))
+    {
+        wxMBConv* converter = getCharsetConverter();
+        std::map<wxString, int64_t> versions;
+        for (MetadataChangeDetector::ObjectVersions::const_iterator it =
+            result.begin(); it != result.end(); ++it)
+        {
+            wxString key(wxUniChar((*it).kind));
+            key += std2wxIdentifier((*it).name, converter);
+            versions[key] = (*it).version;
+        }
+        applyMetadataChanges(versions, localChangeCount);
+    }
+    changeDetectorM->start(localChangeCountM);
+}
+
+// the keys of versions are the object kind followed by the object name
+static int getObjectKind(const wxString& key)
+{
+    return int(key[0].GetValue());
+}
+
+static NodeType getNodeTypeOfKind(int kind)
+{
+    switch (kind)
+    {
+        case MetadataChangeDetector::okTable:
+            return ntTable;
+        case MetadataChangeDetector::okView:
+            return ntView;
+        case MetadataChangeDetector::okProcedure:
+            return ntProcedure;
+        case MetadataChangeDetector::okTrigger:
+            return ntTrigger;
+        case MetadataChangeDetector::okDomain:
+            return ntDomain;
+        case MetadataChangeDetector::okException:
+            return ntException;
+        case MetadataChangeDetector::okGenerator:
+            return ntGenerator;
+        case MetadataChangeDetector::okFunction:
+            return ntFunction;
+        case MetadataChangeDetector::okRole:
+            return ntRole;
+        default:
+            return ntUnknown;
+    }
+}
+
+static int getKindOfNodeType(NodeType type)
+{
+    switch (type)
+    {
+        case ntTable:
+            return MetadataChangeDetector::okTable;
+        case ntView:
+            return MetadataChangeDetector::okView;
+        case ntProcedure:
+            return MetadataChangeDetector::okProcedure;
+        case ntTrigger:
+            return MetadataChangeDetector::okTrigger;
+        case ntDomain:
+            return MetadataChangeDetector::okDomain;
+        case ntException:
+            return MetadataChangeDetector::okException;
+        case ntGenerator:
+            return MetadataChangeDetector::okGenerator;
+        case ntFunction:
+            return MetadataChangeDetector::okFunction;
+        case ntRole:
+            return MetadataChangeDetector::okRole;
+        default:
+            return 0;
+    }
+}
+
+void Database::addLocalChange(NodeType type, const wxString& name)
+{
+    int kind = getKindOfNodeType(type);
+    if (!kind || name.IsEmpty())
+        return;
+    wxString key(wxUniChar(kind));
+    key += name;
+    localChangesM[key] = ++localChangeCountM;
+}
+
+void Database::applyMetadataChanges(std::map<wxString, int64_t>& versions,
+    unsigned localChangeCount)
+{
+    // the versions read contain all local changes made before the check
+    // was started, later ones have to be skipped by the next check as well
+    std::map<wxString, unsigned> localChanges;
+    localChanges.swap(localChangesM);
+    for (std::map<wxString, unsigned>::const_iterator it =
+        localChanges.begin(); it != localChanges.end(); ++it)
+    {
+        if ((*it).second > localChangeCount)
+            localChangesM.insert(*it);
+    }
+
+    // the first check only establishes the versions to compare with
+    if (!objectVersionsLoadedM)
+    {
+        objectVersionsM.swap(versions);
+        objectVersionsLoadedM = true;
+        return;
+    }
+
+    // collections with created or dropped objects are reloaded as a whole,
+    // altered objects are invalidated and reload on demand
+    typedef std::map<wxString, int64_t>::const_iterator VersionIterator;
+    std::set<int> changedKinds;
+    std::vector<wxString> alteredObjects;
+    VersionIterator itOld = objectVersionsM.begin();
+    VersionIterator itNew = versions.begin();
+    while (itOld != objectVersionsM.end() || itNew != versions.end())
+    {
+        if (itNew == versions.end() || (itOld != objectVersionsM.end()
+            && (*itOld).first < (*itNew).first))
+        {
+            if (!localChanges.count((*itOld).first))
+                changedKinds.insert(getObjectKind((*itOld).first));
+            ++itOld;
+        }
+        else if (itOld == objectVersionsM.end()
+            || (*itNew).first < (*itOld).first)
+        {
+            if (!localChanges.count((*itNew).first))
+                changedKinds.insert(getObjectKind((*itNew).first));
+            ++itNew;
+        }
+        else
+        {
+            if ((*itOld).second != (*itNew).second
+                && !localChanges.count((*itNew).first))
+            {
+                alteredObjects.push_back((*itNew).first);
+            }
+            ++itOld;
+            ++itNew;
+        }
+    }
+    objectVersionsM.swap(versions);
+    if (changedKinds.empty() && alteredObjects.empty())
+        return;
+
+    invalidateSearchIndex();
+
+    if (dependencyGraphM.get())
+    {
+        if (!changedKinds.empty())
+            dependencyGraphM->invalidate();
+        for (std::vector<wxString>::const_iterator it = alteredObjects.begin();
+            it != alteredObjects.end(); ++it)
+        {
+            dependencyGraphM->invalidateObject(
+                getNodeTypeOfKind(getObjectKind(*it)), (*it).Mid(1));
+        }
+    }
+
+    // observers are notified only once, when the database is unlocked
+    MetadataLoader* loader = getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    NotificationBatch batch("Metadata changes");
+    SubjectLocker lock(this);
+
+    for (std::set<int>::const_iterator it = changedKinds.begin();
+        it != changedKinds.end(); ++it)
+    {
+        switch (*it)
+        {
+            case MetadataChangeDetector::okTable:
+                tablesM->load(0);
+                break;
+            case MetadataChangeDetector::okView:
+                viewsM->load(0);
+                break;
+            case MetadataChangeDetector::okProcedure:
+                proceduresM->load(0);
+                break;
+            case MetadataChangeDetector::okTrigger:
+                triggersM->load(0);
+                break;
+            case MetadataChangeDetector::okDomain:
+                userDomainsM->load(0);
+                break;
+            case MetadataChangeDetector::okException:
+                exceptionsM->load(0);
+                break;
+            case MetadataChangeDetector::okGenerator:
+                generatorsM->load(0);
+                break;
+            case MetadataChangeDetector::okFunction:
+                functionsM->load(0);
+                break;
+            case MetadataChangeDetector::okRole:
+                rolesM->load(0);
+                break;
+        }
+    }
+
+    for (std::vector<wxString>::const_iterator it = alteredObjects.begin();
+        it != alteredObjects.end(); ++it)
+    {
+        wxString name((*it).Mid(1));
+        switch (getObjectKind(*it))
+        {
+            case MetadataChangeDetector::okTable:
+                if (MetadataItem* t = findByNameAndType(ntTable, name))
+                    t->invalidate();
+                break;
+            case MetadataChangeDetector::okView:
+                if (MetadataItem* v = findByNameAndType(ntView, name))
+                    v->invalidate();
+                break;
+            case MetadataChangeDetector::okProcedure:
+                if (MetadataItem* p = findByNameAndType(ntProcedure, name))
+                    p->invalidate();
+                break;
+            case MetadataChangeDetector::okTrigger:
+                if (Trigger* t = dynamic_cast<Trigger*>(
+                    findByNameAndType(ntTrigger, name)))
+                {
+                    t->invalidate();
+                    if (Relation* r = getRelationForTrigger(t))
+                        r->notifyObservers();
+                    else  // database trigger
+                        notifyObservers();
+                }
+                break;
+            case MetadataChangeDetector::okDomain:
+                if (MetadataItem* d = findByNameAndType(ntDomain, name))
+                {
+                    d->invalidate();
+                    invalidateColumnsOfDomain(name);
+                }
+                break;
+            case MetadataChangeDetector::okException:
+                if (MetadataItem* e = findByNameAndType(ntException, name))
+                    e->invalidate();
+                break;
+        }
+    }
+}
+
 void Database::create(int pagesize, int dialect)
 {
     wxString extra_params;
@@ -911,6 +1415,12 @@ void Database::create(int pagesize, int dialect)
 
 void Database::drop()
 {
+    // the server refuses to drop a database with other attachments
+    changeDetectorM.reset();
+    searchIndexM.reset();
+    if (backgroundAttachmentM)
+        backgroundAttachmentM->closeAndWait();
+    Logger::releaseDatabase(this);
     databaseM->Drop();
     setDisconnected();
 }
@@ -920,6 +1430,11 @@ void Database::reconnect()
     // must recreate, because IBPP::Database member will become invalid
     delete metadataLoaderM;
     metadataLoaderM = 0;
+    releaseLoaderAttachments();
+    changeDetectorM.reset();
+    searchIndexM.reset();
+    closeBackgroundAttachment();
+    Logger::releaseDatabase(this);
 
     databaseM->Disconnect();
     databaseM->Connect();
@@ -994,6 +1509,92 @@ public:
     }
 };
 
+// loads the names of metadata collections on a secondary attachment in its
+// own transaction, the names are converted and merged into the collections
+// by the main thread
+class BackgroundIdentifierLoader;
+typedef boost::shared_ptr<BackgroundIdentifierLoader>
+    SharedBackgroundIdentifierLoader;
+
+class BackgroundIdentifierLoader: public BackgroundTask
+{
+private:
+    IBPP::Database databaseM;
+    std::vector<std::string> statementsM;
+    std::vector<std::vector<std::string> > identifiersM;
+    boost::mutex cancelLockM;
+    bool canceledM;
+
+    BackgroundIdentifierLoader(IBPP::Database database)
+        : databaseM(database), canceledM(false)
+    {
+    }
+
+    bool isCanceled()
+    {
+        boost::lock_guard<boost::mutex> guard(cancelLockM);
+        return canceledM;
+    }
+
+    virtual void doExecute()
+    {
+        if (!databaseM->Connected())
+            databaseM->Connect();
+        // same transaction settings as the MetadataLoader of the database
+        IBPP::Transaction tr = IBPP::TransactionFactory(databaseM,
+            IBPP::amRead);
+        tr->Start();
+        IBPP::Statement st = IBPP::StatementFactory(databaseM, tr);
+        for (size_t i = 0; i < statementsM.size(); ++i)
+        {
+            std::vector<std::string> identifiers;
+            st->Execute(statementsM[i]);
+            while (st->Fetch())
+            {
+                if (isCanceled())
+                    return;
+                if (!st->IsNull(1))
+                {
+                    std::string s;
+                    st->Get(1, s);
+                    identifiers.push_back(s);
+                }
+            }
+            identifiersM.push_back(identifiers);
+        }
+        tr->Commit();
+    }
+public:
+    static SharedBackgroundIdentifierLoader create(IBPP::Database database)
+    {
+        wxASSERT(database != 0);
+        return SharedBackgroundIdentifierLoader(
+            new BackgroundIdentifierLoader(database));
+    }
+
+    // returns the index to get the identifiers with after the task is done
+    size_t addStatement(const std::string& statement)
+    {
+        statementsM.push_back(statement);
+        return statementsM.size() - 1;
+    }
+
+    void cancel()
+    {
+        boost::lock_guard<boost::mutex> guard(cancelLockM);
+        canceledM = true;
+    }
+
+    // returns false if the statement couldn't be executed
+    bool getIdentifiers(size_t index, std::vector<std::string>& identifiers)
+    {
+        if (index >= identifiersM.size())
+            return false;
+        identifiers = identifiersM[index];
+        return true;
+    }
+};
+
 // the caller of this function should check whether the database object has the
 // password set, and if it does not, it should provide the password
 //               and if it does, just provide that password
@@ -1002,6 +1603,7 @@ void Database::connect(const wxString& password, ProgressIndicator* indicator)
     if (connectedM)
         return;
 
+    NotificationBatch batch("Connect");
     SubjectLocker lock(this);
     try
     {
@@ -1119,7 +1721,7 @@ void Database::connect(const wxString& password, ProgressIndicator* indicator)
 
                 // load collections of metadata objects
                 setChildrenLoaded(false);
-                loadCollections(indicator);
+                loadCollections(indicator, true);
                 setChildrenLoaded(true);
                 if (indicator)
                     indicator->initProgress(_("Complete"), 1, 1);
@@ -1145,7 +1747,100 @@ void Database::connect(const wxString& password, ProgressIndicator* indicator)
     }
 }
 
-void Database::loadCollections(ProgressIndicator* progressIndicator)
+// collections that are plain lists of names, the names can be loaded on
+// any attachment and are set in the main thread
+struct IdentifierCollection
+{
+    wxString name;
+    wxString key;
+    wxString statement;
+    boost::function<void (const wxArrayString&)> setItems;
+    // returns false if the collection hasn't been loaded
+    boost::function<bool (wxArrayString&)> getItems;
+};
+
+template<class T>
+static void setCollectionItems(boost::shared_ptr<T> collection,
+    const wxArrayString& names)
+{
+    collection->setItems(names);
+}
+
+template<class T>
+static bool getCollectionItems(boost::shared_ptr<T> collection,
+    wxArrayString& names)
+{
+    if (!collection->childrenLoaded())
+        return false;
+    for (typename T::iterator it = collection->begin();
+        it != collection->end(); ++it)
+    {
+        names.push_back((*it)->getName_());
+    }
+    return true;
+}
+
+template<class T>
+static void addIdentifierCollection(std::vector<IdentifierCollection>& list,
+    const wxString& name, boost::shared_ptr<T> collection)
+{
+    IdentifierCollection ic;
+    ic.name = name;
+    ic.key = collection->getTypeName();
+    ic.statement = collection->getLoadStatement();
+    if (ic.statement.empty())
+        return;
+    ic.setItems = boost::bind(&setCollectionItems<T>, collection, _1);
+    ic.getItems = boost::bind(&getCollectionItems<T>, collection, _1);
+    list.push_back(ic);
+}
+
+void Database::getIdentifierCollections(
+    std::vector<IdentifierCollection>& collections)
+{
+    addIdentifierCollection(collections, _("tables"), tablesM);
+    addIdentifierCollection(collections, _("system tables"), sysTablesM);
+    addIdentifierCollection(collections, _("views"), viewsM);
+    addIdentifierCollection(collections, _("procedures"), proceduresM);
+    addIdentifierCollection(collections, _("triggers"), triggersM);
+    addIdentifierCollection(collections, _("roles"), rolesM);
+    addIdentifierCollection(collections, _("system roles"), sysRolesM);
+    addIdentifierCollection(collections, _("functions"), functionsM);
+    addIdentifierCollection(collections, _("generators"), generatorsM);
+}
+
+// the cached names are validated by the check for metadata changes, so the
+// cache is only used when that check is enabled
+bool Database::isMetadataCacheEnabled()
+{
+    return config().get("MetadataCache", true)
+        && config().get("MetadataChangeCheckInterval", 60) > 0
+        && getInfo().getODSVersionIsHigherOrEqualTo(11, 1);
+}
+
+// the cached names must not be older than the cached versions, which is
+// why the cache is written when the database is disconnected
+void Database::saveMetadataCache()
+{
+    if (!objectVersionsLoadedM || !isMetadataCacheEnabled())
+        return;
+    MetadataCache cache(getId(), getPath(), getInfo().getODS(),
+        getInfo().getODSMinor());
+    std::vector<IdentifierCollection> collections;
+    getIdentifierCollections(collections);
+    for (size_t i = 0; i < collections.size(); ++i)
+    {
+        wxArrayString names;
+        if (collections[i].getItems(names))
+            cache.setNames(collections[i].key, names);
+    }
+    cache.setObjectVersions(MetadataCache::ObjectVersions(
+        objectVersionsM.begin(), objectVersionsM.end()));
+    cache.save();
+}
+
+void Database::loadCollections(ProgressIndicator* progressIndicator,
+    bool useCache)
 {
     // use a small helper to cut down on the repetition...
     struct ProgressIndicatorHelper
@@ -1168,45 +1863,211 @@ void Database::loadCollections(ProgressIndicator* progressIndicator)
     };
 
     const int collectionCount = 11;
-    std::string loadStmt;
     ProgressIndicatorHelper pih(progressIndicator);
 
     MetadataLoader* loader = getMetadataLoader();
     MetadataLoaderTransaction tr(loader);
     SubjectLocker lock(this);
 
-    pih.init(_("tables"), collectionCount, 0);
-    tablesM->load(progressIndicator);
+    std::vector<IdentifierCollection> collections;
+    getIdentifierCollections(collections);
 
-    pih.init(_("system tables"), collectionCount, 1);
-    sysTablesM->load(progressIndicator);
+    // the names of the collections are shown at once, the versions of the
+    // objects they were cached with are compared with the database by the
+    // first check for metadata changes in the background, which reloads
+    // the collections with created or dropped objects and invalidates the
+    // altered ones
+    bool cached = false;
+    if (useCache && isMetadataCacheEnabled())
+    {
+        MetadataCache cache(getId(), getPath(), getInfo().getODS(),
+            getInfo().getODSMinor());
+        if (cache.load())
+        {
+            pih.init(_("cached metadata"), collectionCount, 0);
+            std::vector<IdentifierCollection> uncached;
+            for (size_t i = 0; i < collections.size(); ++i)
+            {
+                wxArrayString names;
+                if (cache.getNames(collections[i].key, names))
+                    collections[i].setItems(names);
+                else
+                    uncached.push_back(collections[i]);
+            }
+            collections.swap(uncached);
+            const MetadataCache::ObjectVersions& versions(
+                cache.getObjectVersions());
+            objectVersionsM = std::map<wxString, int64_t>(versions.begin(),
+                versions.end());
+            objectVersionsLoadedM = true;
+            cached = true;
+        }
+    }
 
-    pih.init(_("views"), collectionCount, 2);
-    viewsM->load(progressIndicator);
+    std::vector<wxArrayString> names(collections.size());
+    size_t connections = std::min(size_t(std::max(0,
+        config().get("MetadataLoaderConnections", 4))), collections.size());
+    if (connections < 2)
+    {
+        int step = collectionCount - 2 - int(collections.size());
+        for (size_t i = 0; i < collections.size(); ++i)
+        {
+            pih.init(collections[i].name, collectionCount, step++);
+            names[i] = loadIdentifiers(collections[i].statement,
+                progressIndicator);
+        }
 
-    pih.init(_("procedures"), collectionCount, 3);
-    proceduresM->load(progressIndicator);
+        pih.init(_("domains"), collectionCount, step++);
+        userDomainsM->load(progressIndicator);
 
-    pih.init(_("triggers"), collectionCount, 4);
-    triggersM->load(progressIndicator);
+        pih.init(_("exceptions"), collectionCount, step++);
+        exceptionsM->load(progressIndicator);
+    }
+    else
+    {
+        std::vector<wxString> statements;
+        for (size_t i = 0; i < collections.size(); ++i)
+            statements.push_back(collections[i].statement);
+        loadIdentifiersInParallel(statements, names, connections,
+            progressIndicator);
+    }
 
-    pih.init(_("roles"), collectionCount, 5);
-    rolesM->load(progressIndicator);
+    for (size_t i = 0; i < collections.size(); ++i)
+        collections[i].setItems(names[i]);
+
+    if (cached)
+    {
+        changeDetectorM.reset(
+            new MetadataChangeDetector(getBackgroundAttachment()));
+        changeDetectorM->start(localChangeCountM);
+    }
+}
+
+// loads domains and exceptions on the main attachment, and the names of the
+// other collections on secondary attachments at the same time
+void Database::loadIdentifiersInParallel(
+    const std::vector<wxString>& statements,
+    std::vector<wxArrayString>& names, size_t connections,
+    ProgressIndicator* progressIndicator)
+{
+    const int collectionCount = 11;
+    int firstStep = collectionCount - 2 - int(statements.size());
+    if (progressIndicator)
+    {
+        progressIndicator->initProgress(_("Loading domains..."),
+            collectionCount, firstStep, 1);
+    }
 
-    pih.init(_("system roles"), collectionCount, 6);
-    sysRolesM->load(progressIndicator);
+    // distribute the collections over the secondary attachments, each of
+    // them is used by a single thread only
+    while (loaderAttachmentsM.size() < connections)
+        loaderAttachmentsM.push_back(createSecondaryAttachment());
+    std::vector<SharedBackgroundIdentifierLoader> tasks;
+    for (size_t i = 0; i < connections; ++i)
+    {
+        tasks.push_back(
+            BackgroundIdentifierLoader::create(loaderAttachmentsM[i]));
+    }
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < statements.size(); ++i)
+    {
+        indices.push_back(tasks[i % connections]->addStatement(
+            wx2std(statements[i], getCharsetConverter())));
+    }
 
-    pih.init(_("domains"), collectionCount, 7);
-    userDomainsM->load(progressIndicator);
+    std::vector<boost::shared_ptr<boost::thread> > threads;
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        threads.push_back(boost::shared_ptr<boost::thread>(new boost::thread(
+            boost::bind(&::runTask, SharedBackgroundTask(tasks[i])))));
+    }
 
-    pih.init(_("functions"), collectionCount, 8);
-    functionsM->load(progressIndicator);
+    bool canceled = false;
+    try
+    {
+        // domains and exceptions read their properties along with the
+        // names, so they are loaded on the main attachment meanwhile
+        userDomainsM->load(progressIndicator);
 
-    pih.init(_("generators"), collectionCount, 9);
-    generatorsM->load(progressIndicator);
+        if (progressIndicator)
+        {
+            progressIndicator->initProgress(_("Loading exceptions..."),
+                collectionCount, firstStep + 1, 1);
+        }
+        exceptionsM->load(progressIndicator);
 
-    pih.init(_("exceptions"), collectionCount, 10);
-    exceptionsM->load(progressIndicator);
+        if (progressIndicator)
+        {
+            progressIndicator->initProgress(
+                _("Loading tables, views, procedures and other objects..."),
+                collectionCount, firstStep + 2, 1);
+        }
+        for (size_t i = 0; i < threads.size(); ++i)
+        {
+            while (!threads[i]->timed_join(
+                boost::posix_time::milliseconds(50)))
+            {
+                if (!canceled && progressIndicator
+                    && progressIndicator->isCanceled())
+                {
+                    for (size_t j = 0; j < tasks.size(); ++j)
+                        tasks[j]->cancel();
+                    canceled = true;
+                }
+            }
+        }
+    }
+    catch (...)
+    {
+        // the attachments must not be used by any thread when the database
+        // is disconnected because of the error
+        for (size_t i = 0; i < tasks.size(); ++i)
+            tasks[i]->cancel();
+        for (size_t i = 0; i < threads.size(); ++i)
+            threads[i]->join();
+        throw;
+    }
+    checkProgressIndicatorCanceled(progressIndicator);
+
+    wxMBConv* converter = getCharsetConverter();
+    for (size_t i = 0; i < statements.size(); ++i)
+    {
+        std::vector<std::string> identifiers;
+        if (tasks[i % connections]->getIdentifiers(indices[i], identifiers))
+        {
+            for (size_t j = 0; j < identifiers.size(); ++j)
+            {
+                names[i].push_back(std2wxIdentifier(identifiers[j],
+                    converter));
+            }
+        }
+        else
+        {
+            // the secondary attachment could not be used (for example
+            // because of a connection limit), so use the main attachment
+            names[i] = loadIdentifiers(statements[i],
+                progressIndicator);
+        }
+    }
+    // the attachments are only needed while connecting, they would just
+    // occupy server connections until the database is disconnected
+    releaseLoaderAttachments();
+}
+
+// returns an unconnected attachment with the parameters of the main one
+IBPP::Database Database::createSecondaryAttachment()
+{
+    return IBPP::DatabaseFactory(databaseM->ServerName(),
+        databaseM->DatabaseName(), databaseM->Username(),
+        databaseM->UserPassword(), databaseM->RoleName(),
+        databaseM->CharSet(), "");
+}
+
+void Database::releaseLoaderAttachments()
+{
+    for (size_t i = 0; i < loaderAttachmentsM.size(); ++i)
+        disconnectAttachment(loaderAttachmentsM[i]);
+    loaderAttachmentsM.clear();
 }
 
 wxArrayString Database::loadIdentifiers(const wxString& loadStatement,
@@ -1238,6 +2099,8 @@ void Database::disconnect()
 {
     if (connectedM)
     {
+        saveMetadataCache();
+        Logger::releaseDatabase(this);
         databaseM->Disconnect();
         setDisconnected();
     }
@@ -1247,9 +2110,18 @@ void Database::setDisconnected()
 {
     delete metadataLoaderM;
     metadataLoaderM = 0;
+    releaseLoaderAttachments();
+    changeDetectorM.reset();
+    objectVersionsM.clear();
+    objectVersionsLoadedM = false;
+    localChangesM.clear();
+    dependencyGraphM.reset();
+    searchIndexM.reset();
+    closeBackgroundAttachment();
     resetCredentials();     // "forget" temporary username/password
     connectedM = false;
     resetPendingLoadData();
+    relationNamesM.clear();
 
     // remove entire DBH beneath
     userDomainsM.reset();
@@ -1277,10 +2149,65 @@ bool Database::isConnected() const
 MetadataLoader* Database::getMetadataLoader()
 {
     if (metadataLoaderM == 0)
-        metadataLoaderM = new MetadataLoader(*this, 8);
+    {
+        // the size of the prepared statement cache can be set per database
+        const wxString STATEMENT_CACHE_SIZE = "MetadataStatementCacheSize";
+
+        int size;
+        if (!DatabaseConfig(this, config()).getValue(STATEMENT_CACHE_SIZE,
+            size))
+        {
+            size = config().get(STATEMENT_CACHE_SIZE, 64);
+        }
+        metadataLoaderM = new MetadataLoader(*this, std::max(size, 1));
+    }
     return metadataLoaderM;
 }
 
+DependencyGraph& Database::getDependencyGraph()
+{
+    if (!dependencyGraphM.get())
+        dependencyGraphM.reset(new DependencyGraph(this));
+    return *dependencyGraphM;
+}
+
+MetadataSearchIndex& Database::getSearchIndex()
+{
+    checkConnected(_("getSearchIndex"));
+    if (!searchIndexM.get())
+    {
+        searchIndexM.reset(new MetadataSearchIndex(
+            getBackgroundAttachment(), getCharsetConverter()));
+    }
+    return *searchIndexM;
+}
+
+void Database::invalidateSearchIndex()
+{
+    if (searchIndexM.get())
+        searchIndexM->invalidate();
+}
+
+boost::shared_ptr<SharedAttachment> Database::getBackgroundAttachment()
+{
+    if (!backgroundAttachmentM)
+    {
+        backgroundAttachmentM.reset(
+            new SharedAttachment(createSecondaryAttachment()));
+    }
+    return backgroundAttachmentM;
+}
+
+// a task still using the attachment disconnects it when it is done
+void Database::closeBackgroundAttachment()
+{
+    if (backgroundAttachmentM)
+    {
+        backgroundAttachmentM->close();
+        backgroundAttachmentM.reset();
+    }
+}
+
 bool Database::getChildren(std::vector<MetadataItem*>& temp)
 {
     if (!connectedM)
@@ -27,6 +27,7 @@
 #include <wx/strconv.h>
 
 #include <map>
+#include <vector>
 
 #include <boost/enable_shared_from_this.hpp>
 
@@ -35,6 +36,11 @@
 #include "metadata/MetadataClasses.h"
 #include "metadata/metadataitem.h"
 
+class DependencyGraph;
+struct IdentifierCollection;
+class MetadataChangeDetector;
+class MetadataSearchIndex;
+class SharedAttachment;
 class MetadataLoader;
 class ProgressIndicator;
 class SqlStatement;
@@ -189,7 +195,52 @@ private:
     std::multimap<CharacterSet, wxString> collationsM;
     void loadCollations();
 
-    void loadCollections(ProgressIndicator* progressIndicator);
+    // relation ids are only needed to resolve the relations in the
+    // detailed database counts, so they are loaded on demand
+    std::map<int, wxString> relationNamesM;
+    void loadRelationNames();
+
+    // secondary attachments used to load the metadata collections in
+    // parallel, they are released when the collections have been loaded
+    std::vector<IBPP::Database> loaderAttachmentsM;
+    void releaseLoaderAttachments();
+
+    // version markers of all user objects, compared periodically to find
+    // the objects that were changed by other connections
+    std::auto_ptr<MetadataChangeDetector> changeDetectorM;
+    std::map<wxString, int64_t> objectVersionsM;
+    bool objectVersionsLoadedM;
+    void applyMetadataChanges(std::map<wxString, int64_t>& versions,
+        unsigned localChangeCount);
+    // objects changed by DDL committed here, with the value of
+    // localChangeCountM at the time; they are already up to date, so their
+    // new versions are taken over without reloading anything
+    unsigned localChangeCountM;
+    std::map<wxString, unsigned> localChangesM;
+    void addLocalChange(NodeType type, const wxString& name);
+    void invalidateColumnsOfDomain(const wxString& domainName);
+
+    // dependencies between all objects, loaded on first use
+    std::auto_ptr<DependencyGraph> dependencyGraphM;
+    // index for the advanced search, created on first use and kept until
+    // the database is disconnected
+    std::auto_ptr<MetadataSearchIndex> searchIndexM;
+    // attachment shared by the change detector and the search index
+    boost::shared_ptr<SharedAttachment> backgroundAttachmentM;
+    boost::shared_ptr<SharedAttachment> getBackgroundAttachment();
+    void closeBackgroundAttachment();
+
+    // the names of the collections are taken from the metadata cache if
+    // useCache is true, the first check for metadata changes validates them
+    void loadCollections(ProgressIndicator* progressIndicator,
+        bool useCache = false);
+    void getIdentifierCollections(
+        std::vector<IdentifierCollection>& collections);
+    bool isMetadataCacheEnabled();
+    void saveMetadataCache();
+    void loadIdentifiersInParallel(const std::vector<wxString>& statements,
+        std::vector<wxArrayString>& names, size_t connections,
+        ProgressIndicator* progressIndicator);
 
     // small help for parser
     wxString getTableForIndex(const wxString& indexName);
@@ -235,6 +286,14 @@ public:
     void drop();
 
     MetadataLoader* getMetadataLoader();
+    DependencyGraph& getDependencyGraph();
+    MetadataSearchIndex& getSearchIndex();
+    // to be called when a change isn't committed as DDL, like a new
+    // description
+    void invalidateSearchIndex();
+    // returns a new (not yet connected) attachment with the credentials of
+    // this one, for work done in background threads
+    IBPP::Database createSecondaryAttachment();
 
     wxArrayString loadIdentifiers(const wxString& loadStatement,
         ProgressIndicator* progressIndicator = 0);
@@ -244,12 +303,26 @@ public:
     DomainPtr getDomain(const wxString& name);
 
     void loadGeneratorValues();
+    // reloads the objects that were changed by other connections since the
+    // last call, the check itself runs in the background and its result is
+    // only applied by the next call
+    void checkForMetadataChanges();
+    // loads columns, parameters, trigger properties, table constraints and
+    // privileges of all non-system objects with one query per kind, call it
+    // before processing many objects, to avoid running these queries once
+    // for every single object
+    void loadSchemaDetails();
+    // reads the descriptions of all objects of the same type as the item
+    // (of all columns or parameters of its parent) with one query
+    void loadDescriptions(MetadataItem* item);
     Relation* getRelationForTrigger(Trigger* trigger);
 
     virtual DatabasePtr getDatabase() const;
     MetadataItem* findByNameAndType(NodeType nt, const wxString& name);
     MetadataItem* findByName(const wxString& name);
     Relation* findRelation(const Identifier& name);
+    Relation* findRelationById(int relationId);
+    wxString getRelationNameById(int relationId);
     void dropObject(MetadataItem *object);
     void addObject(NodeType type, const wxString& name);
     void parseCommitedSql(const SqlStatement& stm);     // reads a DDL statement and does accordingly
@@ -219,12 +219,17 @@ void Functions::acceptVisitor(MetadataItemVisitor* visitor)
     visitor->visitFunctions(*this);
 }
 
-void Functions::load(ProgressIndicator* progressIndicator)
+wxString Functions::getLoadStatement()
 {
-    wxString stmt = "select rdb$function_name from rdb$functions"
+    return "select rdb$function_name from rdb$functions"
         " where (rdb$system_flag = 0 or rdb$system_flag is null)"
         " order by 1";
-    setItems(getDatabase()->loadIdentifiers(stmt, progressIndicator));
+}
+
+void Functions::load(ProgressIndicator* progressIndicator)
+{
+    setItems(getDatabase()->loadIdentifiers(getLoadStatement(),
+        progressIndicator));
 }
 
 void Functions::loadChildren()
@@ -54,6 +54,7 @@ public:
     Functions(DatabasePtr database);
 
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
+    wxString getLoadStatement();
     void load(ProgressIndicator* progressIndicator);
     virtual const wxString getTypeName() const;
 };
@@ -31,6 +31,8 @@
 #endif
 
 
+#include <algorithm>
+
 #include <ibpp.h>
 
 #include "core/FRError.h"
@@ -76,6 +78,49 @@ void Generator::loadProperties()
     notifyObservers();
 }
 
+void Generator::loadValuesOf(DatabasePtr database,
+    const std::vector<Generator*>& generators)
+{
+    // keeps the statements well below the maximum statement length
+    const size_t batchSize = 256;
+
+    MetadataLoader* loader = database->getMetadataLoader();
+    // first start a transaction for metadata loading, then lock the database
+    // when objects go out of scope and are destroyed, database will be
+    // unlocked before the transaction is committed - any update() calls on
+    // observers can possibly use the same transaction
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(database.get());
+    wxMBConv* converter = database->getCharsetConverter();
+
+    for (size_t first = 0; first < generators.size(); first += batchSize)
+    {
+        size_t last = std::min(first + batchSize, generators.size());
+        // one column per generator, see loadProperties() for the names
+        std::string sql("select ");
+        for (size_t i = first; i < last; ++i)
+        {
+            if (i > first)
+                sql += ", ";
+            sql += "gen_id("
+                + wx2std(generators[i]->getQuotedName(), converter) + ", 0)";
+        }
+        sql += " from rdb$database";
+        // do not use cached statements, because this can not be reused
+        IBPP::Statement st1 = loader->createStatement(sql);
+
+        st1->Execute();
+        st1->Fetch();
+        for (size_t i = first; i < last; ++i)
+        {
+            Generator* g = generators[i];
+            st1->Get(int(i - first + 1), &g->valueM);
+            g->setPropertiesLoaded(true);
+            g->notifyObservers();
+        }
+    }
+}
+
 const wxString Generator::getTypeName() const
 {
     return "GENERATOR";
@@ -97,12 +142,17 @@ void Generators::acceptVisitor(MetadataItemVisitor* visitor)
     visitor->visitGenerators(*this);
 }
 
-void Generators::load(ProgressIndicator* progressIndicator)
+wxString Generators::getLoadStatement()
 {
-    wxString stmt = "select rdb$generator_name from rdb$generators"
+    return "select rdb$generator_name from rdb$generators"
         " where (rdb$system_flag = 0 or rdb$system_flag is null)"
         " order by 1";
-    setItems(getDatabase()->loadIdentifiers(stmt, progressIndicator));
+}
+
+void Generators::load(ProgressIndicator* progressIndicator)
+{
+    setItems(getDatabase()->loadIdentifiers(getLoadStatement(),
+        progressIndicator));
 }
 
 void Generators::loadChildren()
@@ -24,6 +24,8 @@
 #ifndef FR_GENERATOR_H
 #define FR_GENERATOR_H
 
+#include <vector>
+
 #include "metadata/collection.h"
 #include "metadata/database.h"
 
@@ -39,6 +41,11 @@ protected:
 public:
     Generator(DatabasePtr database, const wxString& name);
 
+    // reads the current values of all the generators with one statement
+    // per batch of generators, instead of one statement per generator
+    static void loadValuesOf(DatabasePtr database,
+        const std::vector<Generator*>& generators);
+
     int64_t getValue();
 
     virtual const wxString getTypeName() const;
@@ -53,6 +60,7 @@ public:
     Generators(DatabasePtr database);
 
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
+    wxString getLoadStatement();
     void load(ProgressIndicator* progressIndicator);
     virtual const wxString getTypeName() const;
 };
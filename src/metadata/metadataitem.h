@@ -113,6 +113,9 @@ public:
     bool getDescription(wxString& description);
     void invalidateDescription();
     void setDescription(const wxString& description);
+    // sets the description read together with the ones of other objects,
+    // descriptions that are loaded already are kept
+    void setLoadedDescription(const wxString& description);
 
     bool childrenLoaded() const;
     void ensureChildrenLoaded();
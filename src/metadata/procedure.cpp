@@ -33,6 +33,7 @@
 // needed for platform independent EOL
 #include <wx/textbuf.h>
 
+#include <map>
 #include <string>
 
 #include <boost/function.hpp>
@@ -50,10 +51,29 @@
 #include "metadata/procedure.h"
 
 Procedure::Procedure(DatabasePtr database, const wxString& name)
-    : MetadataItem(ntProcedure, database.get(), name)
+    : MetadataItem(ntProcedure, database.get(), name), privilegesLoadedM(false)
 {
 }
 
+// the procedure name is the last column, so the statement can be used both
+// for loading the parameters of one procedure and of all procedures
+/*static*/
+std::string Procedure::getParametersSql(DatabasePtr database)
+{
+    std::string sql(
+        "select rdb$parameter_name, rdb$field_source, "
+        "rdb$parameter_type, "
+    );
+    if (database->getInfo().getODSVersionIsHigherOrEqualTo(11, 1))
+        sql += "rdb$default_source, rdb$null_flag, rdb$parameter_mechanism, ";
+    else
+        sql += "null, null, -1, ";
+
+    sql +=  "rdb$description, rdb$procedure_name "
+            "from rdb$procedure_parameters ";
+    return sql;
+}
+
 void Procedure::loadChildren()
 {
     bool childrenWereLoaded = childrenLoaded();
@@ -73,17 +93,8 @@ void Procedure::loadChildren()
     SubjectLocker lock(db.get());
     wxMBConv* converter = db->getCharsetConverter();
 
-    std::string sql(
-        "select rdb$parameter_name, rdb$field_source, "
-        "rdb$parameter_type, "
-    );
-    if (db->getInfo().getODSVersionIsHigherOrEqualTo(11, 1))
-        sql += "rdb$default_source, rdb$null_flag, rdb$parameter_mechanism, ";
-    else
-        sql += "null, null, -1, ";
-
-    sql +=  "rdb$description from rdb$procedure_parameters "
-            "where rdb$procedure_name = ? "
+    std::string sql(getParametersSql(db));
+    sql +=  "where rdb$procedure_name = ? "
             "order by rdb$parameter_type, rdb$parameter_number";
 
     IBPP::Statement st1 = loader->getStatement(sql);
@@ -92,48 +103,124 @@ void Procedure::loadChildren()
 
     ParameterPtrs parameters;
     while (st1->Fetch())
+        parameters.push_back(readParameter(st1, converter));
+    setParameters(parameters, !childrenWereLoaded);
+}
+
+ParameterPtr Procedure::readParameter(IBPP::Statement& st1,
+    wxMBConv* converter)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString param_name(std2wxIdentifier(s, converter));
+    st1->Get(2, s);
+    wxString source(std2wxIdentifier(s, converter));
+
+    short partype, mechanism = -1;
+    st1->Get(3, &partype);
+    bool hasDefault = !st1->IsNull(4);
+    wxString defaultSrc;
+    if (hasDefault)
     {
-        std::string s;
-        st1->Get(1, s);
-        wxString param_name(std2wxIdentifier(s, converter));
-        st1->Get(2, s);
-        wxString source(std2wxIdentifier(s, converter));
-
-        short partype, mechanism = -1;
-        st1->Get(3, &partype);
-        bool hasDefault = !st1->IsNull(4);
-        wxString defaultSrc;
-        if (hasDefault)
-        {
-            st1->Get(4, s);
-            defaultSrc = std2wxIdentifier(s, converter);
-        }
-        bool notNull = false;
-        if (!st1->IsNull(5))
-            st1->Get(5, &notNull);
-        if (!st1->IsNull(6))
-            st1->Get(6, mechanism);
-        bool hasDescription = !st1->IsNull(7);
-
-        ParameterPtr par = findParameter(param_name);
-        if (!par)
-        {
-            par.reset(new Parameter(this, param_name));
-            initializeLockCount(par, getLockCount());
-        }
-        parameters.push_back(par);
-        par->initialize(source, partype, mechanism, !notNull, defaultSrc,
-            hasDefault, hasDescription);
+        st1->Get(4, s);
+        defaultSrc = std2wxIdentifier(s, converter);
     }
+    bool notNull = false;
+    if (!st1->IsNull(5))
+        st1->Get(5, &notNull);
+    if (!st1->IsNull(6))
+        st1->Get(6, mechanism);
+    bool hasDescription = !st1->IsNull(7);
+
+    ParameterPtr par = findParameter(param_name);
+    if (!par)
+    {
+        par.reset(new Parameter(this, param_name));
+        initializeLockCount(par, getLockCount());
+    }
+    par->initialize(source, partype, mechanism, !notNull, defaultSrc,
+        hasDefault, hasDescription);
+    return par;
+}
 
+void Procedure::setParameters(ParameterPtrs& parameters, bool notify)
+{
     setChildrenLoaded(true);
-    if (!childrenWereLoaded || parametersM != parameters)
+    if (notify || parametersM != parameters)
     {
         parametersM.swap(parameters);
         notifyObservers();
     }
 }
 
+/*static*/
+void Procedure::loadParametersOf(DatabasePtr database,
+    const std::vector<Procedure*>& procedures)
+{
+    std::map<wxString, Procedure*> pending;
+    for (std::vector<Procedure*>::const_iterator it = procedures.begin();
+        it != procedures.end(); ++it)
+    {
+        if (!(*it)->childrenLoaded())
+            pending[(*it)->getName_()] = *it;
+    }
+    if (pending.empty())
+        return;
+    if (pending.size() == 1)
+    {
+        (*pending.begin()).second->ensureChildrenLoaded();
+        return;
+    }
+
+    MetadataLoader* loader = database->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(database.get());
+    wxMBConv* converter = database->getCharsetConverter();
+
+    std::string sql(getParametersSql(database));
+    sql += "order by rdb$procedure_name, rdb$parameter_type, "
+        "rdb$parameter_number";
+    IBPP::Statement st1 = loader->getStatement(sql);
+    st1->Execute();
+
+    // rows are ordered by procedure, so parameters can be handed over
+    // whenever the procedure name changes
+    Procedure* current = 0;
+    ParameterPtrs parameters;
+    while (st1->Fetch())
+    {
+        std::string s;
+        st1->Get(8, s);
+        wxString procedureName(std2wxIdentifier(s, converter));
+        if (!current || current->getName_() != procedureName)
+        {
+            if (current)
+                current->setParameters(parameters, true);
+            parameters.clear();
+            std::map<wxString, Procedure*>::iterator it =
+                pending.find(procedureName);
+            if (it == pending.end())
+            {
+                current = 0;
+                continue;
+            }
+            current = (*it).second;
+            pending.erase(it);
+        }
+        parameters.push_back(current->readParameter(st1, converter));
+    }
+    if (current)
+        current->setParameters(parameters, true);
+
+    // procedures without any parameters
+    for (std::map<wxString, Procedure*>::iterator it = pending.begin();
+        it != pending.end(); ++it)
+    {
+        parameters.clear();
+        (*it).second->setParameters(parameters, true);
+    }
+}
+
 bool Procedure::getChildren(std::vector<MetadataItem *>& temp)
 {
     if (parametersM.empty())
@@ -418,9 +505,57 @@ void Procedure::checkDependentProcedures()
     }
 }
 
+// the procedure name is the last column, so the statement can be used both
+// for loading the privileges of one procedure and of all procedures
+static const char* privilegesSelectSql =
+    "select RDB$USER, RDB$USER_TYPE, RDB$GRANTOR, RDB$PRIVILEGE, "
+    "RDB$GRANT_OPTION, RDB$FIELD_NAME, RDB$RELATION_NAME "
+    "from RDB$USER_PRIVILEGES ";
+
 std::vector<Privilege>* Procedure::getPrivileges()
 {
-    // load privileges from database and return the pointer to collection
+    if (!privilegesLoadedM)
+        loadPrivileges();
+    return &privilegesM;
+}
+
+void Procedure::invalidatePrivileges()
+{
+    privilegesLoadedM = false;
+}
+
+void Procedure::invalidate()
+{
+    invalidatePrivileges();
+    MetadataItem::invalidate();
+}
+
+// rows of the same grantee have to be consecutive
+void Procedure::addPrivilegeRow(IBPP::Statement& st1, wxMBConv* converter,
+    std::string& lastUser, int& lastType)
+{
+    std::string user, grantor, privilege;
+    int usertype, grantoption = 0;
+    st1->Get(1, user);
+    st1->Get(2, usertype);
+    st1->Get(3, grantor);
+    st1->Get(4, privilege);
+    if (!st1->IsNull(5))
+        st1->Get(5, grantoption);
+    if (privilegesM.empty() || user != lastUser || usertype != lastType)
+    {
+        Privilege p(this, std2wxIdentifier(user, converter), usertype);
+        privilegesM.push_back(p);
+        lastUser = user;
+        lastType = usertype;
+    }
+    privilegesM.back().addPrivilege(privilege[0],
+        wxString(grantor.c_str(), *converter), grantoption == 1);
+}
+
+void Procedure::loadPrivileges()
+{
+    // load privileges from database
     DatabasePtr db = getDatabase();
     MetadataLoader* loader = db->getMetadataLoader();
     // first start a transaction for metadata loading, then lock the procedure
@@ -434,9 +569,7 @@ std::vector<Privilege>* Procedure::getPrivileges()
     privilegesM.clear();
 
     IBPP::Statement st1 = loader->getStatement(
-        "select RDB$USER, RDB$USER_TYPE, RDB$GRANTOR, RDB$PRIVILEGE, "
-        "RDB$GRANT_OPTION, RDB$FIELD_NAME "
-        "from RDB$USER_PRIVILEGES "
+        std::string(privilegesSelectSql) +
         "where RDB$RELATION_NAME = ? and rdb$object_type = 5 "
         "order by rdb$user, rdb$user_type, rdb$privilege"
     );
@@ -444,31 +577,64 @@ std::vector<Privilege>* Procedure::getPrivileges()
     st1->Execute();
     std::string lastuser;
     int lasttype = -1;
-    Privilege *pr = 0;
+    while (st1->Fetch())
+        addPrivilegeRow(st1, converter, lastuser, lasttype);
+    privilegesLoadedM = true;
+}
+
+void Procedure::loadPrivilegesOf(DatabasePtr database,
+    const std::vector<Procedure*>& procedures)
+{
+    std::map<wxString, Procedure*> pending;
+    for (std::vector<Procedure*>::const_iterator it = procedures.begin();
+        it != procedures.end(); ++it)
+    {
+        if (!(*it)->privilegesLoadedM)
+            pending[(*it)->getName_()] = *it;
+    }
+    if (pending.size() <= 1)
+    {
+        if (!pending.empty())
+            (*pending.begin()).second->loadPrivileges();
+        return;
+    }
+
+    MetadataLoader* loader = database->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(database.get());
+    wxMBConv* converter = database->getCharsetConverter();
+
+    std::map<wxString, Procedure*>::iterator it;
+    for (it = pending.begin(); it != pending.end(); ++it)
+        (*it).second->privilegesM.clear();
+
+    IBPP::Statement& st1 = loader->getStatement(
+        std::string(privilegesSelectSql) +
+        "where rdb$object_type = 5 "
+        "order by rdb$relation_name, rdb$user, rdb$user_type, rdb$privilege"
+    );
+    st1->Execute();
+    wxString lastProcedure;
+    Procedure* procedure = 0;
+    std::string lastuser;
+    int lasttype = -1;
     while (st1->Fetch())
     {
-        std::string user, grantor, privilege, field;
-        int usertype, grantoption = 0;
-        st1->Get(1, user);
-        st1->Get(2, usertype);
-        st1->Get(3, grantor);
-        st1->Get(4, privilege);
-        if (!st1->IsNull(5))
-            st1->Get(5, grantoption);
-        st1->Get(6, field);
-        if (!pr || user != lastuser || usertype != lasttype)
+        std::string s;
+        st1->Get(7, s);
+        wxString name(std2wxIdentifier(s, converter));
+        if (name != lastProcedure)
         {
-            Privilege p(this, std2wxIdentifier(user, converter),
-                usertype);
-            privilegesM.push_back(p);
-            pr = &privilegesM.back();
-            lastuser = user;
-            lasttype = usertype;
+            lastProcedure = name;
+            it = pending.find(name);
+            procedure = (it != pending.end()) ? (*it).second : 0;
         }
-        pr->addPrivilege(privilege[0], wxString(grantor.c_str(), *converter),
-            grantoption == 1);
+        if (procedure)
+            procedure->addPrivilegeRow(st1, converter, lastuser, lasttype);
     }
-    return &privilegesM;
+
+    for (it = pending.begin(); it != pending.end(); ++it)
+        (*it).second->privilegesLoadedM = true;
 }
 
 const wxString Procedure::getTypeName() const
@@ -492,12 +658,17 @@ void Procedures::acceptVisitor(MetadataItemVisitor* visitor)
     visitor->visitProcedures(*this);
 }
 
-void Procedures::load(ProgressIndicator* progressIndicator)
+wxString Procedures::getLoadStatement()
 {
-    wxString stmt = "select rdb$procedure_name from rdb$procedures"
+    return "select rdb$procedure_name from rdb$procedures"
         " where (rdb$system_flag = 0 or rdb$system_flag is null)"
         " order by 1";
-    setItems(getDatabase()->loadIdentifiers(stmt, progressIndicator));
+}
+
+void Procedures::load(ProgressIndicator* progressIndicator)
+{
+    setItems(getDatabase()->loadIdentifiers(getLoadStatement(),
+        progressIndicator));
 }
 
 void Procedures::loadChildren()
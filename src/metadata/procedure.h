@@ -26,6 +26,8 @@
 
 #include <vector>
 
+#include <ibpp.h>
+
 #include "metadata/collection.h"
 #include "metadata/privilege.h"
 
@@ -35,7 +37,14 @@ class Procedure : public MetadataItem
 {
 private:
     std::vector<Privilege> privilegesM;
+    bool privilegesLoadedM;
+    void loadPrivileges();
+    void addPrivilegeRow(IBPP::Statement& st1, wxMBConv* converter,
+        std::string& lastUser, int& lastType);
     ParameterPtrs parametersM;
+    static std::string getParametersSql(DatabasePtr database);
+    ParameterPtr readParameter(IBPP::Statement& st1, wxMBConv* converter);
+    void setParameters(ParameterPtrs& parameters, bool notify);
 protected:
     virtual void loadChildren();
     virtual void lockChildren();
@@ -43,6 +52,17 @@ protected:
 public:
     Procedure(DatabasePtr database, const wxString& name);
 
+    // loads the parameters of all procedures whose children are not loaded
+    // yet with a single query, instead of one query per procedure
+    static void loadParametersOf(DatabasePtr database,
+        const std::vector<Procedure*>& procedures);
+    // loads the privileges of all procedures that don't have them loaded
+    // yet with a single query
+    static void loadPrivilegesOf(DatabasePtr database,
+        const std::vector<Procedure*>& procedures);
+
+    virtual void invalidate();
+
     bool getChildren(std::vector<MetadataItem *>& temp);
 
     ParameterPtrs::iterator begin();
@@ -58,6 +78,7 @@ public:
     wxString getAlterSql(bool full = true);
     wxString getDefinition();   // used for calltip in sql editor
     std::vector<Privilege>* getPrivileges();
+    void invalidatePrivileges();
 
     void checkDependentProcedures();
 
@@ -73,6 +94,7 @@ public:
     Procedures(DatabasePtr database);
 
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
+    wxString getLoadStatement();
     void load(ProgressIndicator* progressIndicator);
     virtual const wxString getTypeName() const;
 };
@@ -30,6 +30,9 @@
     #include "wx/wx.h"
 #endif
 
+#include <algorithm>
+#include <map>
+
 #include <boost/function.hpp>
 
 #include <ibpp.h>
@@ -41,13 +44,14 @@
 #include "metadata/column.h"
 #include "metadata/CreateDDLVisitor.h"
 #include "metadata/database.h"
+#include "metadata/DependencyGraph.h"
 #include "metadata/procedure.h"
 #include "metadata/table.h"
 #include "metadata/view.h"
 #include "sql/StatementBuilder.h"
 
 Relation::Relation(NodeType type, DatabasePtr database, const wxString& name)
-    : MetadataItem(type, database.get(), name)
+    : MetadataItem(type, database.get(), name), privilegesLoadedM(false)
 {
 }
 
@@ -166,6 +170,19 @@ int Relation::getRelationType()
     return relationTypeM;
 }
 
+// the relation name is the last column, so the statement can be used both
+// for loading the columns of one relation and of all relations
+static const char* const columnsSelectSql =
+    "select r.rdb$field_name, r.rdb$null_flag, r.rdb$field_source,"
+    " l.rdb$collation_name, f.rdb$computed_source, r.rdb$default_source,"
+    " r.rdb$description, r.rdb$relation_name"
+    " from rdb$fields f"
+    " join rdb$relation_fields r "
+    "     on f.rdb$field_name=r.rdb$field_source"
+    " left outer join rdb$collations l "
+    "     on l.rdb$collation_id = r.rdb$collation_id "
+    "     and l.rdb$character_set_id = f.rdb$character_set_id";
+
 void Relation::loadChildren()
 {
     // in case an exception is thrown this should be repeated
@@ -185,15 +202,7 @@ void Relation::loadChildren()
     wxMBConv* converter = db->getCharsetConverter();
 
     IBPP::Statement& st1 = loader->getStatement(
-        "select r.rdb$field_name, r.rdb$null_flag, r.rdb$field_source,"
-        " l.rdb$collation_name, f.rdb$computed_source, r.rdb$default_source,"
-        " r.rdb$description"
-        " from rdb$fields f"
-        " join rdb$relation_fields r "
-        "     on f.rdb$field_name=r.rdb$field_source"
-        " left outer join rdb$collations l "
-        "     on l.rdb$collation_id = r.rdb$collation_id "
-        "     and l.rdb$character_set_id = f.rdb$character_set_id"
+        std::string(columnsSelectSql) +
         " where r.rdb$relation_name = ?"
         " order by r.rdb$field_position"
     );
@@ -202,42 +211,49 @@ void Relation::loadChildren()
 
     ColumnPtrs columns;
     while (st1->Fetch())
+        columns.push_back(readColumn(st1, converter));
+    setColumns(columns);
+}
+
+ColumnPtr Relation::readColumn(IBPP::Statement& st1, wxMBConv* converter)
+{
+    std::string s, coll;
+    st1->Get(1, s);
+    wxString fname(std2wxIdentifier(s, converter));
+    bool notNull = false;
+    if (!st1->IsNull(2))
+        st1->Get(2, &notNull);
+    st1->Get(3, s);
+    wxString source(std2wxIdentifier(s, converter));
+    if (!st1->IsNull(4))
+        st1->Get(4, coll);
+    wxString collation(std2wxIdentifier(coll, converter));
+    wxString computedSrc, defaultSrc;
+    readBlob(st1, 5, computedSrc, converter);
+    bool hasDefault = !st1->IsNull(6);
+    if (hasDefault)
     {
-        std::string s, coll;
-        st1->Get(1, s);
-        wxString fname(std2wxIdentifier(s, converter));
-        bool notNull = false;
-        if (!st1->IsNull(2))
-            st1->Get(2, &notNull);
-        st1->Get(3, s);
-        wxString source(std2wxIdentifier(s, converter));
-        if (!st1->IsNull(4))
-            st1->Get(4, coll);
-        wxString collation(std2wxIdentifier(coll, converter));
-        wxString computedSrc, defaultSrc;
-        readBlob(st1, 5, computedSrc, converter);
-        bool hasDefault = !st1->IsNull(6);
-        if (hasDefault)
-        {
-            readBlob(st1, 6, defaultSrc, converter);
-            // Some users reported two spaces before DEFAULT word in source
-            // Perhaps some other tools can put garbage here? Should we
-            // parse it as SQL to clean up comments, whitespace, etc?
-            defaultSrc.Trim(false).Remove(0, 8);
-        }
-        bool hasDescription = !st1->IsNull(7);
+        readBlob(st1, 6, defaultSrc, converter);
+        // Some users reported two spaces before DEFAULT word in source
+        // Perhaps some other tools can put garbage here? Should we
+        // parse it as SQL to clean up comments, whitespace, etc?
+        defaultSrc.Trim(false).Remove(0, 8);
+    }
+    bool hasDescription = !st1->IsNull(7);
 
-        ColumnPtr col = findColumn(fname);
-        if (!col)
-        {
-            col.reset(new Column(this, fname));
-            initializeLockCount(col, getLockCount());
-        }
-        columns.push_back(col);
-        col->initialize(source, computedSrc, collation, !notNull,
-            defaultSrc, hasDefault, hasDescription);
+    ColumnPtr col = findColumn(fname);
+    if (!col)
+    {
+        col.reset(new Column(this, fname));
+        initializeLockCount(col, getLockCount());
     }
+    col->initialize(source, computedSrc, collation, !notNull,
+        defaultSrc, hasDefault, hasDescription);
+    return col;
+}
 
+void Relation::setColumns(ColumnPtrs& columns)
+{
     setChildrenLoaded(true);
     if (columnsM != columns)
     {
@@ -246,6 +262,76 @@ void Relation::loadChildren()
     }
 }
 
+/*static*/
+void Relation::loadColumnsOf(DatabasePtr database,
+    const std::vector<Relation*>& relations)
+{
+    std::map<wxString, Relation*> pending;
+    for (std::vector<Relation*>::const_iterator it = relations.begin();
+        it != relations.end(); ++it)
+    {
+        if (!(*it)->childrenLoaded())
+            pending[(*it)->getName_()] = *it;
+    }
+    if (pending.empty())
+        return;
+    // a single relation is loaded with the statement for one relation,
+    // which is much more likely to be in the statement cache already
+    if (pending.size() == 1)
+    {
+        (*pending.begin()).second->ensureChildrenLoaded();
+        return;
+    }
+
+    MetadataLoader* loader = database->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(database.get());
+    wxMBConv* converter = database->getCharsetConverter();
+
+    IBPP::Statement& st1 = loader->getStatement(
+        std::string(columnsSelectSql) +
+        " order by r.rdb$relation_name, r.rdb$field_position"
+    );
+    st1->Execute();
+
+    // rows are ordered by relation, so columns can be handed over whenever
+    // the relation name changes
+    Relation* current = 0;
+    ColumnPtrs columns;
+    while (st1->Fetch())
+    {
+        std::string s;
+        st1->Get(8, s);
+        wxString relationName(std2wxIdentifier(s, converter));
+        if (!current || current->getName_() != relationName)
+        {
+            if (current)
+                current->setColumns(columns);
+            columns.clear();
+            std::map<wxString, Relation*>::iterator it =
+                pending.find(relationName);
+            if (it == pending.end())
+            {
+                current = 0;
+                continue;
+            }
+            current = (*it).second;
+            pending.erase(it);
+        }
+        columns.push_back(current->readColumn(st1, converter));
+    }
+    if (current)
+        current->setColumns(columns);
+
+    // relations without any columns
+    for (std::map<wxString, Relation*>::iterator it = pending.begin();
+        it != pending.end(); ++it)
+    {
+        columns.clear();
+        (*it).second->setColumns(columns);
+    }
+}
+
 //! holds all views + self (even if it's a table)
 void Relation::getDependentViews(std::vector<Relation *>& views,
     const wxString& forColumn)
@@ -255,12 +341,28 @@ void Relation::getDependentViews(std::vector<Relation *>& views,
         getDependencies(list, false);
     else
         getDependencies(list, false, forColumn);
+
+    // all views selecting from the directly dependent views, ordered so
+    // that every view comes before the views it selects from
+    DependencyGraph& graph = getDatabase()->getDependencyGraph();
+    std::vector<MetadataItem*> dependent;
     for (std::vector<Dependency>::iterator it = list.begin();
         it != list.end(); ++it)
     {
         View *v = dynamic_cast<View *>((*it).getDependentObject());
-        if (v && views.end() == std::find(views.begin(), views.end(), v))
-            v->getDependentViews(views);
+        if (v)
+        {
+            dependent.push_back(v);
+            graph.getClosure(v, false, dependent, ntView);
+        }
+    }
+    graph.sortTopologically(dependent, true);
+    for (std::vector<MetadataItem*>::iterator it = dependent.begin();
+        it != dependent.end(); ++it)
+    {
+        Relation* r = dynamic_cast<Relation*>(*it);
+        if (r && views.end() == std::find(views.begin(), views.end(), r))
+            views.push_back(r);
     }
 
     // add self
@@ -562,9 +664,59 @@ wxString Relation::getRebuildSql(const wxString& forColumn)
     return sql;
 }
 
+// the relation name is the last column, so the statement can be used both
+// for loading the privileges of one relation and of all relations
+static const char* privilegesSelectSql =
+    "select RDB$USER, RDB$USER_TYPE, RDB$GRANTOR, RDB$PRIVILEGE, "
+    "RDB$GRANT_OPTION, RDB$FIELD_NAME, RDB$RELATION_NAME "
+    "from RDB$USER_PRIVILEGES ";
+
 std::vector<Privilege>* Relation::getPrivileges()
 {
-    // load privileges from database and return the pointer to collection
+    if (!privilegesLoadedM)
+        loadPrivileges();
+    return &privilegesM;
+}
+
+void Relation::invalidatePrivileges()
+{
+    privilegesLoadedM = false;
+}
+
+void Relation::invalidate()
+{
+    invalidatePrivileges();
+    MetadataItem::invalidate();
+}
+
+// rows of the same grantee have to be consecutive
+void Relation::addPrivilegeRow(IBPP::Statement& st1, wxMBConv* converter,
+    std::string& lastUser, int& lastType)
+{
+    std::string user, grantor, privilege, field;
+    int usertype, grantoption = 0;
+    st1->Get(1, user);
+    st1->Get(2, usertype);
+    st1->Get(3, grantor);
+    st1->Get(4, privilege);
+    if (!st1->IsNull(5))
+        st1->Get(5, grantoption);
+    st1->Get(6, field);
+    if (privilegesM.empty() || user != lastUser || usertype != lastType)
+    {
+        Privilege p(this, wxString(user.c_str(), *converter).Strip(), usertype);
+        privilegesM.push_back(p);
+        lastUser = user;
+        lastType = usertype;
+    }
+    privilegesM.back().addPrivilege(privilege[0],
+        std2wxIdentifier(grantor, converter), grantoption == 1,
+        std2wxIdentifier(field, converter));
+}
+
+void Relation::loadPrivileges()
+{
+    // load privileges from database
     DatabasePtr db = getDatabase();
     MetadataLoader* loader = db->getMetadataLoader();
 
@@ -579,9 +731,7 @@ std::vector<Privilege>* Relation::getPrivileges()
     wxMBConv* converter = db->getCharsetConverter();
 
     IBPP::Statement& st1 = loader->getStatement(
-        "select RDB$USER, RDB$USER_TYPE, RDB$GRANTOR, RDB$PRIVILEGE, "
-        "RDB$GRANT_OPTION, RDB$FIELD_NAME "
-        "from RDB$USER_PRIVILEGES "
+        std::string(privilegesSelectSql) +
         "where RDB$RELATION_NAME = ? and rdb$object_type = 0 "
         "order by rdb$user, rdb$user_type, rdb$grant_option, rdb$privilege"
     );
@@ -589,30 +739,65 @@ std::vector<Privilege>* Relation::getPrivileges()
     st1->Execute();
     std::string lastuser;
     int lasttype = -1;
-    Privilege *pr = 0;
+    while (st1->Fetch())
+        addPrivilegeRow(st1, converter, lastuser, lasttype);
+    privilegesLoadedM = true;
+}
+
+void Relation::loadPrivilegesOf(DatabasePtr database,
+    const std::vector<Relation*>& relations)
+{
+    std::map<wxString, Relation*> pending;
+    for (std::vector<Relation*>::const_iterator it = relations.begin();
+        it != relations.end(); ++it)
+    {
+        if (!(*it)->privilegesLoadedM)
+            pending[(*it)->getName_()] = *it;
+    }
+    if (pending.size() <= 1)
+    {
+        if (!pending.empty())
+            (*pending.begin()).second->loadPrivileges();
+        return;
+    }
+
+    MetadataLoader* loader = database->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(database.get());
+    wxMBConv* converter = database->getCharsetConverter();
+
+    std::map<wxString, Relation*>::iterator it;
+    for (it = pending.begin(); it != pending.end(); ++it)
+        (*it).second->privilegesM.clear();
+
+    IBPP::Statement& st1 = loader->getStatement(
+        std::string(privilegesSelectSql) +
+        "where rdb$object_type = 0 "
+        "order by rdb$relation_name, rdb$user, rdb$user_type, "
+        "rdb$grant_option, rdb$privilege"
+    );
+    st1->Execute();
+    wxString lastRelation;
+    Relation* relation = 0;
+    std::string lastuser;
+    int lasttype = -1;
     while (st1->Fetch())
     {
-        std::string user, grantor, privilege, field;
-        int usertype, grantoption = 0;
-        st1->Get(1, user);
-        st1->Get(2, usertype);
-        st1->Get(3, grantor);
-        st1->Get(4, privilege);
-        if (!st1->IsNull(5))
-            st1->Get(5, grantoption);
-        st1->Get(6, field);
-        if (!pr || user != lastuser || usertype != lasttype)
+        std::string s;
+        st1->Get(7, s);
+        wxString name(std2wxIdentifier(s, converter));
+        if (name != lastRelation)
         {
-            Privilege p(this, wxString(user.c_str(), *converter).Strip(), usertype);
-            privilegesM.push_back(p);
-            pr = &privilegesM.back();
-            lastuser = user;
-            lasttype = usertype;
+            lastRelation = name;
+            it = pending.find(name);
+            relation = (it != pending.end()) ? (*it).second : 0;
         }
-        pr->addPrivilege(privilege[0], std2wxIdentifier(grantor, converter),
-            grantoption == 1, std2wxIdentifier(field, converter));
+        if (relation)
+            relation->addPrivilegeRow(st1, converter, lastuser, lasttype);
     }
-    return &privilegesM;
+
+    for (it = pending.begin(); it != pending.end(); ++it)
+        (*it).second->privilegesLoadedM = true;
 }
 
 //! load list of triggers for relation
@@ -620,26 +805,13 @@ std::vector<Privilege>* Relation::getPrivileges()
 void Relation::getTriggers(std::vector<Trigger *>& list,
     Trigger::FiringTime time)
 {
-    DatabasePtr db = getDatabase();
-    MetadataLoader* loader = db->getMetadataLoader();
-    MetadataLoaderTransaction tr(loader);
-    wxMBConv* converter = db->getCharsetConverter();
-
-    IBPP::Statement& st1 = loader->getStatement(
-        "select rdb$trigger_name from rdb$triggers"
-        " where rdb$relation_name = ?"
-        " order by rdb$trigger_sequence"
-    );
-    st1->Set(1, wx2std(getName_(), converter));
-    st1->Execute();
-    while (st1->Fetch())
+    std::vector<Trigger*> triggers;
+    Trigger::loadTriggersOf(getDatabase(), getName_(), triggers);
+    for (std::vector<Trigger*>::iterator it = triggers.begin();
+        it != triggers.end(); ++it)
     {
-        std::string name;
-        st1->Get(1, name);
-        Trigger* t = dynamic_cast<Trigger*>(db->findByNameAndType(ntTrigger,
-            std2wxIdentifier(name, converter)));
-        if (t && t->getFiringTime() == time)
-            list.push_back(t);
+        if ((*it)->getFiringTime() == time)
+            list.push_back(*it);
     }
 }
 
@@ -27,6 +27,8 @@
 
 #include <vector>
 
+#include <ibpp.h>
+
 #include "metadata/constraints.h"
 #include "metadata/MetadataClasses.h"
 #include "metadata/metadataitem.h"
@@ -45,9 +47,15 @@ protected:
 
     ColumnPtrs columnsM;
     std::vector<Privilege> privilegesM;
+    bool privilegesLoadedM;
+    void loadPrivileges();
+    void addPrivilegeRow(IBPP::Statement& st1, wxMBConv* converter,
+        std::string& lastUser, int& lastType);
 
     virtual void loadProperties();
     virtual void loadChildren();
+    ColumnPtr readColumn(IBPP::Statement& st1, wxMBConv* converter);
+    void setColumns(ColumnPtrs& columns);
     virtual void lockChildren();
     virtual void unlockChildren();
 
@@ -60,6 +68,17 @@ protected:
 public:
     Relation(NodeType type, DatabasePtr database, const wxString& name);
 
+    // loads the columns of all relations whose children are not loaded yet
+    // with a single query, instead of one query per relation
+    static void loadColumnsOf(DatabasePtr database,
+        const std::vector<Relation*>& relations);
+    // loads the privileges of all relations that don't have them loaded yet
+    // with a single query
+    static void loadPrivilegesOf(DatabasePtr database,
+        const std::vector<Relation*>& relations);
+
+    virtual void invalidate();
+
     wxString getOwner();
     int getRelationType();
 
@@ -73,6 +92,7 @@ public:
 
     wxString getRebuildSql(const wxString& forColumn = "");
     std::vector<Privilege>* getPrivileges();
+    void invalidatePrivileges();
     bool getChildren(std::vector<MetadataItem *>& temp);
     void getTriggers(std::vector<Trigger*>& list,
         Trigger::FiringTime time);
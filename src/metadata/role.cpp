@@ -137,15 +137,23 @@ bool SysRoles::isSystem() const
     return true;
 }
 
-void SysRoles::load(ProgressIndicator* progressIndicator)
+// returns an empty statement if the database has no system roles
+wxString SysRoles::getLoadStatement()
 {
     DatabasePtr db = getDatabase();
     if (db && db->getInfo().getODSVersionIsHigherOrEqualTo(11, 1))
     {
-        wxString stmt = "select rdb$role_name from rdb$roles"
+        return "select rdb$role_name from rdb$roles"
             " where (rdb$system_flag > 0) order by 1";
-        setItems(getDatabase()->loadIdentifiers(stmt, progressIndicator));
     }
+    return wxEmptyString;
+}
+
+void SysRoles::load(ProgressIndicator* progressIndicator)
+{
+    wxString stmt(getLoadStatement());
+    if (!stmt.empty())
+        setItems(getDatabase()->loadIdentifiers(stmt, progressIndicator));
 }
 
 void SysRoles::loadChildren()
@@ -169,14 +177,20 @@ void Roles::acceptVisitor(MetadataItemVisitor* visitor)
     visitor->visitRoles(*this);
 }
 
-void Roles::load(ProgressIndicator* progressIndicator)
+wxString Roles::getLoadStatement()
 {
     wxString stmt = "select rdb$role_name from rdb$roles";
     DatabasePtr db = getDatabase();
     if (db && db->getInfo().getODSVersionIsHigherOrEqualTo(11, 1))
         stmt += " where (rdb$system_flag = 0 or rdb$system_flag is null)";
     stmt += " order by 1";
-    setItems(getDatabase()->loadIdentifiers(stmt, progressIndicator));
+    return stmt;
+}
+
+void Roles::load(ProgressIndicator* progressIndicator)
+{
+    setItems(getDatabase()->loadIdentifiers(getLoadStatement(),
+        progressIndicator));
 }
 
 void Roles::loadChildren()
@@ -54,6 +54,7 @@ public:
 
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
     virtual bool isSystem() const;
+    wxString getLoadStatement();
     void load(ProgressIndicator* progressIndicator);
     virtual const wxString getTypeName() const;
 };
@@ -66,6 +67,7 @@ public:
     Roles(DatabasePtr database);
 
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
+    wxString getLoadStatement();
     void load(ProgressIndicator* progressIndicator);
     virtual const wxString getTypeName() const;
 };
@@ -30,6 +30,8 @@
     #include "wx/wx.h"
 #endif
 
+#include <map>
+
 #include <ibpp.h>
 
 #include "core/FRError.h"
@@ -96,6 +98,69 @@ void Table::loadChildren()
     Relation::loadChildren();
 }
 
+// the statements below select the name of the table as their last column and
+// have a where clause that the restriction to a single table can be added to,
+// so they can be used both for loading the data of one table and of all
+// tables at once
+static const char* const checkConstraintsSelectSql =
+    "select r.rdb$constraint_name, t.rdb$trigger_source, d.rdb$field_name, "
+    " r.rdb$relation_name "
+    " from rdb$relation_constraints r "
+    " join rdb$check_constraints c on r.rdb$constraint_name=c.rdb$constraint_name"
+    " join rdb$triggers t on c.rdb$trigger_name=t.rdb$trigger_name and t.rdb$trigger_type = 1 "
+    " left join rdb$dependencies d on t.rdb$trigger_name = d.rdb$dependent_name "
+    "      and d.rdb$depended_on_name = r.rdb$relation_name "
+    "      and d.rdb$depended_on_type = 0 "
+    " where r.rdb$constraint_type = 'CHECK' ";
+
+static const char* const primaryKeySelectSql =
+    "select r.rdb$constraint_name, i.rdb$field_name, r.rdb$index_name, "
+    " r.rdb$relation_name "
+    "from rdb$relation_constraints r, rdb$index_segments i "
+    "where r.rdb$index_name=i.rdb$index_name and "
+    "(r.rdb$constraint_type='PRIMARY KEY') ";
+
+static const char* const uniqueConstraintsSelectSql =
+    "select r.rdb$constraint_name, i.rdb$field_name, r.rdb$index_name, "
+    " r.rdb$relation_name "
+    "from rdb$relation_constraints r, rdb$index_segments i "
+    "where r.rdb$index_name=i.rdb$index_name and "
+    "(r.rdb$constraint_type='UNIQUE') ";
+
+static const char* const foreignKeysSelectSql =
+    "select r.rdb$constraint_name, i.rdb$field_name, c.rdb$update_rule, "
+    " c.rdb$delete_rule, c.RDB$CONST_NAME_UQ, r.rdb$index_name, "
+    " r.rdb$relation_name "
+    "from rdb$relation_constraints r, rdb$index_segments i, rdb$ref_constraints c "
+    "where r.rdb$index_name=i.rdb$index_name  "
+    "and r.rdb$constraint_name = c.rdb$constraint_name "
+    "and (r.rdb$constraint_type='FOREIGN KEY') ";
+
+static const char* const indicesSelectSql =
+    "SELECT i.rdb$index_name, i.rdb$unique_flag, i.rdb$index_inactive, "
+    " i.rdb$index_type, i.rdb$statistics, "
+    " s.rdb$field_name, rc.rdb$constraint_name, i.rdb$expression_source, "
+    " i.rdb$relation_name "
+    " from rdb$indices i "
+    " left join rdb$index_segments s on i.rdb$index_name = s.rdb$index_name "
+    " left join rdb$relation_constraints rc "
+    "   on rc.rdb$index_name = i.rdb$index_name "
+    " where i.rdb$relation_name is not null ";
+
+static std::string getTableDataSql(const char* selectSql,
+    const char* relationColumn, const char* orderBy, bool allTables)
+{
+    std::string sql(selectSql);
+    if (allTables)
+        sql += std::string(" order by ") + relationColumn + ", " + orderBy;
+    else
+    {
+        sql += std::string(" and ") + relationColumn + " = ? order by "
+            + orderBy;
+    }
+    return sql;
+}
+
 //! reads checks info from database
 void Table::loadCheckConstraints()
 {
@@ -114,46 +179,41 @@ void Table::loadCheckConstraints()
     SubjectLocker lock(this);
 
     IBPP::Statement& st1 = loader->getStatement(
-        "select r.rdb$constraint_name, t.rdb$trigger_source, d.rdb$field_name "
-        " from rdb$relation_constraints r "
-        " join rdb$check_constraints c on r.rdb$constraint_name=c.rdb$constraint_name and r.rdb$constraint_type = 'CHECK'"
-        " join rdb$triggers t on c.rdb$trigger_name=t.rdb$trigger_name and t.rdb$trigger_type = 1 "
-        " left join rdb$dependencies d on t.rdb$trigger_name = d.rdb$dependent_name "
-        "      and d.rdb$depended_on_name = r.rdb$relation_name "
-        "      and d.rdb$depended_on_type = 0 "
-        " where r.rdb$relation_name=? "
-        " order by 1 "
+        getTableDataSql(checkConstraintsSelectSql, "r.rdb$relation_name",
+            "r.rdb$constraint_name", false)
     );
 
     st1->Set(1, wx2std(getName_(), conv));
     st1->Execute();
-    CheckConstraint *cc = 0;
     while (st1->Fetch())
+        addCheckConstraintRow(st1, conv);
+    checkConstraintsLoadedM = true;
+}
+
+void Table::addCheckConstraintRow(IBPP::Statement& st1, wxMBConv* conv)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString cname(std2wxIdentifier(s, conv));
+    if (checkConstraintsM.empty()
+        || cname != checkConstraintsM.back().getName_()) // new constraint
     {
-        std::string s;
-        st1->Get(1, s);
-        wxString cname(std2wxIdentifier(s, conv));
-        if (!cc || cname != cc->getName_()) // new constraint
-        {
-            wxString source;
-            readBlob(st1, 2, source, conv);
-
-            CheckConstraint c;
-            c.setParent(this);
-            c.setName_(cname);
-            c.sourceM = source;
-            checkConstraintsM.push_back(c);
-            cc = &checkConstraintsM.back();
-        }
+        wxString source;
+        readBlob(st1, 2, source, conv);
+
+        CheckConstraint c;
+        c.setParent(this);
+        c.setName_(cname);
+        c.sourceM = source;
+        checkConstraintsM.push_back(c);
+    }
 
-        if (!st1->IsNull(3))
-        {
-            st1->Get(3, s);
-            wxString fname(std2wxIdentifier(s, conv));
-            cc->columnsM.push_back(fname);
-        }
+    if (!st1->IsNull(3))
+    {
+        st1->Get(3, s);
+        wxString fname(std2wxIdentifier(s, conv));
+        checkConstraintsM.back().columnsM.push_back(fname);
     }
-    checkConstraintsLoadedM = true;
 }
 
 //! reads primary key info from database
@@ -174,32 +234,33 @@ void Table::loadPrimaryKey()
     SubjectLocker lock(this);
 
     IBPP::Statement& st1 = loader->getStatement(
-        "select r.rdb$constraint_name, i.rdb$field_name, r.rdb$index_name "
-        "from rdb$relation_constraints r, rdb$index_segments i "
-        "where r.rdb$relation_name=? and r.rdb$index_name=i.rdb$index_name and "
-        "(r.rdb$constraint_type='PRIMARY KEY') order by r.rdb$constraint_name, i.rdb$field_position"
+        getTableDataSql(primaryKeySelectSql, "r.rdb$relation_name",
+            "r.rdb$constraint_name, i.rdb$field_position", false)
     );
 
     st1->Set(1, wx2std(getName_(), conv));
     st1->Execute();
     while (st1->Fetch())
-    {
-        std::string s;
-        st1->Get(1, s);
-        wxString cname(std2wxIdentifier(s, conv));
-        st1->Get(2, s);
-        wxString fname(std2wxIdentifier(s, conv));
-        st1->Get(3, s);
-        wxString ixname(std2wxIdentifier(s, conv));
-
-        primaryKeyM.setName_(cname);
-        primaryKeyM.columnsM.push_back(fname);
-        primaryKeyM.indexNameM = ixname;
-    }
+        addPrimaryKeyRow(st1, conv);
     primaryKeyM.setParent(this);
     primaryKeyLoadedM = true;
 }
 
+void Table::addPrimaryKeyRow(IBPP::Statement& st1, wxMBConv* conv)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString cname(std2wxIdentifier(s, conv));
+    st1->Get(2, s);
+    wxString fname(std2wxIdentifier(s, conv));
+    st1->Get(3, s);
+    wxString ixname(std2wxIdentifier(s, conv));
+
+    primaryKeyM.setName_(cname);
+    primaryKeyM.columnsM.push_back(fname);
+    primaryKeyM.indexNameM = ixname;
+}
+
 //! reads uniques from database
 void Table::loadUniqueConstraints()
 {
@@ -218,39 +279,42 @@ void Table::loadUniqueConstraints()
     SubjectLocker lock(this);
 
     IBPP::Statement& st1 = loader->getStatement(
-        "select r.rdb$constraint_name, i.rdb$field_name, r.rdb$index_name "
-        "from rdb$relation_constraints r, rdb$index_segments i "
-        "where r.rdb$relation_name=? and r.rdb$index_name=i.rdb$index_name and "
-        "(r.rdb$constraint_type='UNIQUE') order by r.rdb$constraint_name, i.rdb$field_position"
+        getTableDataSql(uniqueConstraintsSelectSql, "r.rdb$relation_name",
+            "r.rdb$constraint_name, i.rdb$field_position", false)
     );
 
     st1->Set(1, wx2std(getName_(), conv));
     st1->Execute();
-    UniqueConstraint *cc = 0;
     while (st1->Fetch())
-    {
-        std::string s;
-        st1->Get(1, s);
-        wxString cname(std2wxIdentifier(s, conv));
-        st1->Get(2, s);
-        wxString fname(std2wxIdentifier(s, conv));
-        st1->Get(3, s);
-        wxString ixname(std2wxIdentifier(s, conv));
+        addUniqueConstraintRow(st1, conv);
+    uniqueConstraintsLoadedM = true;
+}
 
-        if (cc && cc->getName_() == cname)
-            cc->columnsM.push_back(fname);
-        else
-        {
-            UniqueConstraint c;
-            uniqueConstraintsM.push_back(c);
-            cc = &uniqueConstraintsM.back();
-            cc->indexNameM = ixname;
-            cc->setName_(cname);
-            cc->columnsM.push_back(fname);
-            cc->setParent(this);
-        }
+void Table::addUniqueConstraintRow(IBPP::Statement& st1, wxMBConv* conv)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString cname(std2wxIdentifier(s, conv));
+    st1->Get(2, s);
+    wxString fname(std2wxIdentifier(s, conv));
+    st1->Get(3, s);
+    wxString ixname(std2wxIdentifier(s, conv));
+
+    if (!uniqueConstraintsM.empty()
+        && uniqueConstraintsM.back().getName_() == cname)
+    {
+        uniqueConstraintsM.back().columnsM.push_back(fname);
+    }
+    else
+    {
+        UniqueConstraint c;
+        uniqueConstraintsM.push_back(c);
+        UniqueConstraint* cc = &uniqueConstraintsM.back();
+        cc->indexNameM = ixname;
+        cc->setName_(cname);
+        cc->columnsM.push_back(fname);
+        cc->setParent(this);
     }
-    uniqueConstraintsLoadedM = true;
 }
 
 PrimaryKeyConstraint *Table::getPrimaryKey()
@@ -303,12 +367,8 @@ void Table::loadForeignKeys()
     SubjectLocker lock(this);
 
     IBPP::Statement& st1 = loader->getStatement(
-        "select r.rdb$constraint_name, i.rdb$field_name, c.rdb$update_rule, "
-        " c.rdb$delete_rule, c.RDB$CONST_NAME_UQ, r.rdb$index_name "
-        "from rdb$relation_constraints r, rdb$index_segments i, rdb$ref_constraints c "
-        "where r.rdb$relation_name=? and r.rdb$index_name=i.rdb$index_name  "
-        "and r.rdb$constraint_name = c.rdb$constraint_name "
-        "and (r.rdb$constraint_type='FOREIGN KEY') order by 1, i.rdb$field_position"
+        getTableDataSql(foreignKeysSelectSql, "r.rdb$relation_name",
+            "r.rdb$constraint_name, i.rdb$field_position", false)
     );
 
     IBPP::Statement& st2 = loader->getStatement(
@@ -321,52 +381,63 @@ void Table::loadForeignKeys()
 
     st1->Set(1, wx2std(getName_(), conv));
     st1->Execute();
-    ForeignKey *fkp = 0;
     while (st1->Fetch())
     {
-        std::string s;
-        st1->Get(1, s);
-        wxString cname(std2wxIdentifier(s, conv));
-        st1->Get(2, s);
-        wxString fname(std2wxIdentifier(s, conv));
-        st1->Get(3, s);
-        wxString update_rule(std2wxIdentifier(s, conv));
-        st1->Get(4, s);
-        wxString delete_rule(std2wxIdentifier(s, conv));
-        std::string ref_constraint;
-        st1->Get(5, ref_constraint);
-        st1->Get(6, s);
-        wxString ixname(std2wxIdentifier(s, conv));
+        ForeignKey* fkp = addForeignKeyRow(st1, conv);
+        if (!fkp)
+            continue;
 
-        if (fkp && fkp->getName_() == cname) // add column
-            fkp->columnsM.push_back(fname);
-        else
+        std::string ref_constraint, s;
+        st1->Get(5, ref_constraint);
+        st2->Set(1, ref_constraint);
+        st2->Execute();
+        std::string rtable;
+        while (st2->Fetch())
         {
-            ForeignKey fk;
-            foreignKeysM.push_back(fk);
-            fkp = &foreignKeysM.back();
-            fkp->setName_(cname);
-            fkp->setParent(this);
-            fkp->updateActionM = update_rule;
-            fkp->deleteActionM = delete_rule;
-            fkp->indexNameM = ixname;
-
-            st2->Set(1, ref_constraint);
-            st2->Execute();
-            std::string rtable;
-            while (st2->Fetch())
-            {
-                st2->Get(1, rtable);
-                st2->Get(2, s);
-                fkp->referencedColumnsM.push_back(std2wxIdentifier(s, conv));
-            }
-            fkp->referencedTableM = std2wxIdentifier(rtable, conv);
-            fkp->columnsM.push_back(fname);
+            st2->Get(1, rtable);
+            st2->Get(2, s);
+            fkp->referencedColumnsM.push_back(std2wxIdentifier(s, conv));
         }
+        fkp->referencedTableM = std2wxIdentifier(rtable, conv);
     }
     foreignKeysLoadedM = true;
 }
 
+//! returns the foreign key if the row starts a new one, or 0 if the row
+//! only adds a column to the previous one
+ForeignKey* Table::addForeignKeyRow(IBPP::Statement& st1, wxMBConv* conv)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString cname(std2wxIdentifier(s, conv));
+    st1->Get(2, s);
+    wxString fname(std2wxIdentifier(s, conv));
+
+    if (!foreignKeysM.empty() && foreignKeysM.back().getName_() == cname)
+    {
+        foreignKeysM.back().columnsM.push_back(fname);
+        return 0;
+    }
+
+    st1->Get(3, s);
+    wxString update_rule(std2wxIdentifier(s, conv));
+    st1->Get(4, s);
+    wxString delete_rule(std2wxIdentifier(s, conv));
+    st1->Get(6, s);
+    wxString ixname(std2wxIdentifier(s, conv));
+
+    ForeignKey fk;
+    foreignKeysM.push_back(fk);
+    ForeignKey* fkp = &foreignKeysM.back();
+    fkp->setName_(cname);
+    fkp->setParent(this);
+    fkp->updateActionM = update_rule;
+    fkp->deleteActionM = delete_rule;
+    fkp->indexNameM = ixname;
+    fkp->columnsM.push_back(fname);
+    return fkp;
+}
+
 //! reads indices from database
 void Table::loadIndices()
 {
@@ -385,70 +456,247 @@ void Table::loadIndices()
     SubjectLocker lock(this);
 
     IBPP::Statement& st1 = loader->getStatement(
-        "SELECT i.rdb$index_name, i.rdb$unique_flag, i.rdb$index_inactive, "
-        " i.rdb$index_type, i.rdb$statistics, "
-        " s.rdb$field_name, rc.rdb$constraint_name, i.rdb$expression_source "
-        " from rdb$indices i "
-        " left join rdb$index_segments s on i.rdb$index_name = s.rdb$index_name "
-        " left join rdb$relation_constraints rc "
-        "   on rc.rdb$index_name = i.rdb$index_name "
-        " where i.rdb$relation_name = ? "
-        " order by i.rdb$index_name, s.rdb$field_position "
+        getTableDataSql(indicesSelectSql, "i.rdb$relation_name",
+            "i.rdb$index_name, s.rdb$field_position", false)
     );
 
     st1->Set(1, wx2std(getName_(), conv));
     st1->Execute();
-    Index* i = 0;
+    while (st1->Fetch())
+        addIndexRow(st1, conv);
+    indicesLoadedM = true;
+}
+
+void Table::addIndexRow(IBPP::Statement& st1, wxMBConv* conv)
+{
+    std::string s;
+    st1->Get(1, s);
+    wxString ixname(std2wxIdentifier(s, conv));
+
+    short unq, inactive, type;
+    if (st1->IsNull(2))     // null = non-unique
+        unq = 0;
+    else
+        st1->Get(2, unq);
+    if (st1->IsNull(3))     // null = active
+        inactive = 0;
+    else
+        st1->Get(3, inactive);
+    if (st1->IsNull(4))     // null = ascending
+        type = 0;
+    else
+        st1->Get(4, type);
+    double statistics;
+    if (st1->IsNull(5))     // this can happen, see bug #1825725
+        statistics = -1;
+    else
+        st1->Get(5, statistics);
+
+    st1->Get(6, s);
+    wxString fname(std2wxIdentifier(s, conv));
+    wxString expression;
+    readBlob(st1, 8, expression, conv);
+
+    if (!indicesM.empty() && indicesM.back().getName_() == ixname)
+        indicesM.back().getSegments()->push_back(fname);
+    else
+    {
+        Index x(
+            unq == 1,
+            inactive == 0,
+            type == 0,
+            statistics,
+            !st1->IsNull(7),
+            expression
+        );
+        indicesM.push_back(x);
+        Index* i = &indicesM.back();
+        i->setName_(ixname);
+        i->getSegments()->push_back(fname);
+        i->setParent(this);
+    }
+}
+
+//! executes a statement for all tables and hands each row over to the
+//! table it belongs to, rows of tables not in the map are skipped
+/*static*/
+void Table::readTableRows(IBPP::Statement& st1, int relationColumn,
+    wxMBConv* conv, const std::map<wxString, Table*>& tables,
+    RowReader reader)
+{
+    st1->Execute();
+    Table* current = 0;
+    wxString currentName;
     while (st1->Fetch())
     {
         std::string s;
-        st1->Get(1, s);
-        wxString ixname(std2wxIdentifier(s, conv));
+        st1->Get(relationColumn, s);
+        wxString relationName(std2wxIdentifier(s, conv));
+        if (!current || relationName != currentName)
+        {
+            std::map<wxString, Table*>::const_iterator it =
+                tables.find(relationName);
+            current = (it != tables.end()) ? (*it).second : 0;
+            currentName = relationName;
+            if (!current)
+                continue;
+        }
+        (current->*reader)(st1, conv);
+    }
+}
 
-        short unq, inactive, type;
-        if (st1->IsNull(2))     // null = non-unique
-            unq = 0;
-        else
-            st1->Get(2, unq);
-        if (st1->IsNull(3))     // null = active
-            inactive = 0;
-        else
-            st1->Get(3, inactive);
-        if (st1->IsNull(4))     // null = ascending
-            type = 0;
-        else
-            st1->Get(4, type);
-        double statistics;
-        if (st1->IsNull(5))     // this can happen, see bug #1825725
-            statistics = -1;
-        else
-            st1->Get(5, statistics);
+/*static*/
+void Table::loadConstraintsOf(DatabasePtr database,
+    const std::vector<Table*>& tables)
+{
+    std::map<wxString, Table*> checks, primaryKeys, uniques, foreignKeys,
+        indices;
+    for (std::vector<Table*>::const_iterator it = tables.begin();
+        it != tables.end(); ++it)
+    {
+        Table* t = *it;
+        if (!t->checkConstraintsLoadedM)
+            checks[t->getName_()] = t;
+        if (!t->primaryKeyLoadedM)
+            primaryKeys[t->getName_()] = t;
+        if (!t->uniqueConstraintsLoadedM)
+            uniques[t->getName_()] = t;
+        if (!t->foreignKeysLoadedM)
+            foreignKeys[t->getName_()] = t;
+        if (!t->indicesLoadedM)
+            indices[t->getName_()] = t;
+    }
+    // a single table is loaded with the statements for one table, which are
+    // much more likely to be in the statement cache already
+    if (checks.size() <= 1 && primaryKeys.size() <= 1 && uniques.size() <= 1
+        && foreignKeys.size() <= 1 && indices.size() <= 1)
+    {
+        for (std::vector<Table*>::const_iterator it = tables.begin();
+            it != tables.end(); ++it)
+        {
+            (*it)->loadCheckConstraints();
+            (*it)->loadPrimaryKey();
+            (*it)->loadUniqueConstraints();
+            (*it)->loadForeignKeys();
+            (*it)->loadIndices();
+        }
+        return;
+    }
 
-        st1->Get(6, s);
-        wxString fname(std2wxIdentifier(s, conv));
-        wxString expression;
-        readBlob(st1, 8, expression, conv);
+    wxMBConv* conv = database->getCharsetConverter();
+    MetadataLoader* loader = database->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(database.get());
 
-        if (i && i->getName_() == ixname)
-            i->getSegments()->push_back(fname);
-        else
+    std::map<wxString, Table*>::iterator it;
+    if (!checks.empty())
+    {
+        for (it = checks.begin(); it != checks.end(); ++it)
+            (*it).second->checkConstraintsM.clear();
+        readTableRows(loader->getStatement(
+            getTableDataSql(checkConstraintsSelectSql, "r.rdb$relation_name",
+                "r.rdb$constraint_name", true)),
+            4, conv, checks, &Table::addCheckConstraintRow);
+        for (it = checks.begin(); it != checks.end(); ++it)
+            (*it).second->checkConstraintsLoadedM = true;
+    }
+
+    if (!primaryKeys.empty())
+    {
+        for (it = primaryKeys.begin(); it != primaryKeys.end(); ++it)
+            (*it).second->primaryKeyM.columnsM.clear();
+        readTableRows(loader->getStatement(
+            getTableDataSql(primaryKeySelectSql, "r.rdb$relation_name",
+                "r.rdb$constraint_name, i.rdb$field_position", true)),
+            4, conv, primaryKeys, &Table::addPrimaryKeyRow);
+        for (it = primaryKeys.begin(); it != primaryKeys.end(); ++it)
         {
-            Index x(
-                unq == 1,
-                inactive == 0,
-                type == 0,
-                statistics,
-                !st1->IsNull(7),
-                expression
-            );
-            indicesM.push_back(x);
-            i = &indicesM.back();
-            i->setName_(ixname);
-            i->getSegments()->push_back(fname);
-            i->setParent(this);
+            Table* t = (*it).second;
+            t->primaryKeyM.setParent(t);
+            t->primaryKeyLoadedM = true;
         }
     }
-    indicesLoadedM = true;
+
+    if (!uniques.empty())
+    {
+        for (it = uniques.begin(); it != uniques.end(); ++it)
+            (*it).second->uniqueConstraintsM.clear();
+        readTableRows(loader->getStatement(
+            getTableDataSql(uniqueConstraintsSelectSql, "r.rdb$relation_name",
+                "r.rdb$constraint_name, i.rdb$field_position", true)),
+            4, conv, uniques, &Table::addUniqueConstraintRow);
+        for (it = uniques.begin(); it != uniques.end(); ++it)
+            (*it).second->uniqueConstraintsLoadedM = true;
+    }
+
+    if (!foreignKeys.empty())
+    {
+        for (it = foreignKeys.begin(); it != foreignKeys.end(); ++it)
+            (*it).second->foreignKeysM.clear();
+
+        // columns of all referenced primary keys and unique constraints
+        typedef std::pair<wxString, std::vector<wxString> > ReferencedKey;
+        std::map<wxString, ReferencedKey> referenced;
+        IBPP::Statement& st2 = loader->getStatement(
+            "select r.rdb$constraint_name, r.rdb$relation_name,"
+            " i.rdb$field_name"
+            " from rdb$relation_constraints r"
+            " join rdb$index_segments i on i.rdb$index_name = r.rdb$index_name "
+            " where r.rdb$constraint_type in ('PRIMARY KEY', 'UNIQUE')"
+            " order by r.rdb$constraint_name, i.rdb$field_position "
+        );
+        st2->Execute();
+        while (st2->Fetch())
+        {
+            std::string s;
+            st2->Get(1, s);
+            ReferencedKey& key(referenced[std2wxIdentifier(s, conv)]);
+            st2->Get(2, s);
+            key.first = std2wxIdentifier(s, conv);
+            st2->Get(3, s);
+            key.second.push_back(std2wxIdentifier(s, conv));
+        }
+
+        IBPP::Statement& st1 = loader->getStatement(
+            getTableDataSql(foreignKeysSelectSql, "r.rdb$relation_name",
+                "r.rdb$constraint_name, i.rdb$field_position", true)
+        );
+        st1->Execute();
+        while (st1->Fetch())
+        {
+            std::string s;
+            st1->Get(7, s);
+            it = foreignKeys.find(std2wxIdentifier(s, conv));
+            if (it == foreignKeys.end())
+                continue;
+            ForeignKey* fkp = (*it).second->addForeignKeyRow(st1, conv);
+            if (!fkp)
+                continue;
+
+            st1->Get(5, s);
+            std::map<wxString, ReferencedKey>::const_iterator itRef =
+                referenced.find(std2wxIdentifier(s, conv));
+            if (itRef != referenced.end())
+            {
+                fkp->referencedTableM = (*itRef).second.first;
+                fkp->referencedColumnsM = (*itRef).second.second;
+            }
+        }
+        for (it = foreignKeys.begin(); it != foreignKeys.end(); ++it)
+            (*it).second->foreignKeysLoadedM = true;
+    }
+
+    if (!indices.empty())
+    {
+        for (it = indices.begin(); it != indices.end(); ++it)
+            (*it).second->indicesM.clear();
+        readTableRows(loader->getStatement(
+            getTableDataSql(indicesSelectSql, "i.rdb$relation_name",
+                "i.rdb$index_name, s.rdb$field_position", true)),
+            9, conv, indices, &Table::addIndexRow);
+        for (it = indices.begin(); it != indices.end(); ++it)
+            (*it).second->indicesLoadedM = true;
+    }
 }
 
 const wxString Table::getTypeName() const
@@ -527,12 +775,17 @@ bool SysTables::isSystem() const
     return true;
 }
 
-void SysTables::load(ProgressIndicator* progressIndicator)
+wxString SysTables::getLoadStatement()
 {
-    wxString stmt = "select rdb$relation_name from rdb$relations"
+    return "select rdb$relation_name from rdb$relations"
         " where rdb$system_flag = 1"
         " and rdb$view_source is null order by 1";
-    setItems(getDatabase()->loadIdentifiers(stmt, progressIndicator));
+}
+
+void SysTables::load(ProgressIndicator* progressIndicator)
+{
+    setItems(getDatabase()->loadIdentifiers(getLoadStatement(),
+        progressIndicator));
 }
 
 void SysTables::loadChildren()
@@ -556,12 +809,17 @@ void Tables::acceptVisitor(MetadataItemVisitor* visitor)
     visitor->visitTables(*this);
 }
 
-void Tables::load(ProgressIndicator* progressIndicator)
+wxString Tables::getLoadStatement()
 {
-    wxString stmt = "select rdb$relation_name from rdb$relations"
+    return "select rdb$relation_name from rdb$relations"
         " where (rdb$system_flag = 0 or rdb$system_flag is null)"
         " and rdb$view_source is null order by 1";
-    setItems(getDatabase()->loadIdentifiers(stmt, progressIndicator));
+}
+
+void Tables::load(ProgressIndicator* progressIndicator)
+{
+    setItems(getDatabase()->loadIdentifiers(getLoadStatement(),
+        progressIndicator));
 }
 
 void Tables::loadChildren()
@@ -25,6 +25,10 @@
 #ifndef FR_TABLE_H
 #define FR_TABLE_H
 
+#include <map>
+
+#include <ibpp.h>
+
 #include "metadata/collection.h"
 #include "metadata/constraints.h"
 #include "metadata/Index.h"
@@ -36,25 +40,35 @@ private:
     PrimaryKeyConstraint primaryKeyM;           // table can have only one pk
     bool primaryKeyLoadedM;
     void loadPrimaryKey();
+    void addPrimaryKeyRow(IBPP::Statement& st1, wxMBConv* conv);
 
     std::vector<ForeignKey> foreignKeysM;
     bool foreignKeysLoadedM;
     void loadForeignKeys();
+    ForeignKey* addForeignKeyRow(IBPP::Statement& st1, wxMBConv* conv);
 
     std::vector<CheckConstraint> checkConstraintsM;
     bool checkConstraintsLoadedM;
     void loadCheckConstraints();
+    void addCheckConstraintRow(IBPP::Statement& st1, wxMBConv* conv);
 
     std::vector<UniqueConstraint> uniqueConstraintsM;
     bool uniqueConstraintsLoadedM;
     void loadUniqueConstraints();
+    void addUniqueConstraintRow(IBPP::Statement& st1, wxMBConv* conv);
 
     std::vector<Index> indicesM;
     bool indicesLoadedM;
     void loadIndices();
+    void addIndexRow(IBPP::Statement& st1, wxMBConv* conv);
 
     wxString externalPathM;
 
+    typedef void (Table::*RowReader)(IBPP::Statement& st1, wxMBConv* conv);
+    static void readTableRows(IBPP::Statement& st1, int relationColumn,
+        wxMBConv* conv, const std::map<wxString, Table*>& tables,
+        RowReader reader);
+
 protected:
     virtual void setExternalFilePath(const wxString& value);
 
@@ -66,6 +80,11 @@ public:
     static bool tablesRelate(const std::vector<wxString>& tables,
         Table *table, std::vector<ForeignKey>& list);
 
+    // loads constraints and indices of all tables that don't have them
+    // loaded yet with one query per kind, instead of one per table
+    static void loadConstraintsOf(DatabasePtr database,
+        const std::vector<Table*>& tables);
+
     void invalidateIndices(const wxString& forIndex = wxEmptyString);
 
     wxString getExternalPath();
@@ -89,6 +108,7 @@ public:
 
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
     virtual bool isSystem() const;
+    wxString getLoadStatement();
     void load(ProgressIndicator* progressIndicator);
     virtual const wxString getTypeName() const;
 };
@@ -101,6 +121,7 @@ public:
     Tables(DatabasePtr database);
 
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
+    wxString getLoadStatement();
     void load(ProgressIndicator* progressIndicator);
     virtual const wxString getTypeName() const;
 };
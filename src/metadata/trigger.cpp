@@ -30,6 +30,8 @@
     #include "wx/wx.h"
 #endif
 
+#include <map>
+
 #include <ibpp.h>
 
 #include "core/FRError.h"
@@ -153,6 +155,12 @@ wxString Trigger::getSource()
     return sourceM;
 }
 
+// the columns read by readProperties(), followed by the trigger name
+static const char* const triggerSelectSql =
+    "select t.rdb$relation_name, t.rdb$trigger_sequence, "
+    "t.rdb$trigger_inactive, t.rdb$trigger_type, t.rdb$trigger_source, "
+    "t.rdb$trigger_name from rdb$triggers t ";
+
 void Trigger::loadProperties()
 {
     setPropertiesLoaded(false);
@@ -162,36 +170,13 @@ void Trigger::loadProperties()
     MetadataLoaderTransaction tr(loader);
 
     IBPP::Statement& st1 = loader->getStatement(
-        "select t.rdb$relation_name, t.rdb$trigger_sequence, "
-        "t.rdb$trigger_inactive, t.rdb$trigger_type, rdb$trigger_source "
-        "from rdb$triggers t where rdb$trigger_name = ? "
+        std::string(triggerSelectSql) + "where t.rdb$trigger_name = ?"
     );
 
     st1->Set(1, wx2std(getName_(), db->getCharsetConverter()));
     st1->Execute();
     if (st1->Fetch())
-    {
-        if (st1->IsNull(1))
-            relationNameM.clear();
-        else
-        {
-            std::string objname;
-            st1->Get(1, objname);
-            relationNameM = std2wxIdentifier(objname, db->getCharsetConverter());
-        }
-        st1->Get(2, &positionM);
-
-        short temp;
-        if (st1->IsNull(3))
-            temp = 0;
-        else
-            st1->Get(3, &temp);
-        activeM = (temp == 0);
-
-        st1->Get(4, &typeM);
-
-        readBlob(st1, 5, sourceM, db->getCharsetConverter());
-    }
+        readProperties(st1, db->getCharsetConverter());
     else // maybe trigger was dropped?
     {
         relationNameM.clear();
@@ -204,6 +189,106 @@ void Trigger::loadProperties()
     setPropertiesLoaded(true);
 }
 
+void Trigger::readProperties(IBPP::Statement& st1, wxMBConv* converter)
+{
+    if (st1->IsNull(1))
+        relationNameM.clear();
+    else
+    {
+        std::string objname;
+        st1->Get(1, objname);
+        relationNameM = std2wxIdentifier(objname, converter);
+    }
+    st1->Get(2, &positionM);
+
+    short temp;
+    if (st1->IsNull(3))
+        temp = 0;
+    else
+        st1->Get(3, &temp);
+    activeM = (temp == 0);
+
+    st1->Get(4, &typeM);
+    readBlob(st1, 5, sourceM, converter);
+}
+
+/*static*/
+void Trigger::loadPropertiesOf(DatabasePtr database,
+    const std::vector<Trigger*>& triggers)
+{
+    std::map<wxString, Trigger*> pending;
+    for (std::vector<Trigger*>::const_iterator it = triggers.begin();
+        it != triggers.end(); ++it)
+    {
+        if (!(*it)->propertiesLoaded())
+            pending[(*it)->getName_()] = *it;
+    }
+    if (pending.size() < 2)
+    {
+        if (!pending.empty())
+            (*pending.begin()).second->ensurePropertiesLoaded();
+        return;
+    }
+
+    MetadataLoader* loader = database->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(database.get());
+    wxMBConv* converter = database->getCharsetConverter();
+
+    IBPP::Statement& st1 = loader->getStatement(triggerSelectSql);
+    st1->Execute();
+    while (st1->Fetch())
+    {
+        std::string s;
+        st1->Get(6, s);
+        std::map<wxString, Trigger*>::iterator it =
+            pending.find(std2wxIdentifier(s, converter));
+        if (it == pending.end())
+            continue;
+        (*it).second->readProperties(st1, converter);
+        (*it).second->setPropertiesLoaded(true);
+        pending.erase(it);
+    }
+    // the remaining triggers have been dropped meanwhile
+    for (std::map<wxString, Trigger*>::iterator it = pending.begin();
+        it != pending.end(); ++it)
+    {
+        (*it).second->ensurePropertiesLoaded();
+    }
+}
+
+/*static*/
+void Trigger::loadTriggersOf(DatabasePtr database,
+    const wxString& relationName, std::vector<Trigger*>& triggers)
+{
+    MetadataLoader* loader = database->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    SubjectLocker lock(database.get());
+    wxMBConv* converter = database->getCharsetConverter();
+
+    IBPP::Statement& st1 = loader->getStatement(
+        std::string(triggerSelectSql) + "where t.rdb$relation_name = ? "
+        "order by t.rdb$trigger_sequence, t.rdb$trigger_name"
+    );
+    st1->Set(1, wx2std(relationName, converter));
+    st1->Execute();
+    while (st1->Fetch())
+    {
+        std::string s;
+        st1->Get(6, s);
+        Trigger* t = dynamic_cast<Trigger*>(database->findByNameAndType(
+            ntTrigger, std2wxIdentifier(s, converter)));
+        if (!t)
+            continue;
+        if (!t->propertiesLoaded())
+        {
+            t->readProperties(st1, converter);
+            t->setPropertiesLoaded(true);
+        }
+        triggers.push_back(t);
+    }
+}
+
 wxString Trigger::getAlterSql()
 {
     ensurePropertiesLoaded();
@@ -263,12 +348,17 @@ void Triggers::acceptVisitor(MetadataItemVisitor* visitor)
     visitor->visitTriggers(*this);
 }
 
-void Triggers::load(ProgressIndicator* progressIndicator)
+wxString Triggers::getLoadStatement()
 {
-    wxString stmt = "select rdb$trigger_name from rdb$triggers"
+    return "select rdb$trigger_name from rdb$triggers"
         " where (rdb$system_flag = 0 or rdb$system_flag is null)"
         " order by 1";
-    setItems(getDatabase()->loadIdentifiers(stmt, progressIndicator));
+}
+
+void Triggers::load(ProgressIndicator* progressIndicator)
+{
+    setItems(getDatabase()->loadIdentifiers(getLoadStatement(),
+        progressIndicator));
 }
 
 void Triggers::loadChildren()
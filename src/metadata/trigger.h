@@ -50,11 +50,21 @@ private:
     int typeM;
 
     static FiringTime getFiringTime(int type);
+    void readProperties(IBPP::Statement& st1, wxMBConv* converter);
 protected:
     virtual void loadProperties();
 public:
     Trigger(DatabasePtr database, const wxString& name);
 
+    // loads the properties of all triggers that are not loaded yet with
+    // a single query, instead of one query per trigger
+    static void loadPropertiesOf(DatabasePtr database,
+        const std::vector<Trigger*>& triggers);
+    // returns the user triggers of a relation in the order of their
+    // position, the properties of all of them are loaded with one query
+    static void loadTriggersOf(DatabasePtr database,
+        const wxString& relationName, std::vector<Trigger*>& triggers);
+
     bool getActive();
     wxString getFiringEvent();
     FiringTime getFiringTime();
@@ -76,6 +86,7 @@ public:
     Triggers(DatabasePtr database);
 
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
+    wxString getLoadStatement();
     void load(ProgressIndicator* progressIndicator);
     virtual const wxString getTypeName() const;
 };
@@ -96,12 +96,17 @@ void Views::acceptVisitor(MetadataItemVisitor* visitor)
     visitor->visitViews(*this);
 }
 
-void Views::load(ProgressIndicator* progressIndicator)
+wxString Views::getLoadStatement()
 {
-    wxString stmt = "select rdb$relation_name from rdb$relations"
+    return "select rdb$relation_name from rdb$relations"
         " where (rdb$system_flag = 0 or rdb$system_flag is null)"
         " and rdb$view_source is not null order by 1";
-    setItems(getDatabase()->loadIdentifiers(stmt, progressIndicator));
+}
+
+void Views::load(ProgressIndicator* progressIndicator)
+{
+    setItems(getDatabase()->loadIdentifiers(getLoadStatement(),
+        progressIndicator));
 }
 
 void Views::loadChildren()
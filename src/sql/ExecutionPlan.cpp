@@ -0,0 +1,622 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/tokenzr.h>
+
+#include <map>
+
+#include "sql/ExecutionPlan.h"
+
+ExecutionPlanNode::ExecutionPlanNode(NodeType nodeType)
+    : type(nodeType), access(atNone)
+{
+}
+
+wxString ExecutionPlanNode::getAccessString() const
+{
+    wxString result;
+    size_t first = 0;
+    switch (access)
+    {
+        case atNatural:
+            return "NATURAL";
+        case atOrder:
+            if (indices.empty())
+                return "ORDER";
+            result = "ORDER " + indices[0];
+            first = 1;
+            if (indices.size() == 1)
+                return result;
+            result += " ";
+            // fall through
+        case atIndex:
+            result += "INDEX (";
+            for (size_t i = first; i < indices.size(); ++i)
+            {
+                if (i > first)
+                    result += ", ";
+                result += indices[i];
+            }
+            return result + ")";
+        default:
+            return wxEmptyString;
+    }
+}
+
+wxString ExecutionPlanNode::toString() const
+{
+    if (type == ntTable)
+    {
+        wxString access(getAccessString());
+        if (access.IsEmpty())
+            return name;
+        return name + " " + access;
+    }
+
+    wxString result;
+    switch (type)
+    {
+        case ntJoin:
+            result = "JOIN ";
+            break;
+        case ntMerge:
+            result = "MERGE ";
+            break;
+        case ntHash:
+            result = "HASH ";
+            break;
+        case ntSort:
+            result = "SORT ";
+            break;
+        default:
+            break;
+    }
+    result += "(";
+    for (std::vector<ExecutionPlanNode>::const_iterator it =
+        children.begin(); it != children.end(); ++it)
+    {
+        if (it != children.begin())
+            result += ", ";
+        result += (*it).toString();
+    }
+    return result + ")";
+}
+
+// the plan of a single table is shown as "PLAN (T NATURAL)", and composite
+// nodes are shown without the surrounding list: "PLAN JOIN (...)"
+static void normalizeRoot(ExecutionPlanNode& root)
+{
+    if (root.type == ExecutionPlanNode::ntList && root.children.size() == 1
+        && root.children[0].type != ExecutionPlanNode::ntTable)
+    {
+        ExecutionPlanNode child(root.children[0]);
+        root = child;
+    }
+    else if (root.type == ExecutionPlanNode::ntTable)
+    {
+        ExecutionPlanNode list(ExecutionPlanNode::ntList);
+        list.children.push_back(root);
+        root = list;
+    }
+}
+
+// legacy plan format
+namespace {
+
+class LegacyPlanParser
+{
+private:
+    std::vector<wxString> tokensM;
+    size_t posM;
+
+    wxString current() const
+    {
+        return posM < tokensM.size() ? tokensM[posM] : wxString();
+    }
+    bool isKeyword(const wxString& keyword) const
+    {
+        return current().IsSameAs(keyword, false);
+    }
+    bool isCompositeStart() const
+    {
+        if (current() == "(")
+            return true;
+        if (posM + 1 >= tokensM.size())
+            return false;
+        if (isKeyword("SORT") && tokensM[posM + 1].IsSameAs("MERGE", false))
+            return true;
+        return (isKeyword("JOIN") || isKeyword("MERGE") || isKeyword("SORT")
+            || isKeyword("HASH")) && tokensM[posM + 1] == "(";
+    }
+    void parseIndexList(std::vector<wxString>& indices);
+    void parseTable(ExecutionPlanNode& node);
+    void parseComposite(ExecutionPlanNode& node);
+public:
+    LegacyPlanParser(const wxString& plan);
+    void parse(std::vector<ExecutionPlanNode>& roots);
+};
+
+LegacyPlanParser::LegacyPlanParser(const wxString& plan)
+    : posM(0)
+{
+    wxString token;
+    bool quoted = false;
+    for (wxString::const_iterator it = plan.begin(); it != plan.end(); ++it)
+    {
+        wxChar c = *it;
+        if (quoted)
+        {
+            token += c;
+            if (c == '"')
+                quoted = false;
+            continue;
+        }
+        if (c == '"')
+        {
+            token += c;
+            quoted = true;
+        }
+        else if (c == '(' || c == ')' || c == ',' || wxIsspace(c))
+        {
+            if (!token.IsEmpty())
+                tokensM.push_back(token);
+            token.Clear();
+            if (!wxIsspace(c))
+                tokensM.push_back(wxString(c));
+        }
+        else
+            token += c;
+    }
+    if (!token.IsEmpty())
+        tokensM.push_back(token);
+}
+
+void LegacyPlanParser::parseIndexList(std::vector<wxString>& indices)
+{
+    if (current() != "(")
+        return;
+    for (++posM; posM < tokensM.size() && current() != ")"; ++posM)
+    {
+        if (current() != ",")
+            indices.push_back(current());
+    }
+    ++posM;
+}
+
+void LegacyPlanParser::parseTable(ExecutionPlanNode& node)
+{
+    node.type = ExecutionPlanNode::ntTable;
+    while (posM < tokensM.size() && current() != "," && current() != ")"
+        && current() != "(" && !isKeyword("NATURAL") && !isKeyword("INDEX")
+        && !isKeyword("ORDER"))
+    {
+        if (!node.name.IsEmpty())
+            node.name += " ";
+        node.name += current();
+        ++posM;
+    }
+
+    if (isKeyword("NATURAL"))
+    {
+        node.access = ExecutionPlanNode::atNatural;
+        ++posM;
+        return;
+    }
+    if (isKeyword("ORDER"))
+    {
+        node.access = ExecutionPlanNode::atOrder;
+        ++posM;
+        if (posM < tokensM.size())
+            node.indices.push_back(tokensM[posM++]);
+    }
+    if (isKeyword("INDEX"))
+    {
+        if (node.access == ExecutionPlanNode::atNone)
+            node.access = ExecutionPlanNode::atIndex;
+        ++posM;
+        parseIndexList(node.indices);
+    }
+}
+
+void LegacyPlanParser::parseComposite(ExecutionPlanNode& node)
+{
+    if (isKeyword("JOIN"))
+        node.type = ExecutionPlanNode::ntJoin;
+    else if (isKeyword("MERGE"))
+        node.type = ExecutionPlanNode::ntMerge;
+    else if (isKeyword("HASH"))
+        node.type = ExecutionPlanNode::ntHash;
+    else if (isKeyword("SORT"))
+    {
+        node.type = ExecutionPlanNode::ntSort;
+        // old servers show "SORT MERGE"
+        if (posM + 1 < tokensM.size()
+            && tokensM[posM + 1].IsSameAs("MERGE", false))
+        {
+            node.type = ExecutionPlanNode::ntMerge;
+            ++posM;
+        }
+    }
+    if (current() != "(")
+        ++posM;
+    if (current() != "(")
+        return;
+    ++posM;
+
+    while (posM < tokensM.size() && current() != ")")
+    {
+        if (current() == ",")
+        {
+            ++posM;
+            continue;
+        }
+        size_t start = posM;
+        ExecutionPlanNode child;
+        if (isCompositeStart())
+            parseComposite(child);
+        else
+            parseTable(child);
+        node.children.push_back(child);
+        // skip unknown tokens instead of looping forever
+        if (posM == start)
+            ++posM;
+    }
+    ++posM;
+}
+
+void LegacyPlanParser::parse(std::vector<ExecutionPlanNode>& roots)
+{
+    while (posM < tokensM.size())
+    {
+        if (!isKeyword("PLAN"))
+        {
+            ++posM;
+            continue;
+        }
+        ++posM;
+        ExecutionPlanNode root;
+        parseComposite(root);
+        normalizeRoot(root);
+        roots.push_back(root);
+    }
+}
+
+// explained plan format of Firebird 3 and later
+struct ExplainedLine
+{
+    size_t indent;
+    wxString text;
+};
+
+// returns all strings in double quotes
+std::vector<wxString> getQuotedNames(const wxString& text)
+{
+    std::vector<wxString> names;
+    wxStringTokenizer tkz(text, "\"", wxTOKEN_RET_EMPTY_ALL);
+    bool inside = false;
+    while (tkz.HasMoreTokens())
+    {
+        wxString token(tkz.GetNextToken());
+        if (inside)
+            names.push_back(token);
+        inside = !inside;
+    }
+    return names;
+}
+
+// converts the node in line pos and all its descendants, returns the
+// position of the next sibling
+size_t convertExplained(const std::vector<ExplainedLine>& lines, size_t pos,
+    std::vector<ExecutionPlanNode>& result)
+{
+    const ExplainedLine& line = lines[pos];
+    size_t end = pos + 1;
+    while (end < lines.size() && lines[end].indent > line.indent)
+        ++end;
+
+    if (line.text.StartsWith("Table "))
+    {
+        ExecutionPlanNode node(ExecutionPlanNode::ntTable);
+        std::vector<wxString> names(getQuotedNames(line.text));
+        if (!names.empty())
+            node.relationName = names[0];
+        // aliases follow the relation name: Table "T" as "V" "A"
+        for (size_t i = 1; i < names.size(); ++i)
+        {
+            if (!node.name.IsEmpty())
+                node.name += " ";
+            node.name += names[i];
+        }
+        if (node.name.IsEmpty())
+            node.name = node.relationName;
+
+        if (line.text.Contains("Full Scan"))
+            node.access = ExecutionPlanNode::atNatural;
+        else
+        {
+            // an index directly below the table is used for navigation,
+            // indices below bitmaps are used for filtering
+            wxString order;
+            std::vector<wxString> filter;
+            size_t childIndent = end > pos + 1 ? lines[pos + 1].indent : 0;
+            for (size_t i = pos + 1; i < end; ++i)
+            {
+                if (!lines[i].text.StartsWith("Index "))
+                    continue;
+                std::vector<wxString> index(getQuotedNames(lines[i].text));
+                if (index.empty())
+                    continue;
+                if (lines[i].indent == childIndent && order.IsEmpty())
+                    order = index[0];
+                else
+                    filter.push_back(index[0]);
+            }
+            if (!order.IsEmpty())
+            {
+                node.access = ExecutionPlanNode::atOrder;
+                node.indices.push_back(order);
+            }
+            else if (!filter.empty())
+                node.access = ExecutionPlanNode::atIndex;
+            node.indices.insert(node.indices.end(), filter.begin(),
+                filter.end());
+        }
+        result.push_back(node);
+        return end;
+    }
+
+    bool composite = true;
+    ExecutionPlanNode node;
+    if (line.text.StartsWith("Nested Loop Join"))
+        node.type = ExecutionPlanNode::ntJoin;
+    else if (line.text.StartsWith("Hash Join"))
+        node.type = ExecutionPlanNode::ntHash;
+    else if (line.text.StartsWith("Merge Join"))
+        node.type = ExecutionPlanNode::ntMerge;
+    else if (line.text.StartsWith("Sort"))
+        node.type = ExecutionPlanNode::ntSort;
+    else if (line.text.StartsWith("Select Expression")
+        || line.text.StartsWith("Sub-query"))
+    {
+        node.type = ExecutionPlanNode::ntList;
+    }
+    else // filters, aggregates, unions, ... are not part of the tree
+        composite = false;
+
+    std::vector<ExecutionPlanNode> children;
+    for (size_t i = pos + 1; i < end; )
+        i = convertExplained(lines, i, children);
+    if (composite)
+    {
+        node.children = children;
+        result.push_back(node);
+    }
+    else
+        result.insert(result.end(), children.begin(), children.end());
+    return end;
+}
+
+} // namespace
+
+ExecutionPlan::ExecutionPlan()
+{
+}
+
+ExecutionPlan::ExecutionPlan(const wxString& plan)
+{
+    wxString trimmed(plan);
+    trimmed.Trim(false);
+    if (trimmed.Upper().StartsWith("PLAN"))
+        parseLegacy(plan);
+    else
+        parseExplained(plan);
+}
+
+void ExecutionPlan::parseLegacy(const wxString& plan)
+{
+    LegacyPlanParser parser(plan);
+    parser.parse(rootsM);
+}
+
+void ExecutionPlan::parseExplained(const wxString& plan)
+{
+    std::vector<ExplainedLine> lines;
+    wxStringTokenizer tkz(plan, "\r\n", wxTOKEN_STRTOK);
+    while (tkz.HasMoreTokens())
+    {
+        wxString text(tkz.GetNextToken());
+        ExplainedLine line;
+        line.indent = 0;
+        while (line.indent < text.Length() && wxIsspace(text[line.indent]))
+            ++line.indent;
+        line.text = text.Mid(line.indent);
+        if (line.text.StartsWith("->"))
+        {
+            line.indent += 2;
+            line.text = line.text.Mid(2);
+            line.text.Trim(false);
+        }
+        line.text.Trim(true);
+        if (!line.text.IsEmpty())
+            lines.push_back(line);
+    }
+
+    std::vector<ExecutionPlanNode> roots;
+    for (size_t i = 0; i < lines.size(); )
+        i = convertExplained(lines, i, roots);
+    for (std::vector<ExecutionPlanNode>::iterator it = roots.begin();
+        it != roots.end(); ++it)
+    {
+        normalizeRoot(*it);
+        rootsM.push_back(*it);
+    }
+}
+
+bool ExecutionPlan::isEmpty() const
+{
+    return rootsM.empty();
+}
+
+const std::vector<ExecutionPlanNode>& ExecutionPlan::getRoots() const
+{
+    return rootsM;
+}
+
+static void addTableNodes(const ExecutionPlanNode& node,
+    std::vector<const ExecutionPlanNode*>& nodes)
+{
+    if (node.type == ExecutionPlanNode::ntTable)
+        nodes.push_back(&node);
+    for (std::vector<ExecutionPlanNode>::const_iterator it =
+        node.children.begin(); it != node.children.end(); ++it)
+    {
+        addTableNodes(*it, nodes);
+    }
+}
+
+void ExecutionPlan::getTableNodes(
+    std::vector<const ExecutionPlanNode*>& nodes) const
+{
+    for (std::vector<ExecutionPlanNode>::const_iterator it = rootsM.begin();
+        it != rootsM.end(); ++it)
+    {
+        addTableNodes(*it, nodes);
+    }
+}
+
+std::vector<const ExecutionPlanNode*> ExecutionPlan::getNaturalScans() const
+{
+    std::vector<const ExecutionPlanNode*> tables, result;
+    getTableNodes(tables);
+    for (std::vector<const ExecutionPlanNode*>::const_iterator it =
+        tables.begin(); it != tables.end(); ++it)
+    {
+        if ((*it)->access == ExecutionPlanNode::atNatural)
+            result.push_back(*it);
+    }
+    return result;
+}
+
+wxString ExecutionPlan::toString() const
+{
+    wxString result;
+    for (std::vector<ExecutionPlanNode>::const_iterator it = rootsM.begin();
+        it != rootsM.end(); ++it)
+    {
+        if (it != rootsM.begin())
+            result += "\n";
+        result += "PLAN " + (*it).toString();
+    }
+    return result;
+}
+
+bool ExecutionPlan::equals(const ExecutionPlan& other) const
+{
+    return toString() == other.toString();
+}
+
+std::vector<ExecutionPlanChange> ExecutionPlan::compareTo(
+    const ExecutionPlan& previous) const
+{
+    // key tables by name and occurrence, as the same table may be read
+    // several times (self joins, sub-queries without aliases)
+    std::map<wxString, const ExecutionPlanNode*> previousTables;
+    std::map<wxString, int> occurrences;
+    std::vector<const ExecutionPlanNode*> tables;
+    previous.getTableNodes(tables);
+    for (std::vector<const ExecutionPlanNode*>::const_iterator it =
+        tables.begin(); it != tables.end(); ++it)
+    {
+        wxString key((*it)->name + wxString::Format("#%d",
+            occurrences[(*it)->name]++));
+        previousTables[key] = *it;
+    }
+
+    std::vector<ExecutionPlanChange> changes;
+    occurrences.clear();
+    tables.clear();
+    getTableNodes(tables);
+    for (std::vector<const ExecutionPlanNode*>::const_iterator it =
+        tables.begin(); it != tables.end(); ++it)
+    {
+        wxString key((*it)->name + wxString::Format("#%d",
+            occurrences[(*it)->name]++));
+        std::map<wxString, const ExecutionPlanNode*>::const_iterator prev =
+            previousTables.find(key);
+        if (prev == previousTables.end())
+            continue;
+        const ExecutionPlanNode* before = (*prev).second;
+        if (before->getAccessString() == (*it)->getAccessString())
+            continue;
+
+        ExecutionPlanChange change;
+        change.name = (*it)->name;
+        change.previousAccess = before->getAccessString();
+        change.currentAccess = (*it)->getAccessString();
+        change.isRegression = before->access != ExecutionPlanNode::atNatural
+            && (*it)->access == ExecutionPlanNode::atNatural;
+        changes.push_back(change);
+    }
+    return changes;
+}
+
+/*static*/
+wxString ExecutionPlan::getStatementHash(const wxString& sql)
+{
+    // collapse all whitespace so that reformatting does not matter
+    wxString normalized;
+    normalized.reserve(sql.Length());
+    bool space = false;
+    for (wxString::const_iterator it = sql.begin(); it != sql.end(); ++it)
+    {
+        if (wxIsspace(*it))
+        {
+            space = true;
+            continue;
+        }
+        if (space && !normalized.IsEmpty())
+            normalized += ' ';
+        space = false;
+        normalized += *it;
+    }
+
+    // 64 bit FNV-1a hash of the UTF-8 text
+    wxUint64 hash = wxULL(14695981039346656037);
+    wxCharBuffer buf(normalized.utf8_str());
+    for (const char* p = buf.data(); p && *p; ++p)
+    {
+        hash ^= wxUint64((unsigned char)*p);
+        hash *= wxULL(1099511628211);
+    }
+    return wxString::Format("%08x%08x", unsigned(hash >> 32),
+        unsigned(hash & 0xFFFFFFFF));
+}
@@ -0,0 +1,98 @@
+/*
+  Copyright (c) 2004-2016 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_EXECUTIONPLAN_H
+#define FR_EXECUTIONPLAN_H
+
+#include <wx/string.h>
+
+#include <vector>
+
+//! Node of a parsed statement execution plan. Both the legacy plan text
+//! ("PLAN JOIN (A NATURAL, B INDEX (B_PK))") and the explained plan format
+//! of Firebird 3 and later are normalized to a tree of these nodes, so that
+//! plans can be stored and compared independently of the source format.
+class ExecutionPlanNode
+{
+public:
+    enum NodeType { ntList, ntJoin, ntMerge, ntHash, ntSort, ntTable };
+    enum AccessType { atNone, atNatural, atIndex, atOrder };
+
+    NodeType type;
+    AccessType access;
+    // table nodes: relation name or alias as shown in the plan, and the
+    // real relation name when it is known (explained plans only)
+    wxString name;
+    wxString relationName;
+    // ORDER index, followed by the indices used for filtering
+    std::vector<wxString> indices;
+    std::vector<ExecutionPlanNode> children;
+
+    ExecutionPlanNode(NodeType nodeType = ntList);
+
+    wxString getAccessString() const;
+    wxString toString() const;
+};
+
+//! Access path of a single table in the plan, used for comparing plans.
+struct ExecutionPlanChange
+{
+    wxString name;
+    wxString previousAccess;
+    wxString currentAccess;
+    // index or navigational access changed to a full scan
+    bool isRegression;
+};
+
+class ExecutionPlan
+{
+private:
+    // one root per "PLAN" (sub-queries have plans of their own)
+    std::vector<ExecutionPlanNode> rootsM;
+
+    void parseLegacy(const wxString& plan);
+    void parseExplained(const wxString& plan);
+    void getTableNodes(std::vector<const ExecutionPlanNode*>& nodes) const;
+public:
+    ExecutionPlan();
+    // detects the plan format and parses it
+    ExecutionPlan(const wxString& plan);
+
+    bool isEmpty() const;
+    const std::vector<ExecutionPlanNode>& getRoots() const;
+    // returns all tables that are read with a full scan
+    std::vector<const ExecutionPlanNode*> getNaturalScans() const;
+    // returns the plan in legacy format, one line per root, which can be
+    // parsed again to recreate the plan tree
+    wxString toString() const;
+    bool equals(const ExecutionPlan& other) const;
+    // lists all tables whose access path is different in the other plan,
+    // tables are matched by name and the order of their occurrence
+    std::vector<ExecutionPlanChange> compareTo(const ExecutionPlan& previous) const;
+
+    // returns a hash of the statement text with whitespace normalized,
+    // which is used to find the plan history of a statement
+    static wxString getStatementHash(const wxString& sql);
+};
+
+#endif
@@ -32,13 +32,104 @@
 
 #include <wx/ffile.h>
 #include <wx/filefn.h>
+#include <wx/tokenzr.h>
+
+#include <algorithm>
+#include <iterator>
 #include <map>
+#include <string>
 
 #include "config/Config.h"
 #include "metadata/database.h"
 #include "statementHistory.h"
 
-wxString StatementHistory::getFilename(StatementHistory::Position item)
+namespace {
+
+// log entries: 4 bytes length, 8 bytes timestamp, UTF-8 text
+const size_t entryHeaderSize = 12;
+// index entries: 8 bytes offset, 4 bytes length, 8 bytes timestamp
+const size_t indexEntrySize = 20;
+
+// trigram index: 4 bytes each for version, number of covered entries and
+// number of trigrams, then for every trigram its value, offset and size of
+// the list of entry positions, followed by all the lists (delta-encoded
+// positions stored as variable length integers)
+const wxUint32 trigramIndexVersion = 1;
+const size_t trigramHeaderSize = 12;
+const size_t trigramListSize = 12;
+// the trigram index is rebuilt when more entries have been added since
+const size_t trigramIndexMaxUncovered = 500;
+
+void putUint32(char* p, wxUint32 value)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = char((value >> (8 * i)) & 0xFF);
+}
+
+wxUint32 getUint32(const char* p)
+{
+    wxUint32 value = 0;
+    for (int i = 3; i >= 0; --i)
+        value = (value << 8) | (unsigned char)p[i];
+    return value;
+}
+
+void putInt64(char* p, wxInt64 value)
+{
+    wxUint64 u = wxUint64(value);
+    for (int i = 0; i < 8; ++i)
+        p[i] = char((u >> (8 * i)) & 0xFF);
+}
+
+wxInt64 getInt64(const char* p)
+{
+    wxUint64 value = 0;
+    for (int i = 7; i >= 0; --i)
+        value = (value << 8) | (unsigned char)p[i];
+    return wxInt64(value);
+}
+
+void appendVarint(std::string& data, wxUint32 value)
+{
+    while (value >= 0x80)
+    {
+        data += char((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    data += char(value);
+}
+
+// all distinct trigrams of the upper-cased text, as FNV-1a hash values
+void getTrigrams(const wxString& text, std::vector<wxUint32>& trigrams)
+{
+    trigrams.clear();
+    wxString upper(text.Upper());
+    std::vector<wxUint32> chars;
+    chars.reserve(upper.length());
+    for (wxString::const_iterator it = upper.begin(); it != upper.end(); ++it)
+        chars.push_back(wxUint32((*it).GetValue()));
+    for (size_t i = 0; i + 2 < chars.size(); ++i)
+    {
+        wxUint32 hash = 2166136261u;
+        for (size_t j = i; j < i + 3; ++j)
+            hash = (hash ^ chars[j]) * 16777619u;
+        trigrams.push_back(hash);
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()),
+        trigrams.end());
+}
+
+struct TrigramPostings
+{
+    std::string data;
+    wxUint32 last;
+    TrigramPostings() : last(0) {}
+};
+
+} // namespace
+
+wxString StatementHistory::getFilePrefix()
 {
     wxString fn = config().getUserHomePath() + "history/";
     if (!wxDirExists(fn))
@@ -46,6 +137,17 @@ wxString StatementHistory::getFilename(StatementHistory::Position item)
 
     for (Position i=0; i<storageNameM.Length(); ++i)
         fn += wxString::Format("%04x", storageNameM[i]);
+    return fn;
+}
+
+wxString StatementHistory::getFilename(const wxString& suffix)
+{
+    return getFilePrefix() + suffix;
+}
+
+wxString StatementHistory::getLegacyFilename(StatementHistory::Position item)
+{
+    wxString fn = getFilePrefix();
     fn << "_ITEM_" << (item);
     return fn;
 }
@@ -54,18 +156,25 @@ StatementHistory::StatementHistory(const wxString& storageName)
 {
     storageNameM = storageName;
     sizeM = 0;
-    while (true)    // load history
-    {
-        if (!wxFileExists(getFilename(sizeM)))
-            break;
-        sizeM++;
-    }
+    entriesLoadedM = false;
+    trigramCountM = 0;
+    trigramDataOffsetM = 0;
+    trigramsLoadedM = false;
+    plansLoadedM = false;
 }
 
 StatementHistory::StatementHistory(const StatementHistory& source)
 {
     storageNameM = source.storageNameM;
     sizeM = source.sizeM;
+    entriesM = source.entriesM;
+    entriesLoadedM = source.entriesLoadedM;
+    trigramListsM = source.trigramListsM;
+    trigramCountM = source.trigramCountM;
+    trigramDataOffsetM = source.trigramDataOffsetM;
+    trigramsLoadedM = source.trigramsLoadedM;
+    plansM = source.plansM;
+    plansLoadedM = source.plansLoadedM;
 }
 
 //! reads granularity from config() and gives pointer to appropriate history object
@@ -102,28 +211,198 @@ StatementHistory& StatementHistory::get(Database* db)
     }
 }
 
-wxDateTime StatementHistory::getDateTime(StatementHistory::Position pos)
+void StatementHistory::loadEntries()
 {
-    if (pos < sizeM)
+    if (entriesLoadedM)
+        return;
+    entriesLoadedM = true;
+
+    if (!wxFileExists(getFilename("_LOG")))
+        migrateLegacyFiles();
+    entriesM.clear();
+
+    wxFFile idx(getFilename("_IDX"), "rb");
+    if (idx.IsOpened())
+    {
+        size_t count = size_t(idx.Length() / indexEntrySize);
+        std::vector<char> buf(count * indexEntrySize);
+        if (count > 0 && idx.Read(&buf[0], buf.size()) == buf.size())
+        {
+            entriesM.resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const char* p = &buf[i * indexEntrySize];
+                entriesM[i].offset = wxFileOffset(getInt64(p));
+                entriesM[i].length = getUint32(p + 8);
+                entriesM[i].timestamp = getInt64(p + 12);
+            }
+        }
+        idx.Close();
+    }
+
+    // the index may be missing entries when the program was terminated
+    // while adding a statement, the log entries are self-describing
+    wxFFile log(getFilename("_LOG"), "rb");
+    wxFileOffset logLength = log.IsOpened() ? log.Length() : 0;
+    wxFileOffset indexed = 0;
+    if (!entriesM.empty())
+    {
+        const Entry& last = entriesM.back();
+        indexed = last.offset + entryHeaderSize + last.length;
+    }
+    if (indexed > logLength)
+    {
+        entriesM.clear();
+        indexed = 0;
+    }
+    if (indexed < logLength)
+    {
+        char header[entryHeaderSize];
+        while (indexed + wxFileOffset(entryHeaderSize) <= logLength
+            && log.Seek(indexed)
+            && log.Read(header, entryHeaderSize) == entryHeaderSize)
+        {
+            Entry e;
+            e.offset = indexed;
+            e.length = getUint32(header);
+            e.timestamp = getInt64(header + 4);
+            if (e.offset + wxFileOffset(entryHeaderSize + e.length) > logLength)
+                break;
+            entriesM.push_back(e);
+            indexed += entryHeaderSize + e.length;
+        }
+        writeIndex();
+    }
+    sizeM = entriesM.size();
+}
+
+bool StatementHistory::writeIndex()
+{
+    wxFFile idx(getFilename("_IDX"), "wb");
+    if (!idx.IsOpened())
+        return false;
+    std::vector<char> buf(entriesM.size() * indexEntrySize);
+    for (size_t i = 0; i < entriesM.size(); ++i)
+    {
+        char* p = &buf[i * indexEntrySize];
+        putInt64(p, entriesM[i].offset);
+        putUint32(p + 8, entriesM[i].length);
+        putInt64(p + 12, entriesM[i].timestamp);
+    }
+    return buf.empty() || idx.Write(&buf[0], buf.size()) == buf.size();
+}
+
+// older versions stored every statement in a file of its own, they are
+// copied to a new log in their original order, the log replaces the old one
+// and the files are removed only after all of them have been copied, so a
+// migration that failed is retried the next time
+void StatementHistory::migrateLegacyFiles()
+{
+    if (!wxFileExists(getLegacyFilename(0)))
+        return;
+
+    wxBusyCursor wait;
+    wxString tempName(getFilename("_LOG.tmp"));
+    Position count = 0;
+    bool ok = true;
+    {
+        wxFFile temp(tempName, "wb");
+        if (!temp.IsOpened())
+            return;
+        for (; wxFileExists(getLegacyFilename(count)); ++count)
+        {
+            wxString fn(getLegacyFilename(count));
+            wxFFile f(fn, "rb");
+            wxString str;
+            Entry e;
+            if (!f.IsOpened() || !f.ReadAll(&str) || !writeEntry(temp, str,
+                wxInt64(::wxFileModificationTime(fn)), e))
+            {
+                ok = false;
+                break;
+            }
+        }
+        if (!temp.Close())
+            ok = false;
+    }
+    // the index is rebuilt from the log when it is loaded
+    if (ok && wxFileExists(getFilename("_IDX")))
+        ok = wxRemoveFile(getFilename("_IDX"));
+    if (!ok || !wxRenameFile(tempName, getFilename("_LOG"), false))
     {
-        return wxDateTime(::wxFileModificationTime(getFilename(pos)));
+        wxRemoveFile(tempName);
+        return;
     }
+    for (Position i = 0; i < count; ++i)
+        wxRemoveFile(getLegacyFilename(i));
+}
+
+bool StatementHistory::writeEntry(wxFFile& log, const wxString& str,
+    wxInt64 timestamp, Entry& entry)
+{
+    wxScopedCharBuffer buf(str.utf8_str());
+    entry.length = wxUint32(buf.length());
+    entry.timestamp = timestamp;
+    if (!log.SeekEnd())
+        return false;
+    entry.offset = log.Tell();
+    char header[entryHeaderSize];
+    putUint32(header, entry.length);
+    putInt64(header + 4, entry.timestamp);
+    return log.Write(header, entryHeaderSize) == entryHeaderSize
+        && log.Write(buf.data(), entry.length) == entry.length;
+}
+
+bool StatementHistory::appendEntry(const wxString& str, wxInt64 timestamp)
+{
+    Entry e;
+    wxFFile log(getFilename("_LOG"), "ab");
+    if (!log.IsOpened() || !writeEntry(log, str, timestamp, e))
+        return false;
+    log.Close();
+
+    char entry[indexEntrySize];
+    putInt64(entry, e.offset);
+    putUint32(entry + 8, e.length);
+    putInt64(entry + 12, e.timestamp);
+    wxFFile idx(getFilename("_IDX"), "ab");
+    if (idx.IsOpened())
+        idx.Write(entry, indexEntrySize);
+
+    entriesM.push_back(e);
+    sizeM = entriesM.size();
+    return true;
+}
+
+wxString StatementHistory::readEntry(wxFFile& log, const Entry& entry)
+{
+    if (entry.length == 0
+        || !log.Seek(entry.offset + wxFileOffset(entryHeaderSize)))
+    {
+        return wxEmptyString;
+    }
+    std::vector<char> buf(entry.length);
+    if (log.Read(&buf[0], entry.length) != entry.length)
+        return wxEmptyString;
+    return wxString::FromUTF8(&buf[0], entry.length);
+}
+
+wxDateTime StatementHistory::getDateTime(StatementHistory::Position pos)
+{
+    loadEntries();
+    if (pos < sizeM)
+        return wxDateTime(time_t(entriesM[pos].timestamp));
     return wxInvalidDateTime;
 }
 
 wxString StatementHistory::get(StatementHistory::Position pos)
 {
+    loadEntries();
     if (pos < sizeM)
     {
-        wxFFile f(getFilename(pos), "rb");
-        if (!f.IsOpened())
-            return wxEmptyString;
-        wxString retval;
-        if (f.ReadAll(&retval))
-        {
-            f.Close();
-            return retval;
-        }
+        wxFFile log(getFilename("_LOG"), "rb");
+        if (log.IsOpened())
+            return readEntry(log, entriesM[pos]);
     }
     return wxEmptyString;
 }
@@ -137,47 +416,352 @@ void StatementHistory::add(const wxString& str)
         return;
     }
 
+    loadEntries();
     if (sizeM == 0 || get(sizeM-1) != str)
-    {
-        wxFFile f(getFilename(sizeM), "wb+");
-        if (f.IsOpened())
-        {
-            f.Write(str);
-            f.Close();
-            sizeM++;
-        }
-    }
+        appendEntry(str, wxInt64(wxDateTime::Now().GetTicks()));
 }
 
 StatementHistory::Position StatementHistory::size()
 {
+    loadEntries();
     return sizeM;
 }
 
 void StatementHistory::deleteItems(
     const std::vector<StatementHistory::Position>& items)
 {
-    // remove the files (remembering the "lowest" deleted)
-    Position start = size();
+    loadEntries();
+    std::vector<bool> deleted(entriesM.size(), false);
     for (std::vector<Position>::const_iterator ci = items.begin();
         ci != items.end(); ++ci)
     {
-        wxRemoveFile(getFilename(*ci));
-        if ((*ci) < start)
-            start = (*ci);
+        if ((*ci) < deleted.size())
+            deleted[*ci] = true;
+    }
+
+    // copy the remaining entries to a new log file
+    wxString logName(getFilename("_LOG"));
+    wxString tempName(getFilename("_LOG.tmp"));
+    std::vector<Entry> remaining;
+    {
+        wxFFile log(logName, "rb");
+        wxFFile temp(tempName, "wb");
+        if (!log.IsOpened() || !temp.IsOpened())
+            return;
+        for (size_t i = 0; i < entriesM.size(); ++i)
+        {
+            if (deleted[i])
+                continue;
+            Entry e(entriesM[i]);
+            size_t size = entryHeaderSize + e.length;
+            std::vector<char> buf(size);
+            if (!log.Seek(e.offset) || log.Read(&buf[0], size) != size)
+                return;
+            e.offset = temp.Tell();
+            if (temp.Write(&buf[0], size) != size)
+                return;
+            remaining.push_back(e);
+        }
+    }
+    if (!wxRenameFile(tempName, logName, true))
+        return;
+
+    entriesM = remaining;
+    sizeM = entriesM.size();
+    writeIndex();
+    // positions have changed
+    dropTrigramIndex();
+}
+
+void StatementHistory::dropTrigramIndex()
+{
+    if (wxFileExists(getFilename("_TRI")))
+        wxRemoveFile(getFilename("_TRI"));
+    trigramListsM.clear();
+    trigramCountM = 0;
+    trigramDataOffsetM = 0;
+    trigramsLoadedM = true;
+}
+
+void StatementHistory::loadTrigramIndex()
+{
+    if (trigramsLoadedM)
+        return;
+    trigramsLoadedM = true;
+    trigramListsM.clear();
+    trigramCountM = 0;
+
+    wxFFile file(getFilename("_TRI"), "rb");
+    if (!file.IsOpened())
+        return;
+    char header[trigramHeaderSize];
+    if (file.Read(header, trigramHeaderSize) != trigramHeaderSize
+        || getUint32(header) != trigramIndexVersion
+        || getUint32(header + 4) > sizeM)
+    {
+        return;
+    }
+    size_t count = getUint32(header + 8);
+    std::vector<char> buf(count * trigramListSize);
+    if (count > 0 && file.Read(&buf[0], buf.size()) != buf.size())
+        return;
+
+    trigramListsM.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const char* p = &buf[i * trigramListSize];
+        trigramListsM[i].trigram = getUint32(p);
+        trigramListsM[i].offset = getUint32(p + 4);
+        trigramListsM[i].size = getUint32(p + 8);
+    }
+    trigramCountM = getUint32(header + 4);
+    trigramDataOffsetM = trigramHeaderSize + buf.size();
+}
+
+void StatementHistory::buildTrigramIndex()
+{
+    dropTrigramIndex();
+
+    std::map<wxUint32, TrigramPostings> postings;
+    std::vector<wxUint32> trigrams;
+    wxFFile log(getFilename("_LOG"), "rb");
+    if (!log.IsOpened())
+        return;
+    for (Position p = 0; p < entriesM.size(); ++p)
+    {
+        getTrigrams(readEntry(log, entriesM[p]), trigrams);
+        for (std::vector<wxUint32>::const_iterator it = trigrams.begin();
+            it != trigrams.end(); ++it)
+        {
+            TrigramPostings& tp = postings[*it];
+            appendVarint(tp.data, wxUint32(p) - tp.last);
+            tp.last = wxUint32(p);
+        }
+    }
+
+    std::vector<char> header(trigramHeaderSize
+        + postings.size() * trigramListSize);
+    putUint32(&header[0], trigramIndexVersion);
+    putUint32(&header[4], wxUint32(entriesM.size()));
+    putUint32(&header[8], wxUint32(postings.size()));
+    std::vector<TrigramList> lists;
+    lists.reserve(postings.size());
+    wxUint32 offset = 0;
+    for (std::map<wxUint32, TrigramPostings>::const_iterator it =
+        postings.begin(); it != postings.end(); ++it)
+    {
+        TrigramList tl;
+        tl.trigram = (*it).first;
+        tl.offset = offset;
+        tl.size = wxUint32((*it).second.data.size());
+        char* p = &header[trigramHeaderSize + lists.size() * trigramListSize];
+        putUint32(p, tl.trigram);
+        putUint32(p + 4, tl.offset);
+        putUint32(p + 8, tl.size);
+        lists.push_back(tl);
+        offset += tl.size;
+    }
+
+    wxFFile file(getFilename("_TRI"), "wb");
+    if (!file.IsOpened()
+        || file.Write(&header[0], header.size()) != header.size())
+    {
+        return;
+    }
+    for (std::map<wxUint32, TrigramPostings>::const_iterator it =
+        postings.begin(); it != postings.end(); ++it)
+    {
+        const std::string& data((*it).second.data);
+        if (file.Write(data.data(), data.size()) != data.size())
+            return;
+    }
+    if (!file.Close())
+        return;
+
+    trigramListsM.swap(lists);
+    trigramCountM = entriesM.size();
+    trigramDataOffsetM = header.size();
+}
+
+bool StatementHistory::readTrigramList(wxFFile& file, wxUint32 trigram,
+    std::vector<StatementHistory::Position>& positions)
+{
+    positions.clear();
+    // binary search, the lists are sorted by trigram
+    size_t lo = 0, hi = trigramListsM.size();
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (trigramListsM[mid].trigram < trigram)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
+    // no statement contains the trigram
+    if (lo == trigramListsM.size() || trigramListsM[lo].trigram != trigram)
+        return true;
 
-    // move existing files
-    for (Position currentpos = start; currentpos < size(); currentpos++)
+    const TrigramList& list(trigramListsM[lo]);
+    std::vector<char> buf(list.size);
+    if (buf.empty())
+        return true;
+    if (!file.Seek(trigramDataOffsetM + list.offset)
+        || file.Read(&buf[0], buf.size()) != buf.size())
+    {
+        return false;
+    }
+    wxUint32 position = 0, value = 0;
+    int shift = 0;
+    for (size_t i = 0; i < buf.size(); ++i)
     {
-        if (!wxFileExists(getFilename(currentpos)))
+        unsigned char c = (unsigned char)buf[i];
+        value |= wxUint32(c & 0x7F) << shift;
+        if (c & 0x80)
+        {
+            shift += 7;
             continue;
-        if (currentpos != start)
-            wxRenameFile(getFilename(currentpos), getFilename(start));
-        start++;
+        }
+        position += value;
+        positions.push_back(position);
+        value = 0;
+        shift = 0;
+    }
+    return true;
+}
+
+std::vector<StatementHistory::Position> StatementHistory::findCandidates(
+    const wxString& text)
+{
+    loadEntries();
+    std::vector<Position> result;
+    std::vector<wxUint32> trigrams;
+    getTrigrams(text, trigrams);
+    if (trigrams.empty())
+    {
+        // too short for the index, all entries need to be checked
+        for (Position p = 0; p < sizeM; ++p)
+            result.push_back(p);
+        return result;
+    }
+
+    loadTrigramIndex();
+    if (sizeM - trigramCountM > trigramIndexMaxUncovered)
+    {
+        wxBusyCursor wait;
+        buildTrigramIndex();
+    }
+
+    if (trigramCountM > 0)
+    {
+        wxFFile file(getFilename("_TRI"), "rb");
+        std::vector<Position> positions, intersection;
+        for (std::vector<wxUint32>::const_iterator it = trigrams.begin();
+            it != trigrams.end(); ++it)
+        {
+            if (!file.IsOpened() || !readTrigramList(file, *it, positions))
+            {
+                // the index can't be read, it is rebuilt the next time
+                // and all entries need to be checked for now
+                wxLogError(_("Could not read the statement history index \"%s\"."),
+                    getFilename("_TRI").c_str());
+                file.Close();
+                dropTrigramIndex();
+                result.clear();
+                for (Position p = 0; p < sizeM; ++p)
+                    result.push_back(p);
+                return result;
+            }
+            if (it == trigrams.begin())
+                result.swap(positions);
+            else
+            {
+                intersection.clear();
+                std::set_intersection(result.begin(), result.end(),
+                    positions.begin(), positions.end(),
+                    std::back_inserter(intersection));
+                result.swap(intersection);
+            }
+            if (result.empty())
+                break;
+        }
+    }
+
+    // entries added after the index has been built
+    for (Position p = trigramCountM; p < sizeM; ++p)
+        result.push_back(p);
+    return result;
+}
+
+// every line of the file contains the statement hash and the lines of the
+// plan, all separated by tabs; plans are appended when they change, so the
+// last line for a hash wins
+void StatementHistory::loadPlans()
+{
+    if (plansLoadedM)
+        return;
+    plansLoadedM = true;
+
+    wxFFile f(getFilename("_PLANS"), "rb");
+    if (!f.IsOpened())
+        return;
+    wxString contents;
+    if (!f.ReadAll(&contents, wxConvUTF8))
+        return;
+    f.Close();
+
+    size_t lines = 0;
+    wxStringTokenizer tkz(contents, "\n", wxTOKEN_STRTOK);
+    while (tkz.HasMoreTokens())
+    {
+        wxString line(tkz.GetNextToken());
+        wxString hash(line.BeforeFirst('\t'));
+        wxString plan(line.AfterFirst('\t'));
+        plan.Replace("\t", "\n");
+        if (!hash.IsEmpty())
+            plansM[hash] = plan;
+        ++lines;
     }
 
-    // set new size
-    sizeM = start;
+    // rewrite the file without superseded plans
+    if (lines > 2 * plansM.size() + 100)
+    {
+        wxFFile out(getFilename("_PLANS"), "wb");
+        if (!out.IsOpened())
+            return;
+        for (std::map<wxString, wxString>::const_iterator it = plansM.begin();
+            it != plansM.end(); ++it)
+        {
+            wxString plan((*it).second);
+            plan.Replace("\n", "\t");
+            out.Write((*it).first + "\t" + plan + "\n", wxConvUTF8);
+        }
+    }
+}
+
+wxString StatementHistory::getPlan(const wxString& statementHash)
+{
+    loadPlans();
+    std::map<wxString, wxString>::const_iterator it =
+        plansM.find(statementHash);
+    if (it == plansM.end())
+        return wxEmptyString;
+    return (*it).second;
 }
 
+void StatementHistory::setPlan(const wxString& statementHash,
+    const wxString& plan)
+{
+    loadPlans();
+    wxString& stored = plansM[statementHash];
+    if (stored == plan)
+        return;
+    stored = plan;
+
+    wxFFile f(getFilename("_PLANS"), "ab");
+    if (f.IsOpened())
+    {
+        wxString line(plan);
+        line.Replace("\n", "\t");
+        f.Write(statementHash + "\t" + line + "\n", wxConvUTF8);
+    }
+}
@@ -25,21 +25,70 @@
 #define FR_HISTORY_H
 
 #include <wx/wx.h>
+#include <wx/ffile.h>
+#include <map>
 #include <vector>
 
 class Database;
 
+// Statements are stored in a single append-only log file, together with an
+// index file containing offset, length and timestamp of every entry, so that
+// the history can be opened without reading the statements.  A trigram index
+// is used to find the candidates for history searches.
 class StatementHistory
 {
 public:
     typedef size_t Position;
 
 private:
+    struct Entry
+    {
+        wxFileOffset offset;
+        wxUint32 length;
+        wxInt64 timestamp;
+    };
+
     StatementHistory(const wxString& storageName);
-    wxString getFilename(Position item);
+    wxString getFilePrefix();
+    wxString getFilename(const wxString& suffix);
+    wxString getLegacyFilename(Position item);
     wxString storageNameM;
     Position sizeM;
 
+    std::vector<Entry> entriesM;
+    bool entriesLoadedM;
+    void loadEntries();
+    void migrateLegacyFiles();
+    bool writeIndex();
+    bool writeEntry(wxFFile& log, const wxString& str, wxInt64 timestamp,
+        Entry& entry);
+    bool appendEntry(const wxString& str, wxInt64 timestamp);
+    wxString readEntry(wxFFile& log, const Entry& entry);
+
+    // trigram index for searching, covers the first trigramCountM entries
+    struct TrigramList
+    {
+        wxUint32 trigram;
+        wxUint32 offset;
+        wxUint32 size;
+    };
+    std::vector<TrigramList> trigramListsM;
+    Position trigramCountM;
+    wxFileOffset trigramDataOffsetM;
+    bool trigramsLoadedM;
+    void loadTrigramIndex();
+    void buildTrigramIndex();
+    void dropTrigramIndex();
+    // returns false if the list could not be read, a trigram that isn't
+    // in the index has an empty list
+    bool readTrigramList(wxFFile& file, wxUint32 trigram,
+        std::vector<Position>& positions);
+
+    // execution plans of statements, keyed by the statement hash
+    std::map<wxString, wxString> plansM;
+    bool plansLoadedM;
+    void loadPlans();
+
 public:
     // copy ctor needed for std:: containers
     StatementHistory(const StatementHistory& source);
@@ -52,6 +101,14 @@ public:
     void add(const wxString&);
     void deleteItems(const std::vector<Position>& items);
     Position size();
+
+    // returns the positions of all entries that may contain the text, in
+    // ascending order; the entries still need to be checked by the caller
+    std::vector<Position> findCandidates(const wxString& text);
+
+    // the last known execution plan of a statement (see ExecutionPlan)
+    wxString getPlan(const wxString& statementHash);
+    void setPlan(const wxString& statementHash, const wxString& plan);
 };
 
 #endif